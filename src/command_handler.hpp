@@ -5,16 +5,28 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <span>
 #include <string_view>
 
 using CommandArgs = std::span<const resp::Type>;
 using CommandFn = resp::Type (*)(CommandArgs, Storage &,
                                  std::pmr::memory_resource *);
+// The same command answered through a Storage::Reader, for the parallel
+// read phase; must give the same reply as `fn` would.
+using ReadFn = resp::Type (*)(CommandArgs, Storage::Reader &,
+                              std::pmr::memory_resource *);
 
 struct CommandEntry {
+  enum Flag : std::uint8_t {
+    NONE = 0,
+    DENY_OOM = 1U << 0, // may grow memory: refused when over maxmemory
+  };
+
   std::string_view name;
+  std::uint8_t flags = NONE;
   CommandFn fn;
+  ReadFn read = nullptr; // only for commands that never write
 };
 
 template <std::size_t N> struct CommandHandler {
@@ -42,6 +54,12 @@ template <std::size_t N> struct CommandHandler {
                       std::pmr::memory_resource *arena) const {
     for (const auto &cmd : entries) {
       if (cmd.name == name) {
+        if ((cmd.flags & CommandEntry::DENY_OOM) != 0 &&
+            store.FreeMemoryIfNeeded() == Storage::EvictionStatus::Failed)
+          [[unlikely]] {
+          return resp::Error{std::pmr::string{
+            "OOM command not allowed when used memory > 'maxmemory'.", arena}};
+        }
         return cmd.fn(args, store, arena);
       }
     }
@@ -52,4 +70,14 @@ template <std::size_t N> struct CommandHandler {
     msg += "'";
     return resp::Error{std::move(msg)};
   }
+
+  // The read-only form of `name`, or null if it has none (or is unknown)
+  ReadFn FindReader(std::string_view name) const {
+    for (const auto &cmd : entries) {
+      if (cmd.name == name) {
+        return cmd.read;
+      }
+    }
+    return nullptr;
+  }
 };
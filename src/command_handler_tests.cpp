@@ -2,9 +2,14 @@
 #include "resp/values.hpp"
 #include "storage.hpp"
 
+#include <algorithm>
 #include <array>
 #include <catch2/catch_test_macros.hpp>
+#include <cstdint>
 #include <memory_resource>
+#include <set>
+#include <string>
+#include <vector>
 
 using namespace resp;
 
@@ -20,7 +25,7 @@ const std::pmr::string &asBulk(const Type &t) {
   return std::get<BulkString>(t).value;
 }
 
-int asInt(const Type &t) { return std::get<Int>(t).value; }
+std::int64_t asInt(const Type &t) { return std::get<Int>(t).value; }
 
 const std::pmr::vector<Type> &asArray(const Type &t) {
   return std::get<Array>(t).value;
@@ -100,6 +105,64 @@ TEST_CASE("SET and GET commands", "[commands]") {
   }
 }
 
+TEST_CASE("INCR family", "[commands]") {
+  std::array<std::byte, 4096> buf{};
+  std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
+  Storage store;
+
+  SECTION("Counting up and down") {
+    REQUIRE(asInt(dispatch(store, {bulkStr("INCR"), bulkStr("n")}, &arena)) ==
+            1);
+    REQUIRE(asInt(dispatch(store, {bulkStr("INCRBY"), bulkStr("n"),
+                                   bulkStr("4000000000")},
+                           &arena)) == 4'000'000'001);
+    REQUIRE(asInt(dispatch(store, {bulkStr("DECRBY"), bulkStr("n"),
+                                   bulkStr("1")},
+                           &arena)) == 4'000'000'000);
+    REQUIRE(asInt(dispatch(store, {bulkStr("DECR"), bulkStr("n")}, &arena)) ==
+            3'999'999'999);
+    REQUIRE(asBulk(dispatch(store, {bulkStr("GET"), bulkStr("n")}, &arena)) ==
+            "3999999999");
+  }
+
+  SECTION("Errors") {
+    dispatch(store, {bulkStr("SET"), bulkStr("s"), bulkStr("abc")}, &arena);
+    REQUIRE(isError(dispatch(store, {bulkStr("INCR"), bulkStr("s")}, &arena)));
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("INCRBY"), bulkStr("n"), bulkStr("x")}, &arena)));
+    REQUIRE(isError(dispatch(store,
+                             {bulkStr("DECRBY"), bulkStr("n"),
+                              bulkStr("-9223372036854775808")},
+                             &arena)));
+    dispatch(store,
+             {bulkStr("SET"), bulkStr("max"), bulkStr("9223372036854775807")},
+             &arena);
+    auto overflow = dispatch(store, {bulkStr("INCR"), bulkStr("max")}, &arena);
+    REQUIRE(std::get<Error>(overflow).value ==
+            "ERR increment or decrement would overflow");
+    dispatch(store, {bulkStr("LPUSH"), bulkStr("list"), bulkStr("a")}, &arena);
+    auto wrong = dispatch(store, {bulkStr("INCR"), bulkStr("list")}, &arena);
+    REQUIRE(std::get<Error>(wrong).value.starts_with("WRONGTYPE"));
+    REQUIRE(isError(dispatch(store, {bulkStr("INCR")}, &arena)));
+  }
+
+  SECTION("INCRBYFLOAT") {
+    dispatch(store, {bulkStr("SET"), bulkStr("f"), bulkStr("10.50")}, &arena);
+    REQUIRE(asBulk(dispatch(store,
+                            {bulkStr("INCRBYFLOAT"), bulkStr("f"),
+                             bulkStr("0.1")},
+                            &arena)) == "10.6");
+    REQUIRE(asBulk(dispatch(store,
+                            {bulkStr("INCRBYFLOAT"), bulkStr("f"),
+                             bulkStr("-5e0")},
+                            &arena)) == "5.6");
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("INCRBYFLOAT"), bulkStr("f"), bulkStr("inf")}, &arena)));
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("INCRBYFLOAT"), bulkStr("f"), bulkStr("1x")}, &arena)));
+  }
+}
+
 TEST_CASE("DEL command", "[commands]") {
   std::array<std::byte, 4096> buf{};
   std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
@@ -144,6 +207,187 @@ TEST_CASE("KEYS command", "[commands]") {
     auto result = dispatch(store, {bulkStr("KEYS"), bulkStr("*")}, &arena);
     REQUIRE(asArray(result).size() == 2);
   }
+
+  SECTION("Filters by pattern") {
+    for (const auto *key : {"user:1:name", "user:1:mail", "user:12:name"}) {
+      dispatch(store, {bulkStr("SET"), bulkStr(key), bulkStr("v")}, &arena);
+    }
+    auto prefix =
+      dispatch(store, {bulkStr("KEYS"), bulkStr("user:1:*")}, &arena);
+    REQUIRE(asArray(prefix).size() == 2);
+
+    auto cls = dispatch(store, {bulkStr("KEYS"), bulkStr("user:1?:n[a]me")},
+                        &arena);
+    REQUIRE(asArray(cls).size() == 1);
+    REQUIRE(asBulk(asArray(cls)[0]) == "user:12:name");
+
+    auto exact =
+      dispatch(store, {bulkStr("KEYS"), bulkStr("user:1:mail")}, &arena);
+    REQUIRE(asArray(exact).size() == 1);
+
+    auto none = dispatch(store, {bulkStr("KEYS"), bulkStr("nope")}, &arena);
+    REQUIRE(asArray(none).empty());
+  }
+}
+
+TEST_CASE("SCAN and SSCAN commands", "[commands]") {
+  std::pmr::monotonic_buffer_resource arena;
+  Storage store;
+
+  // Follows the cursor to the end, collecting every element returned
+  auto scan_all = [&](std::initializer_list<Type> head,
+                      std::initializer_list<Type> options) {
+    std::set<std::string> seen;
+    std::string cursor = "0";
+    do {
+      std::vector<Type> args(head);
+      args.push_back(bulkStr(cursor.c_str()));
+      args.insert(args.end(), options);
+      std::string name{asBulk(args[0])};
+      auto reply = COMMANDS.Dispatch(
+        name, std::span<const Type>{args}.subspan(1), store, &arena);
+      const auto &parts = asArray(reply);
+      REQUIRE(parts.size() == 2);
+      cursor = asBulk(parts[0]);
+      for (const auto &elem : asArray(parts[1])) {
+        seen.emplace(asBulk(elem));
+      }
+    } while (cursor != "0");
+    return seen;
+  };
+
+  for (auto i = 0; i < 200; ++i) {
+    const auto key = "key:" + std::to_string(i);
+    dispatch(store, {bulkStr("SET"), bulkStr(key.c_str()), bulkStr("v")},
+             &arena);
+    const auto member = "m" + std::to_string(i);
+    dispatch(store,
+             {bulkStr("SADD"), bulkStr("set"), bulkStr(member.c_str())},
+             &arena);
+  }
+
+  SECTION("SCAN returns every key") {
+    const auto keys = scan_all({bulkStr("SCAN")}, {});
+    REQUIRE(keys.size() == 201);
+    REQUIRE(keys.contains("set"));
+  }
+
+  SECTION("A call does bounded work") {
+    auto reply = dispatch(
+      store, {bulkStr("SCAN"), bulkStr("0"), bulkStr("COUNT"), bulkStr("5")},
+      &arena);
+    const auto &parts = asArray(reply);
+    REQUIRE(asBulk(parts[0]) != "0");
+    REQUIRE(asArray(parts[1]).size() < 50);
+  }
+
+  SECTION("MATCH and TYPE filter the reply") {
+    const auto matched =
+      scan_all({bulkStr("SCAN")}, {bulkStr("MATCH"), bulkStr("key:1?")});
+    REQUIRE(matched.size() == 10);
+    REQUIRE(matched.contains("key:15"));
+
+    const auto sets =
+      scan_all({bulkStr("SCAN")}, {bulkStr("TYPE"), bulkStr("set")});
+    REQUIRE(sets == std::set<std::string>{"set"});
+  }
+
+  SECTION("SSCAN walks the members") {
+    const auto members = scan_all({bulkStr("SSCAN"), bulkStr("set")},
+                                  {bulkStr("COUNT"), bulkStr("7")});
+    REQUIRE(members.size() == 200);
+
+    const auto matched = scan_all({bulkStr("SSCAN"), bulkStr("set")},
+                                  {bulkStr("MATCH"), bulkStr("m[1-2]0")});
+    REQUIRE(matched == std::set<std::string>{"m10", "m20"});
+  }
+
+  SECTION("Prefix patterns within COUNT use the key index in one call") {
+    dispatch(store,
+             {bulkStr("CONFIG"), bulkStr("SET"), bulkStr("key-index"),
+              bulkStr("yes")},
+             &arena);
+    auto reply = dispatch(store,
+                          {bulkStr("SCAN"), bulkStr("0"), bulkStr("MATCH"),
+                           bulkStr("key:1*"), bulkStr("COUNT"), bulkStr("111")},
+                          &arena);
+    const auto &parts = asArray(reply);
+    REQUIRE(asBulk(parts[0]) == "0");
+    REQUIRE(asArray(parts[1]).size() == 111);
+    REQUIRE(asBulk(asArray(parts[1])[0]) == "key:1");
+  }
+
+  SECTION("COUNT still bounds a prefix scan with the key index") {
+    dispatch(store,
+             {bulkStr("CONFIG"), bulkStr("SET"), bulkStr("key-index"),
+              bulkStr("yes")},
+             &arena);
+    auto reply = dispatch(store,
+                          {bulkStr("SCAN"), bulkStr("0"), bulkStr("MATCH"),
+                           bulkStr("key:1*"), bulkStr("COUNT"), bulkStr("20")},
+                          &arena);
+    const auto &parts = asArray(reply);
+    REQUIRE(asBulk(parts[0]) != "0");
+    REQUIRE(asArray(parts[1]).size() < 40);
+
+    const auto matched =
+      scan_all({bulkStr("SCAN")}, {bulkStr("MATCH"), bulkStr("key:1*"),
+                                   bulkStr("COUNT"), bulkStr("5")});
+    REQUIRE(matched.size() == 111);
+  }
+
+  SECTION("SSCAN on a missing key is an empty, finished scan") {
+    REQUIRE(scan_all({bulkStr("SSCAN"), bulkStr("nope")}, {}).empty());
+  }
+
+  SECTION("Bad arguments") {
+    REQUIRE(
+      isError(dispatch(store, {bulkStr("SCAN"), bulkStr("x")}, &arena)));
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("SCAN"), bulkStr("0"), bulkStr("COUNT"), bulkStr("0")},
+      &arena)));
+    REQUIRE(isError(
+      dispatch(store, {bulkStr("SCAN"), bulkStr("0"), bulkStr("MATCH")},
+               &arena)));
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("SSCAN"), bulkStr("key:1"), bulkStr("0")}, &arena)));
+  }
+}
+
+TEST_CASE("DELPREFIX command", "[commands]") {
+  std::array<std::byte, 4096> buf{};
+  std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
+  Storage store;
+  for (const auto *key :
+       {"tenant:1:a", "tenant:1:b", "tenant:2:a", "other"}) {
+    dispatch(store, {bulkStr("SET"), bulkStr(key), bulkStr("v")}, &arena);
+  }
+
+  SECTION("Without the index") {
+    auto result =
+      dispatch(store, {bulkStr("DELPREFIX"), bulkStr("tenant:1:")}, &arena);
+    REQUIRE(asInt(result) == 2);
+    REQUIRE(store.KeyCount() == 2);
+  }
+
+  SECTION("With the index") {
+    auto ok = dispatch(store,
+                       {bulkStr("CONFIG"), bulkStr("SET"),
+                        bulkStr("key-index"), bulkStr("yes")},
+                       &arena);
+    REQUIRE(asString(ok) == "OK");
+    auto result =
+      dispatch(store, {bulkStr("DELPREFIX"), bulkStr("tenant:")}, &arena);
+    REQUIRE(asInt(result) == 3);
+    REQUIRE(store.Exists("other"));
+    auto none =
+      dispatch(store, {bulkStr("DELPREFIX"), bulkStr("tenant:")}, &arena);
+    REQUIRE(asInt(none) == 0);
+  }
+
+  SECTION("Wrong arguments") {
+    REQUIRE(isError(dispatch(store, {bulkStr("DELPREFIX")}, &arena)));
+  }
 }
 
 TEST_CASE("FLUSHDB command", "[commands]") {
@@ -159,6 +403,42 @@ TEST_CASE("FLUSHDB command", "[commands]") {
     asArray(dispatch(store, {bulkStr("KEYS"), bulkStr("*")}, &arena)).empty());
 }
 
+TEST_CASE("UNLINK and FLUSHDB ASYNC", "[commands]") {
+  std::array<std::byte, 4096> buf{};
+  std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
+  Storage store;
+
+  dispatch(store, {bulkStr("SET"), bulkStr("a"), bulkStr("1")}, &arena);
+  dispatch(store, {bulkStr("SADD"), bulkStr("b"), bulkStr("x"), bulkStr("y")},
+           &arena);
+
+  SECTION("UNLINK removes keys like DEL") {
+    auto result = dispatch(
+      store, {bulkStr("UNLINK"), bulkStr("a"), bulkStr("b"), bulkStr("c")},
+      &arena);
+    REQUIRE(asInt(result) == 2);
+    REQUIRE(isNull(dispatch(store, {bulkStr("GET"), bulkStr("a")}, &arena)));
+  }
+
+  SECTION("FLUSHDB ASYNC and SYNC") {
+    auto result =
+      dispatch(store, {bulkStr("FLUSHDB"), bulkStr("async")}, &arena);
+    REQUIRE(asString(result) == "OK");
+    REQUIRE(asArray(dispatch(store, {bulkStr("KEYS"), bulkStr("*")}, &arena))
+              .empty());
+
+    dispatch(store, {bulkStr("SET"), bulkStr("a"), bulkStr("1")}, &arena);
+    result = dispatch(store, {bulkStr("FLUSHDB"), bulkStr("SYNC")}, &arena);
+    REQUIRE(asString(result) == "OK");
+    REQUIRE(isNull(dispatch(store, {bulkStr("GET"), bulkStr("a")}, &arena)));
+  }
+
+  SECTION("FLUSHDB rejects unknown modes") {
+    REQUIRE(isError(
+      dispatch(store, {bulkStr("FLUSHDB"), bulkStr("LATER")}, &arena)));
+  }
+}
+
 TEST_CASE("LPUSH and RPUSH commands", "[commands]") {
   std::array<std::byte, 4096> buf{};
   std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
@@ -239,6 +519,70 @@ TEST_CASE("LPOP and RPOP commands", "[commands]") {
   }
 }
 
+TEST_CASE("LMOVE and RPOPLPUSH commands", "[commands]") {
+  std::array<std::byte, 4096> buf{};
+  std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
+  Storage store;
+
+  dispatch(store,
+           {bulkStr("RPUSH"), bulkStr("pending"), bulkStr("a"), bulkStr("b"),
+            bulkStr("c")},
+           &arena);
+  auto element = [&](const char *key, const char *index) {
+    return std::string{
+      asBulk(dispatch(store, {bulkStr("LINDEX"), bulkStr(key), bulkStr(index)},
+                      &arena))};
+  };
+
+  SECTION("RPOPLPUSH moves the tail to the head") {
+    REQUIRE(asBulk(dispatch(store,
+                            {bulkStr("RPOPLPUSH"), bulkStr("pending"),
+                             bulkStr("processing")},
+                            &arena)) == "c");
+    REQUIRE(asBulk(dispatch(store,
+                            {bulkStr("RPOPLPUSH"), bulkStr("pending"),
+                             bulkStr("processing")},
+                            &arena)) == "b");
+    REQUIRE(element("processing", "0") == "b");
+    REQUIRE(asInt(dispatch(store, {bulkStr("LLEN"), bulkStr("pending")},
+                           &arena)) == 1);
+  }
+
+  SECTION("LMOVE picks both ends") {
+    REQUIRE(asBulk(dispatch(store,
+                            {bulkStr("LMOVE"), bulkStr("pending"),
+                             bulkStr("done"), bulkStr("left"),
+                             bulkStr("RIGHT")},
+                            &arena)) == "a");
+    REQUIRE(asBulk(dispatch(store,
+                            {bulkStr("LMOVE"), bulkStr("pending"),
+                             bulkStr("pending"), bulkStr("LEFT"),
+                             bulkStr("RIGHT")},
+                            &arena)) == "b");
+    REQUIRE(element("pending", "0") == "c");
+    REQUIRE(element("pending", "1") == "b");
+    REQUIRE(isError(dispatch(store,
+                             {bulkStr("LMOVE"), bulkStr("pending"),
+                              bulkStr("done"), bulkStr("UP"),
+                              bulkStr("LEFT")},
+                             &arena)));
+  }
+
+  SECTION("Missing sources and wrong types") {
+    REQUIRE(isNull(dispatch(
+      store, {bulkStr("RPOPLPUSH"), bulkStr("missing"), bulkStr("x")},
+      &arena)));
+    REQUIRE(asInt(dispatch(store, {bulkStr("TTL"), bulkStr("x")}, &arena)) ==
+            -2);
+    dispatch(store, {bulkStr("SET"), bulkStr("str"), bulkStr("v")}, &arena);
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("RPOPLPUSH"), bulkStr("pending"), bulkStr("str")},
+      &arena)));
+    REQUIRE(asInt(dispatch(store, {bulkStr("LLEN"), bulkStr("pending")},
+                           &arena)) == 3);
+  }
+}
+
 TEST_CASE("LLEN command", "[commands]") {
   std::array<std::byte, 4096> buf{};
   std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
@@ -314,6 +658,128 @@ TEST_CASE("LRANGE command", "[commands]") {
   }
 }
 
+TEST_CASE("Indexed list commands", "[commands]") {
+  std::array<std::byte, 4096> buf{};
+  std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
+  Storage store;
+
+  dispatch(store,
+           {bulkStr("RPUSH"), bulkStr("list"), bulkStr("a"), bulkStr("b"),
+            bulkStr("a"), bulkStr("c"), bulkStr("a")},
+           &arena);
+  auto range = [&] {
+    std::vector<std::string> elements;
+    const auto reply = dispatch(
+      store, {bulkStr("LRANGE"), bulkStr("list"), bulkStr("0"), bulkStr("-1")},
+      &arena);
+    for (const auto &e : asArray(reply)) {
+      elements.emplace_back(asBulk(e));
+    }
+    return elements;
+  };
+
+  SECTION("LINDEX and LSET address by position") {
+    REQUIRE(asBulk(dispatch(store,
+                            {bulkStr("LINDEX"), bulkStr("list"), bulkStr("1")},
+                            &arena)) == "b");
+    REQUIRE(asBulk(dispatch(store,
+                            {bulkStr("LINDEX"), bulkStr("list"),
+                             bulkStr("-2")},
+                            &arena)) == "c");
+    REQUIRE(isNull(dispatch(
+      store, {bulkStr("LINDEX"), bulkStr("list"), bulkStr("5")}, &arena)));
+
+    REQUIRE(asString(dispatch(store,
+                              {bulkStr("LSET"), bulkStr("list"),
+                               bulkStr("-1"), bulkStr("z")},
+                              &arena)) == "OK");
+    REQUIRE(range() ==
+            std::vector<std::string>{"a", "b", "a", "c", "z"});
+    REQUIRE(isError(dispatch(store,
+                             {bulkStr("LSET"), bulkStr("list"), bulkStr("9"),
+                              bulkStr("x")},
+                             &arena)));
+    REQUIRE(isError(dispatch(store,
+                             {bulkStr("LSET"), bulkStr("missing"),
+                              bulkStr("0"), bulkStr("x")},
+                             &arena)));
+  }
+
+  SECTION("LINSERT goes next to the first pivot") {
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("LINSERT"), bulkStr("list"),
+                            bulkStr("after"), bulkStr("a"), bulkStr("x")},
+                           &arena)) == 6);
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("LINSERT"), bulkStr("list"),
+                            bulkStr("BEFORE"), bulkStr("c"), bulkStr("y")},
+                           &arena)) == 7);
+    REQUIRE(range() ==
+            std::vector<std::string>{"a", "x", "b", "a", "y", "c", "a"});
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("LINSERT"), bulkStr("list"),
+                            bulkStr("BEFORE"), bulkStr("q"), bulkStr("y")},
+                           &arena)) == -1);
+    REQUIRE(isError(dispatch(store,
+                             {bulkStr("LINSERT"), bulkStr("list"),
+                              bulkStr("AROUND"), bulkStr("a"), bulkStr("y")},
+                             &arena)));
+  }
+
+  SECTION("LTRIM keeps a range") {
+    REQUIRE(asString(dispatch(store,
+                              {bulkStr("LTRIM"), bulkStr("list"),
+                               bulkStr("1"), bulkStr("-2")},
+                              &arena)) == "OK");
+    REQUIRE(range() == std::vector<std::string>{"b", "a", "c"});
+    dispatch(store,
+             {bulkStr("LTRIM"), bulkStr("list"), bulkStr("2"), bulkStr("1")},
+             &arena);
+    REQUIRE(range().empty());
+  }
+
+  SECTION("LREM removes from either end") {
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("LREM"), bulkStr("list"), bulkStr("-1"),
+                            bulkStr("a")},
+                           &arena)) == 1);
+    REQUIRE(range() == std::vector<std::string>{"a", "b", "a", "c"});
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("LREM"), bulkStr("list"), bulkStr("0"),
+                            bulkStr("a")},
+                           &arena)) == 2);
+    REQUIRE(range() == std::vector<std::string>{"b", "c"});
+  }
+
+  SECTION("LPOS with RANK, COUNT and MAXLEN") {
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("LPOS"), bulkStr("list"), bulkStr("a")},
+                           &arena)) == 0);
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("LPOS"), bulkStr("list"), bulkStr("a"),
+                            bulkStr("RANK"), bulkStr("-2")},
+                           &arena)) == 2);
+    const auto all = dispatch(store,
+                              {bulkStr("LPOS"), bulkStr("list"), bulkStr("a"),
+                               bulkStr("COUNT"), bulkStr("0")},
+                              &arena);
+    REQUIRE(asArray(all).size() == 3);
+    REQUIRE(asInt(asArray(all)[2]) == 4);
+    const auto near = dispatch(store,
+                               {bulkStr("LPOS"), bulkStr("list"), bulkStr("a"),
+                                bulkStr("COUNT"), bulkStr("0"),
+                                bulkStr("MAXLEN"), bulkStr("3")},
+                               &arena);
+    REQUIRE(asArray(near).size() == 2);
+    REQUIRE(isNull(dispatch(
+      store, {bulkStr("LPOS"), bulkStr("list"), bulkStr("q")}, &arena)));
+    REQUIRE(isError(dispatch(store,
+                             {bulkStr("LPOS"), bulkStr("list"), bulkStr("a"),
+                              bulkStr("RANK"), bulkStr("0")},
+                             &arena)));
+  }
+}
+
 TEST_CASE("SADD command", "[commands]") {
   std::array<std::byte, 4096> buf{};
   std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
@@ -473,6 +939,311 @@ TEST_CASE("SINTER command", "[commands]") {
     auto result = dispatch(store, {bulkStr("SINTER"), bulkStr("s1")}, &arena);
     REQUIRE(asArray(result).size() == 3);
   }
+
+  SECTION("Integer sets against either encoding") {
+    dispatch(store,
+             {bulkStr("SADD"), bulkStr("i1"), bulkStr("1"), bulkStr("2"),
+              bulkStr("300000")},
+             &arena);
+    dispatch(store,
+             {bulkStr("SADD"), bulkStr("i2"), bulkStr("300000"), bulkStr("2"),
+              bulkStr("z")},
+             &arena);
+    auto result = dispatch(
+      store, {bulkStr("SINTER"), bulkStr("i1"), bulkStr("i2")}, &arena);
+    const auto &arr = asArray(result);
+    REQUIRE(arr.size() == 2);
+    REQUIRE(asBulk(arr[0]) == "2");
+    REQUIRE(asBulk(arr[1]) == "300000");
+  }
+
+  SECTION("A wrong type fails even after a missing key") {
+    dispatch(store, {bulkStr("SET"), bulkStr("str"), bulkStr("v")}, &arena);
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("SINTER"), bulkStr("missing"), bulkStr("str")},
+      &arena)));
+  }
+}
+
+TEST_CASE("SINTERCARD and SINTERSTORE commands", "[commands]") {
+  std::array<std::byte, 4096> buf{};
+  std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
+  Storage store;
+
+  dispatch(store,
+           {bulkStr("SADD"), bulkStr("big"), bulkStr("a"), bulkStr("b"),
+            bulkStr("c"), bulkStr("d"), bulkStr("e")},
+           &arena);
+  dispatch(store, {bulkStr("SADD"), bulkStr("small"), bulkStr("e"),
+                   bulkStr("c"), bulkStr("z")},
+           &arena);
+
+  SECTION("SINTERCARD counts the intersection") {
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SINTERCARD"), bulkStr("2"),
+                            bulkStr("big"), bulkStr("small")},
+                           &arena)) == 2);
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SINTERCARD"), bulkStr("2"),
+                            bulkStr("big"), bulkStr("small"), bulkStr("LIMIT"),
+                            bulkStr("1")},
+                           &arena)) == 1);
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SINTERCARD"), bulkStr("1"),
+                            bulkStr("big"), bulkStr("limit"), bulkStr("0")},
+                           &arena)) == 5);
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SINTERCARD"), bulkStr("2"),
+                            bulkStr("big"), bulkStr("missing")},
+                           &arena)) == 0);
+  }
+
+  SECTION("SINTERCARD rejects bad arguments") {
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("SINTERCARD"), bulkStr("0"), bulkStr("big")}, &arena)));
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("SINTERCARD"), bulkStr("3"), bulkStr("big")}, &arena)));
+    REQUIRE(isError(dispatch(store,
+                             {bulkStr("SINTERCARD"), bulkStr("1"),
+                              bulkStr("big"), bulkStr("LIMIT"), bulkStr("-1")},
+                             &arena)));
+    REQUIRE(isError(dispatch(store,
+                             {bulkStr("SINTERCARD"), bulkStr("1"),
+                              bulkStr("big"), bulkStr("LIMIT")},
+                             &arena)));
+  }
+
+  SECTION("SINTERSTORE replaces the destination") {
+    dispatch(store, {bulkStr("SET"), bulkStr("dest"), bulkStr("v")}, &arena);
+    dispatch(store, {bulkStr("EXPIRE"), bulkStr("dest"), bulkStr("100")},
+             &arena);
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SINTERSTORE"), bulkStr("dest"),
+                            bulkStr("big"), bulkStr("small")},
+                           &arena)) == 2);
+    REQUIRE(asInt(dispatch(store, {bulkStr("SCARD"), bulkStr("dest")},
+                           &arena)) == 2);
+    REQUIRE(asInt(dispatch(store, {bulkStr("TTL"), bulkStr("dest")},
+                           &arena)) == -1);
+  }
+
+  SECTION("SINTERSTORE into one of its inputs") {
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SINTERSTORE"), bulkStr("big"),
+                            bulkStr("big"), bulkStr("small")},
+                           &arena)) == 2);
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SISMEMBER"), bulkStr("big"), bulkStr("e")},
+                           &arena)) == 1);
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SISMEMBER"), bulkStr("big"), bulkStr("a")},
+                           &arena)) == 0);
+  }
+
+  SECTION("An empty SINTERSTORE deletes the destination") {
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SINTERSTORE"), bulkStr("small"),
+                            bulkStr("small"), bulkStr("missing")},
+                           &arena)) == 0);
+    REQUIRE(asInt(dispatch(store, {bulkStr("TTL"), bulkStr("small")},
+                           &arena)) == -2);
+  }
+}
+
+TEST_CASE("SUNION and SDIFF commands", "[commands]") {
+  std::array<std::byte, 4096> buf{};
+  std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
+  Storage store;
+
+  dispatch(
+    store,
+    {bulkStr("SADD"), bulkStr("s1"), bulkStr("a"), bulkStr("b"), bulkStr("c")},
+    &arena);
+  dispatch(store,
+           {bulkStr("SADD"), bulkStr("s2"), bulkStr("c"), bulkStr("d")},
+           &arena);
+
+  SECTION("SUNION lists each member once") {
+    auto result = dispatch(
+      store, {bulkStr("SUNION"), bulkStr("s1"), bulkStr("missing"),
+              bulkStr("s2")},
+      &arena);
+    std::set<std::string> members;
+    for (const auto &m : asArray(result)) {
+      members.emplace(asBulk(m));
+    }
+    REQUIRE(members == std::set<std::string>{"a", "b", "c", "d"});
+    REQUIRE(asArray(result).size() == 4);
+  }
+
+  SECTION("SDIFF keeps what only the first set has") {
+    auto result = dispatch(
+      store, {bulkStr("SDIFF"), bulkStr("s1"), bulkStr("s2")}, &arena);
+    REQUIRE(asArray(result).size() == 2);
+    REQUIRE(asArray(dispatch(store,
+                             {bulkStr("SDIFF"), bulkStr("missing"),
+                              bulkStr("s1")},
+                             &arena))
+              .empty());
+  }
+
+  SECTION("Wrong types are errors") {
+    dispatch(store, {bulkStr("SET"), bulkStr("str"), bulkStr("v")}, &arena);
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("SUNION"), bulkStr("s1"), bulkStr("str")}, &arena)));
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("SDIFF"), bulkStr("missing"), bulkStr("str")}, &arena)));
+    REQUIRE(isError(dispatch(store, {bulkStr("SDIFFSTORE"), bulkStr("d")},
+                             &arena)));
+  }
+
+  SECTION("The STORE variants overwrite the destination") {
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SUNIONSTORE"), bulkStr("s1"),
+                            bulkStr("s1"), bulkStr("s2")},
+                           &arena)) == 4);
+    REQUIRE(asInt(dispatch(store, {bulkStr("SCARD"), bulkStr("s1")},
+                           &arena)) == 4);
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SDIFFSTORE"), bulkStr("d"), bulkStr("s1"),
+                            bulkStr("s2")},
+                           &arena)) == 2);
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SISMEMBER"), bulkStr("d"), bulkStr("a")},
+                           &arena)) == 1);
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SDIFFSTORE"), bulkStr("d"), bulkStr("s2"),
+                            bulkStr("s1")},
+                           &arena)) == 0);
+    REQUIRE(asInt(dispatch(store, {bulkStr("TTL"), bulkStr("d")}, &arena)) ==
+            -2);
+  }
+
+  SECTION("set-ops-threads is configurable") {
+    REQUIRE(asString(dispatch(store,
+                              {bulkStr("CONFIG"), bulkStr("SET"),
+                               bulkStr("set-ops-threads"), bulkStr("2")},
+                              &arena)) == "OK");
+    REQUIRE(store.WorkerThreads() == 2);
+    REQUIRE(isError(dispatch(store,
+                             {bulkStr("CONFIG"), bulkStr("SET"),
+                              bulkStr("set-ops-threads"), bulkStr("0")},
+                             &arena)));
+  }
+}
+
+TEST_CASE("SPOP, SRANDMEMBER and SMOVE commands", "[commands]") {
+  std::array<std::byte, 4096> buf{};
+  std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
+  Storage store;
+
+  // Strings past the listpack limit, so picks come from the dense array
+  std::set<std::string> all;
+  for (auto i = 0; i < 200; ++i) {
+    const auto member = "m" + std::to_string(i);
+    dispatch(store,
+             {bulkStr("SADD"), bulkStr("big"),
+              Type{BulkString{std::pmr::string{member}}}},
+             &arena);
+    all.insert(member);
+  }
+  dispatch(store,
+           {bulkStr("SADD"), bulkStr("ints"), bulkStr("1"), bulkStr("2"),
+            bulkStr("3")},
+           &arena);
+
+  auto distinct = [&](const Type &reply) {
+    std::set<std::string> members;
+    for (const auto &m : asArray(reply)) {
+      REQUIRE(all.contains(std::string{asBulk(m)}));
+      members.emplace(asBulk(m));
+    }
+    REQUIRE(members.size() == asArray(reply).size());
+    return members.size();
+  };
+
+  SECTION("SRANDMEMBER leaves the set alone") {
+    REQUIRE(all.contains(std::string{asBulk(dispatch(
+      store, {bulkStr("SRANDMEMBER"), bulkStr("big")}, &arena))}));
+    // Few picks retry duplicates; many shuffle positions
+    for (const char *count : {"5", "150", "200", "1000"}) {
+      const auto reply = dispatch(
+        store, {bulkStr("SRANDMEMBER"), bulkStr("big"), bulkStr(count)},
+        &arena);
+      REQUIRE(distinct(reply) == std::min<std::size_t>(std::stoul(count),
+                                                       200));
+    }
+    const auto repeats = dispatch(
+      store, {bulkStr("SRANDMEMBER"), bulkStr("ints"), bulkStr("-20")},
+      &arena);
+    REQUIRE(asArray(repeats).size() == 20);
+    REQUIRE(asInt(dispatch(store, {bulkStr("SCARD"), bulkStr("big")},
+                           &arena)) == 200);
+
+    REQUIRE(isNull(dispatch(
+      store, {bulkStr("SRANDMEMBER"), bulkStr("missing")}, &arena)));
+    REQUIRE(asArray(dispatch(store,
+                             {bulkStr("SRANDMEMBER"), bulkStr("big"),
+                              bulkStr("0")},
+                             &arena))
+              .empty());
+  }
+
+  SECTION("SPOP removes what it returns") {
+    const auto one =
+      std::string{asBulk(dispatch(store, {bulkStr("SPOP"), bulkStr("big")},
+                                  &arena))};
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SISMEMBER"), bulkStr("big"),
+                            Type{BulkString{std::pmr::string{one}}}},
+                           &arena)) == 0);
+    all.erase(one);
+
+    const auto some = dispatch(
+      store, {bulkStr("SPOP"), bulkStr("big"), bulkStr("50")}, &arena);
+    REQUIRE(distinct(some) == 50);
+    REQUIRE(asInt(dispatch(store, {bulkStr("SCARD"), bulkStr("big")},
+                           &arena)) == 149);
+
+    const auto rest = dispatch(
+      store, {bulkStr("SPOP"), bulkStr("ints"), bulkStr("10")}, &arena);
+    REQUIRE(asArray(rest).size() == 3);
+    REQUIRE(isNull(dispatch(store, {bulkStr("SPOP"), bulkStr("ints")},
+                            &arena)));
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("SPOP"), bulkStr("big"), bulkStr("-1")}, &arena)));
+  }
+
+  SECTION("SMOVE moves one member") {
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SMOVE"), bulkStr("ints"), bulkStr("dst"),
+                            bulkStr("2")},
+                           &arena)) == 1);
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SISMEMBER"), bulkStr("dst"),
+                            bulkStr("2")},
+                           &arena)) == 1);
+    REQUIRE(asInt(dispatch(store, {bulkStr("SCARD"), bulkStr("ints")},
+                           &arena)) == 2);
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SMOVE"), bulkStr("ints"), bulkStr("dst"),
+                            bulkStr("2")},
+                           &arena)) == 0);
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SMOVE"), bulkStr("ints"), bulkStr("ints"),
+                            bulkStr("1")},
+                           &arena)) == 1);
+
+    dispatch(store, {bulkStr("SET"), bulkStr("str"), bulkStr("v")}, &arena);
+    REQUIRE(isError(dispatch(store,
+                             {bulkStr("SMOVE"), bulkStr("ints"),
+                              bulkStr("str"), bulkStr("1")},
+                             &arena)));
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("SISMEMBER"), bulkStr("ints"),
+                            bulkStr("1")},
+                           &arena)) == 1);
+  }
 }
 
 TEST_CASE("EXPIRE and TTL commands", "[commands]") {
@@ -508,6 +1279,506 @@ TEST_CASE("EXPIRE and TTL commands", "[commands]") {
   }
 }
 
+TEST_CASE("SET options", "[commands]") {
+  std::array<std::byte, 4096> buf{};
+  std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
+  Storage store;
+
+  SECTION("NX only sets missing keys") {
+    auto r1 = dispatch(
+      store, {bulkStr("SET"), bulkStr("key"), bulkStr("v1"), bulkStr("nx")},
+      &arena);
+    REQUIRE(asString(r1) == "OK");
+    auto r2 = dispatch(
+      store, {bulkStr("SET"), bulkStr("key"), bulkStr("v2"), bulkStr("NX")},
+      &arena);
+    REQUIRE(isNull(r2));
+    REQUIRE(asBulk(dispatch(store, {bulkStr("GET"), bulkStr("key")}, &arena)) ==
+            "v1");
+  }
+
+  SECTION("XX only sets existing keys") {
+    auto r1 = dispatch(
+      store, {bulkStr("SET"), bulkStr("key"), bulkStr("v1"), bulkStr("XX")},
+      &arena);
+    REQUIRE(isNull(r1));
+    dispatch(store, {bulkStr("SET"), bulkStr("key"), bulkStr("v1")}, &arena);
+    auto r2 = dispatch(
+      store, {bulkStr("SET"), bulkStr("key"), bulkStr("v2"), bulkStr("XX")},
+      &arena);
+    REQUIRE(asString(r2) == "OK");
+  }
+
+  SECTION("GET returns the previous value") {
+    auto r1 = dispatch(
+      store, {bulkStr("SET"), bulkStr("key"), bulkStr("v1"), bulkStr("GET")},
+      &arena);
+    REQUIRE(isNull(r1));
+    auto r2 = dispatch(
+      store, {bulkStr("SET"), bulkStr("key"), bulkStr("v2"), bulkStr("GET")},
+      &arena);
+    REQUIRE(asBulk(r2) == "v1");
+  }
+
+  SECTION("EX and PX set a TTL atomically") {
+    dispatch(store,
+             {bulkStr("SET"), bulkStr("a"), bulkStr("v"), bulkStr("EX"),
+              bulkStr("100")},
+             &arena);
+    REQUIRE(asInt(dispatch(store, {bulkStr("TTL"), bulkStr("a")}, &arena)) ==
+            100);
+
+    dispatch(store,
+             {bulkStr("SET"), bulkStr("b"), bulkStr("v"), bulkStr("PX"),
+              bulkStr("1500")},
+             &arena);
+    auto pttl = asInt(dispatch(store, {bulkStr("PTTL"), bulkStr("b")}, &arena));
+    REQUIRE(pttl > 1000);
+    REQUIRE(pttl <= 1500);
+  }
+
+  SECTION("Plain SET clears the TTL, KEEPTTL keeps it") {
+    dispatch(store,
+             {bulkStr("SET"), bulkStr("key"), bulkStr("v"), bulkStr("EX"),
+              bulkStr("100")},
+             &arena);
+    dispatch(store,
+             {bulkStr("SET"), bulkStr("key"), bulkStr("v2"), bulkStr("KEEPTTL")},
+             &arena);
+    REQUIRE(asInt(dispatch(store, {bulkStr("TTL"), bulkStr("key")}, &arena)) >
+            0);
+    dispatch(store, {bulkStr("SET"), bulkStr("key"), bulkStr("v3")}, &arena);
+    REQUIRE(asInt(dispatch(store, {bulkStr("TTL"), bulkStr("key")}, &arena)) ==
+            -1);
+  }
+
+  SECTION("Conflicting or malformed options are rejected") {
+    REQUIRE(isError(dispatch(store,
+                             {bulkStr("SET"), bulkStr("k"), bulkStr("v"),
+                              bulkStr("NX"), bulkStr("XX")},
+                             &arena)));
+    REQUIRE(isError(dispatch(store,
+                             {bulkStr("SET"), bulkStr("k"), bulkStr("v"),
+                              bulkStr("EX"), bulkStr("10"), bulkStr("KEEPTTL")},
+                             &arena)));
+    REQUIRE(isError(dispatch(store,
+                             {bulkStr("SET"), bulkStr("k"), bulkStr("v"),
+                              bulkStr("EX"), bulkStr("0")},
+                             &arena)));
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("SET"), bulkStr("k"), bulkStr("v"), bulkStr("EX")},
+      &arena)));
+    REQUIRE(isNull(dispatch(store, {bulkStr("GET"), bulkStr("k")}, &arena)));
+  }
+}
+
+TEST_CASE("Millisecond expiry commands", "[commands]") {
+  std::array<std::byte, 4096> buf{};
+  std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
+  Storage store;
+
+  dispatch(store, {bulkStr("SET"), bulkStr("key"), bulkStr("val")}, &arena);
+
+  SECTION("PEXPIRE and PTTL") {
+    auto result = dispatch(
+      store, {bulkStr("PEXPIRE"), bulkStr("key"), bulkStr("2500")}, &arena);
+    REQUIRE(asInt(result) == 1);
+    auto pttl =
+      asInt(dispatch(store, {bulkStr("PTTL"), bulkStr("key")}, &arena));
+    REQUIRE(pttl > 2000);
+    REQUIRE(pttl <= 2500);
+    REQUIRE(asInt(dispatch(store, {bulkStr("PTTL"), bulkStr("missing")},
+                           &arena)) == -2);
+  }
+
+  SECTION("PEXPIREAT in the past expires the key") {
+    dispatch(store, {bulkStr("PEXPIREAT"), bulkStr("key"), bulkStr("1")},
+             &arena);
+    REQUIRE(isNull(dispatch(store, {bulkStr("GET"), bulkStr("key")}, &arena)));
+  }
+
+  SECTION("Negative times delete the key at once") {
+    REQUIRE(asInt(dispatch(store, {bulkStr("EXPIRE"), bulkStr("key"),
+                                   bulkStr("-1")},
+                           &arena)) == 1);
+    REQUIRE(isNull(dispatch(store, {bulkStr("GET"), bulkStr("key")}, &arena)));
+    REQUIRE(store.KeyCount() == 0);
+    REQUIRE(asInt(dispatch(store, {bulkStr("PEXPIRE"), bulkStr("key"),
+                                   bulkStr("-1")},
+                           &arena)) == 0);
+
+    dispatch(store, {bulkStr("SET"), bulkStr("key"), bulkStr("val")}, &arena);
+    REQUIRE(asInt(dispatch(store, {bulkStr("PEXPIRE"), bulkStr("key"),
+                                   bulkStr("-5000")},
+                           &arena)) == 1);
+    REQUIRE(store.KeyCount() == 0);
+  }
+
+  SECTION("Timestamps long past never make the key persistent") {
+    // Deadlines on the steady clock would come out as -1 (NO_EXPIRY) or
+    // below if they were not clamped
+    for (const auto *ts : {"0", "1", "-1", "-100000"}) {
+      dispatch(store, {bulkStr("SET"), bulkStr("key"), bulkStr("val")},
+               &arena);
+      REQUIRE(asInt(dispatch(
+                store, {bulkStr("PEXPIREAT"), bulkStr("key"), bulkStr(ts)},
+                &arena)) == 1);
+      REQUIRE(asInt(dispatch(store, {bulkStr("TTL"), bulkStr("key")},
+                             &arena)) == -2);
+    }
+    REQUIRE(Storage::DeadlineFromUnixMs(-detail::MAX_EXPIRE_MS) == 0);
+
+    dispatch(store, {bulkStr("SET"), bulkStr("key"), bulkStr("val")}, &arena);
+    REQUIRE(asBulk(dispatch(store,
+                            {bulkStr("GETEX"), bulkStr("key"), bulkStr("PXAT"),
+                             bulkStr("1")},
+                            &arena)) == "val");
+    REQUIRE(store.KeyCount() == 0);
+    dispatch(store,
+             {bulkStr("SET"), bulkStr("key"), bulkStr("val"), bulkStr("PXAT"),
+              bulkStr("1")},
+             &arena);
+    REQUIRE(isNull(dispatch(store, {bulkStr("GET"), bulkStr("key")}, &arena)));
+  }
+
+  SECTION("Out of range times are rejected") {
+    for (const auto *cmd : {"EXPIRE", "PEXPIRE", "PEXPIREAT"}) {
+      for (const auto *when : {"9223372036854775807", "-9223372036854775807"}) {
+        REQUIRE(isError(dispatch(
+          store, {bulkStr(cmd), bulkStr("key"), bulkStr(when)}, &arena)));
+      }
+    }
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("EXPIRE"), bulkStr("key"), bulkStr("x")}, &arena)));
+    REQUIRE(asInt(dispatch(store, {bulkStr("TTL"), bulkStr("key")}, &arena)) ==
+            -1);
+  }
+
+  SECTION("PERSIST removes the TTL") {
+    REQUIRE(asInt(dispatch(store, {bulkStr("PERSIST"), bulkStr("key")},
+                           &arena)) == 0);
+    dispatch(store, {bulkStr("EXPIRE"), bulkStr("key"), bulkStr("100")},
+             &arena);
+    REQUIRE(asInt(dispatch(store, {bulkStr("PERSIST"), bulkStr("key")},
+                           &arena)) == 1);
+    REQUIRE(asInt(dispatch(store, {bulkStr("TTL"), bulkStr("key")}, &arena)) ==
+            -1);
+  }
+
+  SECTION("GETEX reads and updates the TTL") {
+    auto r1 = dispatch(
+      store, {bulkStr("GETEX"), bulkStr("key"), bulkStr("EX"), bulkStr("50")},
+      &arena);
+    REQUIRE(asBulk(r1) == "val");
+    REQUIRE(asInt(dispatch(store, {bulkStr("TTL"), bulkStr("key")}, &arena)) ==
+            50);
+
+    auto r2 = dispatch(
+      store, {bulkStr("GETEX"), bulkStr("key"), bulkStr("PERSIST")}, &arena);
+    REQUIRE(asBulk(r2) == "val");
+    REQUIRE(asInt(dispatch(store, {bulkStr("TTL"), bulkStr("key")}, &arena)) ==
+            -1);
+
+    REQUIRE(isNull(
+      dispatch(store, {bulkStr("GETEX"), bulkStr("missing")}, &arena)));
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("GETEX"), bulkStr("key"), bulkStr("BOGUS")}, &arena)));
+  }
+}
+
+TEST_CASE("CONFIG and maxmemory", "[commands]") {
+  std::array<std::byte, 4096> buf{};
+  std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
+  Storage store;
+
+  SECTION("CONFIG GET returns name/value pairs") {
+    auto result = dispatch(
+      store, {bulkStr("CONFIG"), bulkStr("GET"), bulkStr("maxmemory")}, &arena);
+    const auto &arr = asArray(result);
+    REQUIRE(arr.size() == 2);
+    REQUIRE(asBulk(arr[0]) == "maxmemory");
+    REQUIRE(asBulk(arr[1]) == "0");
+  }
+
+  SECTION("CONFIG SET parses units and policies") {
+    auto r1 = dispatch(store,
+                       {bulkStr("CONFIG"), bulkStr("SET"), bulkStr("maxmemory"),
+                        bulkStr("2mb")},
+                       &arena);
+    REQUIRE(asString(r1) == "OK");
+    REQUIRE(store.MaxMemory() == 2 * 1024 * 1024);
+
+    auto r2 = dispatch(store,
+                       {bulkStr("CONFIG"), bulkStr("SET"),
+                        bulkStr("maxmemory-policy"), bulkStr("allkeys-lru")},
+                       &arena);
+    REQUIRE(asString(r2) == "OK");
+    REQUIRE(store.GetEvictionPolicy() == Storage::EvictionPolicy::AllKeysLru);
+
+    REQUIRE(isError(dispatch(store,
+                             {bulkStr("CONFIG"), bulkStr("SET"),
+                              bulkStr("maxmemory-policy"), bulkStr("bogus")},
+                             &arena)));
+    REQUIRE(isError(dispatch(store,
+                             {bulkStr("CONFIG"), bulkStr("SET"),
+                              bulkStr("nonsense"), bulkStr("1")},
+                             &arena)));
+  }
+
+  SECTION("Writes are refused over the limit under noeviction") {
+    dispatch(store, {bulkStr("SET"), bulkStr("key"), bulkStr("value")}, &arena);
+    store.SetMaxMemory(1);
+
+    REQUIRE(isError(
+      dispatch(store, {bulkStr("SET"), bulkStr("k2"), bulkStr("v")}, &arena)));
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("RPUSH"), bulkStr("list"), bulkStr("a")}, &arena)));
+    // Reads and deletions still work
+    REQUIRE(asBulk(dispatch(store, {bulkStr("GET"), bulkStr("key")}, &arena)) ==
+            "value");
+    REQUIRE(
+      asInt(dispatch(store, {bulkStr("DEL"), bulkStr("key")}, &arena)) == 1);
+  }
+}
+
+TEST_CASE("OBJECT command", "[commands]") {
+  std::array<std::byte, 4096> buf{};
+  std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
+  Storage store;
+
+  dispatch(store, {bulkStr("SET"), bulkStr("key"), bulkStr("v")}, &arena);
+
+  SECTION("FREQ requires an LFU policy") {
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("OBJECT"), bulkStr("FREQ"), bulkStr("key")}, &arena)));
+
+    dispatch(store,
+             {bulkStr("CONFIG"), bulkStr("SET"), bulkStr("maxmemory-policy"),
+              bulkStr("volatile-lfu")},
+             &arena);
+    auto result = dispatch(
+      store, {bulkStr("OBJECT"), bulkStr("FREQ"), bulkStr("key")}, &arena);
+    REQUIRE(asInt(result) >= 0);
+    REQUIRE(isNull(dispatch(
+      store, {bulkStr("OBJECT"), bulkStr("FREQ"), bulkStr("missing")}, &arena)));
+  }
+
+  SECTION("IDLETIME under LRU") {
+    auto result = dispatch(
+      store, {bulkStr("OBJECT"), bulkStr("IDLETIME"), bulkStr("key")}, &arena);
+    REQUIRE(asInt(result) == 0);
+  }
+
+  SECTION("ENCODING") {
+    dispatch(store, {bulkStr("SET"), bulkStr("n"), bulkStr("-15")}, &arena);
+    REQUIRE(asBulk(dispatch(
+              store, {bulkStr("OBJECT"), bulkStr("ENCODING"), bulkStr("n")},
+              &arena)) == "int");
+    REQUIRE(asBulk(dispatch(
+              store, {bulkStr("OBJECT"), bulkStr("ENCODING"), bulkStr("key")},
+              &arena)) == "raw");
+    REQUIRE(isNull(dispatch(
+      store, {bulkStr("OBJECT"), bulkStr("ENCODING"), bulkStr("missing")},
+      &arena)));
+  }
+
+  SECTION("ENCODING of lists") {
+    dispatch(store, {bulkStr("RPUSH"), bulkStr("l"), bulkStr("a")}, &arena);
+    REQUIRE(asBulk(dispatch(
+              store, {bulkStr("OBJECT"), bulkStr("ENCODING"), bulkStr("l")},
+              &arena)) == "listpack");
+    for (auto i = 0; i < 200; ++i) {
+      dispatch(store, {bulkStr("RPUSH"), bulkStr("l"), bulkStr("x")}, &arena);
+    }
+    REQUIRE(asBulk(dispatch(
+              store, {bulkStr("OBJECT"), bulkStr("ENCODING"), bulkStr("l")},
+              &arena)) == "quicklist");
+    auto range = dispatch(
+      store, {bulkStr("LRANGE"), bulkStr("l"), bulkStr("0"), bulkStr("1")},
+      &arena);
+    REQUIRE(asBulk(asArray(range)[0]) == "a");
+  }
+
+  SECTION("ENCODING of sets") {
+    dispatch(store, {bulkStr("SADD"), bulkStr("s"), bulkStr("1"), bulkStr("2")},
+             &arena);
+    REQUIRE(asBulk(dispatch(
+              store, {bulkStr("OBJECT"), bulkStr("ENCODING"), bulkStr("s")},
+              &arena)) == "intset");
+    REQUIRE(asInt(dispatch(
+              store, {bulkStr("SISMEMBER"), bulkStr("s"), bulkStr("2")},
+              &arena)) == 1);
+    dispatch(store, {bulkStr("SADD"), bulkStr("s"), bulkStr("x")}, &arena);
+    REQUIRE(asBulk(dispatch(
+              store, {bulkStr("OBJECT"), bulkStr("ENCODING"), bulkStr("s")},
+              &arena)) == "listpack");
+    const std::string long_member(100, 'y');
+    dispatch(store,
+             {bulkStr("SADD"), bulkStr("s"), bulkStr(long_member.c_str())},
+             &arena);
+    REQUIRE(asBulk(dispatch(
+              store, {bulkStr("OBJECT"), bulkStr("ENCODING"), bulkStr("s")},
+              &arena)) == "hashtable");
+    REQUIRE(asArray(dispatch(store, {bulkStr("SMEMBERS"), bulkStr("s")},
+                             &arena))
+              .size() == 4);
+  }
+
+  SECTION("ENCODING of shared values") {
+    dispatch(store,
+             {bulkStr("CONFIG"), bulkStr("SET"), bulkStr("shared-values"),
+              bulkStr("yes")},
+             &arena);
+    for (const auto *key : {"a", "b"}) {
+      dispatch(store,
+               {bulkStr("SET"), bulkStr(key),
+                bulkStr("a value long enough to share")},
+               &arena);
+    }
+    REQUIRE(asBulk(dispatch(
+              store, {bulkStr("OBJECT"), bulkStr("ENCODING"), bulkStr("b")},
+              &arena)) == "shared");
+    REQUIRE(asBulk(dispatch(store, {bulkStr("GET"), bulkStr("b")}, &arena)) ==
+            "a value long enough to share");
+  }
+}
+
+TEST_CASE("MEMORY and INFO commands", "[commands]") {
+  std::array<std::byte, 4096> buf{};
+  std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
+  Storage store;
+
+  dispatch(store, {bulkStr("SET"), bulkStr("key"), bulkStr("value")}, &arena);
+
+  SECTION("MEMORY USAGE") {
+    auto result = dispatch(
+      store, {bulkStr("MEMORY"), bulkStr("USAGE"), bulkStr("key")}, &arena);
+    REQUIRE(asInt(result) > 0);
+
+    result = dispatch(store,
+                      {bulkStr("MEMORY"), bulkStr("USAGE"), bulkStr("key"),
+                       bulkStr("SAMPLES"), bulkStr("0")},
+                      &arena);
+    REQUIRE(asInt(result) > 0);
+
+    REQUIRE(isNull(dispatch(
+      store, {bulkStr("MEMORY"), bulkStr("USAGE"), bulkStr("missing")},
+      &arena)));
+    REQUIRE(isError(dispatch(store,
+                             {bulkStr("MEMORY"), bulkStr("USAGE"),
+                              bulkStr("key"), bulkStr("FOO"), bulkStr("1")},
+                             &arena)));
+  }
+
+  SECTION("MEMORY STATS") {
+    auto result =
+      dispatch(store, {bulkStr("MEMORY"), bulkStr("STATS")}, &arena);
+    const auto &arr = asArray(result);
+    REQUIRE(arr.size() % 2 == 0);
+    REQUIRE(asBulk(arr[0]) == "peak.allocated");
+    REQUIRE(asBulk(arr[6]) == "keys.count");
+    REQUIRE(asInt(arr[7]) == 1);
+  }
+
+  SECTION("Unknown MEMORY subcommand") {
+    REQUIRE(
+      isError(dispatch(store, {bulkStr("MEMORY"), bulkStr("DOCTOR")}, &arena)));
+  }
+
+  SECTION("INFO memory") {
+    auto result = dispatch(store, {bulkStr("INFO"), bulkStr("memory")}, &arena);
+    const std::string_view info{asBulk(result)};
+    REQUIRE(info.starts_with("# Memory\r\n"));
+    REQUIRE(info.find("used_memory:") != std::string_view::npos);
+    REQUIRE(info.find("maxmemory_policy:noeviction") != std::string_view::npos);
+    REQUIRE(info.find("# Keyspace") == std::string_view::npos);
+  }
+
+  SECTION("INFO without arguments reports every section") {
+    auto result = dispatch(store, {bulkStr("INFO")}, &arena);
+    const std::string_view info{asBulk(result)};
+    REQUIRE(info.find("# Memory") != std::string_view::npos);
+    REQUIRE(info.find("# Stats") != std::string_view::npos);
+    REQUIRE(info.find("db0:keys=1,expires=0") != std::string_view::npos);
+  }
+}
+
+TEST_CASE("SELECT, SWAPDB, MOVE and DBSIZE commands", "[commands]") {
+  std::array<std::byte, 4096> buf{};
+  std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
+  Storage store;
+
+  dispatch(store, {bulkStr("SET"), bulkStr("key"), bulkStr("zero")}, &arena);
+  REQUIRE(asString(dispatch(store, {bulkStr("SELECT"), bulkStr("1")},
+                            &arena)) == "OK");
+  REQUIRE(asInt(dispatch(store, {bulkStr("DBSIZE")}, &arena)) == 0);
+  dispatch(store, {bulkStr("SET"), bulkStr("key"), bulkStr("one")}, &arena);
+  dispatch(store, {bulkStr("SET"), bulkStr("only"), bulkStr("one")}, &arena);
+  REQUIRE(asInt(dispatch(store, {bulkStr("DBSIZE")}, &arena)) == 2);
+
+  SECTION("SELECT") {
+    REQUIRE(isError(dispatch(store, {bulkStr("SELECT"), bulkStr("16")},
+                             &arena)));
+    REQUIRE(isError(dispatch(store, {bulkStr("SELECT"), bulkStr("-1")},
+                             &arena)));
+    REQUIRE(isError(dispatch(store, {bulkStr("SELECT"), bulkStr("x")},
+                             &arena)));
+    REQUIRE(isError(dispatch(store, {bulkStr("SELECT")}, &arena)));
+    dispatch(store, {bulkStr("SELECT"), bulkStr("0")}, &arena);
+    REQUIRE(asBulk(dispatch(store, {bulkStr("GET"), bulkStr("key")},
+                            &arena)) == "zero");
+  }
+
+  SECTION("SWAPDB") {
+    REQUIRE(asString(dispatch(store,
+                              {bulkStr("SWAPDB"), bulkStr("0"), bulkStr("1")},
+                              &arena)) == "OK");
+    REQUIRE(asBulk(dispatch(store, {bulkStr("GET"), bulkStr("key")},
+                            &arena)) == "zero");
+    REQUIRE(asInt(dispatch(store, {bulkStr("DBSIZE")}, &arena)) == 1);
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("SWAPDB"), bulkStr("0"), bulkStr("99")}, &arena)));
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("SWAPDB"), bulkStr("a"), bulkStr("1")}, &arena)));
+  }
+
+  SECTION("MOVE") {
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("MOVE"), bulkStr("only"), bulkStr("0")},
+                           &arena)) == 1);
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("MOVE"), bulkStr("key"), bulkStr("0")},
+                           &arena)) == 0);
+    REQUIRE(asInt(dispatch(store,
+                           {bulkStr("MOVE"), bulkStr("missing"), bulkStr("0")},
+                           &arena)) == 0);
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("MOVE"), bulkStr("key"), bulkStr("1")}, &arena)));
+    REQUIRE(isError(dispatch(
+      store, {bulkStr("MOVE"), bulkStr("key"), bulkStr("16")}, &arena)));
+    REQUIRE(asInt(dispatch(store, {bulkStr("DBSIZE")}, &arena)) == 1);
+
+    dispatch(store, {bulkStr("SELECT"), bulkStr("0")}, &arena);
+    REQUIRE(asBulk(dispatch(store, {bulkStr("GET"), bulkStr("only")},
+                            &arena)) == "one");
+  }
+
+  SECTION("INFO keyspace and FLUSHALL") {
+    auto result =
+      dispatch(store, {bulkStr("INFO"), bulkStr("keyspace")}, &arena);
+    const std::string_view info{asBulk(result)};
+    REQUIRE(info.find("db0:keys=1,expires=0") != std::string_view::npos);
+    REQUIRE(info.find("db1:keys=2,expires=0") != std::string_view::npos);
+
+    REQUIRE(asString(dispatch(store, {bulkStr("FLUSHALL"), bulkStr("ASYNC")},
+                              &arena)) == "OK");
+    REQUIRE(asInt(dispatch(store, {bulkStr("DBSIZE")}, &arena)) == 0);
+    dispatch(store, {bulkStr("SELECT"), bulkStr("0")}, &arena);
+    REQUIRE(asInt(dispatch(store, {bulkStr("DBSIZE")}, &arena)) == 0);
+    store.WaitForLazyFree();
+  }
+}
+
 TEST_CASE("Unknown command", "[commands]") {
   std::array<std::byte, 4096> buf{};
   std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
@@ -546,3 +1817,70 @@ TEST_CASE("Wrong type across operations", "[commands]") {
       isError(dispatch(store, {bulkStr("LLEN"), bulkStr("set")}, &arena)));
   }
 }
+
+TEST_CASE("Read-only command forms", "[commands]") {
+  std::array<std::byte, 4096> buf{};
+  std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size()};
+  Storage store;
+  dispatch(store, {bulkStr("SET"), bulkStr("str"), bulkStr("value")}, &arena);
+  dispatch(store, {bulkStr("RPUSH"), bulkStr("list"), bulkStr("a"),
+                   bulkStr("b"), bulkStr("c")},
+           &arena);
+  dispatch(store, {bulkStr("SADD"), bulkStr("set"), bulkStr("m")}, &arena);
+  dispatch(store, {bulkStr("EXPIRE"), bulkStr("set"), bulkStr("100")},
+           &arena);
+
+  // Every read form answers exactly like the command it stands in for
+  const std::vector<std::vector<Type>> commands{
+    {bulkStr("GET"), bulkStr("str")},
+    {bulkStr("GET"), bulkStr("list")},
+    {bulkStr("GET"), bulkStr("missing")},
+    {bulkStr("GET")},
+    {bulkStr("LRANGE"), bulkStr("list"), bulkStr("1"), bulkStr("-1")},
+    {bulkStr("LRANGE"), bulkStr("str"), bulkStr("0"), bulkStr("-1")},
+    {bulkStr("LRANGE"), bulkStr("list"), bulkStr("x"), bulkStr("1")},
+    {bulkStr("SISMEMBER"), bulkStr("set"), bulkStr("m")},
+    {bulkStr("SISMEMBER"), bulkStr("set"), bulkStr("n")},
+    {bulkStr("TTL"), bulkStr("set")},
+    {bulkStr("PTTL"), bulkStr("str")},
+    {bulkStr("PTTL"), bulkStr("missing")},
+  };
+  for (const auto &command : commands) {
+    const auto &name = std::get<BulkString>(command[0]).value;
+    const auto read = COMMANDS.FindReader(name);
+    REQUIRE(read);
+    std::span<const Type> args{command.data() + 1, command.size() - 1};
+    Storage::Reader reader{store, store.SelectedDb()};
+    const auto expected = COMMANDS.Dispatch(name, args, store, &arena);
+    const auto actual = read(args, reader, &arena);
+    REQUIRE(actual.index() == expected.index());
+    if (const auto *array = std::get_if<Array>(&expected)) {
+      REQUIRE(asArray(actual).size() == array->value.size());
+    } else if (const auto *bulk = std::get_if<BulkString>(&expected)) {
+      REQUIRE(asBulk(actual) == bulk->value);
+    } else if (const auto *integer = std::get_if<Int>(&expected)) {
+      // TTLs may tick over between the two
+      REQUIRE(asInt(actual) <= integer->value);
+      REQUIRE(asInt(actual) >= integer->value - 1);
+    }
+  }
+
+  REQUIRE_FALSE(COMMANDS.FindReader("SET"));
+  REQUIRE_FALSE(COMMANDS.FindReader("FOOBAR"));
+
+  SECTION("CONFIG read-threads") {
+    REQUIRE(asString(dispatch(store,
+                              {bulkStr("CONFIG"), bulkStr("SET"),
+                               bulkStr("read-threads"), bulkStr("4")},
+                              &arena)) == "OK");
+    REQUIRE(store.ReadThreads() == 4);
+    REQUIRE(isError(dispatch(store,
+                             {bulkStr("CONFIG"), bulkStr("SET"),
+                              bulkStr("read-threads"), bulkStr("0")},
+                             &arena)));
+    auto result = dispatch(
+      store, {bulkStr("CONFIG"), bulkStr("GET"), bulkStr("read-threads")},
+      &arena);
+    REQUIRE(asBulk(asArray(result)[1]) == "4");
+  }
+}
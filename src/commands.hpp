@@ -1,10 +1,18 @@
 #pragma once
 
 #include "command_handler.hpp"
+#include "set_ops.hpp"
 
 #include <algorithm>
+#include <cctype>
 #include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
 #include <string>
+#include <type_traits>
+#include <unordered_set>
 
 namespace detail {
 
@@ -32,6 +40,29 @@ inline resp::Type ErrorNotInteger(std::pmr::memory_resource *arena) {
   return resp::Error{std::pmr::string{"ERR value is not an integer", arena}};
 }
 
+inline resp::Type ErrorOverflow(std::pmr::memory_resource *arena) {
+  return resp::Error{
+    std::pmr::string{"ERR increment or decrement would overflow", arena}};
+}
+
+inline resp::Type ErrorNotFloat(std::pmr::memory_resource *arena) {
+  return resp::Error{std::pmr::string{"ERR value is not a valid float", arena}};
+}
+
+inline resp::Type ErrorSyntax(std::pmr::memory_resource *arena) {
+  return resp::Error{std::pmr::string{"ERR syntax error", arena}};
+}
+
+inline resp::Type ErrorInvalidExpire(std::string_view cmd,
+                                     std::pmr::memory_resource *arena) {
+  std::pmr::string msg{arena};
+  msg.reserve(40 + cmd.size());
+  msg += "ERR invalid expire time in '";
+  msg += cmd;
+  msg += "' command";
+  return resp::Error{std::move(msg)};
+}
+
 inline resp::Type Ok(std::pmr::memory_resource *arena) {
   return resp::String{std::pmr::string{"OK", arena}};
 }
@@ -41,8 +72,9 @@ inline const std::pmr::string *AsBulkString(const resp::Type &t) {
   return bs ? &bs->value : nullptr;
 }
 
-inline std::optional<int> ParseInt(std::string_view sv) {
-  auto val = 0;
+template <typename T = int>
+inline std::optional<T> ParseInt(std::string_view sv) {
+  T val{};
   auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), val);
   if (ec != std::errc{} || ptr != sv.data() + sv.size()) {
     return std::nullopt;
@@ -50,51 +82,1106 @@ inline std::optional<int> ParseInt(std::string_view sv) {
   return val;
 }
 
+inline bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+  return std::ranges::equal(a, b, [](char x, char y) {
+    return std::tolower(static_cast<unsigned char>(x)) ==
+           std::tolower(static_cast<unsigned char>(y));
+  });
+}
+
+enum class ExpiryUnit : std::uint8_t { Seconds, Millis, UnixSeconds, UnixMillis };
+
+inline std::optional<ExpiryUnit> ParseExpiryUnit(std::string_view sv) {
+  if (EqualsIgnoreCase(sv, "EX")) {
+    return ExpiryUnit::Seconds;
+  }
+  if (EqualsIgnoreCase(sv, "PX")) {
+    return ExpiryUnit::Millis;
+  }
+  if (EqualsIgnoreCase(sv, "EXAT")) {
+    return ExpiryUnit::UnixSeconds;
+  }
+  if (EqualsIgnoreCase(sv, "PXAT")) {
+    return ExpiryUnit::UnixMillis;
+  }
+  return std::nullopt;
+}
+
+// Bound on expire arguments in ms, relative or absolute, so that deadlines
+// computed from them cannot overflow
+inline constexpr auto MAX_EXPIRE_MS =
+  std::numeric_limits<std::int64_t>::max() / 4;
+
+// Turns the argument of EX/PX/EXAT/PXAT into an absolute Storage deadline;
+// nullopt unless it is a positive integer in range.
+inline std::optional<std::int64_t> ParseDeadline(ExpiryUnit unit,
+                                                 std::string_view sv) {
+  auto val = ParseInt<std::int64_t>(sv);
+  if (!val || *val <= 0) {
+    return std::nullopt;
+  }
+
+  const bool seconds =
+    unit == ExpiryUnit::Seconds || unit == ExpiryUnit::UnixSeconds;
+  if (*val > (seconds ? MAX_EXPIRE_MS / 1000 : MAX_EXPIRE_MS)) {
+    return std::nullopt;
+  }
+  const auto ms = seconds ? *val * 1000 : *val;
+
+  switch (unit) {
+  case ExpiryUnit::Seconds:
+  case ExpiryUnit::Millis:
+    return Storage::NowMs() + ms;
+  case ExpiryUnit::UnixSeconds:
+  case ExpiryUnit::UnixMillis:
+    return Storage::DeadlineFromUnixMs(ms);
+  }
+  return std::nullopt;
+}
+
+// Sets `key` to expire at `deadline_ms`. A deadline that is already due
+// deletes the key at once, as in Redis. False if the key is missing.
+inline bool ExpireAt(Storage &store, std::string_view key,
+                     std::int64_t deadline_ms) {
+  if (deadline_ms <= Storage::NowMs()) {
+    return store.Exists(key) && store.Erase(key);
+  }
+  return store.SetDeadline(key, deadline_ms);
+}
+
+// Accepts plain bytes or a k/kb/m/mb/g/gb suffix, like redis.conf
+inline std::optional<std::size_t> ParseMemory(std::string_view sv) {
+  constexpr std::array<std::pair<std::string_view, std::size_t>, 6> UNITS{{
+    {"KB", std::size_t{1} << 10},
+    {"MB", std::size_t{1} << 20},
+    {"GB", std::size_t{1} << 30},
+    {"K", 1000},
+    {"M", 1000 * 1000},
+    {"G", 1000 * 1000 * 1000},
+  }};
+
+  std::size_t multiplier = 1;
+  for (const auto &[suffix, mul] : UNITS) {
+    if (sv.size() > suffix.size() &&
+        EqualsIgnoreCase(sv.substr(sv.size() - suffix.size()), suffix)) {
+      sv.remove_suffix(suffix.size());
+      multiplier = mul;
+      break;
+    }
+  }
+
+  auto val = ParseInt<std::size_t>(sv);
+  if (!val || *val > std::numeric_limits<std::size_t>::max() / multiplier) {
+    return std::nullopt;
+  }
+  return *val * multiplier;
+}
+
+inline constexpr std::array<std::pair<std::string_view, Storage::EvictionPolicy>,
+                            5>
+  EVICTION_POLICIES{{
+    {"noeviction", Storage::EvictionPolicy::NoEviction},
+    {"allkeys-lru", Storage::EvictionPolicy::AllKeysLru},
+    {"volatile-lru", Storage::EvictionPolicy::VolatileLru},
+    {"allkeys-lfu", Storage::EvictionPolicy::AllKeysLfu},
+    {"volatile-lfu", Storage::EvictionPolicy::VolatileLfu},
+  }};
+
+inline std::string_view PolicyName(Storage::EvictionPolicy policy) {
+  for (const auto &[name, value] : EVICTION_POLICIES) {
+    if (value == policy) {
+      return name;
+    }
+  }
+  return {};
+}
+
+inline std::pmr::string FormatInt(std::int64_t val,
+                                  std::pmr::memory_resource *arena) {
+  std::array<char, 24> buf{};
+  auto [ptr, _] = std::to_chars(buf.data(), buf.data() + buf.size(), val);
+  return std::pmr::string{buf.data(), ptr, arena};
+}
+
+inline std::optional<bool> ParseYesNo(std::string_view sv) {
+  if (EqualsIgnoreCase(sv, "yes")) {
+    return true;
+  }
+  if (EqualsIgnoreCase(sv, "no")) {
+    return false;
+  }
+  return std::nullopt;
+}
+
+struct ConfigParam {
+  std::string_view name;
+  std::pmr::string (*get)(const Storage &, std::pmr::memory_resource *);
+  bool (*set)(Storage &, std::string_view);
+};
+
+inline constexpr std::array CONFIG_PARAMS{
+  ConfigParam{
+    .name = "maxmemory",
+    .get = [](const Storage &store, std::pmr::memory_resource *arena) {
+      return FormatInt(static_cast<std::int64_t>(store.MaxMemory()), arena);
+    },
+    .set = [](Storage &store, std::string_view value) {
+      auto bytes = ParseMemory(value);
+      if (!bytes) {
+        return false;
+      }
+      store.SetMaxMemory(*bytes);
+      return true;
+    }},
+  ConfigParam{
+    .name = "maxmemory-policy",
+    .get = [](const Storage &store, std::pmr::memory_resource *arena) {
+      return std::pmr::string{PolicyName(store.GetEvictionPolicy()), arena};
+    },
+    .set = [](Storage &store, std::string_view value) {
+      for (const auto &[name, policy] : EVICTION_POLICIES) {
+        if (EqualsIgnoreCase(name, value)) {
+          store.SetEvictionPolicy(policy);
+          return true;
+        }
+      }
+      return false;
+    }},
+  ConfigParam{
+    .name = "lfu-log-factor",
+    .get = [](const Storage &store, std::pmr::memory_resource *arena) {
+      return FormatInt(store.LfuLogFactor(), arena);
+    },
+    .set = [](Storage &store, std::string_view value) {
+      auto factor = ParseInt(value);
+      if (!factor || *factor < 0) {
+        return false;
+      }
+      store.SetLfuLogFactor(*factor);
+      return true;
+    }},
+  ConfigParam{
+    .name = "lfu-decay-time",
+    .get = [](const Storage &store, std::pmr::memory_resource *arena) {
+      return FormatInt(store.LfuDecayTime(), arena);
+    },
+    .set = [](Storage &store, std::string_view value) {
+      auto minutes = ParseInt(value);
+      if (!minutes || *minutes < 0) {
+        return false;
+      }
+      store.SetLfuDecayTime(*minutes);
+      return true;
+    }},
+  ConfigParam{
+    .name = "activedefrag",
+    .get = [](const Storage &store, std::pmr::memory_resource *arena) {
+      return std::pmr::string{store.ActiveDefragEnabled() ? "yes" : "no",
+                              arena};
+    },
+    .set = [](Storage &store, std::string_view value) {
+      auto enabled = ParseYesNo(value);
+      if (!enabled) {
+        return false;
+      }
+      store.SetActiveDefragEnabled(*enabled);
+      return true;
+    }},
+  ConfigParam{
+    .name = "active-defrag-ignore-bytes",
+    .get = [](const Storage &store, std::pmr::memory_resource *arena) {
+      return FormatInt(static_cast<std::int64_t>(store.DefragIgnoreBytes()),
+                       arena);
+    },
+    .set = [](Storage &store, std::string_view value) {
+      auto bytes = ParseMemory(value);
+      if (!bytes) {
+        return false;
+      }
+      store.SetDefragIgnoreBytes(*bytes);
+      return true;
+    }},
+  ConfigParam{
+    .name = "active-defrag-threshold-lower",
+    .get = [](const Storage &store, std::pmr::memory_resource *arena) {
+      return FormatInt(store.DefragThresholdLower(), arena);
+    },
+    .set = [](Storage &store, std::string_view value) {
+      auto percent = ParseInt(value);
+      if (!percent || *percent < 0 || *percent > 1000) {
+        return false;
+      }
+      store.SetDefragThresholdLower(*percent);
+      return true;
+    }},
+  ConfigParam{
+    .name = "key-index",
+    .get = [](const Storage &store, std::pmr::memory_resource *arena) {
+      return std::pmr::string{store.KeyIndexEnabled() ? "yes" : "no", arena};
+    },
+    .set = [](Storage &store, std::string_view value) {
+      auto enabled = ParseYesNo(value);
+      if (!enabled) {
+        return false;
+      }
+      store.SetKeyIndexEnabled(*enabled);
+      return true;
+    }},
+  ConfigParam{
+    .name = "shared-values",
+    .get = [](const Storage &store, std::pmr::memory_resource *arena) {
+      return std::pmr::string{store.SharedValuesEnabled() ? "yes" : "no",
+                              arena};
+    },
+    .set = [](Storage &store, std::string_view value) {
+      auto enabled = ParseYesNo(value);
+      if (!enabled) {
+        return false;
+      }
+      store.SetSharedValuesEnabled(*enabled);
+      return true;
+    }},
+  ConfigParam{
+    .name = "set-ops-threads",
+    .get = [](const Storage &store, std::pmr::memory_resource *arena) {
+      return FormatInt(static_cast<std::int64_t>(store.WorkerThreads()),
+                       arena);
+    },
+    .set = [](Storage &store, std::string_view value) {
+      auto threads = ParseInt(value);
+      if (!threads || *threads < 1 || *threads > 64) {
+        return false;
+      }
+      store.Workers().SetThreads(static_cast<std::size_t>(*threads));
+      return true;
+    }},
+  ConfigParam{
+    .name = "read-threads",
+    .get = [](const Storage &store, std::pmr::memory_resource *arena) {
+      return FormatInt(static_cast<std::int64_t>(store.ReadThreads()), arena);
+    },
+    .set = [](Storage &store, std::string_view value) {
+      auto threads = ParseInt(value);
+      if (!threads || *threads < 1 || *threads > 64) {
+        return false;
+      }
+      store.Readers().SetThreads(static_cast<std::size_t>(*threads));
+      return true;
+    }},
+};
+
+// INFO replies are "name:value" lines grouped under "# Section" headers
+inline void AppendInfoField(std::pmr::string &out, std::string_view name,
+                            std::string_view value) {
+  out += name;
+  out += ':';
+  out += value;
+  out += "\r\n";
+}
+
+inline void AppendInfoField(std::pmr::string &out, std::string_view name,
+                            std::size_t value) {
+  std::array<char, 24> buf{};
+  auto [ptr, _] = std::to_chars(buf.data(), buf.data() + buf.size(), value);
+  AppendInfoField(out, name, std::string_view{buf.data(), ptr});
+}
+
+inline std::pmr::string FormatRatio(double val,
+                                    std::pmr::memory_resource *arena) {
+  std::array<char, 32> buf{};
+  auto [ptr, _] = std::to_chars(buf.data(), buf.data() + buf.size(), val,
+                                std::chars_format::fixed, 2);
+  return std::pmr::string{buf.data(), ptr, arena};
+}
+
+// 1536 -> "1.50K", as in the *_human INFO fields
+inline void AppendInfoBytesHuman(std::pmr::string &out, std::string_view name,
+                                 std::size_t bytes) {
+  constexpr std::array<char, 4> UNITS{'B', 'K', 'M', 'G'};
+  auto value = static_cast<double>(bytes);
+  std::size_t unit = 0;
+  while (value >= 1024 && unit + 1 < UNITS.size()) {
+    value /= 1024;
+    ++unit;
+  }
+
+  std::array<char, 32> buf{};
+  auto [ptr, _] = std::to_chars(buf.data(), buf.data() + buf.size() - 1, value,
+                                std::chars_format::fixed, 2);
+  *ptr++ = UNITS[unit];
+  AppendInfoField(out, name, std::string_view{buf.data(), ptr});
+}
+
+struct InfoSection {
+  std::string_view name;
+  void (*append)(std::pmr::string &, Storage &);
+};
+
+inline constexpr std::array INFO_SECTIONS{
+  InfoSection{
+    .name = "memory",
+    .append = [](std::pmr::string &out, Storage &store) {
+      const auto mem = store.GetMemoryStats();
+      out += "# Memory\r\n";
+      AppendInfoField(out, "used_memory", mem.total);
+      AppendInfoBytesHuman(out, "used_memory_human", mem.total);
+      AppendInfoField(out, "used_memory_peak", mem.peak);
+      AppendInfoBytesHuman(out, "used_memory_peak_human", mem.peak);
+      AppendInfoField(out, "used_memory_dataset", store.DatasetMemory());
+      AppendInfoField(out, "mem_keys", mem.keys);
+      AppendInfoField(out, "mem_strings", mem.strings);
+      AppendInfoField(out, "mem_lists", mem.lists);
+      AppendInfoField(out, "mem_sets", mem.sets);
+      AppendInfoField(out, "shared_values", store.SharedValueCount());
+      AppendInfoField(out, "mem_clients_normal", mem.clients);
+      AppendInfoField(out, "mem_snapshot", mem.snapshot);
+      AppendInfoField(out, "allocator_reserved", mem.reserved);
+      AppendInfoField(
+        out, "mem_fragmentation_ratio",
+        FormatRatio(mem.FragmentationRatio(), out.get_allocator().resource()));
+      AppendInfoField(out, "active_defrag_running",
+                      std::size_t{store.DefragRunning()});
+      AppendInfoField(out, "lazyfree_pending_objects", store.LazyFreePending());
+      AppendInfoField(out, "maxmemory", store.MaxMemory());
+      AppendInfoBytesHuman(out, "maxmemory_human", store.MaxMemory());
+      AppendInfoField(out, "maxmemory_policy",
+                      PolicyName(store.GetEvictionPolicy()));
+    }},
+  InfoSection{
+    .name = "stats",
+    .append = [](std::pmr::string &out, Storage &store) {
+      out += "# Stats\r\n";
+      AppendInfoField(out, "expired_keys", store.ExpiredKeys());
+      AppendInfoField(out, "evicted_keys", store.EvictedKeys());
+      AppendInfoField(out, "lazyfreed_objects", store.LazyFreed());
+      AppendInfoField(out, "active_defrag_hits", store.DefragHits());
+      AppendInfoField(out, "active_defrag_reclaimed_bytes",
+                      store.DefragReclaimed());
+    }},
+  InfoSection{
+    .name = "keyspace",
+    .append = [](std::pmr::string &out, Storage &store) {
+      out += "# Keyspace\r\n";
+      auto *arena = out.get_allocator().resource();
+      for (std::size_t index = 0; index < store.Databases(); ++index) {
+        const auto keys = store.KeyCount(index);
+        if (keys == 0) {
+          continue;
+        }
+        std::pmr::string name{"db", arena};
+        name += FormatInt(static_cast<std::int64_t>(index), arena);
+        std::pmr::string db{"keys=", arena};
+        db += FormatInt(static_cast<std::int64_t>(keys), arena);
+        db += ",expires=";
+        db += FormatInt(static_cast<std::int64_t>(store.VolatileCount(index)),
+                        arena);
+        AppendInfoField(out, name, db);
+      }
+    }},
+};
+
+inline std::string_view TypeName(const Storage::Value &value) {
+  constexpr std::array<std::string_view, 3> NAMES{"string", "list", "set"};
+  return NAMES[value.index()];
+}
+
+// Int-encoded values are formatted straight into the reply
+inline resp::Type StringReply(const Storage::String &str,
+                              std::pmr::memory_resource *arena) {
+  Storage::String::IntBuffer buf;
+  return resp::BulkString{std::pmr::string{str.View(buf), arena}};
+}
+
+// INCR, DECR, INCRBY and DECRBY; the *BY forms take the increment as their
+// second argument, and the DECR forms negate it.
+inline resp::Type IncrDecr(std::string_view cmd, CommandArgs args, bool by,
+                           bool negate, Storage &store,
+                           std::pmr::memory_resource *arena) {
+  if (args.size() != (by ? 2U : 1U)) {
+    return ErrorArgCount(cmd, arena);
+  }
+  const auto *key = AsBulkString(args[0]);
+  if (!key) {
+    return ErrorNotBulkString(arena);
+  }
+
+  std::int64_t delta = 1;
+  if (by) {
+    const auto *arg = AsBulkString(args[1]);
+    if (!arg) {
+      return ErrorNotBulkString(arena);
+    }
+    auto parsed = ParseInt<std::int64_t>(*arg);
+    if (!parsed) {
+      return ErrorNotInteger(arena);
+    }
+    delta = *parsed;
+  }
+  if (negate) {
+    if (delta == std::numeric_limits<std::int64_t>::min()) {
+      return ErrorOverflow(arena);
+    }
+    delta = -delta;
+  }
+
+  auto result = store.IncrBy(std::string_view{*key}, delta);
+  if (!result) {
+    switch (result.error()) {
+    case Storage::Error::WrongType:
+      return ErrorWrongType(arena);
+    case Storage::Error::Overflow:
+      return ErrorOverflow(arena);
+    default:
+      return ErrorNotInteger(arena);
+    }
+  }
+  return resp::Int{*result};
+}
+
+// Trailing options of SCAN and SSCAN
+struct ScanOptions {
+  std::string_view pattern = "*";
+  std::size_t count = 10;   // elements to visit per call, roughly
+  std::string_view type;    // SCAN only; empty = any
+};
+
+inline std::optional<ScanOptions> ParseScanOptions(CommandArgs args,
+                                                   bool allow_type) {
+  ScanOptions options;
+  for (std::size_t i = 0; i < args.size(); i += 2) {
+    const auto *name = AsBulkString(args[i]);
+    const auto *value =
+      i + 1 < args.size() ? AsBulkString(args[i + 1]) : nullptr;
+    if (!name || !value) {
+      return std::nullopt;
+    }
+    if (EqualsIgnoreCase(*name, "MATCH")) {
+      options.pattern = *value;
+    } else if (EqualsIgnoreCase(*name, "COUNT")) {
+      auto count = ParseInt<std::size_t>(*value);
+      if (!count || *count == 0) {
+        return std::nullopt;
+      }
+      options.count = *count;
+    } else if (allow_type && EqualsIgnoreCase(*name, "TYPE")) {
+      options.type = *value;
+    } else {
+      return std::nullopt;
+    }
+  }
+  return options;
+}
+
+// Drives `scan_step` (cursor -> next cursor) until about `count` elements
+// were visited, the walk completes, or ten times that many steps were taken
+// over empty buckets, so one call never does unbounded work.
+template <typename Step>
+inline std::uint64_t ScanSteps(std::uint64_t cursor, std::size_t count,
+                               const std::size_t &visited,
+                               Step &&scan_step) {
+  auto steps = count * 10;
+  do {
+    cursor = scan_step(cursor);
+  } while (cursor != 0 && --steps > 0 && visited < count);
+  return cursor;
+}
+
+inline resp::Type ScanReply(std::uint64_t cursor,
+                            std::pmr::vector<resp::Type> elements,
+                            std::pmr::memory_resource *arena) {
+  std::pmr::vector<resp::Type> reply{arena};
+  reply.reserve(2);
+  reply.emplace_back(
+    resp::BulkString{FormatInt(static_cast<std::int64_t>(cursor), arena)});
+  reply.emplace_back(resp::Array{std::move(elements)});
+  return resp::Array{std::move(reply)};
+}
+
+// A list index, negative ones counting from the end, as a position below
+// `size`; nullopt when out of range
+inline std::optional<std::size_t> ListIndex(std::int64_t index,
+                                            std::size_t size) {
+  const auto len = static_cast<std::int64_t>(size);
+  if (index < 0) {
+    index += len;
+  }
+  if (index < 0 || index >= len) {
+    return std::nullopt;
+  }
+  return static_cast<std::size_t>(index);
+}
+
+inline resp::Type ErrorInvalidCursor(std::pmr::memory_resource *arena) {
+  return resp::Error{std::pmr::string{"ERR invalid cursor", arena}};
+}
+
+// Looks up the sets named by `keys` in order, with nullptr for a missing
+// key. Returns an error reply for a bad argument or a key holding another
+// type, whichever position it is in.
+inline std::optional<resp::Type>
+LookupSets(CommandArgs keys, Storage &store,
+           std::vector<const Storage::Set *> &sets,
+           std::pmr::memory_resource *arena) {
+  sets.reserve(keys.size());
+  for (const auto &arg : keys) {
+    const auto *key = AsBulkString(arg);
+    if (!key) {
+      return ErrorNotBulkString(arena);
+    }
+    auto set = store.Get<Storage::Set>(std::string_view{*key});
+    if (!set && set.error() == Storage::Error::WrongType) {
+      return ErrorWrongType(arena);
+    }
+    sets.push_back(set ? *set : nullptr);
+  }
+  return std::nullopt;
+}
+
+// LookupSets for an intersection, ordered smallest first. A missing or
+// empty set makes the whole intersection empty, and then `sets` is left
+// empty.
+inline std::optional<resp::Type>
+IntersectionInputs(CommandArgs keys, Storage &store,
+                   std::vector<const Storage::Set *> &sets,
+                   std::pmr::memory_resource *arena) {
+  if (auto error = LookupSets(keys, store, sets, arena)) {
+    return error;
+  }
+  if (std::ranges::any_of(
+        sets, [](const auto *set) { return !set || set->empty(); })) {
+    sets.clear();
+  }
+  std::ranges::sort(sets, {}, [](const auto *set) { return set->size(); });
+  return std::nullopt;
+}
+
+// SUNION, SDIFF and their STORE variants; the destination, if any, is the
+// first argument
+inline resp::Type SetAlgebra(std::string_view cmd, CommandArgs args,
+                             bool difference, bool store_result,
+                             Storage &store,
+                             std::pmr::memory_resource *arena) {
+  if (args.size() < (store_result ? 2u : 1u)) {
+    return ErrorArgCount(cmd, arena);
+  }
+  const auto *dest = store_result ? AsBulkString(args[0]) : nullptr;
+  if (store_result && !dest) {
+    return ErrorNotBulkString(arena);
+  }
+
+  std::vector<const Storage::Set *> sets;
+  if (auto error =
+        LookupSets(args.subspan(store_result ? 1 : 0), store, sets, arena)) {
+    return std::move(*error);
+  }
+  // A missing key is an empty set: it empties a difference it starts and
+  // drops out of everything else
+  if (difference && !sets.front()) {
+    sets.clear();
+  }
+  std::erase(sets, nullptr);
+
+  // Members are copied out of the inputs, so `dest` may be one of them
+  const auto result = difference ? set_ops::Difference(sets, store.Workers())
+                                 : set_ops::Union(sets, store.Workers());
+
+  if (store_result) {
+    if (result.Empty()) {
+      store.Erase(std::string_view{*dest});
+      return resp::Int{0};
+    }
+    auto *set = store.Overwrite<Storage::Set>(std::string_view{*dest});
+    result.ForEach([&](std::string_view member) { set->insert(member); });
+    return resp::Int{static_cast<std::int64_t>(set->size())};
+  }
+
+  std::pmr::vector<resp::Type> members{arena};
+  members.reserve(result.Size());
+  result.ForEach([&](std::string_view member) {
+    members.emplace_back(resp::BulkString{std::pmr::string{member, arena}});
+  });
+  return resp::Array{std::move(members)};
+}
+
+// Calls visit(std::string_view) for each member of the intersection of
+// `sets`, as ordered by IntersectionInputs, until it returns false. Only
+// the smallest set is walked; the others are probed, so the cost follows
+// the smallest input rather than the first one named.
+template <typename F>
+void Intersect(const std::vector<const Storage::Set *> &sets, F &&visit) {
+  if (sets.empty()) {
+    return;
+  }
+  const auto rest = std::span{sets}.subspan(1);
+  if (sets.front()->IsIntSet()) {
+    // Compare packed integers; only the survivors get formatted
+    const auto &ints = sets.front()->Ints();
+    StringValue::IntBuffer buf;
+    for (std::size_t i = 0; i < ints.Size(); ++i) {
+      const auto member = ints.Get(i);
+      if (std::ranges::all_of(
+            rest, [&](const auto *s) { return s->ContainsInt(member); }) &&
+          !visit(Storage::Set::Format(member, buf))) {
+        return;
+      }
+    }
+    return;
+  }
+  sets.front()->ForEach([&](std::string_view member) {
+    return !std::ranges::all_of(
+             rest, [&](const auto *s) { return s->contains(member); }) ||
+           visit(member);
+  });
+}
+
+inline resp::Type SetMemberReply(const Storage::Set &set, std::size_t position,
+                                 std::pmr::memory_resource *arena) {
+  StringValue::IntBuffer buf;
+  return resp::BulkString{std::pmr::string{set.At(position, buf), arena}};
+}
+
+// SRANDMEMBER with a count: up to `count` distinct members, or -count
+// members that may repeat. Picks are positions in the set, each equally
+// likely. Distinct picks come from a partial shuffle of the positions
+// when they cover much of the set, and by retrying duplicates otherwise.
+inline resp::Type RandomMembers(const Storage::Set &set, std::int64_t count,
+                                Storage &store,
+                                std::pmr::memory_resource *arena) {
+  std::pmr::vector<resp::Type> members{arena};
+  const auto size = set.size();
+  if (count < 0) {
+    const auto picks = static_cast<std::size_t>(-count);
+    members.reserve(picks);
+    for (std::size_t i = 0; i < picks; ++i) {
+      members.push_back(SetMemberReply(set, store.RandomIndex(size), arena));
+    }
+    return resp::Array{std::move(members)};
+  }
+
+  const auto picks = static_cast<std::size_t>(count);
+  members.reserve(std::min(picks, size));
+  if (picks >= size) {
+    set.ForEach([&](std::string_view member) {
+      members.emplace_back(resp::BulkString{std::pmr::string{member, arena}});
+    });
+  } else if (picks * 3 > size) {
+    std::pmr::vector<std::size_t> positions(size, arena);
+    std::iota(positions.begin(), positions.end(), std::size_t{0});
+    for (std::size_t i = 0; i < picks; ++i) {
+      std::swap(positions[i], positions[i + store.RandomIndex(size - i)]);
+      members.push_back(SetMemberReply(set, positions[i], arena));
+    }
+  } else {
+    std::pmr::unordered_set<std::size_t> seen{arena};
+    seen.reserve(picks);
+    while (members.size() < picks) {
+      const auto position = store.RandomIndex(size);
+      if (seen.insert(position).second) {
+        members.push_back(SetMemberReply(set, position, arena));
+      }
+    }
+  }
+  return resp::Array{std::move(members)};
+}
+
+// LMOVE and RPOPLPUSH: pops from one end of `source` and pushes onto one
+// end of `dest`, in place. Only the reply is a copy.
+inline resp::Type ListMove(const resp::Type &source, const resp::Type &dest,
+                           bool from_back, bool to_back, Storage &store,
+                           std::pmr::memory_resource *arena) {
+  const auto *source_key = AsBulkString(source);
+  const auto *dest_key = AsBulkString(dest);
+  if (!source_key || !dest_key) {
+    return ErrorNotBulkString(arena);
+  }
+
+  // Both types are checked before anything moves
+  auto from = store.Find<Storage::List>(std::string_view{*source_key});
+  auto to = store.Find<Storage::List>(std::string_view{*dest_key});
+  if ((!from && from.error() == Storage::Error::WrongType) ||
+      (!to && to.error() == Storage::Error::WrongType)) {
+    return ErrorWrongType(arena);
+  }
+  if (!from || (*from)->empty()) {
+    return resp::Null{};
+  }
+
+  auto *list = *from;
+  resp::BulkString moved{
+    std::pmr::string{from_back ? list->back() : list->front(), arena}};
+  auto target = store.FindOrCreate<Storage::List>(std::string_view{*dest_key});
+  list->MoveTo(**target, from_back, to_back);
+  return moved;
+}
+
+// LEFT or RIGHT, as true for the right end
+inline std::optional<bool> ListEnd(const resp::Type &arg) {
+  const auto *name = AsBulkString(arg);
+  if (name && EqualsIgnoreCase(*name, "LEFT")) {
+    return false;
+  }
+  if (name && EqualsIgnoreCase(*name, "RIGHT")) {
+    return true;
+  }
+  return std::nullopt;
+}
+
+// A database number for SELECT, SWAPDB and MOVE; nullopt unless it is an
+// integer. Negative numbers come back out of range, like too big ones.
+inline std::optional<std::size_t> DbIndex(const resp::Type &arg) {
+  const auto *str = AsBulkString(arg);
+  const auto index = str ? ParseInt<std::int64_t>(*str) : std::nullopt;
+  if (!index) {
+    return std::nullopt;
+  }
+  return *index < 0 ? std::numeric_limits<std::size_t>::max()
+                    : static_cast<std::size_t>(*index);
+}
+
+inline resp::Type ErrorDbRange(std::pmr::memory_resource *arena) {
+  return resp::Error{std::pmr::string{"ERR DB index is out of range", arena}};
+}
+
+// Read-only commands, written once for Storage and for Storage::Reader (the
+// parallel read phase)
+template <typename Store>
+resp::Type Get(CommandArgs args, Store &store,
+               std::pmr::memory_resource *arena) {
+  if (args.size() != 1) {
+    return ErrorArgCount("GET", arena);
+  }
+  const auto *key = AsBulkString(args[0]);
+  if (!key) {
+    return ErrorNotBulkString(arena);
+  }
+
+  auto result = store.template Get<Storage::String>(std::string_view{*key});
+  if (!result) {
+    if (result.error() == Storage::Error::WrongType) {
+      return ErrorWrongType(arena);
+    }
+    return resp::Null{};
+  }
+  return StringReply(**result, arena);
+}
+
+template <typename Store>
+resp::Type LRange(CommandArgs args, Store &store,
+                  std::pmr::memory_resource *arena) {
+  if (args.size() != 3) {
+    return ErrorArgCount("LRANGE", arena);
+  }
+  const auto *key = AsBulkString(args[0]);
+  const auto *start_str = AsBulkString(args[1]);
+  const auto *stop_str = AsBulkString(args[2]);
+  if (!key || !start_str || !stop_str) {
+    return ErrorNotBulkString(arena);
+  }
+
+  auto start_opt = ParseInt(std::string_view{*start_str});
+  auto stop_opt = ParseInt(std::string_view{*stop_str});
+  if (!start_opt || !stop_opt) {
+    return ErrorNotInteger(arena);
+  }
+
+  auto result = store.template Get<Storage::List>(std::string_view{*key});
+  if (!result) {
+    if (result.error() == Storage::Error::WrongType) {
+      return ErrorWrongType(arena);
+    }
+    return resp::Array{std::pmr::vector<resp::Type>{arena}};
+  }
+
+  const auto *list = *result;
+  const auto len = static_cast<int>(list->size());
+  const auto start =
+    *start_opt < 0 ? std::max(0, len + *start_opt) : *start_opt;
+  const auto stop =
+    std::min(*stop_opt < 0 ? len + *stop_opt : *stop_opt, len - 1);
+
+  std::pmr::vector<resp::Type> elements{arena};
+  if (start <= stop) {
+    elements.reserve(static_cast<std::size_t>(stop - start + 1));
+    const auto append = [&](auto it) {
+      for (auto i = start; i <= stop; ++i, ++it) {
+        elements.emplace_back(resp::BulkString{std::pmr::string{*it, arena}});
+      }
+    };
+    // Readers share the list, so they must not rebuild its index
+    if constexpr (std::is_same_v<Store, Storage::Reader>) {
+      append(list->SeekShared(static_cast<std::size_t>(start)));
+    } else {
+      append(list->Seek(static_cast<std::size_t>(start)));
+    }
+  }
+  return resp::Array{std::move(elements)};
+}
+
+template <typename Store>
+resp::Type SIsMember(CommandArgs args, Store &store,
+                     std::pmr::memory_resource *arena) {
+  if (args.size() != 2) {
+    return ErrorArgCount("SISMEMBER", arena);
+  }
+  const auto *key = AsBulkString(args[0]);
+  const auto *member = AsBulkString(args[1]);
+  if (!key || !member) {
+    return ErrorNotBulkString(arena);
+  }
+
+  auto result = store.template Get<Storage::Set>(std::string_view{*key});
+  if (!result) {
+    if (result.error() == Storage::Error::WrongType) {
+      return ErrorWrongType(arena);
+    }
+    return resp::Int{0};
+  }
+  return resp::Int{(*result)->contains(std::string_view{*member}) ? 1 : 0};
+}
+
+template <typename Store>
+resp::Type Ttl(CommandArgs args, Store &store,
+               std::pmr::memory_resource *arena) {
+  if (args.size() != 1) {
+    return ErrorArgCount("TTL", arena);
+  }
+  const auto *key = AsBulkString(args[0]);
+  if (!key) {
+    return ErrorNotBulkString(arena);
+  }
+
+  return resp::Int{store.GetTtl(std::string_view{*key})};
+}
+
+template <typename Store>
+resp::Type Pttl(CommandArgs args, Store &store,
+                std::pmr::memory_resource *arena) {
+  if (args.size() != 1) {
+    return ErrorArgCount("PTTL", arena);
+  }
+  const auto *key = AsBulkString(args[0]);
+  if (!key) {
+    return ErrorNotBulkString(arena);
+  }
+
+  return resp::Int{store.GetPttl(std::string_view{*key})};
+}
+
 } // namespace detail
 
 // Frequency-ordered: most common commands first
 inline constexpr auto COMMANDS =
   CommandHandler<0>{}
     .add({.name = "GET",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) {
+            return detail::Get(args, store, arena);
+          },
+          .read = [](CommandArgs args, Storage::Reader &store,
+                     std::pmr::memory_resource *arena) {
+            return detail::Get(args, store, arena);
+          }})
+
+    .add({.name = "SET",
+          .flags = CommandEntry::DENY_OOM,
           .fn = [](CommandArgs args, Storage &store,
                    std::pmr::memory_resource *arena) -> resp::Type {
-            if (args.size() != 1) {
-              return detail::ErrorArgCount("GET", arena);
+            if (args.size() < 2) {
+              return detail::ErrorArgCount("SET", arena);
+            }
+            const auto *key = detail::AsBulkString(args[0]);
+            const auto *val = detail::AsBulkString(args[1]);
+            if (!key || !val) {
+              return detail::ErrorNotBulkString(arena);
+            }
+
+            // Plain SET: one lookup, drops any previous TTL
+            if (args.size() == 2) {
+              if (!store.SetString(std::string_view{*key},
+                                   std::string_view{*val})) {
+                return detail::ErrorWrongType(arena);
+              }
+              return detail::Ok(arena);
+            }
+
+            bool nx = false;
+            bool xx = false;
+            bool get = false;
+            bool keep_ttl = false;
+            std::optional<std::int64_t> deadline;
+
+            for (std::size_t i = 2; i < args.size(); ++i) {
+              const auto *opt = detail::AsBulkString(args[i]);
+              if (!opt) {
+                return detail::ErrorNotBulkString(arena);
+              }
+              const std::string_view name{*opt};
+
+              if (detail::EqualsIgnoreCase(name, "NX") && !xx) {
+                nx = true;
+              } else if (detail::EqualsIgnoreCase(name, "XX") && !nx) {
+                xx = true;
+              } else if (detail::EqualsIgnoreCase(name, "GET")) {
+                get = true;
+              } else if (detail::EqualsIgnoreCase(name, "KEEPTTL") &&
+                         !deadline) {
+                keep_ttl = true;
+              } else if (auto unit = detail::ParseExpiryUnit(name);
+                         unit && !keep_ttl && !deadline &&
+                         i + 1 < args.size()) {
+                const auto *when = detail::AsBulkString(args[++i]);
+                if (!when) {
+                  return detail::ErrorNotBulkString(arena);
+                }
+                deadline = detail::ParseDeadline(*unit, std::string_view{*when});
+                if (!deadline) {
+                  return detail::ErrorInvalidExpire("set", arena);
+                }
+              } else {
+                return detail::ErrorSyntax(arena);
+              }
+            }
+
+            auto current = store.Get<Storage::String>(std::string_view{*key});
+            if (!current && current.error() == Storage::Error::WrongType) {
+              return detail::ErrorWrongType(arena);
+            }
+            const bool exists = current.has_value();
+
+            resp::Type reply = detail::Ok(arena);
+            if (get) {
+              reply = exists ? detail::StringReply(**current, arena)
+                             : resp::Type{resp::Null{}};
+            }
+
+            if ((nx && exists) || (xx && !exists)) {
+              return get ? reply : resp::Null{};
+            }
+
+            const auto ttl = deadline  ? *deadline
+                             : keep_ttl ? Storage::KEEP_TTL
+                                        : Storage::NO_EXPIRY;
+            store.SetString(std::string_view{*key}, std::string_view{*val},
+                            ttl);
+            return reply;
+          }})
+
+    .add({.name = "GETEX",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.empty() || args.size() > 3) {
+              return detail::ErrorArgCount("GETEX", arena);
             }
             const auto *key = detail::AsBulkString(args[0]);
             if (!key) {
               return detail::ErrorNotBulkString(arena);
             }
 
-            auto result = store.Find<Storage::String>(std::string_view{*key});
+            bool persist = false;
+            std::optional<std::int64_t> deadline;
+            if (args.size() > 1) {
+              const auto *opt = detail::AsBulkString(args[1]);
+              if (!opt) {
+                return detail::ErrorNotBulkString(arena);
+              }
+              const std::string_view name{*opt};
+              auto unit = detail::ParseExpiryUnit(name);
+
+              if (args.size() == 2 && detail::EqualsIgnoreCase(name, "PERSIST")) {
+                persist = true;
+              } else if (args.size() == 3 && unit) {
+                const auto *when = detail::AsBulkString(args[2]);
+                if (!when) {
+                  return detail::ErrorNotBulkString(arena);
+                }
+                deadline = detail::ParseDeadline(*unit, std::string_view{*when});
+                if (!deadline) {
+                  return detail::ErrorInvalidExpire("getex", arena);
+                }
+              } else {
+                return detail::ErrorSyntax(arena);
+              }
+            }
+
+            auto result = store.Get<Storage::String>(std::string_view{*key});
             if (!result) {
               if (result.error() == Storage::Error::WrongType) {
                 return detail::ErrorWrongType(arena);
               }
               return resp::Null{};
             }
-            return resp::BulkString{std::pmr::string{**result, arena}};
+
+            resp::Type reply = detail::StringReply(**result, arena);
+            if (deadline) {
+              detail::ExpireAt(store, std::string_view{*key}, *deadline);
+            } else if (persist) {
+              store.Persist(std::string_view{*key});
+            }
+            return reply;
           }})
 
-    .add({.name = "SET",
+    .add({.name = "INCR",
+          .flags = CommandEntry::DENY_OOM,
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            return detail::IncrDecr("INCR", args, false, false, store, arena);
+          }})
+
+    .add({.name = "DECR",
+          .flags = CommandEntry::DENY_OOM,
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            return detail::IncrDecr("DECR", args, false, true, store, arena);
+          }})
+
+    .add({.name = "INCRBY",
+          .flags = CommandEntry::DENY_OOM,
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            return detail::IncrDecr("INCRBY", args, true, false, store, arena);
+          }})
+
+    .add({.name = "DECRBY",
+          .flags = CommandEntry::DENY_OOM,
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            return detail::IncrDecr("DECRBY", args, true, true, store, arena);
+          }})
+
+    .add({.name = "INCRBYFLOAT",
+          .flags = CommandEntry::DENY_OOM,
           .fn = [](CommandArgs args, Storage &store,
                    std::pmr::memory_resource *arena) -> resp::Type {
             if (args.size() != 2) {
-              return detail::ErrorArgCount("SET", arena);
+              return detail::ErrorArgCount("INCRBYFLOAT", arena);
             }
             const auto *key = detail::AsBulkString(args[0]);
-            const auto *val = detail::AsBulkString(args[1]);
-            if (!key || !val) {
+            const auto *arg = detail::AsBulkString(args[1]);
+            if (!key || !arg) {
               return detail::ErrorNotBulkString(arena);
             }
 
-            auto result =
-              store.FindOrCreate<Storage::String>(std::string_view{*key});
+            double delta = 0;
+            auto [ptr, ec] =
+              std::from_chars(arg->data(), arg->data() + arg->size(), delta);
+            if (ec != std::errc{} || ptr != arg->data() + arg->size() ||
+                !std::isfinite(delta)) {
+              return detail::ErrorNotFloat(arena);
+            }
+
+            auto result = store.IncrByFloat(std::string_view{*key}, delta);
             if (!result) {
-              return detail::ErrorWrongType(arena);
+              switch (result.error()) {
+              case Storage::Error::WrongType:
+                return detail::ErrorWrongType(arena);
+              case Storage::Error::Overflow:
+                return resp::Error{std::pmr::string{
+                  "ERR increment would produce NaN or Infinity", arena}};
+              default:
+                return detail::ErrorNotFloat(arena);
+              }
             }
-            **result = std::string{*val};
-            return detail::Ok(arena);
+            return detail::StringReply(**result, arena);
           }})
 
     .add({.name = "DEL",
@@ -116,6 +1203,40 @@ inline constexpr auto COMMANDS =
             return resp::Int{deleted};
           }})
 
+    // Same as DEL: big values are always freed in the background
+    .add({.name = "UNLINK",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.empty()) {
+              return detail::ErrorArgCount("UNLINK", arena);
+            }
+            auto unlinked = 0;
+            for (const auto &arg : args) {
+              const auto *key = detail::AsBulkString(arg);
+              if (!key) {
+                return detail::ErrorNotBulkString(arena);
+              }
+              if (store.Erase(std::string_view{*key})) {
+                ++unlinked;
+              }
+            }
+            return resp::Int{unlinked};
+          }})
+
+    .add({.name = "DELPREFIX",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() != 1) {
+              return detail::ErrorArgCount("DELPREFIX", arena);
+            }
+            const auto *prefix = detail::AsBulkString(args[0]);
+            if (!prefix) {
+              return detail::ErrorNotBulkString(arena);
+            }
+            const auto erased = store.ErasePrefix(std::string_view{*prefix});
+            return resp::Int{static_cast<std::int64_t>(erased)};
+          }})
+
     .add({.name = "PING",
           .fn = [](CommandArgs args, Storage &,
                    std::pmr::memory_resource *arena) -> resp::Type {
@@ -138,8 +1259,11 @@ inline constexpr auto COMMANDS =
             if (args.size() != 1) {
               return detail::ErrorArgCount("KEYS", arena);
             }
-            // Pattern argument is accepted but we always return all keys
-            auto keys = store.Keys();
+            const auto *pattern = detail::AsBulkString(args[0]);
+            if (!pattern) {
+              return detail::ErrorNotBulkString(arena);
+            }
+            auto keys = store.Keys(GlobPattern{*pattern, arena});
             std::pmr::vector<resp::Type> result{arena};
             result.reserve(keys.size());
             for (auto k : keys) {
@@ -148,18 +1272,420 @@ inline constexpr auto COMMANDS =
             return resp::Array{std::move(result)};
           }})
 
+    .add({.name = "SCAN",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.empty()) {
+              return detail::ErrorArgCount("SCAN", arena);
+            }
+            const auto *cursor_arg = detail::AsBulkString(args[0]);
+            if (!cursor_arg) {
+              return detail::ErrorNotBulkString(arena);
+            }
+            auto cursor = detail::ParseInt<std::uint64_t>(*cursor_arg);
+            if (!cursor) {
+              return detail::ErrorInvalidCursor(arena);
+            }
+            auto options = detail::ParseScanOptions(args.subspan(1), true);
+            if (!options) {
+              return detail::ErrorSyntax(arena);
+            }
+
+            const GlobPattern pattern{options->pattern, arena};
+            const bool match_all = pattern.MatchesAll();
+            std::pmr::vector<resp::Type> keys{arena};
+            std::size_t visited = 0;
+            auto visit = [&](std::string_view key,
+                             const Storage::Value &val) {
+              ++visited;
+              if ((options->type.empty() ||
+                   detail::EqualsIgnoreCase(detail::TypeName(val),
+                                            options->type)) &&
+                  (match_all || pattern.Matches(key))) {
+                keys.emplace_back(
+                  resp::BulkString{std::pmr::string{key, arena}});
+              }
+            };
+            // With the key index, a pattern whose literal prefix has no more
+            // than COUNT keys is answered in one call that only touches
+            // them; a bigger one is walked like any other, COUNT at a time
+            if (*cursor == 0 && !pattern.LiteralPrefix().empty() &&
+                store.ScanPrefix(pattern.LiteralPrefix(), visit,
+                                 options->count)) {
+              return detail::ScanReply(0, std::move(keys), arena);
+            }
+            const auto next = detail::ScanSteps(
+              *cursor, options->count, visited,
+              [&](std::uint64_t c) { return store.Scan(c, visit); });
+            return detail::ScanReply(next, std::move(keys), arena);
+          }})
+
     .add({.name = "FLUSHDB",
           .fn = [](CommandArgs args, Storage &store,
                    std::pmr::memory_resource *arena) -> resp::Type {
-            if (!args.empty()) {
+            if (args.size() > 1) {
               return detail::ErrorArgCount("FLUSHDB", arena);
             }
-            store.Clear();
+            if (args.empty()) {
+              store.Clear();
+              return detail::Ok(arena);
+            }
+
+            const auto *mode = detail::AsBulkString(args[0]);
+            if (!mode) {
+              return detail::ErrorNotBulkString(arena);
+            }
+            if (detail::EqualsIgnoreCase(*mode, "ASYNC")) {
+              store.ClearAsync();
+            } else if (detail::EqualsIgnoreCase(*mode, "SYNC")) {
+              store.Clear();
+            } else {
+              return detail::ErrorSyntax(arena);
+            }
             return detail::Ok(arena);
           }})
 
+    .add({.name = "FLUSHALL",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() > 1) {
+              return detail::ErrorArgCount("FLUSHALL", arena);
+            }
+            if (args.empty()) {
+              store.ClearAll();
+              return detail::Ok(arena);
+            }
+
+            const auto *mode = detail::AsBulkString(args[0]);
+            if (!mode) {
+              return detail::ErrorNotBulkString(arena);
+            }
+            if (detail::EqualsIgnoreCase(*mode, "ASYNC")) {
+              store.ClearAllAsync();
+            } else if (detail::EqualsIgnoreCase(*mode, "SYNC")) {
+              store.ClearAll();
+            } else {
+              return detail::ErrorSyntax(arena);
+            }
+            return detail::Ok(arena);
+          }})
+
+    .add({.name = "DBSIZE",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (!args.empty()) {
+              return detail::ErrorArgCount("DBSIZE", arena);
+            }
+            return resp::Int{static_cast<std::int64_t>(store.KeyCount())};
+          }})
+
+    .add({.name = "SELECT",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() != 1) {
+              return detail::ErrorArgCount("SELECT", arena);
+            }
+            const auto index = detail::DbIndex(args[0]);
+            if (!index) {
+              return detail::ErrorNotInteger(arena);
+            }
+            if (*index >= store.Databases()) {
+              return detail::ErrorDbRange(arena);
+            }
+            store.Select(*index);
+            return detail::Ok(arena);
+          }})
+
+    .add({.name = "SWAPDB",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() != 2) {
+              return detail::ErrorArgCount("SWAPDB", arena);
+            }
+            const auto first = detail::DbIndex(args[0]);
+            if (!first) {
+              return resp::Error{
+                std::pmr::string{"ERR invalid first DB index", arena}};
+            }
+            const auto second = detail::DbIndex(args[1]);
+            if (!second) {
+              return resp::Error{
+                std::pmr::string{"ERR invalid second DB index", arena}};
+            }
+            if (*first >= store.Databases() || *second >= store.Databases()) {
+              return detail::ErrorDbRange(arena);
+            }
+            // Clients on either database see the other's keys from now on
+            store.SwapDb(*first, *second);
+            return detail::Ok(arena);
+          }})
+
+    .add({.name = "MOVE",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() != 2) {
+              return detail::ErrorArgCount("MOVE", arena);
+            }
+            const auto *key = detail::AsBulkString(args[0]);
+            if (!key) {
+              return detail::ErrorNotBulkString(arena);
+            }
+            const auto index = detail::DbIndex(args[1]);
+            if (!index) {
+              return detail::ErrorNotInteger(arena);
+            }
+            if (*index >= store.Databases()) {
+              return detail::ErrorDbRange(arena);
+            }
+            if (*index == store.SelectedDb()) {
+              return resp::Error{std::pmr::string{
+                "ERR source and destination objects are the same", arena}};
+            }
+            return resp::Int{store.Move(*key, *index) ? 1 : 0};
+          }})
+
+    .add({.name = "CONFIG",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.empty()) {
+              return detail::ErrorArgCount("CONFIG", arena);
+            }
+            const auto *sub = detail::AsBulkString(args[0]);
+            if (!sub) {
+              return detail::ErrorNotBulkString(arena);
+            }
+
+            if (detail::EqualsIgnoreCase(*sub, "GET")) {
+              if (args.size() != 2) {
+                return detail::ErrorArgCount("CONFIG|GET", arena);
+              }
+              const auto *pattern = detail::AsBulkString(args[1]);
+              if (!pattern) {
+                return detail::ErrorNotBulkString(arena);
+              }
+
+              std::pmr::vector<resp::Type> result{arena};
+              for (const auto &param : detail::CONFIG_PARAMS) {
+                if (*pattern != "*" &&
+                    !detail::EqualsIgnoreCase(param.name, *pattern)) {
+                  continue;
+                }
+                result.emplace_back(
+                  resp::BulkString{std::pmr::string{param.name, arena}});
+                result.emplace_back(resp::BulkString{param.get(store, arena)});
+              }
+              return resp::Array{std::move(result)};
+            }
+
+            if (detail::EqualsIgnoreCase(*sub, "SET")) {
+              if (args.size() != 3) {
+                return detail::ErrorArgCount("CONFIG|SET", arena);
+              }
+              const auto *name = detail::AsBulkString(args[1]);
+              const auto *value = detail::AsBulkString(args[2]);
+              if (!name || !value) {
+                return detail::ErrorNotBulkString(arena);
+              }
+
+              for (const auto &param : detail::CONFIG_PARAMS) {
+                if (!detail::EqualsIgnoreCase(param.name, *name)) {
+                  continue;
+                }
+                if (!param.set(store, std::string_view{*value})) {
+                  std::pmr::string msg{"ERR Invalid argument '", arena};
+                  msg += *value;
+                  msg += "' for CONFIG SET '";
+                  msg += param.name;
+                  msg += "'";
+                  return resp::Error{std::move(msg)};
+                }
+                return detail::Ok(arena);
+              }
+
+              std::pmr::string msg{"ERR Unknown option '", arena};
+              msg += *name;
+              msg += "' for CONFIG SET";
+              return resp::Error{std::move(msg)};
+            }
+
+            std::pmr::string msg{"ERR unknown subcommand '", arena};
+            msg += *sub;
+            msg += "' for 'CONFIG'";
+            return resp::Error{std::move(msg)};
+          }})
+
+    .add({.name = "OBJECT",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() != 2) {
+              return detail::ErrorArgCount("OBJECT", arena);
+            }
+            const auto *sub = detail::AsBulkString(args[0]);
+            const auto *key = detail::AsBulkString(args[1]);
+            if (!sub || !key) {
+              return detail::ErrorNotBulkString(arena);
+            }
+
+            if (detail::EqualsIgnoreCase(*sub, "ENCODING")) {
+              const auto encoding = store.Encoding(std::string_view{*key});
+              if (encoding.empty()) {
+                return resp::Null{};
+              }
+              return resp::BulkString{std::pmr::string{encoding, arena}};
+            }
+
+            if (detail::EqualsIgnoreCase(*sub, "FREQ")) {
+              if (!store.UsesLfu()) {
+                return resp::Error{std::pmr::string{
+                  "ERR An LFU maxmemory policy is not selected, access "
+                  "frequency not tracked.",
+                  arena}};
+              }
+              const auto freq = store.AccessFrequency(std::string_view{*key});
+              return freq < 0 ? resp::Type{resp::Null{}}
+                              : resp::Type{resp::Int{freq}};
+            }
+
+            if (detail::EqualsIgnoreCase(*sub, "IDLETIME")) {
+              if (store.UsesLfu()) {
+                return resp::Error{std::pmr::string{
+                  "ERR An LFU maxmemory policy is selected, idle time not "
+                  "tracked.",
+                  arena}};
+              }
+              const auto idle = store.IdleTime(std::string_view{*key});
+              return idle < 0 ? resp::Type{resp::Null{}}
+                              : resp::Type{resp::Int{idle}};
+            }
+
+            std::pmr::string msg{"ERR unknown subcommand '", arena};
+            msg += *sub;
+            msg += "' for 'OBJECT'";
+            return resp::Error{std::move(msg)};
+          }})
+
+    .add({.name = "MEMORY",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.empty()) {
+              return detail::ErrorArgCount("MEMORY", arena);
+            }
+            const auto *sub = detail::AsBulkString(args[0]);
+            if (!sub) {
+              return detail::ErrorNotBulkString(arena);
+            }
+
+            if (detail::EqualsIgnoreCase(*sub, "USAGE")) {
+              if (args.size() != 2 && args.size() != 4) {
+                return detail::ErrorArgCount("MEMORY|USAGE", arena);
+              }
+              const auto *key = detail::AsBulkString(args[1]);
+              if (!key) {
+                return detail::ErrorNotBulkString(arena);
+              }
+
+              std::size_t samples = 5; // same default as Redis
+              if (args.size() == 4) {
+                const auto *opt = detail::AsBulkString(args[2]);
+                const auto *count = detail::AsBulkString(args[3]);
+                if (!opt || !count) {
+                  return detail::ErrorNotBulkString(arena);
+                }
+                if (!detail::EqualsIgnoreCase(*opt, "SAMPLES")) {
+                  return detail::ErrorSyntax(arena);
+                }
+                auto parsed = detail::ParseInt<std::size_t>(*count);
+                if (!parsed) {
+                  return detail::ErrorNotInteger(arena);
+                }
+                samples = *parsed;
+              }
+
+              auto usage = store.MemoryUsage(std::string_view{*key}, samples);
+              if (!usage) {
+                return resp::Null{};
+              }
+              return resp::Int{static_cast<std::int64_t>(*usage)};
+            }
+
+            if (detail::EqualsIgnoreCase(*sub, "STATS")) {
+              if (args.size() != 1) {
+                return detail::ErrorArgCount("MEMORY|STATS", arena);
+              }
+              const auto mem = store.GetMemoryStats();
+              std::size_t keys = 0;
+              for (std::size_t db = 0; db < store.Databases(); ++db) {
+                keys += store.KeyCount(db);
+              }
+              const std::array<std::pair<std::string_view, std::size_t>, 11>
+                fields{{
+                  {"peak.allocated", mem.peak},
+                  {"total.allocated", mem.total},
+                  {"dataset.bytes", store.DatasetMemory()},
+                  {"keys.count", keys},
+                  {"keys.bytes", mem.keys},
+                  {"strings.bytes", mem.strings},
+                  {"lists.bytes", mem.lists},
+                  {"sets.bytes", mem.sets},
+                  {"clients.normal", mem.clients},
+                  {"snapshot.queued", mem.snapshot},
+                  {"allocator.reserved", mem.reserved},
+                }};
+
+              std::pmr::vector<resp::Type> result{arena};
+              result.reserve(fields.size() * 2 + 2);
+              for (const auto &[name, value] : fields) {
+                result.emplace_back(
+                  resp::BulkString{std::pmr::string{name, arena}});
+                result.emplace_back(
+                  resp::Int{static_cast<std::int64_t>(value)});
+              }
+              result.emplace_back(
+                resp::BulkString{std::pmr::string{"fragmentation", arena}});
+              result.emplace_back(resp::BulkString{
+                detail::FormatRatio(mem.FragmentationRatio(), arena)});
+              return resp::Array{std::move(result)};
+            }
+
+            std::pmr::string msg{"ERR unknown subcommand '", arena};
+            msg += *sub;
+            msg += "' for 'MEMORY'";
+            return resp::Error{std::move(msg)};
+          }})
+
+    .add({.name = "INFO",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            std::pmr::string out{arena};
+            for (const auto &section : detail::INFO_SECTIONS) {
+              // No argument, "all", "everything" or "default" mean all
+              // sections; otherwise only the ones asked for.
+              const bool wanted =
+                args.empty() ||
+                std::ranges::any_of(args, [&](const resp::Type &arg) {
+                  const auto *name = detail::AsBulkString(arg);
+                  if (!name) {
+                    return false;
+                  }
+                  return detail::EqualsIgnoreCase(*name, "all") ||
+                         detail::EqualsIgnoreCase(*name, "everything") ||
+                         detail::EqualsIgnoreCase(*name, "default") ||
+                         detail::EqualsIgnoreCase(*name, section.name);
+                });
+              if (!wanted) {
+                continue;
+              }
+              if (!out.empty()) {
+                out += "\r\n";
+              }
+              section.append(out, store);
+            }
+            return resp::BulkString{std::move(out)};
+          }})
+
     // List operations
     .add({.name = "LPUSH",
+          .flags = CommandEntry::DENY_OOM,
           .fn = [](CommandArgs args, Storage &store,
                    std::pmr::memory_resource *arena) -> resp::Type {
             if (args.size() < 2) {
@@ -182,12 +1708,13 @@ inline constexpr auto COMMANDS =
               if (!val) {
                 return detail::ErrorNotBulkString(arena);
               }
-              list->emplace_front(*val);
+              list->push_front(*val);
             }
-            return resp::Int{static_cast<int>(list->size())};
+            return resp::Int{static_cast<std::int64_t>(list->size())};
           }})
 
     .add({.name = "RPUSH",
+          .flags = CommandEntry::DENY_OOM,
           .fn = [](CommandArgs args, Storage &store,
                    std::pmr::memory_resource *arena) -> resp::Type {
             if (args.size() < 2) {
@@ -210,9 +1737,9 @@ inline constexpr auto COMMANDS =
               if (!val) {
                 return detail::ErrorNotBulkString(arena);
               }
-              list->emplace_back(*val);
+              list->push_back(*val);
             }
-            return resp::Int{static_cast<int>(list->size())};
+            return resp::Int{static_cast<std::int64_t>(list->size())};
           }})
 
     .add({.name = "LPOP",
@@ -252,9 +1779,9 @@ inline constexpr auto COMMANDS =
               if (list->empty()) {
                 return resp::Null{};
               }
-              auto val = std::move(list->front());
+              resp::BulkString val{std::pmr::string{list->front(), arena}};
               list->pop_front();
-              return resp::BulkString{std::pmr::string{val, arena}};
+              return val;
             }
 
             std::pmr::vector<resp::Type> popped{arena};
@@ -303,9 +1830,9 @@ inline constexpr auto COMMANDS =
               if (list->empty()) {
                 return resp::Null{};
               }
-              auto val = std::move(list->back());
+              resp::BulkString val{std::pmr::string{list->back(), arena}};
               list->pop_back();
-              return resp::BulkString{std::pmr::string{val, arena}};
+              return val;
             }
 
             std::pmr::vector<resp::Type> popped{arena};
@@ -317,16 +1844,149 @@ inline constexpr auto COMMANDS =
             return resp::Array{std::move(popped)};
           }})
 
-    .add({.name = "LLEN",
+    .add({.name = "LMOVE",
+          .flags = CommandEntry::DENY_OOM,
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() != 4) {
+              return detail::ErrorArgCount("LMOVE", arena);
+            }
+            const auto from_back = detail::ListEnd(args[2]);
+            const auto to_back = detail::ListEnd(args[3]);
+            if (!from_back || !to_back) {
+              return detail::ErrorSyntax(arena);
+            }
+            return detail::ListMove(args[0], args[1], *from_back, *to_back,
+                                    store, arena);
+          }})
+
+    .add({.name = "RPOPLPUSH",
+          .flags = CommandEntry::DENY_OOM,
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() != 2) {
+              return detail::ErrorArgCount("RPOPLPUSH", arena);
+            }
+            return detail::ListMove(args[0], args[1], true, false, store,
+                                    arena);
+          }})
+
+    .add({.name = "LLEN",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() != 1) {
+              return detail::ErrorArgCount("LLEN", arena);
+            }
+            const auto *key = detail::AsBulkString(args[0]);
+            if (!key) {
+              return detail::ErrorNotBulkString(arena);
+            }
+
+            auto result = store.Get<Storage::List>(std::string_view{*key});
+            if (!result) {
+              if (result.error() == Storage::Error::WrongType) {
+                return detail::ErrorWrongType(arena);
+              }
+              return resp::Int{0};
+            }
+            return resp::Int{static_cast<std::int64_t>((*result)->size())};
+          }})
+
+    .add({.name = "LRANGE",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) {
+            return detail::LRange(args, store, arena);
+          },
+          .read = [](CommandArgs args, Storage::Reader &store,
+                     std::pmr::memory_resource *arena) {
+            return detail::LRange(args, store, arena);
+          }})
+
+    .add({.name = "LINDEX",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() != 2) {
+              return detail::ErrorArgCount("LINDEX", arena);
+            }
+            const auto *key = detail::AsBulkString(args[0]);
+            const auto *index_str = detail::AsBulkString(args[1]);
+            if (!key || !index_str) {
+              return detail::ErrorNotBulkString(arena);
+            }
+            auto index = detail::ParseInt<std::int64_t>(*index_str);
+            if (!index) {
+              return detail::ErrorNotInteger(arena);
+            }
+
+            auto result = store.Get<Storage::List>(std::string_view{*key});
+            if (!result) {
+              if (result.error() == Storage::Error::WrongType) {
+                return detail::ErrorWrongType(arena);
+              }
+              return resp::Null{};
+            }
+            const auto *list = *result;
+            const auto position = detail::ListIndex(*index, list->size());
+            if (!position) {
+              return resp::Null{};
+            }
+            return resp::BulkString{
+              std::pmr::string{*list->Seek(*position), arena}};
+          }})
+
+    .add({.name = "LSET",
+          .flags = CommandEntry::DENY_OOM,
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() != 3) {
+              return detail::ErrorArgCount("LSET", arena);
+            }
+            const auto *key = detail::AsBulkString(args[0]);
+            const auto *index_str = detail::AsBulkString(args[1]);
+            const auto *value = detail::AsBulkString(args[2]);
+            if (!key || !index_str || !value) {
+              return detail::ErrorNotBulkString(arena);
+            }
+            auto index = detail::ParseInt<std::int64_t>(*index_str);
+            if (!index) {
+              return detail::ErrorNotInteger(arena);
+            }
+
+            auto result = store.Find<Storage::List>(std::string_view{*key});
+            if (!result) {
+              if (result.error() == Storage::Error::WrongType) {
+                return detail::ErrorWrongType(arena);
+              }
+              return resp::Error{std::pmr::string{"ERR no such key", arena}};
+            }
+            auto *list = *result;
+            const auto position = detail::ListIndex(*index, list->size());
+            if (!position) {
+              return resp::Error{
+                std::pmr::string{"ERR index out of range", arena}};
+            }
+            list->Replace(list->Seek(*position), std::string_view{*value});
+            return detail::Ok(arena);
+          }})
+
+    .add({.name = "LINSERT",
+          .flags = CommandEntry::DENY_OOM,
           .fn = [](CommandArgs args, Storage &store,
                    std::pmr::memory_resource *arena) -> resp::Type {
-            if (args.size() != 1) {
-              return detail::ErrorArgCount("LLEN", arena);
+            if (args.size() != 4) {
+              return detail::ErrorArgCount("LINSERT", arena);
             }
             const auto *key = detail::AsBulkString(args[0]);
-            if (!key) {
+            const auto *where = detail::AsBulkString(args[1]);
+            const auto *pivot = detail::AsBulkString(args[2]);
+            const auto *value = detail::AsBulkString(args[3]);
+            if (!key || !where || !pivot || !value) {
               return detail::ErrorNotBulkString(arena);
             }
+            const bool after = detail::EqualsIgnoreCase(*where, "AFTER");
+            if (!after && !detail::EqualsIgnoreCase(*where, "BEFORE")) {
+              return detail::ErrorSyntax(arena);
+            }
 
             auto result = store.Find<Storage::List>(std::string_view{*key});
             if (!result) {
@@ -335,14 +1995,23 @@ inline constexpr auto COMMANDS =
               }
               return resp::Int{0};
             }
-            return resp::Int{static_cast<int>((*result)->size())};
+            auto *list = *result;
+            auto it = list->Find(std::string_view{*pivot});
+            if (it == list->end()) {
+              return resp::Int{-1};
+            }
+            if (after) {
+              ++it;
+            }
+            list->Insert(it, std::string_view{*value});
+            return resp::Int{static_cast<std::int64_t>(list->size())};
           }})
 
-    .add({.name = "LRANGE",
+    .add({.name = "LTRIM",
           .fn = [](CommandArgs args, Storage &store,
                    std::pmr::memory_resource *arena) -> resp::Type {
             if (args.size() != 3) {
-              return detail::ErrorArgCount("LRANGE", arena);
+              return detail::ErrorArgCount("LTRIM", arena);
             }
             const auto *key = detail::AsBulkString(args[0]);
             const auto *start_str = detail::AsBulkString(args[1]);
@@ -350,9 +2019,8 @@ inline constexpr auto COMMANDS =
             if (!key || !start_str || !stop_str) {
               return detail::ErrorNotBulkString(arena);
             }
-
-            auto start_opt = detail::ParseInt(std::string_view{*start_str});
-            auto stop_opt = detail::ParseInt(std::string_view{*stop_str});
+            auto start_opt = detail::ParseInt<std::int64_t>(*start_str);
+            auto stop_opt = detail::ParseInt<std::int64_t>(*stop_str);
             if (!start_opt || !stop_opt) {
               return detail::ErrorNotInteger(arena);
             }
@@ -362,26 +2030,154 @@ inline constexpr auto COMMANDS =
               if (result.error() == Storage::Error::WrongType) {
                 return detail::ErrorWrongType(arena);
               }
-              return resp::Array{std::pmr::vector<resp::Type>{arena}};
+              return detail::Ok(arena);
             }
-
-            const auto *list = *result;
-            const auto len = static_cast<int>(list->size());
-            const auto start =
-              *start_opt < 0 ? std::max(0, len + *start_opt) : *start_opt;
+            auto *list = *result;
+            const auto len = static_cast<std::int64_t>(list->size());
+            const auto start = *start_opt < 0
+                                 ? std::max<std::int64_t>(0, len + *start_opt)
+                                 : *start_opt;
             const auto stop =
               std::min(*stop_opt < 0 ? len + *stop_opt : *stop_opt, len - 1);
+            if (start > stop) {
+              list->clear();
+              return detail::Ok(arena);
+            }
+            // Whole nodes outside the range are freed without a look
+            list->EraseBack(static_cast<std::size_t>(len - 1 - stop));
+            list->EraseFront(static_cast<std::size_t>(start));
+            return detail::Ok(arena);
+          }})
+
+    .add({.name = "LREM",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() != 3) {
+              return detail::ErrorArgCount("LREM", arena);
+            }
+            const auto *key = detail::AsBulkString(args[0]);
+            const auto *count_str = detail::AsBulkString(args[1]);
+            const auto *value = detail::AsBulkString(args[2]);
+            if (!key || !count_str || !value) {
+              return detail::ErrorNotBulkString(arena);
+            }
+            auto count = detail::ParseInt<std::int64_t>(*count_str);
+            if (!count || *count == std::numeric_limits<std::int64_t>::min()) {
+              return detail::ErrorNotInteger(arena);
+            }
+
+            auto result = store.Find<Storage::List>(std::string_view{*key});
+            if (!result) {
+              if (result.error() == Storage::Error::WrongType) {
+                return detail::ErrorWrongType(arena);
+              }
+              return resp::Int{0};
+            }
+            // A negative count removes from the tail
+            const auto removed = (*result)->Remove(
+              std::string_view{*value},
+              static_cast<std::size_t>(*count < 0 ? -*count : *count),
+              *count < 0);
+            return resp::Int{static_cast<std::int64_t>(removed)};
+          }})
+
+    .add({.name = "LPOS",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() < 2) {
+              return detail::ErrorArgCount("LPOS", arena);
+            }
+            const auto *key = detail::AsBulkString(args[0]);
+            const auto *value = detail::AsBulkString(args[1]);
+            if (!key || !value) {
+              return detail::ErrorNotBulkString(arena);
+            }
+
+            // RANK n skips the first n-1 matches, from the tail if negative
+            std::int64_t rank = 1;
+            std::optional<std::int64_t> count;
+            std::int64_t maxlen = 0;
+            for (std::size_t i = 2; i < args.size(); i += 2) {
+              const auto *name = detail::AsBulkString(args[i]);
+              if (!name) {
+                return detail::ErrorNotBulkString(arena);
+              }
+              if (i + 1 == args.size()) {
+                return detail::ErrorSyntax(arena);
+              }
+              const auto *arg = detail::AsBulkString(args[i + 1]);
+              if (!arg) {
+                return detail::ErrorNotBulkString(arena);
+              }
+              auto parsed = detail::ParseInt<std::int64_t>(*arg);
+              if (!parsed) {
+                return detail::ErrorNotInteger(arena);
+              }
+              if (detail::EqualsIgnoreCase(*name, "RANK")) {
+                if (*parsed == 0 ||
+                    *parsed == std::numeric_limits<std::int64_t>::min()) {
+                  return resp::Error{std::pmr::string{
+                    "ERR RANK can't be zero: use 1 to start from the first "
+                    "match, 2 from the second ... or use negative to start "
+                    "from the end of the list",
+                    arena}};
+                }
+                rank = *parsed;
+              } else if (detail::EqualsIgnoreCase(*name, "COUNT")) {
+                if (*parsed < 0) {
+                  return resp::Error{std::pmr::string{
+                    "ERR COUNT can't be negative", arena}};
+                }
+                count = *parsed;
+              } else if (detail::EqualsIgnoreCase(*name, "MAXLEN")) {
+                if (*parsed < 0) {
+                  return resp::Error{std::pmr::string{
+                    "ERR MAXLEN can't be negative", arena}};
+                }
+                maxlen = *parsed;
+              } else {
+                return detail::ErrorSyntax(arena);
+              }
+            }
 
-            std::pmr::vector<resp::Type> elements{arena};
-            for (auto i = start; i <= stop; ++i) {
-              elements.emplace_back(
-                resp::BulkString{std::pmr::string{(*list)[i], arena}});
+            std::pmr::vector<resp::Type> found{arena};
+            auto result = store.Get<Storage::List>(std::string_view{*key});
+            if (!result) {
+              if (result.error() == Storage::Error::WrongType) {
+                return detail::ErrorWrongType(arena);
+              }
+              if (!count) {
+                return resp::Null{};
+              }
+              return resp::Array{std::move(found)};
+            }
+
+            // COUNT 0 means every match
+            const auto wanted = static_cast<std::size_t>(count.value_or(1));
+            auto skip = static_cast<std::size_t>(rank < 0 ? -rank : rank) - 1;
+            (*result)->FindEach(
+              std::string_view{*value}, rank < 0,
+              static_cast<std::size_t>(maxlen), [&](std::size_t index) {
+                if (skip > 0) {
+                  --skip;
+                  return true;
+                }
+                found.emplace_back(
+                  resp::Int{static_cast<std::int64_t>(index)});
+                return wanted == 0 || found.size() < wanted;
+              });
+            if (count) {
+              return resp::Array{std::move(found)};
+            }
+            if (found.empty()) {
+              return resp::Null{};
             }
-            return resp::Array{std::move(elements)};
+            return std::move(found.front());
           }})
 
     // Set operations
     .add({.name = "SADD",
+          .flags = CommandEntry::DENY_OOM,
           .fn = [](CommandArgs args, Storage &store,
                    std::pmr::memory_resource *arena) -> resp::Type {
             if (args.size() < 2) {
@@ -405,7 +2201,7 @@ inline constexpr auto COMMANDS =
               if (!member) {
                 return detail::ErrorNotBulkString(arena);
               }
-              if (set->insert(std::string{*member}).second) {
+              if (set->insert(std::string_view{*member})) {
                 ++added;
               }
             }
@@ -438,7 +2234,9 @@ inline constexpr auto COMMANDS =
               if (!member) {
                 return detail::ErrorNotBulkString(arena);
               }
-              removed += static_cast<int>(set->erase(std::string{*member}));
+              if (set->erase(std::string_view{*member})) {
+                ++removed;
+              }
             }
             return resp::Int{removed};
           }})
@@ -454,14 +2252,14 @@ inline constexpr auto COMMANDS =
               return detail::ErrorNotBulkString(arena);
             }
 
-            auto result = store.Find<Storage::Set>(std::string_view{*key});
+            auto result = store.Get<Storage::Set>(std::string_view{*key});
             if (!result) {
               if (result.error() == Storage::Error::WrongType) {
                 return detail::ErrorWrongType(arena);
               }
               return resp::Int{0};
             }
-            return resp::Int{static_cast<int>((*result)->size())};
+            return resp::Int{static_cast<std::int64_t>((*result)->size())};
           }})
 
     .add({.name = "SMEMBERS",
@@ -475,7 +2273,7 @@ inline constexpr auto COMMANDS =
               return detail::ErrorNotBulkString(arena);
             }
 
-            auto result = store.Find<Storage::Set>(std::string_view{*key});
+            auto result = store.Get<Storage::Set>(std::string_view{*key});
             if (!result) {
               if (result.error() == Storage::Error::WrongType) {
                 return detail::ErrorWrongType(arena);
@@ -484,82 +2282,356 @@ inline constexpr auto COMMANDS =
             }
 
             std::pmr::vector<resp::Type> members{arena};
-            for (const auto &m : **result) {
+            members.reserve((*result)->size());
+            (*result)->ForEach([&](std::string_view m) {
               members.emplace_back(
                 resp::BulkString{std::pmr::string{m, arena}});
-            }
+            });
             return resp::Array{std::move(members)};
           }})
 
-    .add({.name = "SINTER",
+    .add({.name = "SSCAN",
           .fn = [](CommandArgs args, Storage &store,
                    std::pmr::memory_resource *arena) -> resp::Type {
-            if (args.empty()) {
-              return detail::ErrorArgCount("SINTER", arena);
+            if (args.size() < 2) {
+              return detail::ErrorArgCount("SSCAN", arena);
             }
-
-            const auto *first_key = detail::AsBulkString(args[0]);
-            if (!first_key) {
+            const auto *key = detail::AsBulkString(args[0]);
+            const auto *cursor_arg = detail::AsBulkString(args[1]);
+            if (!key || !cursor_arg) {
               return detail::ErrorNotBulkString(arena);
             }
+            auto cursor = detail::ParseInt<std::uint64_t>(*cursor_arg);
+            if (!cursor) {
+              return detail::ErrorInvalidCursor(arena);
+            }
+            auto options = detail::ParseScanOptions(args.subspan(2), false);
+            if (!options) {
+              return detail::ErrorSyntax(arena);
+            }
 
-            auto first = store.Find<Storage::Set>(std::string_view{*first_key});
-            if (!first) {
-              if (first.error() == Storage::Error::WrongType) {
+            std::pmr::vector<resp::Type> members{arena};
+            auto result = store.FindSetForScan(std::string_view{*key});
+            if (!result) {
+              if (result.error() == Storage::Error::WrongType) {
                 return detail::ErrorWrongType(arena);
               }
-              return resp::Array{std::pmr::vector<resp::Type>{arena}};
+              return detail::ScanReply(0, std::move(members), arena);
             }
 
-            // Collect other sets
-            std::vector<const Storage::Set *> others;
-            for (std::size_t i = 1; i < args.size(); ++i) {
-              const auto *k = detail::AsBulkString(args[i]);
-              if (!k) {
-                return detail::ErrorNotBulkString(arena);
-              }
-              auto r = store.Find<Storage::Set>(std::string_view{*k});
-              if (!r) {
-                if (r.error() == Storage::Error::WrongType) {
-                  return detail::ErrorWrongType(arena);
-                }
-                return resp::Array{std::pmr::vector<resp::Type>{arena}};
+            auto *set = *result;
+            const GlobPattern pattern{options->pattern, arena};
+            const bool match_all = pattern.MatchesAll();
+            std::size_t visited = 0;
+            auto visit = [&](std::string_view member) {
+              ++visited;
+              if (match_all || pattern.Matches(member)) {
+                members.emplace_back(
+                  resp::BulkString{std::pmr::string{member, arena}});
               }
-              others.push_back(*r);
+            };
+            const auto next = detail::ScanSteps(
+              *cursor, options->count, visited,
+              [&](std::uint64_t c) { return set->Scan(c, visit); });
+            return detail::ScanReply(next, std::move(members), arena);
+          }})
+
+    .add({.name = "SINTER",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.empty()) {
+              return detail::ErrorArgCount("SINTER", arena);
+            }
+
+            std::vector<const Storage::Set *> sets;
+            if (auto error =
+                  detail::IntersectionInputs(args, store, sets, arena)) {
+              return std::move(*error);
             }
 
             std::pmr::vector<resp::Type> result{arena};
-            for (const auto &member : **first) {
-              bool in_all = std::ranges::all_of(
-                others, [&](const auto *s) { return s->contains(member); });
-              if (in_all) {
-                result.emplace_back(
-                  resp::BulkString{std::pmr::string{member, arena}});
+            detail::Intersect(sets, [&](std::string_view member) {
+              result.emplace_back(
+                resp::BulkString{std::pmr::string{member, arena}});
+              return true;
+            });
+            return resp::Array{std::move(result)};
+          }})
+
+    .add({.name = "SINTERCARD",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() < 2) {
+              return detail::ErrorArgCount("SINTERCARD", arena);
+            }
+            const auto *numkeys_arg = detail::AsBulkString(args[0]);
+            if (!numkeys_arg) {
+              return detail::ErrorNotBulkString(arena);
+            }
+            auto numkeys = detail::ParseInt<std::int64_t>(*numkeys_arg);
+            if (!numkeys || *numkeys <= 0) {
+              return resp::Error{std::pmr::string{
+                "ERR numkeys should be greater than 0", arena}};
+            }
+            if (static_cast<std::uint64_t>(*numkeys) > args.size() - 1) {
+              return resp::Error{std::pmr::string{
+                "ERR Number of keys can't be greater than number of args",
+                arena}};
+            }
+
+            const auto keys =
+              args.subspan(1, static_cast<std::size_t>(*numkeys));
+            const auto options = args.subspan(keys.size() + 1);
+            std::size_t limit = 0; // no limit
+            for (std::size_t i = 0; i < options.size(); i += 2) {
+              const auto *name = detail::AsBulkString(options[i]);
+              if (!name || !detail::EqualsIgnoreCase(*name, "LIMIT") ||
+                  i + 1 >= options.size()) {
+                return detail::ErrorSyntax(arena);
+              }
+              const auto *value = detail::AsBulkString(options[i + 1]);
+              auto parsed =
+                value ? detail::ParseInt<std::int64_t>(*value) : std::nullopt;
+              if (!parsed) {
+                return detail::ErrorNotInteger(arena);
+              }
+              if (*parsed < 0) {
+                return resp::Error{
+                  std::pmr::string{"ERR LIMIT can't be negative", arena}};
               }
+              limit = static_cast<std::size_t>(*parsed);
             }
-            return resp::Array{std::move(result)};
+
+            std::vector<const Storage::Set *> sets;
+            if (auto error =
+                  detail::IntersectionInputs(keys, store, sets, arena)) {
+              return std::move(*error);
+            }
+
+            // Counting needs no member copied, and LIMIT stops the walk
+            std::size_t count = 0;
+            detail::Intersect(sets, [&](std::string_view) {
+              return ++count != limit;
+            });
+            return resp::Int{static_cast<std::int64_t>(count)};
+          }})
+
+    .add({.name = "SINTERSTORE",
+          .flags = CommandEntry::DENY_OOM,
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() < 2) {
+              return detail::ErrorArgCount("SINTERSTORE", arena);
+            }
+            const auto *dest = detail::AsBulkString(args[0]);
+            if (!dest) {
+              return detail::ErrorNotBulkString(arena);
+            }
+
+            std::vector<const Storage::Set *> sets;
+            if (auto error = detail::IntersectionInputs(args.subspan(1), store,
+                                                        sets, arena)) {
+              return std::move(*error);
+            }
+
+            // Copied out first: the destination may be one of the inputs
+            std::pmr::vector<std::pmr::string> members{arena};
+            detail::Intersect(sets, [&](std::string_view member) {
+              members.emplace_back(member);
+              return true;
+            });
+            if (members.empty()) {
+              store.Erase(std::string_view{*dest});
+              return resp::Int{0};
+            }
+
+            auto *set = store.Overwrite<Storage::Set>(std::string_view{*dest});
+            for (const auto &member : members) {
+              set->insert(member);
+            }
+            return resp::Int{static_cast<std::int64_t>(set->size())};
+          }})
+
+    .add({.name = "SUNION",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            return detail::SetAlgebra("SUNION", args, false, false, store,
+                                      arena);
+          }})
+
+    .add({.name = "SUNIONSTORE",
+          .flags = CommandEntry::DENY_OOM,
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            return detail::SetAlgebra("SUNIONSTORE", args, false, true, store,
+                                      arena);
+          }})
+
+    .add({.name = "SDIFF",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            return detail::SetAlgebra("SDIFF", args, true, false, store,
+                                      arena);
+          }})
+
+    .add({.name = "SDIFFSTORE",
+          .flags = CommandEntry::DENY_OOM,
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            return detail::SetAlgebra("SDIFFSTORE", args, true, true, store,
+                                      arena);
           }})
 
     .add({.name = "SISMEMBER",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) {
+            return detail::SIsMember(args, store, arena);
+          },
+          .read = [](CommandArgs args, Storage::Reader &store,
+                     std::pmr::memory_resource *arena) {
+            return detail::SIsMember(args, store, arena);
+          }})
+
+    .add({.name = "SPOP",
           .fn = [](CommandArgs args, Storage &store,
                    std::pmr::memory_resource *arena) -> resp::Type {
-            if (args.size() != 2) {
-              return detail::ErrorArgCount("SISMEMBER", arena);
+            if (args.empty() || args.size() > 2) {
+              return detail::ErrorArgCount("SPOP", arena);
             }
             const auto *key = detail::AsBulkString(args[0]);
-            const auto *member = detail::AsBulkString(args[1]);
-            if (!key || !member) {
+            if (!key) {
               return detail::ErrorNotBulkString(arena);
             }
 
+            std::size_t count = 1;
+            if (args.size() == 2) {
+              const auto *cnt = detail::AsBulkString(args[1]);
+              if (!cnt) {
+                return detail::ErrorNotBulkString(arena);
+              }
+              auto parsed = detail::ParseInt<std::int64_t>(*cnt);
+              if (!parsed || *parsed < 0) {
+                return detail::ErrorNotInteger(arena);
+              }
+              count = static_cast<std::size_t>(*parsed);
+            }
+
+            std::pmr::vector<resp::Type> popped{arena};
             auto result = store.Find<Storage::Set>(std::string_view{*key});
             if (!result) {
               if (result.error() == Storage::Error::WrongType) {
                 return detail::ErrorWrongType(arena);
               }
+              if (args.size() == 1) {
+                return resp::Null{};
+              }
+              return resp::Array{std::move(popped)};
+            }
+
+            auto *set = *result;
+            if (args.size() == 1 && set->empty()) {
+              return resp::Null{};
+            }
+            if (count >= set->size()) {
+              popped.reserve(set->size());
+              set->ForEach([&](std::string_view member) {
+                popped.emplace_back(
+                  resp::BulkString{std::pmr::string{member, arena}});
+              });
+              set->clear();
+            } else {
+              popped.reserve(count);
+              for (std::size_t i = 0; i < count; ++i) {
+                // Copied out first: the member's bytes go with the erase
+                auto member = detail::SetMemberReply(
+                  *set, store.RandomIndex(set->size()), arena);
+                set->erase(std::get<resp::BulkString>(member).value);
+                popped.push_back(std::move(member));
+              }
+            }
+            if (args.size() == 1) {
+              return std::move(popped.front());
+            }
+            return resp::Array{std::move(popped)};
+          }})
+
+    .add({.name = "SRANDMEMBER",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.empty() || args.size() > 2) {
+              return detail::ErrorArgCount("SRANDMEMBER", arena);
+            }
+            const auto *key = detail::AsBulkString(args[0]);
+            if (!key) {
+              return detail::ErrorNotBulkString(arena);
+            }
+
+            std::int64_t count = 1;
+            if (args.size() == 2) {
+              const auto *cnt = detail::AsBulkString(args[1]);
+              if (!cnt) {
+                return detail::ErrorNotBulkString(arena);
+              }
+              // Bounded like Redis, so -count cannot overflow
+              auto parsed = detail::ParseInt<std::int64_t>(*cnt);
+              constexpr auto limit = std::numeric_limits<std::int64_t>::max();
+              if (!parsed || *parsed < -limit / 2 || *parsed > limit / 2) {
+                return detail::ErrorNotInteger(arena);
+              }
+              count = *parsed;
+            }
+
+            auto result = store.Get<Storage::Set>(std::string_view{*key});
+            if (!result && result.error() == Storage::Error::WrongType) {
+              return detail::ErrorWrongType(arena);
+            }
+            const auto *set = result ? *result : nullptr;
+            if (args.size() == 1) {
+              if (!set || set->empty()) {
+                return resp::Null{};
+              }
+              return detail::SetMemberReply(
+                *set, store.RandomIndex(set->size()), arena);
+            }
+            if (!set || set->empty() || count == 0) {
+              return resp::Array{std::pmr::vector<resp::Type>{arena}};
+            }
+            return detail::RandomMembers(*set, count, store, arena);
+          }})
+
+    .add({.name = "SMOVE",
+          .flags = CommandEntry::DENY_OOM,
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() != 3) {
+              return detail::ErrorArgCount("SMOVE", arena);
+            }
+            const auto *source = detail::AsBulkString(args[0]);
+            const auto *dest = detail::AsBulkString(args[1]);
+            const auto *member = detail::AsBulkString(args[2]);
+            if (!source || !dest || !member) {
+              return detail::ErrorNotBulkString(arena);
+            }
+
+            // Both types are checked before anything moves
+            auto from = store.Find<Storage::Set>(std::string_view{*source});
+            auto to = store.Find<Storage::Set>(std::string_view{*dest});
+            if ((!from && from.error() == Storage::Error::WrongType) ||
+                (!to && to.error() == Storage::Error::WrongType)) {
+              return detail::ErrorWrongType(arena);
+            }
+            if (!from || !(*from)->contains(std::string_view{*member})) {
               return resp::Int{0};
             }
-            return resp::Int{(*result)->contains(std::string{*member}) ? 1 : 0};
+            if (*source == *dest) {
+              return resp::Int{1};
+            }
+
+            (*from)->erase(std::string_view{*member});
+            auto target =
+              store.FindOrCreate<Storage::Set>(std::string_view{*dest});
+            (*target)->insert(std::string_view{*member});
+            return resp::Int{1};
           }})
 
     // Expiration
@@ -575,26 +2647,102 @@ inline constexpr auto COMMANDS =
               return detail::ErrorNotBulkString(arena);
             }
 
-            auto secs = detail::ParseInt(std::string_view{*secs_str});
-            if (!secs || *secs < 0) {
+            auto secs =
+              detail::ParseInt<std::int64_t>(std::string_view{*secs_str});
+            if (!secs) {
               return detail::ErrorNotInteger(arena);
             }
+            // Negative times are already due
+            if (*secs > detail::MAX_EXPIRE_MS / 1000 ||
+                *secs < -detail::MAX_EXPIRE_MS / 1000) {
+              return detail::ErrorInvalidExpire("expire", arena);
+            }
 
-            bool ok = store.SetExpiry(std::string_view{*key},
-                                      std::chrono::seconds{*secs});
+            bool ok = detail::ExpireAt(store, std::string_view{*key},
+                                       Storage::NowMs() + *secs * 1000);
             return resp::Int{ok ? 1 : 0};
           }})
 
-    .add({.name = "TTL",
+    .add({.name = "PEXPIRE",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() != 2) {
+              return detail::ErrorArgCount("PEXPIRE", arena);
+            }
+            const auto *key = detail::AsBulkString(args[0]);
+            const auto *ms_str = detail::AsBulkString(args[1]);
+            if (!key || !ms_str) {
+              return detail::ErrorNotBulkString(arena);
+            }
+
+            auto ms = detail::ParseInt<std::int64_t>(std::string_view{*ms_str});
+            if (!ms) {
+              return detail::ErrorNotInteger(arena);
+            }
+            if (*ms > detail::MAX_EXPIRE_MS || *ms < -detail::MAX_EXPIRE_MS) {
+              return detail::ErrorInvalidExpire("pexpire", arena);
+            }
+
+            bool ok = detail::ExpireAt(store, std::string_view{*key},
+                                       Storage::NowMs() + *ms);
+            return resp::Int{ok ? 1 : 0};
+          }})
+
+    .add({.name = "PEXPIREAT",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) -> resp::Type {
+            if (args.size() != 2) {
+              return detail::ErrorArgCount("PEXPIREAT", arena);
+            }
+            const auto *key = detail::AsBulkString(args[0]);
+            const auto *ts_str = detail::AsBulkString(args[1]);
+            if (!key || !ts_str) {
+              return detail::ErrorNotBulkString(arena);
+            }
+
+            auto ts = detail::ParseInt<std::int64_t>(std::string_view{*ts_str});
+            if (!ts) {
+              return detail::ErrorNotInteger(arena);
+            }
+            if (*ts > detail::MAX_EXPIRE_MS || *ts < -detail::MAX_EXPIRE_MS) {
+              return detail::ErrorInvalidExpire("pexpireat", arena);
+            }
+
+            bool ok = detail::ExpireAt(store, std::string_view{*key},
+                                       Storage::DeadlineFromUnixMs(*ts));
+            return resp::Int{ok ? 1 : 0};
+          }})
+
+    .add({.name = "PERSIST",
           .fn = [](CommandArgs args, Storage &store,
                    std::pmr::memory_resource *arena) -> resp::Type {
             if (args.size() != 1) {
-              return detail::ErrorArgCount("TTL", arena);
+              return detail::ErrorArgCount("PERSIST", arena);
             }
             const auto *key = detail::AsBulkString(args[0]);
             if (!key) {
               return detail::ErrorNotBulkString(arena);
             }
 
-            return resp::Int{store.GetTtl(std::string_view{*key})};
+            return resp::Int{store.Persist(std::string_view{*key}) ? 1 : 0};
+          }})
+
+    .add({.name = "TTL",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) {
+            return detail::Ttl(args, store, arena);
+          },
+          .read = [](CommandArgs args, Storage::Reader &store,
+                     std::pmr::memory_resource *arena) {
+            return detail::Ttl(args, store, arena);
+          }})
+
+    .add({.name = "PTTL",
+          .fn = [](CommandArgs args, Storage &store,
+                   std::pmr::memory_resource *arena) {
+            return detail::Pttl(args, store, arena);
+          },
+          .read = [](CommandArgs args, Storage::Reader &store,
+                     std::pmr::memory_resource *arena) {
+            return detail::Pttl(args, store, arena);
           }});
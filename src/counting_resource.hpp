@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+
+// Forwards to an upstream resource and keeps a running total of the bytes
+// currently handed out, which is what maxmemory is enforced against. The
+// total is atomic because the lazy freer deallocates from its own thread.
+class CountingResource : public std::pmr::memory_resource {
+public:
+  explicit CountingResource(std::pmr::memory_resource *upstream =
+                              std::pmr::new_delete_resource()) noexcept
+      : upstream_{upstream} {}
+
+  CountingResource(const CountingResource &) = delete;
+  CountingResource &operator=(const CountingResource &) = delete;
+
+  std::size_t Allocated() const noexcept {
+    return allocated_.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::pmr::memory_resource *upstream_;
+  std::atomic<std::size_t> allocated_ = 0;
+
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    void *p = upstream_->allocate(bytes, alignment);
+    allocated_.fetch_add(bytes, std::memory_order_relaxed);
+    return p;
+  }
+
+  void do_deallocate(void *p, std::size_t bytes,
+                     std::size_t alignment) override {
+    upstream_->deallocate(p, bytes, alignment);
+    allocated_.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+    noexcept override {
+    return this == &other;
+  }
+};
@@ -0,0 +1,30 @@
+#include "dense_set.hpp"
+
+bool DenseSet::insert(std::string_view member) {
+  auto [it, inserted] = index_.emplace(member, members_.size());
+  if (inserted) {
+    members_.push_back(&it->first);
+  }
+  return inserted;
+}
+
+bool DenseSet::erase(std::string_view member) {
+  // Const lookups never advance a resize, so `it` stays valid for erase()
+  const auto &index = index_;
+  const auto it = index.find(member);
+  if (it == index.end()) {
+    return false;
+  }
+
+  // Fill the hole with the last member, so the array stays dense
+  const auto position = it->second;
+  const auto *last = members_.back();
+  if (last != &it->first) {
+    members_[position] = last;
+    const_cast<std::size_t &>(index.find(*last)->second) = position;
+  }
+  members_.pop_back();
+  index_.erase(it);
+  index_.ShrinkIfNeeded();
+  return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "dict.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A hash set that also keeps its members in a dense array, so member i is
+// a single load for any i < size(). That makes a uniformly random member
+// O(1) and free of the bias that picking a random bucket and then a random
+// node in it would have, and lets parallel walks split the set by index.
+//
+// The members themselves live in an index Dict that maps each one to its
+// position in the array; the array only points at the keys stored in the
+// Dict's nodes. Erasing moves the last member into the hole, so positions
+// are not stable across erases.
+class DenseSet {
+public:
+  using Index = Dict<std::size_t>;
+
+  static constexpr std::size_t NODE_SIZE = Index::NODE_SIZE;
+  static constexpr std::size_t NODE_ALIGN = Index::NODE_ALIGN;
+
+  explicit DenseSet(std::pmr::memory_resource *resource =
+                      std::pmr::get_default_resource()) noexcept
+      : index_{resource}, members_{resource} {}
+
+  std::size_t size() const noexcept { return members_.size(); }
+  bool empty() const noexcept { return members_.empty(); }
+
+  bool contains(std::string_view member) const {
+    return index_.contains(member);
+  }
+  // Both return whether the set changed
+  bool insert(std::string_view member);
+  bool erase(std::string_view member);
+  void clear() noexcept {
+    members_.clear();
+    members_.shrink_to_fit();
+    index_.clear();
+  }
+  void Reserve(std::size_t count) {
+    index_.Reserve(count);
+    members_.reserve(count);
+  }
+
+  // The member at `position`, which is below size()
+  const std::pmr::string &At(std::size_t position) const noexcept {
+    return *members_[position];
+  }
+  // Every member as a const std::pmr::string &, in position order
+  auto Members() const {
+    return members_ | std::views::transform(
+                        [](const auto *m) -> const std::pmr::string & {
+                          return *m;
+                        });
+  }
+
+  // Like Dict::Scan, for SSCAN: positions move on erase, cursors do not
+  template <typename F> std::uint64_t Scan(std::uint64_t cursor, F &&visit) {
+    return index_.Scan(cursor, [&](const Index::value_type &node) {
+      visit(node.first);
+    });
+  }
+
+  // For memory accounting and defrag
+  std::size_t BucketCount() const noexcept { return index_.BucketCount(); }
+  std::size_t ArrayCapacity() const noexcept { return members_.capacity(); }
+  template <typename F> std::uint64_t ScanNodes(std::uint64_t cursor,
+                                                F &&visit) {
+    return index_.Scan(cursor, visit);
+  }
+  // Dict::Reallocate for a node found by ScanNodes, keeping the array in
+  // step with the node's new address
+  void Reallocate(Index::value_type &node) {
+    auto &fresh = index_.Reallocate(node);
+    members_[fresh.second] = &fresh.first;
+  }
+
+  std::pmr::memory_resource *resource() const noexcept {
+    return index_.resource();
+  }
+
+private:
+  Index index_;
+  std::pmr::vector<const std::pmr::string *> members_;
+};
@@ -0,0 +1,88 @@
+#include "dense_set.hpp"
+
+#include "counting_resource.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <set>
+#include <string>
+
+namespace {
+
+// Every position holds a distinct member, and the index agrees
+void RequireSame(const DenseSet &set, const std::set<std::string> &model) {
+  REQUIRE(set.size() == model.size());
+  std::set<std::string> seen;
+  for (std::size_t i = 0; i < set.size(); ++i) {
+    REQUIRE(seen.emplace(set.At(i)).second);
+  }
+  REQUIRE(seen == model);
+  for (const auto &member : model) {
+    REQUIRE(set.contains(member));
+  }
+}
+
+} // namespace
+
+TEST_CASE("DenseSet matches std::set", "[dense_set]") {
+  CountingResource memory;
+  DenseSet set{&memory};
+  std::set<std::string> model;
+  std::mt19937_64 rng{11};
+  std::uniform_int_distribution<int> pick{0, 2'000};
+
+  // Inserts dominate at first, then erases, so the set grows past several
+  // resizes and shrinks back through them
+  for (auto round = 0; round < 2; ++round) {
+    for (auto i = 0; i < 20'000; ++i) {
+      const auto member = "m" + std::to_string(pick(rng));
+      if ((i % 3 == 0) == (round == 0)) {
+        REQUIRE(set.erase(member) == (model.erase(member) == 1));
+      } else {
+        REQUIRE(set.insert(member) == model.insert(member).second);
+      }
+    }
+    RequireSame(set, model);
+  }
+
+  // Erasing the last position needs no move
+  const std::string last{set.At(set.size() - 1)};
+  REQUIRE(set.erase(last));
+  model.erase(last);
+  RequireSame(set, model);
+
+  for (const auto &member : model) {
+    REQUIRE(set.erase(member));
+  }
+  REQUIRE(set.empty());
+  REQUIRE_FALSE(set.erase("m1"));
+
+  set.clear();
+  REQUIRE(memory.Allocated() == 0);
+}
+
+TEST_CASE("DenseSet Reallocate keeps positions", "[dense_set]") {
+  DenseSet set;
+  std::set<std::string> model;
+  for (auto i = 0; i < 500; ++i) {
+    const auto member = "a member long enough to live on the heap " +
+                        std::to_string(i);
+    set.insert(member);
+    model.insert(member);
+  }
+
+  std::uint64_t cursor = 0;
+  do {
+    cursor = set.ScanNodes(cursor, [&](DenseSet::Index::value_type &node) {
+      set.Reallocate(node);
+    });
+  } while (cursor != 0);
+  RequireSame(set, model);
+
+  for (std::size_t i = 0; i < set.size(); i += 2) {
+    const std::string member{set.At(i)};
+    REQUIRE(set.erase(member));
+    model.erase(member);
+  }
+  RequireSame(set, model);
+}
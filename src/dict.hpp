@@ -0,0 +1,576 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace detail {
+
+template <typename Mapped> struct DictValue {
+  using type = std::pair<const std::pmr::string, Mapped>;
+};
+template <> struct DictValue<void> {
+  using type = const std::pmr::string;
+};
+
+} // namespace detail
+
+// Chained hash table keyed by strings, used for the keyspace and for sets.
+//
+// Bucket counts are powers of two and resizing is incremental, as in Redis:
+// while a resize is in progress entries live in two tables, and every lookup,
+// insert or erase by key moves one more bucket across, so no single command
+// pays for rehashing millions of keys. The power-of-two layout is also what
+// lets Scan hand out reverse-binary cursors that survive any number of
+// resizes between calls.
+//
+// Dict<Mapped> iterates std::pair<const std::pmr::string, Mapped>; Dict<void>
+// is a set and iterates the keys themselves. Keys and nodes are allocated
+// from the dict's memory resource.
+//
+// Lookups and inserts may advance the resize and invalidate iterators;
+// erase(iterator) never does, so erasing while iterating is safe.
+template <typename Mapped> class Dict {
+  static constexpr bool IS_SET = std::is_void_v<Mapped>;
+
+public:
+  using key_type = std::pmr::string;
+  using value_type = typename detail::DictValue<Mapped>::type;
+  using size_type = std::size_t;
+
+private:
+  struct Node {
+    Node *next = nullptr;
+    std::size_t hash;
+    value_type value;
+
+    template <typename K, typename... Args>
+    Node(std::size_t hash, std::pmr::memory_resource *resource, K &&key,
+         Args &&...args)
+        : hash{hash}
+        , value{MakeValue(resource, std::forward<K>(key),
+                          std::forward<Args>(args)...)} {}
+  };
+
+  struct Table {
+    Node **buckets = nullptr;
+    std::size_t size = 0;
+    std::size_t mask = 0;
+    std::size_t used = 0;
+  };
+
+  template <bool Const> class Iterator {
+    using DictPtr = std::conditional_t<Const, const Dict *, Dict *>;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Dict::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer =
+      std::conditional_t<Const, const value_type *, value_type *>;
+    using reference =
+      std::conditional_t<Const, const value_type &, value_type &>;
+
+    Iterator() = default;
+    // iterator -> const_iterator
+    operator Iterator<true>() const
+      requires(!Const)
+    {
+      return Iterator<true>{dict_, table_, bucket_, node_};
+    }
+
+    reference operator*() const { return node_->value; }
+    pointer operator->() const { return &node_->value; }
+
+    Iterator &operator++() {
+      node_ = node_->next;
+      if (!node_) {
+        ++bucket_;
+        Settle();
+      }
+      return *this;
+    }
+    Iterator operator++(int) {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    friend bool operator==(const Iterator &a, const Iterator &b) noexcept {
+      return a.node_ == b.node_;
+    }
+
+  private:
+    friend class Dict;
+
+    DictPtr dict_ = nullptr;
+    int table_ = 0;
+    std::size_t bucket_ = 0;
+    Node *node_ = nullptr;
+
+    Iterator(DictPtr dict, int table, std::size_t bucket, Node *node)
+        : dict_{dict}, table_{table}, bucket_{bucket}, node_{node} {}
+
+    // Moves to the first node at or after (table_, bucket_)
+    void Settle() {
+      for (; table_ < 2; ++table_, bucket_ = 0) {
+        const auto &table = dict_->tables_[table_];
+        for (; bucket_ < table.size; ++bucket_) {
+          if (table.buckets[bucket_]) {
+            node_ = table.buckets[bucket_];
+            return;
+          }
+        }
+      }
+      node_ = nullptr;
+    }
+  };
+
+public:
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  // Node footprint, so callers can ask the allocator about an element
+  static constexpr std::size_t NODE_SIZE = sizeof(Node);
+  static constexpr std::size_t NODE_ALIGN = alignof(Node);
+
+  explicit Dict(std::pmr::memory_resource *resource =
+                  std::pmr::get_default_resource()) noexcept
+      : resource_{resource} {}
+
+  Dict(const Dict &other, std::pmr::memory_resource *resource)
+      : resource_{resource} {
+    Reserve(other.size());
+    for (const auto &value : other) {
+      if constexpr (IS_SET) {
+        emplace(value);
+      } else {
+        emplace(value.first, value.second);
+      }
+    }
+  }
+
+  Dict(Dict &&other) noexcept
+      : resource_{other.resource_}
+      , tables_{std::exchange(other.tables_, {})}
+      , rehash_idx_{std::exchange(other.rehash_idx_, NOT_REHASHING)} {}
+
+  Dict &operator=(Dict &&other) noexcept {
+    if (this != &other) {
+      clear();
+      if (resource_ == other.resource_) {
+        tables_ = std::exchange(other.tables_, {});
+        rehash_idx_ = std::exchange(other.rehash_idx_, NOT_REHASHING);
+      } else {
+        // Different resources: elements have to be rebuilt in ours
+        Reserve(other.size());
+        for (auto &value : other) {
+          if constexpr (IS_SET) {
+            emplace(value);
+          } else {
+            emplace(value.first, std::move(value.second));
+          }
+        }
+        other.clear();
+      }
+    }
+    return *this;
+  }
+
+  Dict(const Dict &) = delete;
+  Dict &operator=(const Dict &) = delete;
+
+  ~Dict() { clear(); }
+
+  std::pmr::memory_resource *resource() const noexcept { return resource_; }
+
+  std::size_t size() const noexcept {
+    return tables_[0].used + tables_[1].used;
+  }
+  bool empty() const noexcept { return size() == 0; }
+
+  iterator begin() noexcept {
+    iterator it{this, 0, 0, nullptr};
+    it.Settle();
+    return it;
+  }
+  iterator end() noexcept { return {}; }
+  const_iterator begin() const noexcept {
+    const_iterator it{this, 0, 0, nullptr};
+    it.Settle();
+    return it;
+  }
+  const_iterator end() const noexcept { return {}; }
+
+  static std::size_t Hash(std::string_view key) noexcept {
+    return std::hash<std::string_view>{}(key);
+  }
+
+  iterator find(std::string_view key) { return find(key, Hash(key)); }
+  const_iterator find(std::string_view key) const {
+    return find(key, Hash(key));
+  }
+  // The same with Hash(key) already computed, e.g. by a sharded owner
+  iterator find(std::string_view key, std::size_t hash) {
+    RehashStep(1);
+    return Find(key, hash);
+  }
+  const_iterator find(std::string_view key, std::size_t hash) const {
+    return const_cast<Dict *>(this)->Find(key, hash);
+  }
+  bool contains(std::string_view key) const { return find(key) != end(); }
+
+  // Inserts unless the key exists; `key` is anything a std::pmr::string can
+  // be built from, and `args` construct the mapped value.
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> emplace(K &&key, Args &&...args) {
+    const auto hash = Hash(std::string_view{key});
+    return EmplaceHashed(hash, std::forward<K>(key),
+                         std::forward<Args>(args)...);
+  }
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> EmplaceHashed(std::size_t hash, K &&key,
+                                          Args &&...args) {
+    const std::string_view view{key};
+    RehashStep(1);
+    if (auto it = Find(view, hash); it != end()) {
+      return {it, false};
+    }
+
+    ExpandIfNeeded();
+    const auto [t, bucket] = Locate(hash);
+    auto *node =
+      NewNode(hash, std::forward<K>(key), std::forward<Args>(args)...);
+    auto &table = tables_[t];
+    node->next = table.buckets[bucket];
+    table.buckets[bucket] = node;
+    ++table.used;
+    return {iterator{this, t, bucket, node}, true};
+  }
+
+  template <typename K>
+  std::pair<iterator, bool> insert(K &&key)
+    requires IS_SET
+  {
+    return emplace(std::forward<K>(key));
+  }
+
+  // Returns the iterator following `pos`.
+  iterator erase(const_iterator pos) {
+    iterator next{this, pos.table_, pos.bucket_, pos.node_};
+    ++next;
+    Unlink(pos.table_, pos.bucket_, pos.node_);
+    DeleteNode(pos.node_);
+    return next;
+  }
+
+  std::size_t erase(std::string_view key) {
+    auto it = find(key);
+    if (it == end()) {
+      return 0;
+    }
+    erase(it);
+    ShrinkIfNeeded();
+    return 1;
+  }
+
+  void clear() noexcept {
+    for (auto &table : tables_) {
+      for (std::size_t b = 0; b < table.size; ++b) {
+        for (auto *node = table.buckets[b]; node;) {
+          auto *next = node->next;
+          DeleteNode(node);
+          node = next;
+        }
+      }
+      FreeBuckets(table);
+    }
+    rehash_idx_ = NOT_REHASHING;
+  }
+
+  void swap(Dict &other) noexcept {
+    std::swap(resource_, other.resource_);
+    std::swap(tables_, other.tables_);
+    std::swap(rehash_idx_, other.rehash_idx_);
+  }
+
+  // Sizes the table for `count` elements up front (only when empty).
+  void Reserve(std::size_t count) {
+    if (empty() && !Rehashing()) {
+      FreeBuckets(tables_[0]);
+      tables_[0] = NewTable(std::bit_ceil(std::max(count, INITIAL_SIZE)));
+    }
+  }
+
+  // Moves up to `buckets` buckets of an in-progress resize. Returns true
+  // while there is more to do.
+  bool RehashStep(std::size_t buckets) {
+    if (!Rehashing()) {
+      return false;
+    }
+    auto &from = tables_[0];
+    auto &to = tables_[1];
+    auto empty_visits = buckets * 10;
+    while (buckets-- > 0 && from.used != 0) {
+      while (!from.buckets[rehash_idx_]) {
+        ++rehash_idx_;
+        if (--empty_visits == 0) {
+          return true;
+        }
+      }
+      for (auto *node = from.buckets[rehash_idx_]; node;) {
+        auto *next = node->next;
+        auto &slot = to.buckets[node->hash & to.mask];
+        node->next = slot;
+        slot = node;
+        --from.used;
+        ++to.used;
+        node = next;
+      }
+      from.buckets[rehash_idx_++] = nullptr;
+    }
+
+    if (from.used != 0) {
+      return true;
+    }
+    FreeBuckets(from);
+    from = std::exchange(to, Table{});
+    rehash_idx_ = NOT_REHASHING;
+    return false;
+  }
+
+  // Starts shrinking if the table is mostly empty. Called by erase(key);
+  // owners that erase through iterators call it once they are done.
+  void ShrinkIfNeeded() {
+    const auto &table = tables_[0];
+    if (!Rehashing() && table.size > INITIAL_SIZE &&
+        table.used * MIN_FILL_RATIO < table.size) {
+      Resize(std::bit_ceil(std::max(table.used, INITIAL_SIZE)));
+    }
+  }
+
+  bool Rehashing() const noexcept { return rehash_idx_ != NOT_REHASHING; }
+
+  // Buckets of both tables, for sampling and incremental walks: indexes
+  // [0, BucketCount()) are stable only until the next resize step.
+  std::size_t BucketCount() const noexcept {
+    return tables_[0].size + tables_[1].size;
+  }
+  template <typename F> void ForEachInBucket(std::size_t bucket, F &&visit) {
+    const auto &table = bucket < tables_[0].size ? tables_[0] : tables_[1];
+    const auto index = bucket < tables_[0].size ? bucket
+                                                : bucket - tables_[0].size;
+    for (auto *node = table.buckets[index]; node;) {
+      auto *next = node->next;
+      visit(node->value);
+      node = next;
+    }
+  }
+
+  // Visits one step's worth of elements starting at `cursor` and returns the
+  // cursor for the next call, or 0 once the walk is complete. Cursors count
+  // up in reverse-binary order, so every element present for the whole walk
+  // is visited at least once even if the table grows or shrinks in between
+  // (some may be visited twice).
+  template <typename F> std::uint64_t Scan(std::uint64_t cursor, F &&visit) {
+    if (empty()) {
+      return 0;
+    }
+    auto visit_bucket = [&](const Table &table, std::uint64_t index) {
+      for (auto *node = table.buckets[index & table.mask]; node;) {
+        auto *next = node->next;
+        visit(node->value);
+        node = next;
+      }
+    };
+
+    if (!Rehashing()) {
+      const auto &table = tables_[0];
+      visit_bucket(table, cursor);
+      return NextCursor(cursor, table.mask);
+    }
+
+    // Visit the cursor's bucket in the small table, then every bucket of the
+    // large table that it expands to.
+    const auto *small = &tables_[0];
+    const auto *large = &tables_[1];
+    if (small->size > large->size) {
+      std::swap(small, large);
+    }
+    visit_bucket(*small, cursor);
+    do {
+      visit_bucket(*large, cursor);
+      cursor = NextCursor(cursor, large->mask);
+    } while (cursor & (small->mask ^ large->mask));
+    return cursor;
+  }
+
+  // Moves an element into a freshly allocated node, for defragmentation.
+  // Keys are const, so the key is copied into a fresh buffer rather than
+  // moved. Returns the new element.
+  value_type &Reallocate(value_type &value) {
+    const auto &key = KeyOf(value);
+    const auto hash = Hash(key);
+    const auto [t, bucket] = Locate(hash);
+    auto **link = &tables_[t].buckets[bucket];
+    while (&(*link)->value != &value) {
+      link = &(*link)->next;
+    }
+    auto *old = *link;
+
+    Node *fresh;
+    if constexpr (IS_SET) {
+      fresh = NewNode(hash, key);
+    } else {
+      fresh = NewNode(hash, key, std::move(value.second));
+    }
+    fresh->next = old->next;
+    *link = fresh;
+    DeleteNode(old);
+    return fresh->value;
+  }
+
+private:
+  static constexpr std::size_t INITIAL_SIZE = 4;
+  static constexpr std::size_t MIN_FILL_RATIO = 8; // shrink below 1/8 full
+  static constexpr std::size_t NOT_REHASHING = -1;
+
+  std::pmr::memory_resource *resource_;
+  std::array<Table, 2> tables_{};
+  // Buckets of tables_[0] below this index have moved to tables_[1]
+  std::size_t rehash_idx_ = NOT_REHASHING;
+
+  static const std::pmr::string &KeyOf(const value_type &value) noexcept {
+    if constexpr (IS_SET) {
+      return value;
+    } else {
+      return value.first;
+    }
+  }
+
+  template <typename K, typename... Args>
+  static value_type MakeValue(std::pmr::memory_resource *resource, K &&key,
+                              Args &&...args) {
+    if constexpr (IS_SET) {
+      return value_type(std::forward<K>(key), resource);
+    } else {
+      return value_type(std::piecewise_construct,
+                        std::forward_as_tuple(std::forward<K>(key), resource),
+                        std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+  }
+
+  static std::uint64_t Reverse(std::uint64_t v) noexcept {
+    v = ((v >> 1) & 0x5555555555555555ULL) | ((v & 0x5555555555555555ULL) << 1);
+    v = ((v >> 2) & 0x3333333333333333ULL) | ((v & 0x3333333333333333ULL) << 2);
+    v = ((v >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((v & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    v = ((v >> 8) & 0x00FF00FF00FF00FFULL) | ((v & 0x00FF00FF00FF00FFULL) << 8);
+    v = ((v >> 16) & 0x0000FFFF0000FFFFULL) |
+        ((v & 0x0000FFFF0000FFFFULL) << 16);
+    return (v >> 32) | (v << 32);
+  }
+
+  // Increments the bits covered by `mask`, most significant first
+  static std::uint64_t NextCursor(std::uint64_t cursor,
+                                  std::uint64_t mask) noexcept {
+    cursor |= ~mask;
+    return Reverse(Reverse(cursor) + 1);
+  }
+
+  // Where an element with this hash lives (or would be inserted): buckets
+  // of the old table that were not moved yet still own their elements.
+  std::pair<int, std::size_t> Locate(std::size_t hash) const noexcept {
+    const auto bucket = hash & tables_[0].mask;
+    if (!Rehashing() || bucket >= rehash_idx_) {
+      return {0, bucket};
+    }
+    return {1, hash & tables_[1].mask};
+  }
+
+  iterator Find(std::string_view key, std::size_t hash) {
+    if (empty()) {
+      return end();
+    }
+    const auto [t, bucket] = Locate(hash);
+    for (auto *node = tables_[t].buckets[bucket]; node; node = node->next) {
+      if (node->hash == hash && KeyOf(node->value) == key) {
+        return iterator{this, t, bucket, node};
+      }
+    }
+    return end();
+  }
+
+  template <typename K, typename... Args>
+  Node *NewNode(std::size_t hash, K &&key, Args &&...args) {
+    std::pmr::polymorphic_allocator<Node> alloc{resource_};
+    auto *node = alloc.allocate(1);
+    try {
+      std::construct_at(node, hash, resource_, std::forward<K>(key),
+                        std::forward<Args>(args)...);
+    } catch (...) {
+      alloc.deallocate(node, 1);
+      throw;
+    }
+    return node;
+  }
+
+  void DeleteNode(Node *node) noexcept {
+    std::destroy_at(node);
+    std::pmr::polymorphic_allocator<Node>{resource_}.deallocate(node, 1);
+  }
+
+  Table NewTable(std::size_t size) {
+    std::pmr::polymorphic_allocator<Node *> alloc{resource_};
+    Table table{
+      .buckets = alloc.allocate(size), .size = size, .mask = size - 1};
+    std::fill_n(table.buckets, size, nullptr);
+    return table;
+  }
+
+  void FreeBuckets(Table &table) noexcept {
+    if (table.buckets) {
+      std::pmr::polymorphic_allocator<Node *>{resource_}.deallocate(
+        table.buckets, table.size);
+    }
+    table = Table{};
+  }
+
+  void Unlink(int t, std::size_t bucket, Node *node) noexcept {
+    auto &table = tables_[t];
+    auto **link = &table.buckets[bucket];
+    while (*link != node) {
+      link = &(*link)->next;
+    }
+    *link = node->next;
+    --table.used;
+  }
+
+  void Resize(std::size_t size) {
+    if (tables_[0].size == 0) {
+      tables_[0] = NewTable(size);
+      return;
+    }
+    tables_[1] = NewTable(size);
+    rehash_idx_ = 0;
+  }
+
+  void ExpandIfNeeded() {
+    const auto &table = tables_[0];
+    if (table.size == 0) {
+      Resize(INITIAL_SIZE);
+    } else if (!Rehashing() && table.used >= table.size) {
+      Resize(table.size * 2);
+    }
+  }
+};
@@ -0,0 +1,189 @@
+#include "dict.hpp"
+
+#include "counting_resource.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string Key(int i) { return "key:" + std::to_string(i); }
+
+// Runs a full scan, calling `between` after every step
+template <typename D, typename F>
+std::multiset<std::string> ScanAll(D &dict, F &&between) {
+  std::multiset<std::string> seen;
+  std::uint64_t cursor = 0;
+  do {
+    cursor = dict.Scan(cursor, [&](const auto &value) {
+      if constexpr (requires { value.first; }) {
+        seen.emplace(value.first);
+      } else {
+        seen.emplace(value);
+      }
+    });
+    between();
+  } while (cursor != 0);
+  return seen;
+}
+
+} // namespace
+
+TEST_CASE("Dict basic operations", "[dict]") {
+  Dict<int> dict;
+
+  SECTION("Insert, find and erase") {
+    auto [it, inserted] = dict.emplace(std::string_view{"a"}, 1);
+    REQUIRE(inserted);
+    REQUIRE(it->second == 1);
+    REQUIRE_FALSE(dict.emplace(std::string_view{"a"}, 2).second);
+    REQUIRE(dict.find("a")->second == 1);
+    REQUIRE(dict.size() == 1);
+
+    REQUIRE(dict.erase("a") == 1);
+    REQUIRE(dict.erase("a") == 0);
+    REQUIRE(dict.find("a") == dict.end());
+    REQUIRE(dict.empty());
+  }
+
+  SECTION("Growing keeps every element reachable") {
+    bool saw_rehash = false;
+    for (auto i = 0; i < 10'000; ++i) {
+      dict.emplace(Key(i), i);
+      saw_rehash |= dict.Rehashing();
+    }
+    REQUIRE(saw_rehash);
+    REQUIRE(dict.size() == 10'000);
+    for (auto i = 0; i < 10'000; ++i) {
+      auto it = dict.find(Key(i));
+      REQUIRE(it != dict.end());
+      REQUIRE(it->second == i);
+    }
+
+    std::size_t iterated = 0;
+    for ([[maybe_unused]] const auto &value : dict) {
+      ++iterated;
+    }
+    REQUIRE(iterated == 10'000);
+  }
+
+  SECTION("Deleting most elements shrinks the table") {
+    for (auto i = 0; i < 10'000; ++i) {
+      dict.emplace(Key(i), i);
+    }
+    const auto buckets = dict.BucketCount();
+    for (auto i = 0; i < 9'990; ++i) {
+      REQUIRE(dict.erase(Key(i)) == 1);
+    }
+    while (dict.RehashStep(100)) {
+    }
+    REQUIRE(dict.BucketCount() < buckets / 100);
+    for (auto i = 9'990; i < 10'000; ++i) {
+      REQUIRE(dict.contains(Key(i)));
+    }
+  }
+
+  SECTION("Erasing while iterating") {
+    for (auto i = 0; i < 1'000; ++i) {
+      dict.emplace(Key(i), i);
+    }
+    for (auto it = dict.begin(); it != dict.end();) {
+      it = it->second % 2 == 0 ? dict.erase(it) : std::next(it);
+    }
+    REQUIRE(dict.size() == 500);
+    for (auto i = 0; i < 1'000; ++i) {
+      REQUIRE(dict.contains(Key(i)) == (i % 2 == 1));
+    }
+  }
+
+  SECTION("Reallocate keeps the element") {
+    for (auto i = 0; i < 100; ++i) {
+      dict.emplace(Key(i), i);
+    }
+    auto &old = *dict.find(Key(42));
+    auto &moved = dict.Reallocate(old);
+    REQUIRE(std::string_view{moved.first} == Key(42));
+    REQUIRE(moved.second == 42);
+    REQUIRE(&*dict.find(Key(42)) == &moved);
+    REQUIRE(dict.size() == 100);
+  }
+}
+
+TEST_CASE("Dict as a set", "[dict]") {
+  CountingResource memory;
+  {
+    Dict<void> set{&memory};
+    for (auto i = 0; i < 1'000; ++i) {
+      set.emplace(Key(i));
+    }
+    REQUIRE(set.size() == 1'000);
+    REQUIRE(set.contains(Key(7)));
+    REQUIRE_FALSE(set.contains("missing"));
+    REQUIRE(memory.Allocated() > 0);
+
+    Dict<void> other{&memory};
+    other = std::move(set);
+    REQUIRE(other.size() == 1'000);
+    REQUIRE(set.empty());
+  }
+  // Nodes, keys and buckets all came from the resource
+  REQUIRE(memory.Allocated() == 0);
+}
+
+TEST_CASE("Dict scan", "[dict]") {
+  Dict<void> set;
+
+  SECTION("Empty dict completes at once") {
+    std::size_t visited = 0;
+    REQUIRE(set.Scan(0, [&](const auto &) { ++visited; }) == 0);
+    REQUIRE(visited == 0);
+  }
+
+  SECTION("Stable table visits each element once") {
+    for (auto i = 0; i < 1'000; ++i) {
+      set.emplace(Key(i));
+    }
+    while (set.RehashStep(100)) {
+    }
+    const auto seen = ScanAll(set, [] {});
+    REQUIRE(seen.size() == 1'000);
+    REQUIRE(std::set<std::string>(seen.begin(), seen.end()).size() == 1'000);
+  }
+
+  SECTION("Growth between calls skips nothing") {
+    for (auto i = 0; i < 100; ++i) {
+      set.emplace(Key(i));
+    }
+    auto next = 100;
+    const auto seen = ScanAll(set, [&] {
+      // Enough inserts per step to resize several times over the scan
+      for (auto j = 0; j < 50 && next < 5'000; ++j) {
+        set.emplace(Key(next++));
+      }
+    });
+    for (auto i = 0; i < 100; ++i) {
+      REQUIRE(seen.contains(Key(i)));
+    }
+  }
+
+  SECTION("Shrinking between calls skips nothing") {
+    for (auto i = 0; i < 5'000; ++i) {
+      set.emplace(Key(i));
+    }
+    while (set.RehashStep(100)) {
+    }
+    // Keys 0-99 stay for the whole scan; the rest disappear along the way
+    auto next = 100;
+    const auto seen = ScanAll(set, [&] {
+      for (auto j = 0; j < 200 && next < 5'000; ++j) {
+        set.erase(Key(next++));
+      }
+    });
+    REQUIRE(set.size() == 100);
+    for (auto i = 0; i < 100; ++i) {
+      REQUIRE(seen.contains(Key(i)));
+    }
+  }
+}
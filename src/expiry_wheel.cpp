@@ -0,0 +1,156 @@
+#include "expiry_wheel.hpp"
+
+#include <bit>
+
+std::uint16_t ExpiryWheel::SlotFor(std::int64_t deadline) const noexcept {
+  if (deadline <= now_) {
+    return DUE_SLOT;
+  }
+
+  // The highest differing bit picks the level; deadline > now_ guarantees the
+  // slot index at that level is ahead of the current one, so no wrap-around.
+  const auto diff = static_cast<std::uint64_t>(deadline ^ now_);
+  const auto level = (std::bit_width(diff) - 1) / SLOT_BITS;
+  if (level >= LEVELS) {
+    return OVERFLOW_SLOT;
+  }
+
+  const auto index = (deadline >> (level * SLOT_BITS)) & (SLOTS - 1);
+  return static_cast<std::uint16_t>(level * SLOTS + index);
+}
+
+void ExpiryWheel::Place(const Timer &timer) {
+  const auto slot = SlotFor(timer.deadline);
+  auto &timers = slots_[slot];
+
+  timer.hook->slot = slot;
+  timer.hook->pos = static_cast<std::uint32_t>(timers.size());
+  timers.push_back(timer);
+
+  if (slot < OVERFLOW_SLOT) {
+    occupied_[slot / SLOTS] |= std::uint64_t{1} << (slot % SLOTS);
+  }
+}
+
+void ExpiryWheel::Take(std::uint16_t slot, std::vector<Timer> &out) {
+  auto &timers = slots_[slot];
+  out.insert(out.end(), timers.begin(), timers.end());
+  timers.clear();
+
+  if (slot < OVERFLOW_SLOT) {
+    occupied_[slot / SLOTS] &= ~(std::uint64_t{1} << (slot % SLOTS));
+  }
+}
+
+void ExpiryWheel::Schedule(Hook &hook, std::string_view key,
+                           std::int64_t deadline_ms) {
+  Unschedule(hook);
+  Place({.deadline = deadline_ms, .key = key, .hook = &hook});
+  ++size_;
+}
+
+void ExpiryWheel::Unschedule(Hook &hook) noexcept {
+  if (!hook.Scheduled()) {
+    return;
+  }
+
+  auto &timers = slots_[hook.slot];
+  if (hook.pos + 1 != timers.size()) {
+    timers[hook.pos] = timers.back();
+    timers[hook.pos].hook->pos = hook.pos;
+  }
+  timers.pop_back();
+
+  if (timers.empty() && hook.slot < OVERFLOW_SLOT) {
+    occupied_[hook.slot / SLOTS] &= ~(std::uint64_t{1} << (hook.slot % SLOTS));
+  }
+
+  hook.slot = UNSCHEDULED;
+  --size_;
+}
+
+void ExpiryWheel::Relocate(Hook &hook, std::string_view key) noexcept {
+  if (!hook.Scheduled()) {
+    return;
+  }
+  auto &timer = slots_[hook.slot][hook.pos];
+  timer.hook = &hook;
+  timer.key = key;
+}
+
+void ExpiryWheel::Advance(std::int64_t now_ms) {
+  if (now_ms <= now_) {
+    return;
+  }
+
+  cascade_.clear();
+
+  for (auto level = 0; level < LEVELS; ++level) {
+    const auto shift = level * SLOT_BITS;
+    const auto window = std::int64_t{1} << (shift + SLOT_BITS);
+    const auto base = now_ & ~(window - 1);
+    const auto current = (now_ >> shift) & (SLOTS - 1);
+
+    // Slots at or behind the current index are always empty at this level.
+    auto mask = current == SLOTS - 1 ? std::uint64_t{0}
+                                     : ~std::uint64_t{0} << (current + 1);
+
+    // Only slots whose time range has started by now_ms need a visit; the
+    // rest keep their position relative to the new time.
+    if (now_ms < base + window) {
+      const auto last = (now_ms - base) >> shift;
+      if (last < SLOTS - 1) {
+        mask &= (std::uint64_t{1} << (last + 1)) - 1;
+      }
+    }
+
+    mask &= occupied_[level];
+    while (mask != 0) {
+      const auto index = std::countr_zero(mask);
+      mask &= mask - 1;
+      Take(static_cast<std::uint16_t>(level * SLOTS + index), cascade_);
+    }
+  }
+
+  constexpr auto TOP_SHIFT = LEVELS * SLOT_BITS;
+  if ((now_ms >> TOP_SHIFT) != (now_ >> TOP_SHIFT)) {
+    Take(OVERFLOW_SLOT, cascade_);
+  }
+
+  now_ = now_ms;
+  for (const auto &timer : cascade_) {
+    Place(timer);
+  }
+}
+
+std::optional<std::string_view> ExpiryWheel::PopDue() noexcept {
+  auto &due = slots_[DUE_SLOT];
+  if (due.empty()) {
+    return std::nullopt;
+  }
+
+  const auto timer = due.back();
+  due.pop_back();
+  timer.hook->slot = UNSCHEDULED;
+  --size_;
+  return timer.key;
+}
+
+std::optional<std::string_view>
+ExpiryWheel::At(std::size_t index) const noexcept {
+  for (const auto &timers : slots_) {
+    if (index < timers.size()) {
+      return timers[index].key;
+    }
+    index -= timers.size();
+  }
+  return std::nullopt;
+}
+
+void ExpiryWheel::Clear() noexcept {
+  for (auto &timers : slots_) {
+    timers.clear();
+  }
+  occupied_.fill(0);
+  size_ = 0;
+}
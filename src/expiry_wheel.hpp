@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Hierarchical timing wheel keyed by absolute deadline in milliseconds.
+//
+// Level L holds timers whose deadline first differs from the wheel's current
+// time in bits [6L, 6L + 6), so each timer cascades at most LEVELS times
+// before it becomes due. Advancing only visits occupied slots (tracked in a
+// bitmap per level), which keeps the cost proportional to the number of
+// timers that actually fire rather than to the number of keys.
+class ExpiryWheel {
+public:
+  // Embedded in every entry that may carry a deadline, so that deleting or
+  // re-arming the entry unschedules it in O(1) without a search.
+  struct Hook {
+    std::uint16_t slot = UNSCHEDULED;
+    std::uint32_t pos = 0;
+
+    bool Scheduled() const noexcept { return slot != UNSCHEDULED; }
+  };
+
+  explicit ExpiryWheel(std::int64_t now_ms = 0) noexcept
+      : now_{now_ms} {}
+
+  // `key` must stay valid until the timer fires or is unscheduled.
+  void Schedule(Hook &hook, std::string_view key, std::int64_t deadline_ms);
+  void Unschedule(Hook &hook) noexcept;
+
+  // The owning entry moved in memory; repoint the timer at its new hook/key.
+  void Relocate(Hook &hook, std::string_view key) noexcept;
+
+  // Moves every timer with deadline <= now_ms to the due list.
+  void Advance(std::int64_t now_ms);
+
+  // Pops one due timer and returns its key.
+  std::optional<std::string_view> PopDue() noexcept;
+
+  // Key of the index-th timer in slot order, for random sampling. O(slots).
+  std::optional<std::string_view> At(std::size_t index) const noexcept;
+
+  std::size_t Size() const noexcept { return size_; }
+  std::size_t DueCount() const noexcept { return slots_[DUE_SLOT].size(); }
+  // Drops every timer; only valid when all hooked entries go away too.
+  void Clear() noexcept;
+
+private:
+  static constexpr std::uint16_t UNSCHEDULED = 0xFFFF;
+  static constexpr int SLOT_BITS = 6;
+  static constexpr int SLOTS = 1 << SLOT_BITS;
+  static constexpr int LEVELS = 6; // 2^36 ms ~ 795 days before overflow
+  static constexpr std::uint16_t OVERFLOW_SLOT = LEVELS * SLOTS;
+  static constexpr std::uint16_t DUE_SLOT = OVERFLOW_SLOT + 1;
+
+  struct Timer {
+    std::int64_t deadline;
+    std::string_view key;
+    Hook *hook;
+  };
+
+  std::int64_t now_;
+  std::size_t size_ = 0;
+  std::array<std::vector<Timer>, DUE_SLOT + 1> slots_{};
+  std::array<std::uint64_t, LEVELS> occupied_{};
+  std::vector<Timer> cascade_; // scratch buffer reused across Advance calls
+
+  std::uint16_t SlotFor(std::int64_t deadline) const noexcept;
+  void Place(const Timer &timer);
+  void Take(std::uint16_t slot, std::vector<Timer> &out);
+};
@@ -0,0 +1,140 @@
+#include "expiry_wheel.hpp"
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string_view> drain(ExpiryWheel &wheel) {
+  std::vector<std::string_view> keys;
+  while (auto key = wheel.PopDue()) {
+    keys.push_back(*key);
+  }
+  std::ranges::sort(keys);
+  return keys;
+}
+
+} // namespace
+
+TEST_CASE("ExpiryWheel fires timers at their deadline", "[expiry]") {
+  ExpiryWheel wheel{1000};
+  ExpiryWheel::Hook a, b, c;
+
+  wheel.Schedule(a, "a", 1005);
+  wheel.Schedule(b, "b", 1100);
+  wheel.Schedule(c, "c", 1000 + 5'000'000);
+  REQUIRE(wheel.Size() == 3);
+
+  SECTION("Nothing is due before the deadline") {
+    wheel.Advance(1004);
+    REQUIRE(wheel.DueCount() == 0);
+  }
+
+  SECTION("Timers become due exactly at their deadline") {
+    wheel.Advance(1005);
+    REQUIRE(drain(wheel) == std::vector<std::string_view>{"a"});
+    REQUIRE_FALSE(a.Scheduled());
+
+    wheel.Advance(1099);
+    REQUIRE(wheel.DueCount() == 0);
+    wheel.Advance(1100);
+    REQUIRE(drain(wheel) == std::vector<std::string_view>{"b"});
+  }
+
+  SECTION("Long timers cascade down through the levels") {
+    wheel.Advance(1000 + 4'999'999);
+    REQUIRE(drain(wheel) == std::vector<std::string_view>{"a", "b"});
+    wheel.Advance(1000 + 5'000'000);
+    REQUIRE(drain(wheel) == std::vector<std::string_view>{"c"});
+    REQUIRE(wheel.Size() == 0);
+  }
+
+  SECTION("Past deadlines are due immediately") {
+    ExpiryWheel::Hook d;
+    wheel.Schedule(d, "d", 10);
+    REQUIRE(wheel.DueCount() == 1);
+  }
+}
+
+TEST_CASE("ExpiryWheel unschedule and reschedule", "[expiry]") {
+  ExpiryWheel wheel{0};
+  ExpiryWheel::Hook a, b, c;
+  wheel.Schedule(a, "a", 50);
+  wheel.Schedule(b, "b", 50);
+  wheel.Schedule(c, "c", 50);
+
+  SECTION("Unschedule removes a timer") {
+    wheel.Unschedule(a);
+    REQUIRE_FALSE(a.Scheduled());
+    REQUIRE(wheel.Size() == 2);
+    wheel.Advance(50);
+    REQUIRE(drain(wheel) == std::vector<std::string_view>{"b", "c"});
+  }
+
+  SECTION("Rescheduling replaces the old deadline") {
+    wheel.Schedule(b, "b", 10'000);
+    REQUIRE(wheel.Size() == 3);
+    wheel.Advance(50);
+    REQUIRE(drain(wheel) == std::vector<std::string_view>{"a", "c"});
+    wheel.Advance(10'000);
+    REQUIRE(drain(wheel) == std::vector<std::string_view>{"b"});
+  }
+
+  SECTION("Relocate follows a moved hook") {
+    ExpiryWheel::Hook moved = a;
+    wheel.Relocate(moved, "a2");
+    wheel.Unschedule(moved);
+    REQUIRE(wheel.Size() == 2);
+  }
+
+  SECTION("Clear drops everything") {
+    wheel.Clear();
+    wheel.Advance(100);
+    REQUIRE(wheel.Size() == 0);
+    REQUIRE_FALSE(wheel.PopDue().has_value());
+  }
+}
+
+TEST_CASE("ExpiryWheel matches a reference model", "[expiry]") {
+  std::mt19937_64 rng{42};
+  std::int64_t now = 123'456;
+  ExpiryWheel wheel{now};
+
+  constexpr auto N = 2000;
+  std::vector<std::string> keys(N);
+  std::vector<ExpiryWheel::Hook> hooks(N);
+  std::vector<std::int64_t> deadlines(N, -1);
+  for (auto i = 0; i < N; ++i) {
+    keys[i] = std::to_string(i);
+  }
+
+  for (auto round = 0; round < 200; ++round) {
+    for (auto j = 0; j < 50; ++j) {
+      const auto i = rng() % N;
+      if (rng() % 4 == 0) {
+        wheel.Unschedule(hooks[i]);
+        deadlines[i] = -1;
+      } else {
+        const auto span = std::int64_t{1} << (rng() % 30);
+        deadlines[i] = now + static_cast<std::int64_t>(rng() % span);
+        wheel.Schedule(hooks[i], keys[i], deadlines[i]);
+      }
+    }
+
+    now += static_cast<std::int64_t>(rng() % (std::int64_t{1} << (rng() % 24)));
+    wheel.Advance(now);
+
+    std::vector<std::string_view> expected;
+    for (auto i = 0; i < N; ++i) {
+      if (deadlines[i] >= 0 && deadlines[i] <= now) {
+        expected.push_back(keys[i]);
+        deadlines[i] = -1;
+      }
+    }
+    std::ranges::sort(expected);
+    REQUIRE(drain(wheel) == expected);
+  }
+}
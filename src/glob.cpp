@@ -0,0 +1,205 @@
+#include "glob.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+GlobPattern::GlobPattern(std::string_view pattern,
+                         std::pmr::memory_resource *resource)
+    : literals_{resource}
+    , tokens_{resource}
+    , classes_{resource}
+    , segments_{resource}
+    , prefix_{resource} {
+  segments_.push_back({.first = 0, .count = 0, .width = 0});
+  bool in_prefix = true;
+  bool after_star = false;
+
+  std::size_t pos = 0;
+  while (pos < pattern.size()) {
+    const char c = pattern[pos];
+    if (c == '*') {
+      // A run of stars is one star
+      if (!after_star) {
+        segments_.push_back(
+          {.first = static_cast<std::uint32_t>(tokens_.size()),
+           .count = 0,
+           .width = 0});
+      }
+      in_prefix = false;
+      after_star = true;
+      ++pos;
+      continue;
+    }
+    after_star = false;
+
+    if (c == '?') {
+      tokens_.push_back({.kind = Kind::Any, .offset = 0, .length = 1});
+      ++segments_.back().count;
+      ++segments_.back().width;
+      in_prefix = false;
+      exact_ = false;
+      ++pos;
+    } else if (c == '[') {
+      pos = ParseClass(pattern, pos);
+      in_prefix = false;
+      exact_ = false;
+    } else {
+      // A trailing backslash stands for itself
+      const bool escaped = c == '\\' && pos + 1 < pattern.size();
+      const char literal = escaped ? pattern[pos + 1] : c;
+      pos += escaped ? 2 : 1;
+      AddLiteral(literal);
+      if (in_prefix) {
+        prefix_ += literal;
+      }
+    }
+  }
+}
+
+void GlobPattern::AddLiteral(char c) {
+  auto &segment = segments_.back();
+  // Extend the current literal run rather than adding a token per byte
+  if (segment.count != 0 && tokens_.back().kind == Kind::Literal) {
+    ++tokens_.back().length;
+  } else {
+    tokens_.push_back({.kind = Kind::Literal,
+                       .offset = static_cast<std::uint32_t>(literals_.size()),
+                       .length = 1});
+    ++segment.count;
+  }
+  literals_ += c;
+  ++segment.width;
+}
+
+std::size_t GlobPattern::ParseClass(std::string_view pattern,
+                                    std::size_t pos) {
+  std::bitset<256> set;
+  auto byte = [](char c) { return static_cast<unsigned char>(c); };
+
+  ++pos; // '['
+  const bool negate = pos < pattern.size() && pattern[pos] == '^';
+  if (negate) {
+    ++pos;
+  }
+  // An unterminated class runs to the end of the pattern, as in Redis
+  while (pos < pattern.size() && pattern[pos] != ']') {
+    if (pattern[pos] == '\\' && pos + 1 < pattern.size()) {
+      set.set(byte(pattern[pos + 1]));
+      pos += 2;
+    } else if (pos + 2 < pattern.size() && pattern[pos + 1] == '-' &&
+               pattern[pos + 2] != ']') {
+      const int a = byte(pattern[pos]);
+      const int b = byte(pattern[pos + 2]);
+      for (auto i = std::min(a, b); i <= std::max(a, b); ++i) {
+        set.set(static_cast<std::size_t>(i));
+      }
+      pos += 3;
+    } else {
+      set.set(byte(pattern[pos]));
+      ++pos;
+    }
+  }
+  if (pos < pattern.size()) {
+    ++pos; // ']'
+  }
+
+  if (negate) {
+    set.flip();
+  }
+  tokens_.push_back({.kind = Kind::Class,
+                     .offset = static_cast<std::uint32_t>(classes_.size()),
+                     .length = 1});
+  classes_.push_back(set);
+  ++segments_.back().count;
+  ++segments_.back().width;
+  return pos;
+}
+
+bool GlobPattern::MatchSegmentAt(const Segment &segment, std::string_view str,
+                                 std::size_t pos) const {
+  const auto *begin = tokens_.data() + segment.first;
+  for (const auto *token = begin; token != begin + segment.count; ++token) {
+    switch (token->kind) {
+    case Kind::Literal:
+      if (std::memcmp(str.data() + pos, literals_.data() + token->offset,
+                      token->length) != 0) {
+        return false;
+      }
+      break;
+    case Kind::Any:
+      break;
+    case Kind::Class:
+      if (!classes_[token->offset][static_cast<unsigned char>(str[pos])]) {
+        return false;
+      }
+      break;
+    }
+    pos += token->length;
+  }
+  return true;
+}
+
+std::size_t GlobPattern::FindSegment(const Segment &segment,
+                                     std::string_view str, std::size_t from,
+                                     std::size_t last) const {
+  if (segment.count == 0) {
+    return from;
+  }
+
+  const auto &head = tokens_[segment.first];
+  if (head.kind != Kind::Literal) {
+    for (auto at = from; at <= last; ++at) {
+      if (MatchSegmentAt(segment, str, at)) {
+        return at;
+      }
+    }
+    return std::string_view::npos;
+  }
+
+  // Only positions holding the segment's first byte can start a match
+  const char first = literals_[head.offset];
+  while (from <= last) {
+    const auto *hit = static_cast<const char *>(
+      std::memchr(str.data() + from, first, last - from + 1));
+    if (!hit) {
+      break;
+    }
+    const auto at = static_cast<std::size_t>(hit - str.data());
+    if (MatchSegmentAt(segment, str, at)) {
+      return at;
+    }
+    from = at + 1;
+  }
+  return std::string_view::npos;
+}
+
+bool GlobPattern::Matches(std::string_view str) const {
+  const auto &head = segments_.front();
+  if (segments_.size() == 1) {
+    return str.size() == head.width && MatchSegmentAt(head, str, 0);
+  }
+
+  // Around the stars: the head is anchored at the start, the tail at the end
+  const auto &tail = segments_.back();
+  if (str.size() < head.width + tail.width ||
+      !MatchSegmentAt(head, str, 0) ||
+      !MatchSegmentAt(tail, str, str.size() - tail.width)) {
+    return false;
+  }
+
+  // Segments in between match leftmost-first; with fixed-width segments
+  // that never rules out a match a later position would have allowed
+  auto pos = head.width;
+  const auto end = str.size() - tail.width;
+  for (auto it = segments_.begin() + 1; it != segments_.end() - 1; ++it) {
+    if (pos + it->width > end) {
+      return false;
+    }
+    const auto at = FindSegment(*it, str, pos, end - it->width);
+    if (at == std::string_view::npos) {
+      return false;
+    }
+    pos = at + it->width;
+  }
+  return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A Redis glob pattern (`*`, `?`, `[abc]`, `[^a-z]`, `\` to escape) compiled
+// once so it can be matched against many keys cheaply.
+//
+// Stars split the pattern into segments of fixed width (literal runs, `?`
+// and classes each consume a known number of characters). The first and
+// last segments are anchored to the ends of the subject; the ones between
+// are located left to right, skipping ahead with memchr on their first
+// literal byte. Matching is therefore linear in the subject with no
+// backtracking, whatever the number of stars.
+class GlobPattern {
+public:
+  explicit GlobPattern(std::string_view pattern,
+                       std::pmr::memory_resource *resource =
+                         std::pmr::get_default_resource());
+
+  bool Matches(std::string_view str) const;
+
+  // Only stars: every string matches.
+  bool MatchesAll() const noexcept {
+    return segments_.size() == 2 && segments_[0].width == 0 &&
+           segments_[1].width == 0;
+  }
+  // No wildcards: the pattern matches exactly LiteralPrefix().
+  bool IsLiteral() const noexcept { return segments_.size() == 1 && exact_; }
+  // Text every match starts with (unescaped), for index lookups.
+  std::string_view LiteralPrefix() const noexcept { return prefix_; }
+
+private:
+  enum class Kind : std::uint8_t { Literal, Any, Class };
+
+  struct Token {
+    Kind kind;
+    std::uint32_t offset; // into literals_, or classes_ index
+    std::uint32_t length; // characters consumed
+  };
+
+  // Tokens between two stars
+  struct Segment {
+    std::uint32_t first; // into tokens_
+    std::uint32_t count;
+    std::size_t width; // characters consumed by the whole segment
+  };
+
+  std::pmr::string literals_;
+  std::pmr::vector<Token> tokens_;
+  std::pmr::vector<std::bitset<256>> classes_;
+  std::pmr::vector<Segment> segments_; // one more than there are stars
+  std::pmr::string prefix_;
+  bool exact_ = true; // no `?` or classes either
+
+  void AddLiteral(char c);
+  std::size_t ParseClass(std::string_view pattern, std::size_t pos);
+
+  bool MatchSegmentAt(const Segment &segment, std::string_view str,
+                      std::size_t pos) const;
+  // Leftmost position in [from, last] where `segment` matches, or npos
+  std::size_t FindSegment(const Segment &segment, std::string_view str,
+                          std::size_t from, std::size_t last) const;
+};
@@ -0,0 +1,128 @@
+#include "glob.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <string>
+
+namespace {
+
+// Straightforward backtracking matcher to check the compiled one against
+bool Reference(std::string_view p, std::string_view s) {
+  if (p.empty()) {
+    return s.empty();
+  }
+  if (p[0] == '*') {
+    for (std::size_t i = 0; i <= s.size(); ++i) {
+      if (Reference(p.substr(1), s.substr(i))) {
+        return true;
+      }
+    }
+    return false;
+  }
+  if (s.empty()) {
+    return false;
+  }
+  if (p[0] == '?') {
+    return Reference(p.substr(1), s.substr(1));
+  }
+  if (p[0] == '[') {
+    const auto close = p.find(']');
+    const auto body = p.substr(1, close - 1);
+    const bool negate = !body.empty() && body[0] == '^';
+    const bool in = body.find(s[0], negate ? 1 : 0) != std::string_view::npos;
+    return in != negate && Reference(p.substr(close + 1), s.substr(1));
+  }
+  return p[0] == s[0] && Reference(p.substr(1), s.substr(1));
+}
+
+} // namespace
+
+TEST_CASE("GlobPattern matching", "[glob]") {
+  SECTION("Literals") {
+    GlobPattern pattern{"user:1"};
+    REQUIRE(pattern.IsLiteral());
+    REQUIRE(pattern.Matches("user:1"));
+    REQUIRE_FALSE(pattern.Matches("user:12"));
+    REQUIRE_FALSE(pattern.Matches("user:"));
+  }
+
+  SECTION("Stars") {
+    REQUIRE(GlobPattern{"*"}.MatchesAll());
+    REQUIRE(GlobPattern{"**"}.MatchesAll());
+    REQUIRE(GlobPattern{"*"}.Matches(""));
+
+    GlobPattern prefix{"user:123:*"};
+    REQUIRE(prefix.Matches("user:123:"));
+    REQUIRE(prefix.Matches("user:123:name"));
+    REQUIRE_FALSE(prefix.Matches("user:1234:name"));
+
+    GlobPattern middle{"*:session:*:x"};
+    REQUIRE(middle.Matches("a:session:b:x"));
+    REQUIRE(middle.Matches(":session::x"));
+    REQUIRE(middle.Matches("a:session:session:b:x"));
+    REQUIRE_FALSE(middle.Matches("a:session:b:y"));
+    REQUIRE_FALSE(middle.Matches(":session:x"));
+  }
+
+  SECTION("Question marks and classes") {
+    GlobPattern any{"h?llo"};
+    REQUIRE(any.Matches("hello"));
+    REQUIRE(any.Matches("hallo"));
+    REQUIRE_FALSE(any.Matches("hllo"));
+
+    GlobPattern cls{"h[ae]llo"};
+    REQUIRE(cls.Matches("hello"));
+    REQUIRE_FALSE(cls.Matches("hillo"));
+
+    GlobPattern negated{"h[^e]llo"};
+    REQUIRE(negated.Matches("hallo"));
+    REQUIRE_FALSE(negated.Matches("hello"));
+
+    GlobPattern range{"key[0-9]"};
+    REQUIRE(range.Matches("key7"));
+    REQUIRE_FALSE(range.Matches("keyx"));
+    REQUIRE(GlobPattern{"key[9-0]"}.Matches("key5"));
+  }
+
+  SECTION("Escapes") {
+    GlobPattern star{"a\\*b"};
+    REQUIRE(star.IsLiteral());
+    REQUIRE(star.Matches("a*b"));
+    REQUIRE_FALSE(star.Matches("axb"));
+    REQUIRE(GlobPattern{"[\\]]"}.Matches("]"));
+    REQUIRE(GlobPattern{"end\\"}.Matches("end\\"));
+  }
+
+  SECTION("Literal prefix") {
+    REQUIRE(GlobPattern{"tenant:7:*"}.LiteralPrefix() == "tenant:7:");
+    REQUIRE(GlobPattern{"a\\*b*"}.LiteralPrefix() == "a*b");
+    REQUIRE(GlobPattern{"ab?c"}.LiteralPrefix() == "ab");
+    REQUIRE(GlobPattern{"*ab"}.LiteralPrefix().empty());
+  }
+
+  SECTION("Agrees with a backtracking matcher") {
+    std::mt19937 rng{42};
+    constexpr std::string_view PIECES[] = {"a", "b", "ab", "*", "?", "[ab]",
+                                           "[^a]"};
+    auto random_string = [&](std::size_t max) {
+      std::string s;
+      for (auto n = rng() % (max + 1); n > 0; --n) {
+        s += "abc"[rng() % 3];
+      }
+      return s;
+    };
+
+    for (auto i = 0; i < 2'000; ++i) {
+      std::string pattern;
+      for (auto n = rng() % 6; n > 0; --n) {
+        pattern += PIECES[rng() % std::size(PIECES)];
+      }
+      const GlobPattern compiled{pattern};
+      for (auto j = 0; j < 20; ++j) {
+        const auto subject = random_string(8);
+        INFO(pattern << " vs " << subject);
+        REQUIRE(compiled.Matches(subject) == Reference(pattern, subject));
+      }
+    }
+  }
+}
@@ -0,0 +1,175 @@
+#include "intset.hpp"
+
+#include <cstring>
+#include <limits>
+
+namespace {
+
+template <typename T> T Load(const char *data, std::size_t index) noexcept {
+  T value;
+  std::memcpy(&value, data + index * sizeof(T), sizeof(T));
+  return value;
+}
+
+template <typename T>
+void Store(char *data, std::size_t index, std::int64_t value) noexcept {
+  const auto narrow = static_cast<T>(value);
+  std::memcpy(data + index * sizeof(T), &narrow, sizeof(T));
+}
+
+std::int64_t LoadAs(const char *data, std::size_t index,
+                    std::size_t width) noexcept {
+  switch (width) {
+  case sizeof(std::int16_t):
+    return Load<std::int16_t>(data, index);
+  case sizeof(std::int32_t):
+    return Load<std::int32_t>(data, index);
+  default:
+    return Load<std::int64_t>(data, index);
+  }
+}
+
+void StoreAs(char *data, std::size_t index, std::size_t width,
+             std::int64_t value) noexcept {
+  switch (width) {
+  case sizeof(std::int16_t):
+    return Store<std::int16_t>(data, index, value);
+  case sizeof(std::int32_t):
+    return Store<std::int32_t>(data, index, value);
+  default:
+    return Store<std::int64_t>(data, index, value);
+  }
+}
+
+std::size_t WidthFor(std::int64_t value) noexcept {
+  if (value >= std::numeric_limits<std::int16_t>::min() &&
+      value <= std::numeric_limits<std::int16_t>::max()) {
+    return sizeof(std::int16_t);
+  }
+  if (value >= std::numeric_limits<std::int32_t>::min() &&
+      value <= std::numeric_limits<std::int32_t>::max()) {
+    return sizeof(std::int32_t);
+  }
+  return sizeof(std::int64_t);
+}
+
+// 16-byte vectors: SSE2 on x86-64, NEON on ARM, plain loops elsewhere
+constexpr std::size_t VECTOR_BYTES = 16;
+
+template <typename T> struct VectorOf;
+template <> struct VectorOf<std::int16_t> {
+  using type [[gnu::vector_size(VECTOR_BYTES)]] = std::int16_t;
+};
+template <> struct VectorOf<std::int32_t> {
+  using type [[gnu::vector_size(VECTOR_BYTES)]] = std::int32_t;
+};
+template <> struct VectorOf<std::int64_t> {
+  using type [[gnu::vector_size(VECTOR_BYTES)]] = std::int64_t;
+};
+// Binary search stops once the range fits in a cache line
+constexpr std::size_t WINDOW_BYTES = 64;
+
+template <typename T>
+std::size_t LowerBound(const char *data, std::size_t size, T value) noexcept {
+  constexpr std::size_t WINDOW = WINDOW_BYTES / sizeof(T);
+  constexpr std::size_t LANES = VECTOR_BYTES / sizeof(T);
+  using Vector = typename VectorOf<T>::type;
+
+  std::size_t lo = 0;
+  std::size_t hi = size;
+  while (hi - lo > WINDOW) {
+    const auto mid = lo + (hi - lo) / 2;
+    if (Load<T>(data, mid) < value) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  // The array is sorted, so the answer is lo plus the number of elements in
+  // the window below `value`; count them without a branch per element.
+  // Each comparison sets a lane to -1 where the element is smaller.
+  const Vector needle = Vector{} + value;
+  Vector below{};
+  auto i = lo;
+  for (; i + LANES <= hi; i += LANES) {
+    Vector block;
+    std::memcpy(&block, data + i * sizeof(T), sizeof(block));
+    below += static_cast<Vector>(block < needle);
+  }
+  auto result = lo;
+  for (std::size_t lane = 0; lane < LANES; ++lane) {
+    result -= static_cast<std::size_t>(static_cast<std::int64_t>(below[lane]));
+  }
+  for (; i < hi && Load<T>(data, i) < value; ++i) {
+    ++result;
+  }
+  return result;
+}
+
+} // namespace
+
+std::int64_t IntSet::Get(std::size_t index) const noexcept {
+  return LoadAs(buf_.data(), index, width_);
+}
+
+std::size_t IntSet::LowerBound(std::int64_t value) const noexcept {
+  switch (width_) {
+  case sizeof(std::int16_t):
+    return ::LowerBound(buf_.data(), Size(), static_cast<std::int16_t>(value));
+  case sizeof(std::int32_t):
+    return ::LowerBound(buf_.data(), Size(), static_cast<std::int32_t>(value));
+  default:
+    return ::LowerBound(buf_.data(), Size(), value);
+  }
+}
+
+bool IntSet::Contains(std::int64_t value) const noexcept {
+  // Too wide for the elements means it cannot be one of them
+  if (WidthFor(value) > width_) {
+    return false;
+  }
+  const auto index = LowerBound(value);
+  return index < Size() && Get(index) == value;
+}
+
+bool IntSet::Insert(std::int64_t value) {
+  if (WidthFor(value) > width_) {
+    // Wider than every element, so it goes at one end or the other
+    Widen(WidthFor(value));
+    const auto index = value < 0 ? 0 : Size();
+    buf_.insert(index * width_, width_, '\0');
+    StoreAs(buf_.data(), index, width_, value);
+    return true;
+  }
+
+  const auto index = LowerBound(value);
+  if (index < Size() && Get(index) == value) {
+    return false;
+  }
+  buf_.insert(index * width_, width_, '\0');
+  StoreAs(buf_.data(), index, width_, value);
+  return true;
+}
+
+bool IntSet::Erase(std::int64_t value) {
+  if (WidthFor(value) > width_) {
+    return false;
+  }
+  const auto index = LowerBound(value);
+  if (index >= Size() || Get(index) != value) {
+    return false;
+  }
+  buf_.erase(index * width_, width_);
+  return true;
+}
+
+void IntSet::Widen(std::size_t width) {
+  const auto size = Size();
+  buf_.resize(size * width);
+  // Back to front, so no element is overwritten before it is moved
+  for (auto i = size; i-- > 0;) {
+    StoreAs(buf_.data(), i, width, LoadAs(buf_.data(), i, width_));
+  }
+  width_ = static_cast<std::uint8_t>(width);
+}
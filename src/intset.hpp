@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <utility>
+
+// A set of integers as one sorted array, after Redis' intset. Every element
+// has the same width, the smallest of 16, 32 or 64 bits that fits them all;
+// adding a value that does not fit widens the whole array once and it never
+// narrows again. Lookups binary search down to a cache line and then compare
+// it a vector at a time.
+//
+// Elements live in a byte buffer so that memory accounting and defrag can
+// treat an intset like any other string.
+class IntSet {
+public:
+  explicit IntSet(std::pmr::memory_resource *resource =
+                    std::pmr::get_default_resource()) noexcept
+      : buf_{resource} {}
+
+  std::size_t Size() const noexcept { return buf_.size() / width_; }
+  bool Empty() const noexcept { return buf_.empty(); }
+  // Bytes per element: 2, 4 or 8
+  std::size_t Width() const noexcept { return width_; }
+
+  // The element at `index`, in ascending order
+  std::int64_t Get(std::size_t index) const noexcept;
+  bool Contains(std::int64_t value) const noexcept;
+  // Both return whether the set changed
+  bool Insert(std::int64_t value);
+  bool Erase(std::int64_t value);
+  void Clear() noexcept {
+    std::pmr::string{buf_.get_allocator()}.swap(buf_);
+    width_ = sizeof(std::int16_t);
+  }
+
+  // The backing buffer, for memory accounting and defrag
+  std::pmr::string &Buffer() noexcept { return buf_; }
+  const std::pmr::string &Buffer() const noexcept { return buf_; }
+
+  void Swap(IntSet &other) noexcept {
+    buf_.swap(other.buf_);
+    std::swap(width_, other.width_);
+  }
+
+private:
+  std::pmr::string buf_;
+  std::uint8_t width_ = sizeof(std::int16_t);
+
+  // Index of the first element not less than `value`
+  std::size_t LowerBound(std::int64_t value) const noexcept;
+  // Rewrites every element at `width` bytes
+  void Widen(std::size_t width);
+};
@@ -0,0 +1,105 @@
+#include "intset.hpp"
+
+#include "counting_resource.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <set>
+
+namespace {
+
+void RequireSame(const IntSet &ints, const std::set<std::int64_t> &model) {
+  REQUIRE(ints.Size() == model.size());
+  std::size_t i = 0;
+  for (auto value : model) {
+    REQUIRE(ints.Get(i++) == value);
+  }
+}
+
+} // namespace
+
+TEST_CASE("IntSet widths", "[intset]") {
+  CountingResource memory;
+  IntSet ints{&memory};
+
+  SECTION("Small values take two bytes each") {
+    for (std::int64_t v : {5, -3, 32767, -32768}) {
+      REQUIRE(ints.Insert(v));
+    }
+    REQUIRE_FALSE(ints.Insert(5));
+    REQUIRE(ints.Width() == 2);
+    REQUIRE(ints.Buffer().size() == 8);
+    REQUIRE(ints.Get(0) == -32768);
+    REQUIRE(ints.Get(3) == 32767);
+  }
+
+  SECTION("A wider value widens every element once") {
+    ints.Insert(1);
+    ints.Insert(2);
+    ints.Insert(std::int64_t{1} << 20);
+    REQUIRE(ints.Width() == 4);
+    ints.Insert(std::numeric_limits<std::int64_t>::min());
+    REQUIRE(ints.Width() == 8);
+    REQUIRE(ints.Get(0) == std::numeric_limits<std::int64_t>::min());
+    REQUIRE(ints.Get(1) == 1);
+    REQUIRE(ints.Get(3) == std::int64_t{1} << 20);
+
+    // Erasing the wide value keeps the width
+    REQUIRE(ints.Erase(std::numeric_limits<std::int64_t>::min()));
+    REQUIRE(ints.Width() == 8);
+    REQUIRE(ints.Contains(2));
+  }
+
+  SECTION("Values wider than the set are never members") {
+    ints.Insert(7);
+    REQUIRE_FALSE(ints.Contains(std::int64_t{7} << 32));
+    REQUIRE_FALSE(ints.Erase(std::int64_t{7} << 32));
+    REQUIRE(ints.Width() == 2);
+  }
+
+  ints.Clear();
+  REQUIRE(memory.Allocated() == 0);
+}
+
+TEST_CASE("IntSet matches std::set", "[intset]") {
+  std::mt19937_64 rng{7};
+  // Each range forces a different width; sizes cross the vector window
+  const std::int64_t ranges[] = {1'000, 100'000,
+                                 std::numeric_limits<std::int64_t>::max()};
+
+  for (auto range : ranges) {
+    for (std::size_t size : {0, 1, 7, 8, 31, 33, 200, 600}) {
+      IntSet ints;
+      std::set<std::int64_t> model;
+      std::uniform_int_distribution<std::int64_t> pick{-range, range};
+      while (model.size() < size) {
+        const auto v = pick(rng);
+        REQUIRE(ints.Insert(v) == model.insert(v).second);
+      }
+      RequireSame(ints, model);
+
+      // Members, their neighbours and random misses
+      for (auto v : model) {
+        REQUIRE(ints.Contains(v));
+        if (v > std::numeric_limits<std::int64_t>::min()) {
+          REQUIRE(ints.Contains(v - 1) == model.contains(v - 1));
+        }
+      }
+      for (auto i = 0; i < 200; ++i) {
+        const auto v = pick(rng);
+        REQUIRE(ints.Contains(v) == model.contains(v));
+      }
+
+      for (auto i = 0; i < 100 && !model.empty(); ++i) {
+        const auto v = pick(rng);
+        REQUIRE(ints.Erase(v) == (model.erase(v) == 1));
+        const auto first = *model.begin();
+        REQUIRE(ints.Erase(first));
+        model.erase(first);
+      }
+      RequireSame(ints, model);
+    }
+  }
+}
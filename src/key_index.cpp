@@ -0,0 +1,500 @@
+#include "key_index.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+
+namespace {
+
+// Length of the common prefix of a and b
+std::size_t CommonPrefix(std::string_view a, std::string_view b) noexcept {
+  const auto n = std::min(a.size(), b.size());
+  return static_cast<std::size_t>(
+    std::mismatch(a.begin(), a.begin() + static_cast<std::ptrdiff_t>(n),
+                  b.begin())
+      .first -
+    a.begin());
+}
+
+std::uint8_t ByteAt(std::string_view key, std::size_t pos) noexcept {
+  return static_cast<std::uint8_t>(key[pos]);
+}
+
+// Shrink thresholds leave slack so a node hovering at a boundary does not
+// flip between sizes on every insert and erase
+constexpr std::uint16_t SHRINK_TO_4 = 3;
+constexpr std::uint16_t SHRINK_TO_16 = 12;
+constexpr std::uint16_t SHRINK_TO_48 = 37;
+
+} // namespace
+
+template <typename T> T *KeyIndex::New(std::string_view prefix) {
+  NodeType type;
+  if constexpr (std::is_same_v<T, Node4>) {
+    type = NodeType::N4;
+  } else if constexpr (std::is_same_v<T, Node16>) {
+    type = NodeType::N16;
+  } else if constexpr (std::is_same_v<T, Node48>) {
+    type = NodeType::N48;
+  } else {
+    type = NodeType::N256;
+  }
+
+  std::pmr::polymorphic_allocator<T> alloc{resource_};
+  auto *node = alloc.allocate(1);
+  std::construct_at(node, type, resource_);
+  node->prefix.assign(prefix);
+  return node;
+}
+
+void KeyIndex::Delete(Node *node) noexcept {
+  auto free = [this](auto *typed) {
+    using T = std::remove_pointer_t<decltype(typed)>;
+    std::destroy_at(typed);
+    std::pmr::polymorphic_allocator<T>{resource_}.deallocate(typed, 1);
+  };
+  switch (node->type) {
+  case NodeType::N4:
+    free(static_cast<Node4 *>(node));
+    break;
+  case NodeType::N16:
+    free(static_cast<Node16 *>(node));
+    break;
+  case NodeType::N48:
+    free(static_cast<Node48 *>(node));
+    break;
+  case NodeType::N256:
+    free(static_cast<Node256 *>(node));
+    break;
+  }
+}
+
+void KeyIndex::DeleteTree(Child child) noexcept {
+  if (child == 0 || IsLeaf(child)) {
+    return;
+  }
+  auto *node = AsNode(child);
+  ForEachChild(node, [this](std::uint8_t, Child c) { DeleteTree(c); });
+  Delete(node);
+}
+
+void KeyIndex::Clear() noexcept {
+  DeleteTree(root_);
+  root_ = 0;
+  size_ = 0;
+}
+
+KeyIndex::Child *KeyIndex::FindChild(Node *node, std::uint8_t byte) noexcept {
+  auto find_sorted = [byte](auto *sorted) -> Child * {
+    for (std::size_t i = 0; i < sorted->count; ++i) {
+      if (sorted->keys[i] == byte) {
+        return &sorted->children[i];
+      }
+    }
+    return nullptr;
+  };
+
+  switch (node->type) {
+  case NodeType::N4:
+    return find_sorted(static_cast<Node4 *>(node));
+  case NodeType::N16:
+    return find_sorted(static_cast<Node16 *>(node));
+  case NodeType::N48: {
+    auto *n48 = static_cast<Node48 *>(node);
+    const auto slot = n48->index[byte];
+    return slot != 0 ? &n48->children[slot - 1] : nullptr;
+  }
+  case NodeType::N256: {
+    auto *n256 = static_cast<Node256 *>(node);
+    return n256->children[byte] != 0 ? &n256->children[byte] : nullptr;
+  }
+  }
+  return nullptr;
+}
+
+template <typename F>
+void KeyIndex::ForEachChild(const Node *node, F &&visit) {
+  auto each_sorted = [&](const auto *sorted) {
+    for (std::size_t i = 0; i < sorted->count; ++i) {
+      visit(sorted->keys[i], sorted->children[i]);
+    }
+  };
+
+  switch (node->type) {
+  case NodeType::N4:
+    each_sorted(static_cast<const Node4 *>(node));
+    break;
+  case NodeType::N16:
+    each_sorted(static_cast<const Node16 *>(node));
+    break;
+  case NodeType::N48: {
+    const auto *n48 = static_cast<const Node48 *>(node);
+    for (std::size_t b = 0; b < 256; ++b) {
+      if (n48->index[b] != 0) {
+        visit(static_cast<std::uint8_t>(b), n48->children[n48->index[b] - 1]);
+      }
+    }
+    break;
+  }
+  case NodeType::N256: {
+    const auto *n256 = static_cast<const Node256 *>(node);
+    for (std::size_t b = 0; b < 256; ++b) {
+      if (n256->children[b] != 0) {
+        visit(static_cast<std::uint8_t>(b), n256->children[b]);
+      }
+    }
+    break;
+  }
+  }
+}
+
+void KeyIndex::PutChild(Node *node, std::uint8_t byte, Child child) noexcept {
+  auto put_sorted = [&](auto *sorted) {
+    std::size_t pos = 0;
+    while (pos < sorted->count && sorted->keys[pos] < byte) {
+      ++pos;
+    }
+    for (auto i = std::size_t{sorted->count}; i > pos; --i) {
+      sorted->keys[i] = sorted->keys[i - 1];
+      sorted->children[i] = sorted->children[i - 1];
+    }
+    sorted->keys[pos] = byte;
+    sorted->children[pos] = child;
+  };
+
+  switch (node->type) {
+  case NodeType::N4:
+    put_sorted(static_cast<Node4 *>(node));
+    break;
+  case NodeType::N16:
+    put_sorted(static_cast<Node16 *>(node));
+    break;
+  case NodeType::N48: {
+    auto *n48 = static_cast<Node48 *>(node);
+    std::size_t slot = 0;
+    while (n48->children[slot] != 0) {
+      ++slot;
+    }
+    n48->children[slot] = child;
+    n48->index[byte] = static_cast<std::uint8_t>(slot + 1);
+    break;
+  }
+  case NodeType::N256:
+    static_cast<Node256 *>(node)->children[byte] = child;
+    break;
+  }
+  ++node->count;
+}
+
+void KeyIndex::AddChild(Child &ref, std::uint8_t byte, Child child) {
+  auto *node = AsNode(ref);
+  switch (node->type) {
+  case NodeType::N4:
+    if (node->count == 4) {
+      Resize(ref, NodeType::N16);
+    }
+    break;
+  case NodeType::N16:
+    if (node->count == 16) {
+      Resize(ref, NodeType::N48);
+    }
+    break;
+  case NodeType::N48:
+    if (node->count == 48) {
+      Resize(ref, NodeType::N256);
+    }
+    break;
+  case NodeType::N256:
+    break;
+  }
+  PutChild(AsNode(ref), byte, child);
+}
+
+void KeyIndex::RemoveChild(Node *node, std::uint8_t byte) noexcept {
+  auto remove_sorted = [&](auto *sorted) {
+    std::size_t pos = 0;
+    while (sorted->keys[pos] != byte) {
+      ++pos;
+    }
+    for (auto i = pos + 1; i < sorted->count; ++i) {
+      sorted->keys[i - 1] = sorted->keys[i];
+      sorted->children[i - 1] = sorted->children[i];
+    }
+    sorted->children[sorted->count - 1] = 0;
+  };
+
+  switch (node->type) {
+  case NodeType::N4:
+    remove_sorted(static_cast<Node4 *>(node));
+    break;
+  case NodeType::N16:
+    remove_sorted(static_cast<Node16 *>(node));
+    break;
+  case NodeType::N48: {
+    auto *n48 = static_cast<Node48 *>(node);
+    n48->children[n48->index[byte] - 1] = 0;
+    n48->index[byte] = 0;
+    break;
+  }
+  case NodeType::N256:
+    static_cast<Node256 *>(node)->children[byte] = 0;
+    break;
+  }
+  --node->count;
+}
+
+void KeyIndex::Resize(Child &ref, NodeType type) {
+  auto *from = AsNode(ref);
+  Node *to = nullptr;
+  switch (type) {
+  case NodeType::N4:
+    to = New<Node4>({});
+    break;
+  case NodeType::N16:
+    to = New<Node16>({});
+    break;
+  case NodeType::N48:
+    to = New<Node48>({});
+    break;
+  case NodeType::N256:
+    to = New<Node256>({});
+    break;
+  }
+  to->prefix.swap(from->prefix);
+  to->leaf = from->leaf;
+  ForEachChild(from, [to](std::uint8_t byte, Child child) {
+    PutChild(to, byte, child);
+  });
+  Delete(from);
+  ref = MakeChild(to);
+}
+
+void KeyIndex::Compact(Child &ref) {
+  auto *node = AsNode(ref);
+  if (node->count == 0) {
+    ref = node->leaf;
+    Delete(node);
+    return;
+  }
+
+  if (node->count == 1 && node->leaf == 0) {
+    // A single path: fold this node's prefix and byte into the child
+    std::uint8_t byte = 0;
+    Child child = 0;
+    ForEachChild(node, [&](std::uint8_t b, Child c) {
+      byte = b;
+      child = c;
+    });
+    if (!IsLeaf(child)) {
+      auto *below = AsNode(child);
+      std::pmr::string prefix{resource_};
+      prefix.reserve(node->prefix.size() + 1 + below->prefix.size());
+      prefix += node->prefix;
+      prefix += static_cast<char>(byte);
+      prefix += below->prefix;
+      below->prefix.swap(prefix);
+    }
+    ref = child;
+    Delete(node);
+    return;
+  }
+
+  if (node->type == NodeType::N256 && node->count <= SHRINK_TO_48) {
+    Resize(ref, NodeType::N48);
+  } else if (node->type == NodeType::N48 && node->count <= SHRINK_TO_16) {
+    Resize(ref, NodeType::N16);
+  } else if (node->type == NodeType::N16 && node->count <= SHRINK_TO_4) {
+    Resize(ref, NodeType::N4);
+  }
+}
+
+void KeyIndex::Insert(const Key &key) { Insert(root_, key, 0); }
+
+void KeyIndex::Insert(Child &ref, const Key &key, std::size_t depth) {
+  const std::string_view view{key};
+  if (ref == 0) {
+    ref = MakeLeaf(key);
+    ++size_;
+    return;
+  }
+
+  if (IsLeaf(ref)) {
+    const std::string_view existing{*LeafKey(ref)};
+    if (existing == view) {
+      ref = MakeLeaf(key);
+      return;
+    }
+    // Two keys share this slot now: branch where they differ
+    const auto common =
+      CommonPrefix(existing.substr(depth), view.substr(depth));
+    auto *node = New<Node4>(view.substr(depth, common));
+    const auto split = depth + common;
+    for (auto [k, leaf] : {std::pair{existing, ref}, {view, MakeLeaf(key)}}) {
+      if (k.size() == split) {
+        node->leaf = leaf;
+      } else {
+        PutChild(node, ByteAt(k, split), leaf);
+      }
+    }
+    ref = MakeChild(node);
+    ++size_;
+    return;
+  }
+
+  auto *node = AsNode(ref);
+  const auto common = CommonPrefix(node->prefix, view.substr(depth));
+  if (common < node->prefix.size()) {
+    // The key leaves this node's compressed path part way through
+    auto *parent = New<Node4>(std::string_view{node->prefix}.substr(0, common));
+    const auto byte = static_cast<std::uint8_t>(node->prefix[common]);
+    node->prefix.erase(0, common + 1);
+    PutChild(parent, byte, ref);
+
+    const auto split = depth + common;
+    if (view.size() == split) {
+      parent->leaf = MakeLeaf(key);
+    } else {
+      PutChild(parent, ByteAt(view, split), MakeLeaf(key));
+    }
+    ref = MakeChild(parent);
+    ++size_;
+    return;
+  }
+
+  depth += node->prefix.size();
+  if (view.size() == depth) {
+    if (node->leaf == 0) {
+      ++size_;
+    }
+    node->leaf = MakeLeaf(key);
+    return;
+  }
+
+  if (auto *child = FindChild(node, ByteAt(view, depth))) {
+    Insert(*child, key, depth + 1);
+  } else {
+    AddChild(ref, ByteAt(view, depth), MakeLeaf(key));
+    ++size_;
+  }
+}
+
+bool KeyIndex::Erase(std::string_view key) {
+  if (!Erase(root_, key, 0)) {
+    return false;
+  }
+  --size_;
+  return true;
+}
+
+bool KeyIndex::Erase(Child &ref, std::string_view key, std::size_t depth) {
+  if (ref == 0) {
+    return false;
+  }
+  if (IsLeaf(ref)) {
+    if (std::string_view{*LeafKey(ref)} != key) {
+      return false;
+    }
+    ref = 0;
+    return true;
+  }
+
+  auto *node = AsNode(ref);
+  if (!key.substr(depth).starts_with(node->prefix)) {
+    return false;
+  }
+  depth += node->prefix.size();
+
+  if (key.size() == depth) {
+    if (node->leaf == 0) {
+      return false;
+    }
+    node->leaf = 0;
+    Compact(ref);
+    return true;
+  }
+
+  const auto byte = ByteAt(key, depth);
+  auto *child = FindChild(node, byte);
+  if (!child || !Erase(*child, key, depth + 1)) {
+    return false;
+  }
+  if (*child == 0) {
+    RemoveChild(node, byte);
+  }
+  Compact(ref);
+  return true;
+}
+
+const KeyIndex::Key *KeyIndex::Find(std::string_view key) const {
+  auto child = root_;
+  std::size_t depth = 0;
+  while (child != 0) {
+    if (IsLeaf(child)) {
+      return std::string_view{*LeafKey(child)} == key ? LeafKey(child)
+                                                      : nullptr;
+    }
+    auto *node = AsNode(child);
+    if (!key.substr(depth).starts_with(node->prefix)) {
+      return nullptr;
+    }
+    depth += node->prefix.size();
+    if (key.size() == depth) {
+      return node->leaf != 0 ? LeafKey(node->leaf) : nullptr;
+    }
+    auto *slot = FindChild(node, ByteAt(key, depth));
+    child = slot ? *slot : 0;
+    ++depth;
+  }
+  return nullptr;
+}
+
+void KeyIndex::CollectAll(Child child, std::vector<const Key *> &out,
+                          std::size_t limit) {
+  if (out.size() >= limit) {
+    return;
+  }
+  if (IsLeaf(child)) {
+    out.push_back(LeafKey(child));
+    return;
+  }
+  const auto *node = AsNode(child);
+  // A key that ends here sorts before everything that continues past it
+  if (node->leaf != 0) {
+    out.push_back(LeafKey(node->leaf));
+  }
+  ForEachChild(node, [&](std::uint8_t, Child below) {
+    CollectAll(below, out, limit);
+  });
+}
+
+void KeyIndex::CollectPrefix(std::string_view prefix,
+                             std::vector<const Key *> &out,
+                             std::size_t limit) const {
+  auto child = root_;
+  std::size_t depth = 0;
+  while (child != 0) {
+    if (IsLeaf(child)) {
+      if (out.size() < limit &&
+          std::string_view{*LeafKey(child)}.starts_with(prefix)) {
+        out.push_back(LeafKey(child));
+      }
+      return;
+    }
+
+    auto *node = AsNode(child);
+    const auto rest = prefix.substr(depth);
+    const auto common = CommonPrefix(node->prefix, rest);
+    if (common == rest.size()) {
+      // The prefix ends inside this node's path: the whole subtree matches
+      CollectAll(child, out, limit);
+      return;
+    }
+    if (common < node->prefix.size()) {
+      return;
+    }
+    depth += node->prefix.size();
+    auto *slot = FindChild(node, ByteAt(prefix, depth));
+    child = slot ? *slot : 0;
+    ++depth;
+  }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Ordered index over the keyspace: an adaptive radix tree (Leis et al.)
+// that answers "every key starting with P, in order" in time proportional
+// to the depth of P plus the number of keys found.
+//
+// Inner nodes come in four sizes (4, 16, 48 and 256 children) and grow or
+// shrink as keys come and go; chains of single-child nodes are collapsed
+// into a prefix stored on the node below. The tree does not copy keys: a
+// leaf is a tagged pointer to the key string owned by the keyspace, so the
+// owner must call Insert again (which repoints the leaf) whenever a key
+// object moves, and Erase before it is destroyed.
+class KeyIndex {
+public:
+  using Key = std::pmr::string;
+
+  explicit KeyIndex(std::pmr::memory_resource *resource =
+                      std::pmr::get_default_resource()) noexcept
+      : resource_{resource} {}
+  ~KeyIndex() { Clear(); }
+
+  KeyIndex(const KeyIndex &) = delete;
+  KeyIndex &operator=(const KeyIndex &) = delete;
+
+  // Adds `key`, or points an existing entry with the same contents at it.
+  void Insert(const Key &key);
+  bool Erase(std::string_view key);
+  const Key *Find(std::string_view key) const;
+  void Clear() noexcept;
+
+  std::size_t Size() const noexcept { return size_; }
+
+  // Appends every key starting with `prefix` to `out`, in byte order,
+  // stopping once `out` holds `limit` keys.
+  void CollectPrefix(std::string_view prefix, std::vector<const Key *> &out,
+                     std::size_t limit = SIZE_MAX) const;
+
+private:
+  // 0 = empty; odd = leaf (a tagged const Key *); otherwise a Node *
+  using Child = std::uintptr_t;
+
+  enum class NodeType : std::uint8_t { N4, N16, N48, N256 };
+
+  struct Node {
+    NodeType type;
+    std::uint16_t count = 0; // children, not counting `leaf`
+    std::pmr::string prefix; // compressed path below the parent's byte
+    Child leaf = 0;          // the key that ends exactly here, if any
+
+    Node(NodeType type, std::pmr::memory_resource *resource)
+        : type{type}, prefix{resource} {}
+  };
+  // Node4/Node16 keep their bytes sorted
+  struct Node4 : Node {
+    std::array<std::uint8_t, 4> keys{};
+    std::array<Child, 4> children{};
+    using Node::Node;
+  };
+  struct Node16 : Node {
+    std::array<std::uint8_t, 16> keys{};
+    std::array<Child, 16> children{};
+    using Node::Node;
+  };
+  // index[byte] is a slot in children, plus one (0 = absent)
+  struct Node48 : Node {
+    std::array<std::uint8_t, 256> index{};
+    std::array<Child, 48> children{};
+    using Node::Node;
+  };
+  struct Node256 : Node {
+    std::array<Child, 256> children{};
+    using Node::Node;
+  };
+
+  std::pmr::memory_resource *resource_;
+  Child root_ = 0;
+  std::size_t size_ = 0;
+
+  static bool IsLeaf(Child child) noexcept { return (child & 1) != 0; }
+  static const Key *LeafKey(Child child) noexcept {
+    return reinterpret_cast<const Key *>(child & ~Child{1});
+  }
+  static Child MakeLeaf(const Key &key) noexcept {
+    return reinterpret_cast<Child>(&key) | 1;
+  }
+  static Node *AsNode(Child child) noexcept {
+    return reinterpret_cast<Node *>(child);
+  }
+  static Child MakeChild(Node *node) noexcept {
+    return reinterpret_cast<Child>(node);
+  }
+
+  template <typename T> T *New(std::string_view prefix);
+  void Delete(Node *node) noexcept;
+  void DeleteTree(Child child) noexcept;
+
+  static Child *FindChild(Node *node, std::uint8_t byte) noexcept;
+  // Calls visit(byte, child) in byte order
+  template <typename F> static void ForEachChild(const Node *node, F &&visit);
+
+  // Adds to a node known to have room
+  static void PutChild(Node *node, std::uint8_t byte, Child child) noexcept;
+  // Adds to the node at `ref`, growing it first if full
+  void AddChild(Child &ref, std::uint8_t byte, Child child);
+  static void RemoveChild(Node *node, std::uint8_t byte) noexcept;
+  // Replaces the node at `ref` with one of another size
+  void Resize(Child &ref, NodeType type);
+  // Frees, merges or shrinks the node at `ref` after a removal below it
+  void Compact(Child &ref);
+
+  void Insert(Child &ref, const Key &key, std::size_t depth);
+  bool Erase(Child &ref, std::string_view key, std::size_t depth);
+  static void CollectAll(Child child, std::vector<const Key *> &out,
+                         std::size_t limit);
+};
@@ -0,0 +1,142 @@
+#include "key_index.hpp"
+
+#include "counting_resource.hpp"
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <deque>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> Collect(const KeyIndex &index,
+                                 std::string_view prefix) {
+  std::vector<const KeyIndex::Key *> keys;
+  index.CollectPrefix(prefix, keys);
+  std::vector<std::string> result;
+  for (const auto *key : keys) {
+    result.emplace_back(*key);
+  }
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("KeyIndex basics", "[key_index]") {
+  // The index points at keys it does not own; a deque keeps them in place
+  std::deque<KeyIndex::Key> keys;
+  KeyIndex index;
+  auto add = [&](std::string_view key) {
+    index.Insert(keys.emplace_back(key));
+  };
+
+  SECTION("Keys that are prefixes of each other") {
+    for (auto key : {"a", "ab", "abc", "abd", "b", ""}) {
+      add(key);
+    }
+    REQUIRE(index.Size() == 6);
+    REQUIRE(Collect(index, "") ==
+            std::vector<std::string>{"", "a", "ab", "abc", "abd", "b"});
+    REQUIRE(Collect(index, "ab") ==
+            std::vector<std::string>{"ab", "abc", "abd"});
+    REQUIRE(Collect(index, "abc") == std::vector<std::string>{"abc"});
+    REQUIRE(Collect(index, "abcd").empty());
+    REQUIRE(Collect(index, "c").empty());
+
+    REQUIRE(index.Erase("ab"));
+    REQUIRE_FALSE(index.Erase("ab"));
+    REQUIRE(Collect(index, "a") ==
+            std::vector<std::string>{"a", "abc", "abd"});
+    REQUIRE(index.Find("abd") != nullptr);
+    REQUIRE(index.Find("ab") == nullptr);
+  }
+
+  SECTION("Long shared prefixes are split where keys diverge") {
+    add("tenant:1:user:1");
+    add("tenant:1:user:2");
+    add("tenant:2:user:1");
+    add("tenant:10:user:1");
+    REQUIRE(Collect(index, "tenant:1:").size() == 2);
+    REQUIRE(Collect(index, "tenant:1").size() == 3);
+    REQUIRE(Collect(index, "tenant:").size() == 4);
+    REQUIRE(Collect(index, "tenant:3").empty());
+  }
+
+  SECTION("Insert repoints an existing key") {
+    add("moved");
+    const auto &fresh = keys.emplace_back("moved");
+    index.Insert(fresh);
+    REQUIRE(index.Size() == 1);
+    REQUIRE(index.Find("moved") == &fresh);
+  }
+
+  SECTION("Every byte value can branch") {
+    for (auto b = 0; b < 256; ++b) {
+      add(std::string{"k"} + static_cast<char>(b));
+    }
+    const auto all = Collect(index, "k");
+    REQUIRE(all.size() == 256);
+    REQUIRE(std::is_sorted(all.begin(), all.end(), [](auto &a, auto &b) {
+      return static_cast<unsigned char>(a[1]) <
+             static_cast<unsigned char>(b[1]);
+    }));
+    for (auto b = 0; b < 256; b += 2) {
+      REQUIRE(index.Erase(std::string{"k"} + static_cast<char>(b)));
+    }
+    REQUIRE(Collect(index, "k").size() == 128);
+    for (auto b = 1; b < 256; b += 2) {
+      REQUIRE(index.Erase(std::string{"k"} + static_cast<char>(b)));
+    }
+    REQUIRE(index.Size() == 0);
+    REQUIRE(Collect(index, "").empty());
+  }
+}
+
+TEST_CASE("KeyIndex agrees with std::set", "[key_index]") {
+  CountingResource memory;
+  std::mt19937 rng{1234};
+  std::deque<KeyIndex::Key> storage;
+  std::set<std::string> reference;
+  {
+    KeyIndex index{&memory};
+    auto random_key = [&] {
+      // Shared stems make for deep trees; the occasional byte from a wide
+      // range makes some nodes grow to 48 and 256 children
+      std::string key = rng() % 2 ? "user:" : "tenant:";
+      for (auto n = rng() % 6; n > 0; --n) {
+        key += rng() % 2 ? "ab:1"[rng() % 4] : static_cast<char>(rng() % 256);
+      }
+      return key;
+    };
+
+    for (auto i = 0; i < 20'000; ++i) {
+      const auto key = random_key();
+      if (rng() % 3 != 0) {
+        index.Insert(storage.emplace_back(key));
+        reference.insert(key);
+      } else {
+        REQUIRE(index.Erase(key) == (reference.erase(key) == 1));
+      }
+      REQUIRE(index.Size() == reference.size());
+    }
+
+    for (auto prefix : {"", "u", "user:", "tenant:a", "user:ab:", "x"}) {
+      std::vector<std::string> expected;
+      for (auto it = reference.lower_bound(prefix);
+           it != reference.end() && it->starts_with(prefix); ++it) {
+        expected.push_back(*it);
+      }
+      REQUIRE(Collect(index, prefix) == expected);
+    }
+
+    for (const auto &key : std::set<std::string>{reference}) {
+      REQUIRE(index.Erase(key));
+    }
+    REQUIRE(index.Size() == 0);
+    // Emptying the tree frees every node
+    REQUIRE(memory.Allocated() == 0);
+  }
+}
@@ -0,0 +1,53 @@
+#include "lazy_freer.hpp"
+
+LazyFreer::~LazyFreer() {
+  {
+    std::lock_guard lock{mutex_};
+    stop_ = true;
+  }
+  wake_.notify_one();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+  // Whatever the worker did not get to (or everything, if it never started)
+  queue_.clear();
+}
+
+void LazyFreer::Enqueue(std::unique_ptr<Garbage> garbage) {
+  {
+    std::lock_guard lock{mutex_};
+    queue_.push_back(std::move(garbage));
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    if (!worker_.joinable()) {
+      worker_ = std::thread{&LazyFreer::Run, this};
+    }
+  }
+  wake_.notify_one();
+}
+
+void LazyFreer::Wait() {
+  std::unique_lock lock{mutex_};
+  idle_.wait(lock,
+             [this] { return pending_.load(std::memory_order_relaxed) == 0; });
+}
+
+void LazyFreer::Run() {
+  std::vector<std::unique_ptr<Garbage>> batch;
+  std::unique_lock lock{mutex_};
+  while (true) {
+    wake_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (stop_) {
+      return;
+    }
+
+    batch.swap(queue_);
+    lock.unlock();
+    const auto count = batch.size();
+    batch.clear(); // the actual work
+    lock.lock();
+
+    pending_.fetch_sub(count, std::memory_order_relaxed);
+    freed_.fetch_add(count, std::memory_order_relaxed);
+    idle_.notify_all();
+  }
+}
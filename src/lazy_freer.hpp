@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Destroys objects on a background thread, so that dropping a huge value or
+// a whole keyspace does not stall the event loop. The object is moved out of
+// the keyspace on the caller's thread first, which keeps the change itself
+// atomic for clients; only the (possibly long) destructor runs elsewhere.
+//
+// Anything handed over must only deallocate through resources that accept
+// frees from another thread (see SlabResource).
+class LazyFreer {
+public:
+  LazyFreer() = default;
+  ~LazyFreer();
+
+  LazyFreer(const LazyFreer &) = delete;
+  LazyFreer &operator=(const LazyFreer &) = delete;
+
+  template <typename T> void Free(T &&object) {
+    Enqueue(std::make_unique<Holder<std::decay_t<T>>>(std::forward<T>(object)));
+  }
+
+  // Blocks until everything queued so far has been destroyed.
+  void Wait();
+
+  std::size_t Pending() const noexcept {
+    return pending_.load(std::memory_order_relaxed);
+  }
+  std::size_t Freed() const noexcept {
+    return freed_.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Garbage {
+    virtual ~Garbage() = default;
+  };
+
+  template <typename T> struct Holder : Garbage {
+    explicit Holder(T &&object) : object{std::move(object)} {}
+    T object;
+  };
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  std::vector<std::unique_ptr<Garbage>> queue_;
+  bool stop_ = false;
+  std::atomic<std::size_t> pending_ = 0;
+  std::atomic<std::size_t> freed_ = 0;
+  std::thread worker_; // started on first use
+
+  void Enqueue(std::unique_ptr<Garbage> garbage);
+  void Run();
+};
@@ -0,0 +1,61 @@
+#include "lazy_freer.hpp"
+
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Tracked {
+  std::atomic<int> *destroyed;
+  std::thread::id *destroyed_on;
+
+  Tracked(std::atomic<int> *counter, std::thread::id *thread)
+      : destroyed{counter}, destroyed_on{thread} {}
+  Tracked(Tracked &&other) noexcept
+      : destroyed{std::exchange(other.destroyed, nullptr)}
+      , destroyed_on{other.destroyed_on} {}
+  ~Tracked() {
+    if (destroyed) {
+      *destroyed_on = std::this_thread::get_id();
+      ++*destroyed;
+    }
+  }
+};
+
+} // namespace
+
+TEST_CASE("LazyFreer destroys objects in the background", "[lazyfree]") {
+  std::atomic<int> destroyed = 0;
+  std::thread::id destroyed_on;
+
+  SECTION("Objects are destroyed on the worker thread") {
+    LazyFreer freer;
+    freer.Free(Tracked{&destroyed, &destroyed_on});
+    freer.Wait();
+    REQUIRE(destroyed == 1);
+    REQUIRE(destroyed_on != std::this_thread::get_id());
+    REQUIRE(freer.Pending() == 0);
+    REQUIRE(freer.Freed() == 1);
+  }
+
+  SECTION("Large batches are all freed") {
+    LazyFreer freer;
+    for (auto i = 0; i < 1000; ++i) {
+      freer.Free(std::vector<int>(1000, i));
+    }
+    freer.Wait();
+    REQUIRE(freer.Freed() == 1000);
+  }
+
+  SECTION("Destruction frees whatever is still queued") {
+    {
+      LazyFreer freer;
+      for (auto i = 0; i < 100; ++i) {
+        freer.Free(Tracked{&destroyed, &destroyed_on});
+      }
+    }
+    REQUIRE(destroyed == 100);
+  }
+}
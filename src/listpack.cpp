@@ -0,0 +1,149 @@
+#include "listpack.hpp"
+
+#include <cstring>
+#include <utility>
+
+namespace {
+
+constexpr unsigned char MORE = 0x80;
+constexpr unsigned char LOW_BITS = 0x7F;
+
+std::size_t VarintSize(std::size_t value) noexcept {
+  std::size_t bytes = 1;
+  while (value > LOW_BITS) {
+    value >>= 7;
+    ++bytes;
+  }
+  return bytes;
+}
+
+// Seven bits per byte, lowest first; the top bit marks that more follow
+char *WriteVarint(char *out, std::size_t value) noexcept {
+  while (value > LOW_BITS) {
+    *out++ = static_cast<char>((value & LOW_BITS) | MORE);
+    value >>= 7;
+  }
+  *out++ = static_cast<char>(value);
+  return out;
+}
+
+std::pair<std::size_t, std::size_t> ReadVarint(const char *in) noexcept {
+  std::size_t value = 0;
+  std::size_t bytes = 0;
+  for (unsigned shift = 0;; shift += 7) {
+    const auto byte = static_cast<unsigned char>(in[bytes++]);
+    value |= static_cast<std::size_t>(byte & LOW_BITS) << shift;
+    if (!(byte & MORE)) {
+      return {value, bytes};
+    }
+  }
+}
+
+// The same bytes in reverse order, ending just before `end`
+void WriteBackVarint(char *end, std::size_t value) noexcept {
+  char tmp[10];
+  const auto bytes = static_cast<std::size_t>(WriteVarint(tmp, value) - tmp);
+  for (std::size_t i = 0; i < bytes; ++i) {
+    end[-1 - static_cast<std::ptrdiff_t>(i)] = tmp[i];
+  }
+}
+
+std::pair<std::size_t, std::size_t> ReadBackVarint(const char *end) noexcept {
+  std::size_t value = 0;
+  std::size_t bytes = 0;
+  for (unsigned shift = 0;; shift += 7) {
+    const auto byte = static_cast<unsigned char>(*(end - 1 - bytes++));
+    value |= static_cast<std::size_t>(byte & LOW_BITS) << shift;
+    if (!(byte & MORE)) {
+      return {value, bytes};
+    }
+  }
+}
+
+// Fills the `bytes` reserved at `at` with an entry holding `value`
+void WriteEntry(char *at, std::string_view value, std::size_t bytes) noexcept {
+  auto *out = WriteVarint(at, value.size());
+  if (!value.empty()) {
+    std::memcpy(out, value.data(), value.size());
+    out += value.size();
+  }
+  WriteBackVarint(at + bytes, static_cast<std::size_t>(out - at));
+}
+
+} // namespace
+
+std::size_t Listpack::EntryBytes(std::size_t length) noexcept {
+  const auto front = VarintSize(length) + length;
+  return front + VarintSize(front);
+}
+
+std::size_t Listpack::Next(std::size_t offset) const noexcept {
+  const auto [length, header] = ReadVarint(buf_.data() + offset);
+  const auto front = header + length;
+  return offset + front + VarintSize(front);
+}
+
+std::size_t Listpack::Prev(std::size_t offset) const noexcept {
+  const auto [front, back] = ReadBackVarint(buf_.data() + offset);
+  return offset - back - front;
+}
+
+std::string_view Listpack::Get(std::size_t offset) const noexcept {
+  const auto [length, header] = ReadVarint(buf_.data() + offset);
+  return {buf_.data() + offset + header, length};
+}
+
+std::size_t Listpack::Find(std::string_view value,
+                           std::size_t from) const noexcept {
+  const auto *data = buf_.data();
+  for (auto offset = from; offset < buf_.size();) {
+    const auto [length, header] = ReadVarint(data + offset);
+    const auto front = header + length;
+    // Lengths first: most entries are skipped without touching their bytes
+    if (length == value.size() &&
+        (length == 0 ||
+         std::memcmp(data + offset + header, value.data(), length) == 0)) {
+      return offset;
+    }
+    offset += front + VarintSize(front);
+  }
+  return buf_.size();
+}
+
+void Listpack::Insert(std::size_t offset, std::string_view value) {
+  const auto bytes = EntryBytes(value.size());
+  buf_.insert(offset, bytes, '\0');
+  WriteEntry(buf_.data() + offset, value, bytes);
+  ++count_;
+}
+
+void Listpack::Replace(std::size_t offset, std::string_view value) {
+  const auto bytes = EntryBytes(value.size());
+  buf_.replace(offset, Next(offset) - offset, bytes, '\0');
+  WriteEntry(buf_.data() + offset, value, bytes);
+}
+
+void Listpack::Erase(std::size_t offset) {
+  buf_.erase(offset, Next(offset) - offset);
+  --count_;
+}
+
+void Listpack::Erase(std::size_t offset, std::size_t count) {
+  auto end = offset;
+  for (std::size_t i = 0; i < count; ++i) {
+    end = Next(end);
+  }
+  buf_.erase(offset, end - offset);
+  count_ -= count;
+}
+
+void Listpack::Split(std::size_t offset, Listpack &tail) {
+  std::size_t moved = 0;
+  for (auto o = offset; o != End(); o = Next(o)) {
+    ++moved;
+  }
+  tail.buf_.append(buf_, offset);
+  tail.count_ += moved;
+  buf_.resize(offset);
+  count_ -= moved;
+}
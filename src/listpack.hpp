@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// A list of strings packed into one contiguous buffer, after Redis'
+// listpack (without its integer encodings). Each entry is
+//
+//   [length] [bytes] [back length]
+//
+// where both lengths are varints and the back length, the size of the
+// first two parts, is written backwards so it can be read from the end of
+// the entry. That is what lets the list be walked from either side. A short
+// element costs two bytes on top of its contents and the whole list is one
+// allocation.
+//
+// Entries are addressed by byte offset: Begin() is the first entry and
+// End() is one past the last. Inserting or erasing moves the bytes after
+// the entry, so callers keep listpacks small (see QuickList).
+class Listpack {
+public:
+  explicit Listpack(std::pmr::memory_resource *resource =
+                      std::pmr::get_default_resource()) noexcept
+      : buf_{resource} {}
+
+  std::size_t Size() const noexcept { return count_; }
+  bool Empty() const noexcept { return count_ == 0; }
+  std::size_t Bytes() const noexcept { return buf_.size(); }
+  // Bytes taken by an entry holding `length` bytes
+  static std::size_t EntryBytes(std::size_t length) noexcept;
+
+  std::size_t Begin() const noexcept { return 0; }
+  std::size_t End() const noexcept { return buf_.size(); }
+  std::size_t Next(std::size_t offset) const noexcept;
+  std::size_t Prev(std::size_t offset) const noexcept;
+  std::string_view Get(std::size_t offset) const noexcept;
+  // Offset of the first entry equal to `value` at or after the entry at
+  // `from`, or End()
+  std::size_t Find(std::string_view value,
+                   std::size_t from = 0) const noexcept;
+
+  // Inserts before the entry at `offset`; End() appends
+  void Insert(std::size_t offset, std::string_view value);
+  // Overwrites the entry at `offset`, moving the bytes after it once
+  void Replace(std::size_t offset, std::string_view value);
+  // Removes the entry at `offset`; the one after it moves to `offset`
+  void Erase(std::size_t offset);
+  // Removes `count` entries from `offset` on with a single move
+  void Erase(std::size_t offset, std::size_t count);
+  // Moves the entries from `offset` on to the end of `tail`
+  void Split(std::size_t offset, Listpack &tail);
+  void Clear() noexcept {
+    // Give the buffer back rather than keep its capacity
+    std::pmr::string{buf_.get_allocator()}.swap(buf_);
+    count_ = 0;
+  }
+
+  // The backing buffer, for memory accounting and defrag
+  std::pmr::string &Buffer() noexcept { return buf_; }
+  const std::pmr::string &Buffer() const noexcept { return buf_; }
+
+  void Swap(Listpack &other) noexcept {
+    buf_.swap(other.buf_);
+    std::swap(count_, other.count_);
+  }
+
+private:
+  std::pmr::string buf_;
+  std::size_t count_ = 0;
+};
@@ -0,0 +1,97 @@
+#include "listpack.hpp"
+
+#include "counting_resource.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+TEST_CASE("Listpack entries", "[listpack]") {
+  CountingResource memory;
+  Listpack entries{&memory};
+
+  SECTION("Entries are read back in either direction") {
+    // Lengths either side of each varint width boundary
+    const std::vector<std::string> values{
+      "", "a", std::string(127, 'b'), std::string(128, 'c'),
+      std::string(20'000, 'd')};
+    for (const auto &value : values) {
+      entries.Insert(entries.End(), value);
+    }
+    REQUIRE(entries.Size() == values.size());
+
+    auto offset = entries.Begin();
+    for (const auto &value : values) {
+      REQUIRE(entries.Get(offset) == value);
+      offset = entries.Next(offset);
+    }
+    REQUIRE(offset == entries.End());
+
+    for (auto it = values.rbegin(); it != values.rend(); ++it) {
+      offset = entries.Prev(offset);
+      REQUIRE(entries.Get(offset) == *it);
+    }
+    REQUIRE(offset == entries.Begin());
+  }
+
+  SECTION("A short entry costs two bytes on top of its contents") {
+    entries.Insert(entries.End(), "hello");
+    REQUIRE(entries.Bytes() == 7);
+    REQUIRE(Listpack::EntryBytes(5) == 7);
+  }
+
+  SECTION("Insert and erase in the middle") {
+    entries.Insert(entries.End(), "a");
+    entries.Insert(entries.End(), "c");
+    entries.Insert(entries.Next(entries.Begin()), "b");
+    REQUIRE(entries.Get(entries.Next(entries.Begin())) == "b");
+
+    entries.Erase(entries.Begin());
+    REQUIRE(entries.Size() == 2);
+    REQUIRE(entries.Get(entries.Begin()) == "b");
+    REQUIRE(entries.Get(entries.Prev(entries.End())) == "c");
+  }
+
+  SECTION("Replace, range erase and split") {
+    for (const auto *value : {"a", "b", "c", "d", "e"}) {
+      entries.Insert(entries.End(), value);
+    }
+    const auto second = entries.Next(entries.Begin());
+    entries.Replace(second, std::string(200, 'B'));
+    REQUIRE(entries.Get(second) == std::string(200, 'B'));
+    REQUIRE(entries.Get(entries.Next(second)) == "c");
+    REQUIRE(entries.Size() == 5);
+
+    entries.Erase(second, 2);
+    REQUIRE(entries.Size() == 3);
+    REQUIRE(entries.Get(second) == "d");
+
+    Listpack tail{&memory};
+    entries.Split(second, tail);
+    REQUIRE(entries.Size() == 1);
+    REQUIRE(tail.Size() == 2);
+    REQUIRE(tail.Get(tail.Begin()) == "d");
+    REQUIRE(tail.Get(tail.Prev(tail.End())) == "e");
+    REQUIRE(tail.Find("e", tail.Next(tail.Begin())) ==
+            tail.Next(tail.Begin()));
+    REQUIRE(tail.Find("d", tail.Next(tail.Begin())) == tail.End());
+  }
+
+  SECTION("Find compares lengths before bytes") {
+    for (const auto *value : {"ab", "", "abc", "abd"}) {
+      entries.Insert(entries.End(), value);
+    }
+    REQUIRE(entries.Get(entries.Find("abd")) == "abd");
+    REQUIRE(entries.Find("") == entries.Next(entries.Begin()));
+    REQUIRE(entries.Find("a") == entries.End());
+    REQUIRE(entries.Find("abcd") == entries.End());
+  }
+
+  SECTION("Clear gives the buffer back") {
+    entries.Insert(entries.End(), std::string(100, 'x'));
+    REQUIRE(memory.Allocated() > 0);
+    entries.Clear();
+    REQUIRE(entries.Empty());
+    REQUIRE(memory.Allocated() == 0);
+  }
+}
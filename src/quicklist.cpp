@@ -0,0 +1,493 @@
+#include "quicklist.hpp"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+QuickList::QuickList(QuickList &&other) noexcept
+    : compact_{other.resource()}
+    , head_{std::exchange(other.head_, nullptr)}
+    , tail_{std::exchange(other.tail_, nullptr)}
+    , nodes_{std::exchange(other.nodes_, 0)}
+    , size_{std::exchange(other.size_, 0)}
+    , origin_{other.origin_}
+    , index_{other.resource()} {
+  compact_.Swap(other.compact_);
+}
+
+QuickList &QuickList::operator=(QuickList &&other) noexcept {
+  if (this != &other) {
+    clear();
+    compact_.Swap(other.compact_);
+    head_ = std::exchange(other.head_, nullptr);
+    tail_ = std::exchange(other.tail_, nullptr);
+    nodes_ = std::exchange(other.nodes_, 0);
+    size_ = std::exchange(other.size_, 0);
+    origin_ = other.origin_;
+    index_stale_ = true;
+  }
+  return *this;
+}
+
+std::string_view QuickList::back() const {
+  const auto &entries = IsCompact() ? compact_ : tail_->entries;
+  return entries.Get(entries.Prev(entries.End()));
+}
+
+void QuickList::push_front(std::string_view value) {
+  --origin_;
+  if (IsCompact()) {
+    if (Fits(compact_, value.size())) {
+      compact_.Insert(compact_.Begin(), value);
+      ++size_;
+      return;
+    }
+    Expand();
+  }
+  if (!Fits(head_->entries, value.size())) {
+    head_ = NewNode(nullptr, head_);
+  }
+  head_->entries.Insert(head_->entries.Begin(), value);
+  head_->first = origin_;
+  ++size_;
+}
+
+void QuickList::push_back(std::string_view value) {
+  if (IsCompact()) {
+    if (Fits(compact_, value.size())) {
+      compact_.Insert(compact_.End(), value);
+      ++size_;
+      return;
+    }
+    Expand();
+  }
+  if (!Fits(tail_->entries, value.size())) {
+    tail_ = NewNode(tail_, nullptr);
+  }
+  tail_->entries.Insert(tail_->entries.End(), value);
+  ++size_;
+}
+
+void QuickList::pop_front() {
+  --size_;
+  ++origin_;
+  if (IsCompact()) {
+    compact_.Erase(compact_.Begin());
+    return;
+  }
+  head_->entries.Erase(head_->entries.Begin());
+  head_->first = origin_;
+  if (head_->entries.Empty()) {
+    Unlink(head_);
+  }
+  MaybeCompact();
+}
+
+void QuickList::pop_back() {
+  --size_;
+  if (IsCompact()) {
+    compact_.Erase(compact_.Prev(compact_.End()));
+    return;
+  }
+  auto &entries = tail_->entries;
+  entries.Erase(entries.Prev(entries.End()));
+  if (entries.Empty()) {
+    Unlink(tail_);
+  }
+  MaybeCompact();
+}
+
+void QuickList::MoveTo(QuickList &to, bool from_back, bool to_back) {
+  auto *node = IsCompact() ? nullptr : (from_back ? tail_ : head_);
+  if (&to != this && node && node->entries.Size() == 1 &&
+      to.resource() == resource()) {
+    // Alone in its node, as big elements are: hand the node over
+    Detach(node);
+    --size_;
+    if (!from_back) {
+      ++origin_;
+    }
+    MaybeCompact();
+    to.Adopt(node, to_back);
+    return;
+  }
+
+  const auto value = from_back ? back() : front();
+  if (&to == this) {
+    // The push may move the bytes it reads, so rotate through a copy
+    const std::pmr::string copy{value, resource()};
+    from_back ? pop_back() : pop_front();
+    to_back ? push_back(copy) : push_front(copy);
+    return;
+  }
+  // Otherwise copied once, straight from one listpack into the other
+  to_back ? to.push_back(value) : to.push_front(value);
+  from_back ? pop_back() : pop_front();
+}
+
+void QuickList::clear() noexcept {
+  while (head_) {
+    auto *next = head_->next;
+    DeleteNode(head_);
+    head_ = next;
+  }
+  tail_ = nullptr;
+  nodes_ = 0;
+  compact_.Clear();
+  size_ = 0;
+  origin_ = 0;
+  std::pmr::vector<Node *>{index_.get_allocator()}.swap(index_);
+  index_stale_ = true;
+}
+
+QuickList::const_iterator QuickList::begin() const noexcept {
+  if (empty()) {
+    return end();
+  }
+  if (IsCompact()) {
+    return {nullptr, &compact_, compact_.Begin()};
+  }
+  return {head_, &head_->entries, 0};
+}
+
+QuickList::const_iterator QuickList::Seek(std::size_t index) const {
+  if (index >= size_) {
+    return end();
+  }
+
+  const Node *node = nullptr;
+  const Listpack *entries = &compact_;
+  if (!IsCompact()) {
+    if (index_stale_) {
+      RebuildIndex();
+    }
+    // The last node starting at or before the element
+    const auto rank = origin_ + static_cast<std::int64_t>(index);
+    const auto after = std::ranges::upper_bound(
+      index_, rank, {}, [](const Node *n) { return n->first; });
+    node = *std::prev(after);
+    index = static_cast<std::size_t>(rank - node->first);
+    entries = &node->entries;
+  }
+  return SeekIn(node, entries, index);
+}
+
+QuickList::const_iterator QuickList::SeekShared(std::size_t index) const {
+  if (index >= size_) {
+    return end();
+  }
+  if (IsCompact() || !index_stale_) {
+    return Seek(index);
+  }
+
+  const Node *node = nullptr;
+  if (index < size_ / 2) {
+    for (node = head_; index >= node->entries.Size(); node = node->next) {
+      index -= node->entries.Size();
+    }
+  } else {
+    auto rest = size_ - index; // elements from `index` to the end
+    for (node = tail_; rest > node->entries.Size(); node = node->prev) {
+      rest -= node->entries.Size();
+    }
+    index = node->entries.Size() - rest;
+  }
+  return SeekIn(node, &node->entries, index);
+}
+
+QuickList::const_iterator QuickList::SeekIn(const Node *node,
+                                            const Listpack *entries,
+                                            std::size_t index) {
+  // Within the listpack, walk from the nearer end too
+  std::size_t offset = 0;
+  if (index < entries->Size() / 2) {
+    offset = entries->Begin();
+    for (; index > 0; --index) {
+      offset = entries->Next(offset);
+    }
+  } else {
+    offset = entries->End();
+    for (auto rest = entries->Size() - index; rest > 0; --rest) {
+      offset = entries->Prev(offset);
+    }
+  }
+  return {node, entries, offset};
+}
+
+QuickList::const_iterator QuickList::Find(std::string_view value) const {
+  if (IsCompact()) {
+    const auto offset = compact_.Find(value);
+    if (offset == compact_.End()) {
+      return end();
+    }
+    return {nullptr, &compact_, offset};
+  }
+  for (const auto *node = head_; node; node = node->next) {
+    const auto offset = node->entries.Find(value);
+    if (offset != node->entries.End()) {
+      return {node, &node->entries, offset};
+    }
+  }
+  return end();
+}
+
+void QuickList::Insert(const_iterator pos, std::string_view value) {
+  if (pos == end()) {
+    push_back(value);
+    return;
+  }
+  if (pos == begin()) {
+    push_front(value);
+    return;
+  }
+  // Iterators only ever point into this list
+  auto *node = const_cast<Node *>(pos.node_);
+  auto &entries = node ? node->entries : compact_;
+  entries.Insert(pos.offset_, value);
+  ++size_;
+  if (node != tail_) {
+    index_stale_ = true;
+  }
+  SplitIfFull(node);
+}
+
+void QuickList::Replace(const_iterator pos, std::string_view value) {
+  auto *node = const_cast<Node *>(pos.node_);
+  auto &entries = node ? node->entries : compact_;
+  entries.Replace(pos.offset_, value);
+  SplitIfFull(node);
+}
+
+QuickList::const_iterator QuickList::Erase(const_iterator pos) {
+  if (pos == begin()) {
+    pop_front();
+    return begin();
+  }
+  --size_;
+  auto *node = const_cast<Node *>(pos.node_);
+  auto &entries = node ? node->entries : compact_;
+  entries.Erase(pos.offset_);
+  if (!node) {
+    return pos.offset_ == entries.End() ? end() : pos;
+  }
+
+  if (node != tail_) {
+    index_stale_ = true;
+  }
+  auto *next = node;
+  auto offset = pos.offset_;
+  if (offset == entries.End()) {
+    next = node->next;
+    offset = 0;
+  }
+  if (entries.Empty()) {
+    Unlink(node);
+  }
+  MaybeCompact();
+  if (!next) {
+    return end();
+  }
+  // Compacting keeps only the one remaining node's entries
+  if (IsCompact()) {
+    return {nullptr, &compact_, offset};
+  }
+  return {next, &next->entries, offset};
+}
+
+void QuickList::EraseFront(std::size_t count) {
+  count = std::min(count, size_);
+  size_ -= count;
+  origin_ += static_cast<std::int64_t>(count);
+  if (IsCompact()) {
+    compact_.Erase(compact_.Begin(), count);
+    return;
+  }
+  while (head_ && count >= head_->entries.Size()) {
+    count -= head_->entries.Size();
+    Unlink(head_);
+  }
+  if (count > 0) {
+    head_->entries.Erase(head_->entries.Begin(), count);
+    head_->first = origin_;
+  }
+  MaybeCompact();
+}
+
+void QuickList::EraseBack(std::size_t count) {
+  count = std::min(count, size_);
+  size_ -= count;
+  auto erase_last = [count](Listpack &entries) {
+    auto offset = entries.End();
+    for (auto i = count; i > 0; --i) {
+      offset = entries.Prev(offset);
+    }
+    entries.Erase(offset, count);
+  };
+  if (IsCompact()) {
+    erase_last(compact_);
+    return;
+  }
+  while (tail_ && count >= tail_->entries.Size()) {
+    count -= tail_->entries.Size();
+    Unlink(tail_);
+  }
+  if (count > 0) {
+    erase_last(tail_->entries);
+  }
+  MaybeCompact();
+}
+
+std::size_t QuickList::Remove(std::string_view value, std::size_t limit,
+                              bool from_back) {
+  std::size_t removed = 0;
+  // True once `limit` is reached
+  auto remove_from = [&](Listpack &entries) {
+    if (!from_back) {
+      for (auto o = entries.Find(value); o != entries.End();
+           o = entries.Find(value, o)) {
+        entries.Erase(o);
+        if (++removed == limit) {
+          return true;
+        }
+      }
+      return false;
+    }
+    for (auto o = entries.End(); o != entries.Begin();) {
+      o = entries.Prev(o);
+      if (entries.Get(o) == value) {
+        entries.Erase(o);
+        if (++removed == limit) {
+          return true;
+        }
+      }
+    }
+    return false;
+  };
+
+  if (IsCompact()) {
+    remove_from(compact_);
+    size_ -= removed;
+    return removed;
+  }
+  for (auto *node = from_back ? tail_ : head_; node;) {
+    auto *next = from_back ? node->prev : node->next;
+    const auto before = removed;
+    const bool done = remove_from(node->entries);
+    if (removed != before) {
+      index_stale_ = true;
+      if (node->entries.Empty()) {
+        Unlink(node);
+      }
+    }
+    if (done) {
+      break;
+    }
+    node = next;
+  }
+  size_ -= removed;
+  MaybeCompact();
+  return removed;
+}
+
+QuickList::Node *QuickList::NewNode(Node *prev, Node *next) {
+  std::pmr::polymorphic_allocator<Node> alloc{resource()};
+  auto *node = alloc.new_object<Node>(resource());
+  node->prev = prev;
+  node->next = next;
+  if (prev) {
+    prev->next = node;
+  }
+  if (next) {
+    next->prev = node;
+  }
+  ++nodes_;
+  index_stale_ = true;
+  return node;
+}
+
+void QuickList::DeleteNode(Node *node) noexcept {
+  std::pmr::polymorphic_allocator<Node> alloc{resource()};
+  alloc.delete_object(node);
+}
+
+void QuickList::Detach(Node *node) noexcept {
+  (node->prev ? node->prev->next : head_) = node->next;
+  (node->next ? node->next->prev : tail_) = node->prev;
+  --nodes_;
+  index_stale_ = true;
+}
+
+void QuickList::Unlink(Node *node) noexcept {
+  Detach(node);
+  DeleteNode(node);
+}
+
+void QuickList::Adopt(Node *node, bool back) {
+  ++size_;
+  if (!back) {
+    --origin_;
+  }
+  if (IsCompact()) {
+    if (compact_.Empty()) {
+      compact_.Swap(node->entries);
+      DeleteNode(node);
+      return;
+    }
+    Expand();
+  }
+  node->prev = back ? tail_ : nullptr;
+  node->next = back ? nullptr : head_;
+  (back ? tail_->next : head_->prev) = node;
+  (back ? tail_ : head_) = node;
+  ++nodes_;
+  index_stale_ = true;
+}
+
+void QuickList::Expand() {
+  head_ = tail_ = NewNode(nullptr, nullptr);
+  head_->entries.Swap(compact_);
+}
+
+void QuickList::MaybeCompact() noexcept {
+  // Half the limits, so a list near them does not flip back and forth
+  if (IsCompact() || head_ != tail_ ||
+      head_->entries.Size() > MAX_NODE_ENTRIES / 2 ||
+      head_->entries.Bytes() > MAX_NODE_BYTES / 2) {
+    return;
+  }
+  compact_.Swap(head_->entries);
+  Unlink(head_);
+}
+
+void QuickList::SplitIfFull(Node *node) {
+  const auto &entries = node ? node->entries : compact_;
+  if (entries.Size() < 2 || (entries.Size() <= MAX_NODE_ENTRIES &&
+                             entries.Bytes() <= MAX_NODE_BYTES)) {
+    return;
+  }
+  if (!node) {
+    Expand();
+    node = head_;
+  }
+  auto offset = node->entries.Begin();
+  for (auto i = node->entries.Size() / 2; i > 0; --i) {
+    offset = node->entries.Next(offset);
+  }
+  auto *half = NewNode(node, node->next);
+  if (tail_ == node) {
+    tail_ = half;
+  }
+  node->entries.Split(offset, half->entries);
+}
+
+void QuickList::RebuildIndex() const {
+  index_.clear();
+  index_.reserve(nodes_);
+  auto rank = origin_;
+  for (auto *node = head_; node; node = node->next) {
+    node->first = rank;
+    rank += static_cast<std::int64_t>(node->entries.Size());
+    index_.push_back(node);
+  }
+  index_stale_ = false;
+}
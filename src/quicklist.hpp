@@ -0,0 +1,249 @@
+#pragma once
+
+#include "listpack.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+// The list type behind LPUSH and friends. A short list is a single Listpack
+// kept in place (the "listpack" encoding), so a list of a few small
+// elements is one allocation. Once it outgrows MAX_NODE_BYTES or
+// MAX_NODE_ENTRIES it becomes a doubly linked chain of listpacks within the
+// same bounds (the "quicklist" encoding), and pushes and pops at either end
+// only ever move bytes inside one small node. A chain that shrinks back to
+// one half-full node turns into a plain listpack again.
+//
+// Positional access goes through an index of the chain's nodes, each
+// tagged with the rank of its first element, where an element's position
+// is its rank minus origin_. Pushing or popping at the front moves origin_
+// rather than every later node's rank, so the index survives the usual
+// queue and timeline traffic; adding or dropping a node, or an edit in
+// front of the last node, leaves it stale until the next Seek rebuilds it.
+// A seek is then a binary search over nodes plus a walk inside one node.
+//
+// Elements are read as string views into the listpacks; any modification
+// invalidates them, and iterators too.
+class QuickList {
+  struct Node {
+    Node *prev = nullptr;
+    Node *next = nullptr;
+    std::int64_t first = 0; // rank of the first element
+    Listpack entries;
+
+    explicit Node(std::pmr::memory_resource *resource) : entries{resource} {}
+  };
+
+public:
+  // Limits per listpack; one element bigger than MAX_NODE_BYTES gets a
+  // node of its own
+  static constexpr std::size_t MAX_NODE_BYTES = 8192;
+  static constexpr std::size_t MAX_NODE_ENTRIES = 128;
+  // Node footprint, so callers can ask the allocator about it
+  static constexpr std::size_t NODE_SIZE = sizeof(Node);
+  static constexpr std::size_t NODE_ALIGN = alignof(Node);
+
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = std::string_view;
+
+    const_iterator() = default;
+
+    std::string_view operator*() const { return entries_->Get(offset_); }
+
+    const_iterator &operator++() {
+      offset_ = entries_->Next(offset_);
+      if (offset_ == entries_->End()) {
+        node_ = node_ ? node_->next : nullptr;
+        entries_ = node_ ? &node_->entries : nullptr;
+        offset_ = 0;
+      }
+      return *this;
+    }
+    const_iterator operator++(int) {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    friend bool operator==(const const_iterator &a,
+                           const const_iterator &b) noexcept {
+      return a.entries_ == b.entries_ && a.offset_ == b.offset_;
+    }
+
+  private:
+    friend class QuickList;
+
+    const Node *node_ = nullptr; // null in a single listpack
+    const Listpack *entries_ = nullptr;
+    std::size_t offset_ = 0;
+
+    const_iterator(const Node *node, const Listpack *entries,
+                   std::size_t offset)
+        : node_{node}, entries_{entries}, offset_{offset} {}
+  };
+
+  explicit QuickList(std::pmr::memory_resource *resource =
+                       std::pmr::get_default_resource()) noexcept
+      : compact_{resource}, index_{resource} {}
+  QuickList(QuickList &&other) noexcept;
+  QuickList &operator=(QuickList &&other) noexcept;
+  QuickList(const QuickList &) = delete;
+  QuickList &operator=(const QuickList &) = delete;
+  ~QuickList() { clear(); }
+
+  std::size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+
+  std::string_view front() const { return *begin(); }
+  std::string_view back() const;
+  void push_front(std::string_view value);
+  void push_back(std::string_view value);
+  void pop_front();
+  void pop_back();
+  // Pops the front or back element and pushes it onto the front or back
+  // of `to`, which may be this list. An element alone in its node, as big
+  // ones are, moves along with the node instead of being copied.
+  void MoveTo(QuickList &to, bool from_back, bool to_back);
+  void clear() noexcept;
+
+  const_iterator begin() const noexcept;
+  const_iterator end() const noexcept { return {}; }
+  // The element at `index`, or end()
+  const_iterator Seek(std::size_t index) const;
+  // The same without rebuilding a stale index (the nodes are walked from
+  // the nearer end instead), so that concurrent readers only ever read
+  const_iterator SeekShared(std::size_t index) const;
+  // The first element equal to `value`, or end()
+  const_iterator Find(std::string_view value) const;
+
+  // Positional edits; each invalidates iterators other than the one it
+  // returns. Inserts before `pos`, end() appending.
+  void Insert(const_iterator pos, std::string_view value);
+  void Replace(const_iterator pos, std::string_view value);
+  // Returns the element after the erased one
+  const_iterator Erase(const_iterator pos);
+  // Drop up to `count` elements from one end, freeing whole nodes without
+  // looking at their elements
+  void EraseFront(std::size_t count);
+  void EraseBack(std::size_t count);
+  // Erases up to `limit` elements equal to `value` (0 for all), from the
+  // front or the back, and returns how many went
+  std::size_t Remove(std::string_view value, std::size_t limit,
+                     bool from_back);
+
+  // Calls visit(index) for each element equal to `value`, walking from the
+  // front or the back, until visit returns false or `maxlen` elements
+  // (0 for all) have been compared
+  template <typename F>
+  void FindEach(std::string_view value, bool from_back, std::size_t maxlen,
+                F &&visit) const {
+    const auto limit = maxlen == 0 ? size_ : std::min(maxlen, size_);
+    const Node *node = IsCompact() ? nullptr : (from_back ? tail_ : head_);
+    const auto *entries = node ? &node->entries : &compact_;
+    for (std::size_t looked = 0; looked < limit;) {
+      if (!from_back) {
+        for (auto o = entries->Begin(); o != entries->End() && looked < limit;
+             o = entries->Next(o), ++looked) {
+          if (entries->Get(o) == value && !visit(looked)) {
+            return;
+          }
+        }
+      } else {
+        for (auto o = entries->End(); o != entries->Begin() && looked < limit;
+             ++looked) {
+          o = entries->Prev(o);
+          if (entries->Get(o) == value && !visit(size_ - 1 - looked)) {
+            return;
+          }
+        }
+      }
+      if (!node) {
+        return;
+      }
+      node = from_back ? node->prev : node->next;
+      if (!node) {
+        return;
+      }
+      entries = &node->entries;
+    }
+  }
+
+  bool IsCompact() const noexcept { return head_ == nullptr; }
+  // Listpacks, and so allocations, that make up the list
+  std::size_t NodeCount() const noexcept {
+    return IsCompact() ? 1 : nodes_;
+  }
+  // Slots in the positional index, for memory accounting
+  std::size_t IndexCapacity() const noexcept { return index_.capacity(); }
+  // Calls visit(Listpack &) for each listpack, front to back
+  template <typename F> void ForEachListpack(F &&visit) {
+    if (IsCompact()) {
+      visit(compact_);
+      return;
+    }
+    for (auto *node = head_; node; node = node->next) {
+      visit(node->entries);
+    }
+  }
+  template <typename F> void ForEachListpack(F &&visit) const {
+    if (IsCompact()) {
+      visit(compact_);
+      return;
+    }
+    for (const auto *node = head_; node; node = node->next) {
+      visit(node->entries);
+    }
+  }
+
+  std::pmr::memory_resource *resource() const noexcept {
+    return compact_.Buffer().get_allocator().resource();
+  }
+
+private:
+  Listpack compact_; // the whole list while IsCompact(), else empty
+  Node *head_ = nullptr;
+  Node *tail_ = nullptr;
+  std::size_t nodes_ = 0;
+  std::size_t size_ = 0;
+  // Rank of the front element; see the class comment
+  std::int64_t origin_ = 0;
+  // The nodes in order, rebuilt lazily by Seek
+  mutable std::pmr::vector<Node *> index_;
+  mutable bool index_stale_ = true;
+
+  static bool Fits(const Listpack &entries, std::size_t length) noexcept {
+    return entries.Empty() ||
+           (entries.Size() < MAX_NODE_ENTRIES &&
+            entries.Bytes() + Listpack::EntryBytes(length) <= MAX_NODE_BYTES);
+  }
+
+  Node *NewNode(Node *prev, Node *next);
+  void DeleteNode(Node *node) noexcept;
+  // Takes a node out of the chain; unlinking the last one leaves an empty
+  // single listpack. Unlink also frees it.
+  void Detach(Node *node) noexcept;
+  void Unlink(Node *node) noexcept;
+  // Links a node detached from another list sharing our resource at
+  // either end
+  void Adopt(Node *node, bool back);
+  // Moves the single listpack into the first node of a chain
+  void Expand();
+  // Back to a single listpack once the chain is one small node
+  void MaybeCompact() noexcept;
+  // Halves a listpack (null for the single one) that an insert or a
+  // replace pushed past the limits
+  void SplitIfFull(Node *node);
+  void RebuildIndex() const;
+  // Element `index` of one listpack
+  static const_iterator SeekIn(const Node *node, const Listpack *entries,
+                               std::size_t index);
+};
@@ -0,0 +1,313 @@
+#include "quicklist.hpp"
+
+#include "counting_resource.hpp"
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+void RequireSame(const QuickList &list, const std::deque<std::string> &model) {
+  REQUIRE(list.size() == model.size());
+  auto it = list.begin();
+  for (const auto &value : model) {
+    REQUIRE(it != list.end());
+    REQUIRE(*it == value);
+    ++it;
+  }
+  REQUIRE(it == list.end());
+}
+
+} // namespace
+
+TEST_CASE("QuickList encodings", "[quicklist]") {
+  CountingResource memory;
+  QuickList list{&memory};
+
+  SECTION("A short list is a single listpack") {
+    list.push_back("b");
+    list.push_front("a");
+    list.push_back("c");
+    REQUIRE(list.IsCompact());
+    REQUIRE(list.NodeCount() == 1);
+    REQUIRE(list.front() == "a");
+    REQUIRE(list.back() == "c");
+  }
+
+  SECTION("A long list becomes a chain and shrinks back") {
+    const auto count = QuickList::MAX_NODE_ENTRIES * 3;
+    for (std::size_t i = 0; i < count; ++i) {
+      list.push_back(std::to_string(i));
+    }
+    REQUIRE_FALSE(list.IsCompact());
+    REQUIRE(list.NodeCount() == 3);
+    REQUIRE(list.front() == "0");
+    REQUIRE(list.back() == std::to_string(count - 1));
+
+    while (list.size() > 1) {
+      list.pop_front();
+    }
+    REQUIRE(list.IsCompact());
+    REQUIRE(list.front() == std::to_string(count - 1));
+  }
+
+  SECTION("Big elements get nodes of their own") {
+    const std::string big(QuickList::MAX_NODE_BYTES, 'x');
+    list.push_back(big);
+    list.push_back(big);
+    REQUIRE(list.NodeCount() == 2);
+    REQUIRE(list.back() == big);
+  }
+
+  SECTION("Seek finds elements from either end") {
+    for (auto i = 0; i < 1000; ++i) {
+      list.push_back(std::to_string(i));
+    }
+    for (auto i : {0, 1, 127, 128, 499, 500, 501, 872, 998, 999}) {
+      REQUIRE(*list.Seek(static_cast<std::size_t>(i)) == std::to_string(i));
+    }
+    REQUIRE(list.Seek(1000) == list.end());
+  }
+
+  SECTION("Moving leaves the source empty") {
+    for (auto i = 0; i < 300; ++i) {
+      list.push_back(std::to_string(i));
+    }
+    QuickList moved{std::move(list)};
+    REQUIRE(moved.size() == 300);
+    REQUIRE(list.empty());
+    REQUIRE(list.IsCompact());
+    list = std::move(moved);
+    REQUIRE(list.size() == 300);
+    REQUIRE(list.back() == "299");
+  }
+
+  list.clear();
+  REQUIRE(memory.Allocated() == 0);
+}
+
+TEST_CASE("QuickList matches a deque", "[quicklist]") {
+  CountingResource memory;
+  std::deque<std::string> model;
+  std::mt19937 rng{42};
+
+  {
+    QuickList list{&memory};
+    for (auto step = 0; step < 20'000; ++step) {
+      const auto op = rng() % 5;
+      if (op < 3) {
+        // Mostly small values, now and then one past the node limit
+        const auto length =
+          rng() % 50 == 0 ? QuickList::MAX_NODE_BYTES + 1 : rng() % 40;
+        std::string value(length, static_cast<char>('a' + step % 26));
+        if (op == 0) {
+          list.push_front(value);
+          model.push_front(std::move(value));
+        } else {
+          list.push_back(value);
+          model.push_back(std::move(value));
+        }
+      } else if (!model.empty()) {
+        if (op == 3) {
+          REQUIRE(list.front() == model.front());
+          list.pop_front();
+          model.pop_front();
+        } else {
+          REQUIRE(list.back() == model.back());
+          list.pop_back();
+          model.pop_back();
+        }
+      }
+      if (step % 1000 == 0) {
+        RequireSame(list, model);
+        if (!model.empty()) {
+          const auto index = rng() % model.size();
+          REQUIRE(*list.Seek(index) == model[index]);
+        }
+      }
+    }
+    RequireSame(list, model);
+  }
+  REQUIRE(memory.Allocated() == 0);
+}
+
+TEST_CASE("QuickList positional edits match a deque", "[quicklist]") {
+  CountingResource memory;
+  std::deque<std::string> model;
+  std::mt19937 rng{7};
+  // Few distinct values, so Remove and FindEach find plenty
+  auto value = [&] {
+    const auto length =
+      rng() % 200 == 0 ? QuickList::MAX_NODE_BYTES / 3 : rng() % 6;
+    return std::string(length, static_cast<char>('a' + rng() % 3));
+  };
+
+  {
+    QuickList list{&memory};
+    for (auto step = 0; step < 20'000; ++step) {
+      const auto op = rng() % 10;
+      const auto index = model.empty() ? 0 : rng() % model.size();
+      if (op < 3) {
+        auto v = value();
+        if (op == 0) {
+          list.push_front(v);
+          model.push_front(std::move(v));
+        } else {
+          list.push_back(v);
+          model.push_back(std::move(v));
+        }
+      } else if (op == 3 && !model.empty()) {
+        list.pop_front();
+        model.pop_front();
+      } else if (op == 4) {
+        auto v = value();
+        list.Insert(list.Seek(index), v);
+        model.insert(model.begin() + static_cast<std::ptrdiff_t>(index),
+                     std::move(v));
+      } else if (op == 5 && !model.empty()) {
+        auto v = value();
+        list.Replace(list.Seek(index), v);
+        model[index] = std::move(v);
+      } else if (op == 6 && !model.empty()) {
+        auto next = list.Erase(list.Seek(index));
+        model.erase(model.begin() + static_cast<std::ptrdiff_t>(index));
+        REQUIRE(next == list.Seek(index));
+      } else if (op == 7 && rng() % 20 == 0) {
+        const auto front = rng() % 300;
+        const auto back = rng() % 300;
+        list.EraseFront(front);
+        list.EraseBack(back);
+        model.erase(model.begin(),
+                    model.begin() + static_cast<std::ptrdiff_t>(
+                                      std::min<std::size_t>(front,
+                                                            model.size())));
+        model.resize(model.size() - std::min<std::size_t>(back, model.size()));
+      } else if (op == 8 && rng() % 10 == 0) {
+        const auto target = value();
+        const auto limit = rng() % 4;
+        const bool from_back = rng() % 2 == 0;
+        std::size_t removed = 0;
+        auto matches = [&](const std::string &v) {
+          if (v != target || (limit != 0 && removed == limit)) {
+            return false;
+          }
+          ++removed;
+          return true;
+        };
+        if (from_back) {
+          std::deque<std::string> kept;
+          for (auto it = model.rbegin(); it != model.rend(); ++it) {
+            if (!matches(*it)) {
+              kept.push_front(*it);
+            }
+          }
+          model = std::move(kept);
+        } else {
+          std::erase_if(model, matches);
+        }
+        REQUIRE(list.Remove(target, limit, from_back) == removed);
+      } else if (op == 9 && !model.empty()) {
+        const auto target = model[index];
+        std::vector<std::size_t> found;
+        list.FindEach(target, rng() % 2 == 0, 0, [&](std::size_t i) {
+          found.push_back(i);
+          return true;
+        });
+        std::ranges::sort(found);
+        std::vector<std::size_t> expected;
+        for (std::size_t i = 0; i < model.size(); ++i) {
+          if (model[i] == target) {
+            expected.push_back(i);
+          }
+        }
+        REQUIRE(found == expected);
+      }
+
+      if (!model.empty()) {
+        const auto probe = rng() % model.size();
+        REQUIRE(*list.Seek(probe) == model[probe]);
+      }
+      if (step % 1000 == 0) {
+        RequireSame(list, model);
+      }
+    }
+    RequireSame(list, model);
+  }
+  REQUIRE(memory.Allocated() == 0);
+}
+
+TEST_CASE("QuickList MoveTo", "[quicklist]") {
+  CountingResource memory;
+  {
+    QuickList from{&memory};
+    QuickList to{&memory};
+    const std::string big(QuickList::MAX_NODE_BYTES + 1, 'x');
+
+    SECTION("A big element takes its node along") {
+      for (auto i = 0; i < 200; ++i) {
+        from.push_back(std::to_string(i));
+      }
+      from.push_back(big);
+      const auto nodes = from.NodeCount();
+      const auto allocated = memory.Allocated();
+
+      from.MoveTo(to, /*from_back=*/true, /*to_back=*/false);
+      REQUIRE(to.front() == big);
+      REQUIRE(from.NodeCount() == nodes - 1);
+      REQUIRE(memory.Allocated() <= allocated);
+
+      // Into a chain this time
+      to.push_back("a");
+      to.push_back(big);
+      from.push_back(big);
+      from.MoveTo(to, true, true);
+      RequireSame(to, {big, "a", big, big});
+      REQUIRE(*from.Seek(199) == "199");
+      REQUIRE(from.size() == 200);
+    }
+
+    SECTION("Small elements are copied across") {
+      from.push_back("a");
+      from.push_back("b");
+      from.MoveTo(to, false, true);
+      from.MoveTo(to, false, false);
+      RequireSame(from, {});
+      RequireSame(to, {"b", "a"});
+    }
+
+    SECTION("A list can rotate onto itself") {
+      from.push_back("a");
+      from.push_back("b");
+      from.push_back(big);
+      from.MoveTo(from, true, false);
+      from.MoveTo(from, false, true);
+      from.MoveTo(from, true, false);
+      RequireSame(from, {big, "a", "b"});
+    }
+  }
+  REQUIRE(memory.Allocated() == 0);
+}
+
+TEST_CASE("QuickList SeekShared", "[quicklist]") {
+  QuickList list;
+  std::deque<std::string> model;
+  for (auto i = 0; i < 5'000; ++i) {
+    list.push_back(std::to_string(i));
+    model.push_back(std::to_string(i));
+  }
+
+  // Fresh index, then a stale one after an edit in the middle
+  for (auto round = 0; round < 2; ++round) {
+    for (std::size_t i = 0; i < model.size(); i += 97) {
+      REQUIRE(*list.SeekShared(i) == model[i]);
+    }
+    REQUIRE(*list.SeekShared(model.size() - 1) == model.back());
+    REQUIRE(list.SeekShared(model.size()) == list.end());
+    list.Insert(list.Seek(2'500), "new");
+    model.insert(model.begin() + 2'500, "new");
+  }
+}
@@ -4,6 +4,7 @@
 #include <array>
 #include <catch2/catch_test_macros.hpp>
 #include <memory_resource>
+#include <string_view>
 
 using namespace resp;
 
@@ -117,6 +118,44 @@ TEST_CASE("RespHandler handles partial data", "[handler]") {
     REQUIRE_FALSE(result.value.has_value());
     REQUIRE(result.value.error() == ParseStatus::NeedMore);
   }
+
+  SECTION("Command fed one byte at a time") {
+    RespHandler handler{&arena};
+    const std::string_view input = "*3\r\n$3\r\nSET\r\n:-7\r\n+OK\r\n";
+
+    for (std::size_t i = 0; i + 1 < input.size(); ++i) {
+      auto result = handler.Feed(input.substr(i, 1));
+      REQUIRE(result.consumed == 1);
+      REQUIRE_FALSE(result.value.has_value());
+      REQUIRE(result.value.error() == ParseStatus::NeedMore);
+    }
+    auto result = handler.Feed(input.substr(input.size() - 1));
+    REQUIRE(result.value.has_value());
+
+    auto &arr = std::get<Array>(*result.value).value;
+    REQUIRE(arr.size() == 3);
+    REQUIRE(std::get<BulkString>(arr[0]).value == "SET");
+    REQUIRE(std::get<Int>(arr[1]).value == -7);
+    REQUIRE(std::get<String>(arr[2]).value == "OK");
+  }
+
+  SECTION("CRLF split between feeds") {
+    RespHandler handler{&arena};
+
+    auto result1 = handler.Feed("*1\r");
+    REQUIRE(result1.consumed == 3);
+    auto result2 = handler.Feed("\n$2\r");
+    REQUIRE(result2.consumed == 4);
+    auto result3 = handler.Feed("\nhi\r");
+    REQUIRE(result3.consumed == 4);
+    REQUIRE_FALSE(result3.value.has_value());
+
+    auto result4 = handler.Feed("\n:1\r\n");
+    REQUIRE(result4.consumed == 1);
+    REQUIRE(result4.value.has_value());
+    REQUIRE(std::get<BulkString>(std::get<Array>(*result4.value).value[0])
+              .value == "hi");
+  }
 }
 
 TEST_CASE("RespHandler reset functionality", "[handler]") {
@@ -1,6 +1,7 @@
 #include "parser.hpp"
 #include "handler.hpp"
 
+#include <array>
 #include <charconv>
 #include <utility>
 
@@ -13,17 +14,14 @@ constexpr char LF = '\n';
 } // namespace
 
 ParseResult IntParser::Feed(std::string_view input) {
-  const auto crlf_pos = input.find("\r\n");
-  if (crlf_pos == std::string_view::npos) {
-    buffer_.append(input);
-    return {.consumed = input.size(),
+  const auto line = detail::FeedLine(buffer_, input);
+  if (!line.complete) {
+    return {.consumed = line.consumed,
             .value = std::unexpected(ParseStatus::NeedMore)};
   }
+  const std::size_t consumed = line.consumed;
 
-  buffer_.append(input.substr(0, crlf_pos));
-  const std::size_t consumed = crlf_pos + 2;
-
-  int value = 0;
+  std::int64_t value = 0;
   auto [ptr, ec] =
     std::from_chars(buffer_.data(), buffer_.data() + buffer_.size(), value);
 
@@ -39,16 +37,14 @@ ParseResult BulkStringParser::Feed(std::string_view input) {
   std::size_t consumed = 0;
 
   if (state_ == State::ReadingLength) {
-    const auto crlf_pos = input.find("\r\n");
-    if (crlf_pos == std::string_view::npos) {
-      length_buffer_.append(input);
-      return {.consumed = input.size(),
+    const auto line = detail::FeedLine(length_buffer_, input);
+    if (!line.complete) {
+      return {.consumed = line.consumed,
               .value = std::unexpected(ParseStatus::NeedMore)};
     }
 
-    length_buffer_.append(input.substr(0, crlf_pos));
-    consumed += crlf_pos + 2;
-    input.remove_prefix(crlf_pos + 2);
+    consumed += line.consumed;
+    input.remove_prefix(line.consumed);
 
     auto [ptr, ec] = std::from_chars(
       length_buffer_.data(), length_buffer_.data() + length_buffer_.size(),
@@ -86,17 +82,23 @@ ParseResult BulkStringParser::Feed(std::string_view input) {
   }
 
   if (state_ == State::ReadingCRLF) {
-    if (input.size() < 2) {
-      return {.consumed = consumed,
-              .value = std::unexpected(ParseStatus::NeedMore)};
+    // The terminator can be split across feeds too
+    constexpr std::array<char, 2> CRLF{CR, LF};
+    for (; crlf_read_ < CRLF.size() && !input.empty(); ++crlf_read_) {
+      if (input[0] != CRLF[crlf_read_]) {
+        return {.consumed = consumed,
+                .value = std::unexpected(ParseStatus::Cancelled)};
+      }
+      ++consumed;
+      input.remove_prefix(1);
     }
 
-    if (input[0] != CR || input[1] != LF) {
+    if (crlf_read_ < CRLF.size()) {
       return {.consumed = consumed,
-              .value = std::unexpected(ParseStatus::Cancelled)};
+              .value = std::unexpected(ParseStatus::NeedMore)};
     }
 
-    return {.consumed = consumed + 2,
+    return {.consumed = consumed,
             .value = Type{BulkString{std::move(data_buffer_)}}};
   }
 
@@ -149,16 +151,14 @@ ParseResult ArrayParser::Feed(std::string_view input) {
   std::size_t consumed = 0;
 
   if (state_ == State::ReadingLength) {
-    const auto crlf_pos = input.find("\r\n");
-    if (crlf_pos == std::string_view::npos) {
-      length_buffer_.append(input);
-      return {.consumed = input.size(),
+    const auto line = detail::FeedLine(length_buffer_, input);
+    if (!line.complete) {
+      return {.consumed = line.consumed,
               .value = std::unexpected(ParseStatus::NeedMore)};
     }
 
-    length_buffer_.append(input.substr(0, crlf_pos));
-    consumed += crlf_pos + 2;
-    input.remove_prefix(crlf_pos + 2);
+    consumed += line.consumed;
+    input.remove_prefix(line.consumed);
 
     auto [ptr, ec] = std::from_chars(
       length_buffer_.data(), length_buffer_.data() + length_buffer_.size(),
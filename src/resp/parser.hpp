@@ -29,6 +29,37 @@ inline constexpr std::size_t LARGE_BUFFER_SIZE = 512;
 inline constexpr std::size_t LENGTH_BUFFER_SIZE = 16;
 inline constexpr std::size_t DEFAULT_ARRAY_CAPACITY = 8;
 
+namespace detail {
+
+struct LineResult {
+  std::size_t consumed{};
+  bool complete = false;
+};
+
+// Appends input up to the next "\r\n" to line. Input may be cut anywhere,
+// including between the CR and the LF, so a line is only complete once an
+// LF arrives with the CR before it, possibly from an earlier feed.
+inline LineResult FeedLine(std::pmr::string &line, std::string_view input) {
+  std::size_t consumed = 0;
+  while (true) {
+    const auto lf_pos = input.find('\n', consumed);
+    if (lf_pos == std::string_view::npos) {
+      line.append(input.substr(consumed));
+      return {.consumed = input.size(), .complete = false};
+    }
+
+    line.append(input.substr(consumed, lf_pos - consumed));
+    consumed = lf_pos + 1;
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+      return {.consumed = consumed, .complete = true};
+    }
+    line.push_back('\n'); // a bare LF is part of the line
+  }
+}
+
+} // namespace detail
+
 template <typename ParserType>
 concept Parser = requires(ParserType parser, std::string_view input) {
   { parser.Feed(input) } -> std::same_as<ParseResult>;
@@ -60,17 +91,14 @@ public:
   }
 
   ParseResult Feed(std::string_view input) {
-    const auto crlf_pos = input.find("\r\n");
-    if (crlf_pos == std::string_view::npos) {
-      buffer_.append(input);
-      return {.consumed = input.size(),
+    const auto line = detail::FeedLine(buffer_, input);
+    if (!line.complete) {
+      return {.consumed = line.consumed,
               .value = std::unexpected(ParseStatus::NeedMore)};
     }
 
-    buffer_.append(input.substr(0, crlf_pos));
-    const std::size_t consumed = crlf_pos + 2;
-
-    return {.consumed = consumed, .value = Type{ValueType{std::move(buffer_)}}};
+    return {.consumed = line.consumed,
+            .value = Type{ValueType{std::move(buffer_)}}};
   }
 
 private:
@@ -102,6 +130,7 @@ private:
   std::pmr::string data_buffer_{arena_};
   State state_ = State::ReadingLength;
   int expected_length_ = -1;
+  std::uint8_t crlf_read_ = 0;
 };
 
 static_assert(Parser<BulkStringParser>);
@@ -3,6 +3,7 @@
 
 #include <array>
 #include <catch2/catch_test_macros.hpp>
+#include <cstdint>
 #include <memory_resource>
 
 using namespace resp;
@@ -39,6 +40,14 @@ TEST_CASE("IntParser parses integers", "[parser][int]") {
     REQUIRE(std::get<Int>(*result.value).value == 0);
   }
 
+  SECTION("64-bit integer") {
+    IntParser parser{&arena};
+    auto result = parser.Feed("-9223372036854775808\r\n");
+
+    REQUIRE(result.value.has_value());
+    REQUIRE(std::get<Int>(*result.value).value == INT64_MIN);
+  }
+
   SECTION("Partial data needs more") {
     IntParser parser{&arena};
     auto result = parser.Feed("42");
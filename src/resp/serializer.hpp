@@ -6,6 +6,7 @@
 #include <bit>
 #include <charconv>
 #include <concepts>
+#include <cstdint>
 #include <memory_resource>
 #include <string>
 
@@ -16,7 +17,7 @@ namespace resp {
 namespace detail {
 
 constexpr int CountDigits(std::size_t n) noexcept;
-constexpr int CountDigitsInt(int n) noexcept;
+constexpr int CountDigitsInt(std::int64_t n) noexcept;
 ALWAYS_INLINE void AppendInteger(std::pmr::string &buffer,
                                  std::integral auto value);
 
@@ -218,13 +219,10 @@ constexpr int CountDigits(std::size_t n) noexcept {
   return digits + static_cast<int>(n >= powersOf10[digits]);
 }
 
-constexpr int CountDigitsInt(int n) noexcept {
-  if (n == 0) {
-    return 1;
-  }
+constexpr int CountDigitsInt(std::int64_t n) noexcept {
   if (n < 0) {
-    return CountDigits(static_cast<std::size_t>(-static_cast<long long>(n))) +
-           1;
+    // Negate in unsigned arithmetic so that INT64_MIN does not overflow
+    return CountDigits(std::size_t{0} - static_cast<std::size_t>(n)) + 1;
   }
   return CountDigits(static_cast<std::size_t>(n));
 }
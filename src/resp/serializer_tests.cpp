@@ -3,6 +3,7 @@
 
 #include <array>
 #include <catch2/catch_test_macros.hpp>
+#include <cstdint>
 #include <memory_resource>
 
 using namespace resp;
@@ -77,6 +78,13 @@ TEST_CASE("Serialize integer", "[serializer]") {
     auto result = serializer.Serialize(Type{i});
     REQUIRE(result == ":123456789\r\n");
   }
+
+  SECTION("64-bit extremes") {
+    REQUIRE(serializer.Serialize(Type{Int{INT64_MAX}}) ==
+            ":9223372036854775807\r\n");
+    REQUIRE(serializer.Serialize(Type{Int{INT64_MIN}}) ==
+            ":-9223372036854775808\r\n");
+  }
 }
 
 TEST_CASE("Serialize bulk string", "[serializer]") {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <variant>
 #include <vector>
@@ -25,10 +26,10 @@ struct Error {
 };
 
 struct Int {
-  int value = 0;
+  std::int64_t value = 0;
 
   Int() = default;
-  explicit Int(int v)
+  explicit Int(std::int64_t v)
       : value(v) {}
 };
 
@@ -4,6 +4,8 @@
 #include "error_checker.hpp"
 #include "resp/serializer.hpp"
 
+#include <algorithm>
+
 #include <fcntl.h>
 #include <sys/socket.h>
 
@@ -39,26 +41,69 @@ void Server::Setup(const Config &config) {
     | ToFdGuard;
 
   RegisterToEpoll(*server_fd_);
+
+  store_.SetMaxMemory(config.maxmemory);
+  store_.SetEvictionPolicy(config.maxmemory_policy);
+  store_.SetDatabases(config.databases);
 }
 
 void Server::Run() {
+  next_cron_ = Storage::Clock::now() + CRON_INTERVAL;
+
   while (true) {
+    // Input left unread last round gets no new edge, so do not wait for one
+    const auto timeout = unread_.empty() ? MillisUntilCron() : 0;
     const auto event_count =
-      epoll_wait(*epoll_fd_, event_buffer_.data(), MAX_EVENTS, -1)
+      epoll_wait(*epoll_fd_, event_buffer_.data(), MAX_EVENTS, timeout)
         | ThrowIfErrno("Server epoll_wait");
 
+    const auto unread = std::exchange(unread_, {});
     for (auto i = 0; i < event_count; ++i) {
       const auto &event = event_buffer_[i];
 
       if (event.data.fd == *server_fd_) {
         AcceptNewConnections();
-      } else {
-        HandleClientRequest(event.data.fd);
+      } else if (auto it = clients_.find(event.data.fd);
+                 it == clients_.end() || !it->second->unread) {
+        ReadClient(event.data.fd); // else it is read below
       }
     }
+    for (const auto client_fd : unread) {
+      if (clients_.contains(client_fd)) {
+        ReadClient(client_fd);
+      }
+    }
+    ServeReadyClients();
+
+    if (Storage::Clock::now() >= next_cron_) {
+      Cron();
+    }
   }
 }
 
+void Server::Cron() {
+  store_.UpdatePeakMemory();
+  // Expired keys leave promptly even if nobody touches them; when a large
+  // batch comes due at once, the remainder is picked up on the next tick.
+  const auto removed = store_.Sweep(EXPIRE_KEYS_PER_CRON);
+  // Finish evictions that ran out of time budget in front of a write
+  store_.FreeMemoryIfNeeded();
+  store_.ActiveDefrag(DEFRAG_TIME_BUDGET);
+  store_.ResizeStep();
+  // A running snapshot is walked on every tick, and ticks come quickly until
+  // it is done
+  store_.SnapshotStep(SNAPSHOT_KEYS_PER_CRON);
+  const auto busy = removed >= EXPIRE_KEYS_PER_CRON || store_.SnapshotRunning();
+  const auto interval = busy ? std::chrono::milliseconds{1} : CRON_INTERVAL;
+  next_cron_ = Storage::Clock::now() + interval;
+}
+
+int Server::MillisUntilCron() const {
+  const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+    next_cron_ - Storage::Clock::now());
+  return static_cast<int>(std::max<std::int64_t>(0, remaining.count()));
+}
+
 void Server::AcceptNewConnections() {
   while (true) {
     sockaddr_in client_addr{};
@@ -76,12 +121,13 @@ void Server::AcceptNewConnections() {
       }
     }
 
-    clients_.emplace(client_fd, std::make_unique<ClientState>());
+    clients_.emplace(client_fd,
+                     std::make_unique<ClientState>(store_.ClientMemory()));
     RegisterToEpoll(client_fd);
   }
 }
 
-void Server::HandleClientRequest(int client_fd) {
+void Server::ReadClient(int client_fd) {
   auto it = clients_.find(client_fd);
   if (it == clients_.end()) [[unlikely]] {
     CloseClient(client_fd);
@@ -90,29 +136,24 @@ void Server::HandleClientRequest(int client_fd) {
   auto &client = *it->second;
   std::array<char, READ_BUFFER_SIZE> buffer{};
 
-  while (true) {
-    const auto bytes_read = read(client_fd, buffer.data(), buffer.size());
-
-    if (bytes_read == -1) {
-      if (errno == EAGAIN || errno == EWOULDBLOCK) {
-        break;
-      }
-      CloseClient(client_fd);
-      return;
-    }
+  // One read per round: a client that pipelines without pause is served,
+  // and its arena released, between reads, and does not hold up the others.
+  // A full buffer may have left more behind, so it is read again next round.
+  const auto bytes_read = read(client_fd, buffer.data(), buffer.size());
+  client.unread = bytes_read == static_cast<ssize_t>(buffer.size());
+  if (client.unread) {
+    unread_.push_back(client_fd);
+  }
 
-    if (bytes_read == 0) [[unlikely]] {
-      CloseClient(client_fd);
-      return;
+  if (bytes_read == -1) {
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      client.eof = true;
     }
-
+  } else if (bytes_read == 0) [[unlikely]] {
+    client.eof = true;
+  } else {
     auto input =
       std::string_view{buffer.data(), static_cast<std::size_t>(bytes_read)};
-    bool can_release = true;
-
-    resp::Serializer serializer{&client.arena};
-    std::pmr::string write_buf{&client.arena};
-    std::size_t command_count = 0;
 
     while (!input.empty()) {
       auto result = client.handler.Feed(input);
@@ -121,61 +162,137 @@ void Server::HandleClientRequest(int client_fd) {
       if (!result.value.has_value()) {
         if (result.value.error() == resp::ParseStatus::Cancelled) [[unlikely]] {
           client.handler.Reset();
+          client.partial = false;
         } else {
-          can_release = false;
+          client.partial = true;
         }
         break;
       }
 
-      // Commands are RESP arrays: ["COMMAND", arg1, arg2, ...]
-      const auto *arr = std::get_if<resp::Array>(&*result.value);
-      if (!arr || arr->value.empty()) [[unlikely]] {
-        auto response = serializer.Serialize(resp::Error{
-          std::pmr::string{"ERR invalid command format", &client.arena}});
-        write_buf.append(response);
-        client.handler.Reset();
-        continue;
-      }
+      client.commands.push_back(std::move(*result.value));
+      client.handler.Reset();
+      client.partial = false;
+    }
+  }
 
-      const auto *name_bs = std::get_if<resp::BulkString>(arr->value.data());
-      if (!name_bs) [[unlikely]] {
-        auto response = serializer.Serialize(resp::Error{std::pmr::string{
-          "ERR command name must be a bulk string", &client.arena}});
-        write_buf.append(response);
-        client.handler.Reset();
-        continue;
+  if (!client.commands.empty() || client.eof) {
+    ready_.emplace_back(client_fd, &client);
+  }
+}
+
+void Server::ServeReadyClients() {
+  // Read phase: the leading read-only commands of every ready client run at
+  // once on the reader threads. Nothing writes until they are all done, so
+  // they only need const lookups; the access times they would have updated
+  // are applied afterwards, here on the event loop.
+  if (store_.ReadThreads() > 1 && ready_.size() > 1) {
+    store_.Readers().Run(ready_.size(), [this](std::size_t i) {
+      ServeReads(*ready_[i].second);
+    });
+    for (auto &[client_fd, client] : ready_) {
+      if (client->reader) {
+        store_.RecordAccesses(*client->reader);
+        client->reader.reset();
       }
+    }
+  }
 
-      std::span<const resp::Type> args{arr->value.data() + 1,
-                                       arr->value.size() - 1};
-      auto reply =
-        COMMANDS.Dispatch(name_bs->value, args, store_, &client.arena);
+  // Whatever is left runs in order, one client after another
+  for (auto &[client_fd, client] : ready_) {
+    ServeCommands(client_fd, *client);
+  }
+  ready_.clear();
+}
 
-      auto response = serializer.Serialize(reply);
-      write_buf.append(response);
-      ++command_count;
-      client.handler.Reset();
+void Server::ServeReads(ClientState &client) const {
+  // Replies are built on this thread, so not in the client's arena
+  std::array<std::byte, READ_BUFFER_SIZE> scratch_buf;
+  std::pmr::monotonic_buffer_resource scratch{
+    scratch_buf.data(), scratch_buf.size(), std::pmr::new_delete_resource()};
+  resp::Serializer serializer{&scratch};
+
+  for (; client.reads_done < client.commands.size(); ++client.reads_done) {
+    const auto *arr =
+      std::get_if<resp::Array>(&client.commands[client.reads_done]);
+    if (!arr || arr->value.empty()) {
+      break;
+    }
+    const auto *name_bs = std::get_if<resp::BulkString>(arr->value.data());
+    if (!name_bs) {
+      break;
+    }
+    const auto read = COMMANDS.FindReader(name_bs->value);
+    if (!read) {
+      break;
     }
 
-    // Periodic sweep
-    commands_since_sweep_ += command_count;
-    if (commands_since_sweep_ >= SWEEP_INTERVAL) [[unlikely]] {
-      store_.Sweep();
-      commands_since_sweep_ = 0;
+    if (!client.reader) {
+      client.reader.emplace(store_, client.db);
     }
+    std::span<const resp::Type> args{arr->value.data() + 1,
+                                     arr->value.size() - 1};
+    client.read_replies.append(
+      serializer.Serialize(read(args, *client.reader, &scratch)));
+  }
+}
 
-    // Flush all accumulated responses in a single write
-    if (!write_buf.empty()) {
-      if (!WriteAll(client_fd, write_buf)) [[unlikely]] {
-        CloseClient(client_fd);
-        return;
-      }
+void Server::ServeCommands(int client_fd, ClientState &client) {
+  // Closing frees the client's arena, so it waits until the replies
+  // built from it are gone
+  if (!FlushCommands(client_fd, client) || client.eof) {
+    CloseClient(client_fd);
+    return;
+  }
+  if (!client.partial) {
+    client.arena.release();
+  }
+}
+
+bool Server::FlushCommands(int client_fd, ClientState &client) {
+  resp::Serializer serializer{&client.arena};
+  std::pmr::string write_buf{&client.arena};
+
+  for (auto i = client.reads_done; i < client.commands.size(); ++i) {
+    // Commands are RESP arrays: ["COMMAND", arg1, arg2, ...]
+    const auto *arr = std::get_if<resp::Array>(&client.commands[i]);
+    if (!arr || arr->value.empty()) [[unlikely]] {
+      auto response = serializer.Serialize(resp::Error{
+        std::pmr::string{"ERR invalid command format", &client.arena}});
+      write_buf.append(response);
+      continue;
+    }
+
+    const auto *name_bs = std::get_if<resp::BulkString>(arr->value.data());
+    if (!name_bs) [[unlikely]] {
+      auto response = serializer.Serialize(resp::Error{std::pmr::string{
+        "ERR command name must be a bulk string", &client.arena}});
+      write_buf.append(response);
+      continue;
     }
 
-    if (can_release) {
-      client.arena.release();
+    std::span<const resp::Type> args{arr->value.data() + 1,
+                                     arr->value.size() - 1};
+    // The storage is shared, so each client's database is selected
+    // around its command
+    store_.Select(client.db);
+    auto reply = COMMANDS.Dispatch(name_bs->value, args, store_, &client.arena);
+    client.db = store_.SelectedDb();
+
+    auto response = serializer.Serialize(reply);
+    write_buf.append(response);
+  }
+  client.commands.clear();
+  client.reads_done = 0;
+
+  // Flush all accumulated responses, in command order, in one go each
+  for (const std::string_view replies : {std::string_view{client.read_replies},
+                                         std::string_view{write_buf}}) {
+    if (!replies.empty() && !WriteAll(client_fd, replies)) [[unlikely]] {
+      return false;
     }
   }
+  client.read_replies.clear();
+  return true;
 }
 
 void Server::CloseClient(int client_fd) {
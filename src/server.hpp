@@ -5,12 +5,16 @@
 #include "storage.hpp"
 
 #include <array>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <memory_resource>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <arpa/inet.h>
 #include <sys/epoll.h>
@@ -29,6 +33,10 @@ public:
     std::string address = "0.0.0.0";
     std::uint16_t port = DEFAULT_PORT;
     int backlog = SOMAXCONN;
+    std::size_t maxmemory = 0; // bytes, 0 = unlimited
+    Storage::EvictionPolicy maxmemory_policy =
+      Storage::EvictionPolicy::NoEviction;
+    std::size_t databases = Storage::DEFAULT_DATABASES;
   };
 
   void Setup(const Config &config);
@@ -39,24 +47,54 @@ private:
   static constexpr std::size_t MAX_EVENTS = 1024;
   static constexpr std::size_t READ_BUFFER_SIZE = 4096;
   static constexpr std::size_t ARENA_SIZE = 8192;
-  static constexpr std::size_t SWEEP_INTERVAL = 1024;
+  static constexpr auto CRON_INTERVAL = std::chrono::milliseconds{100};
+  static constexpr std::size_t EXPIRE_KEYS_PER_CRON = 1024;
+  static constexpr std::size_t SNAPSHOT_KEYS_PER_CRON = 1024;
+  // 1% of a core at the default cron interval
+  static constexpr auto DEFRAG_TIME_BUDGET = std::chrono::microseconds{1000};
 
+  // The arena and anything it spills over come from `memory`, so per-client
+  // buffers (including pending replies) show up in the memory totals.
   struct ClientState {
-    std::array<std::byte, ARENA_SIZE> arena_buf{};
-    std::pmr::monotonic_buffer_resource arena{arena_buf.data(),
-                                              arena_buf.size()};
+    explicit ClientState(std::pmr::memory_resource *memory)
+        : arena_buf(ARENA_SIZE, memory) {}
+
+    std::pmr::vector<std::byte> arena_buf;
+    std::pmr::monotonic_buffer_resource arena{
+      arena_buf.data(), arena_buf.size(), arena_buf.get_allocator().resource()};
     resp::RespHandler handler{&arena};
+    std::size_t db = 0; // selected with SELECT
+
+    // Complete commands read this round, parsed into the arena
+    std::vector<resp::Type> commands;
+    bool partial = false; // the handler holds part of a command
+    bool eof = false;     // serve what was read, then close
+    bool unread = false;  // the last read filled the buffer; on unread_
+    // The leading read-only commands answered in the read phase
+    std::size_t reads_done = 0;
+    std::string read_replies;
+    std::optional<Storage::Reader> reader;
   };
 
   FdGuard server_fd_;
   FdGuard epoll_fd_;
   std::array<epoll_event, MAX_EVENTS> event_buffer_{};
+  Storage store_; // client buffers allocate from it, so it outlives them
   std::unordered_map<int, std::unique_ptr<ClientState>> clients_;
-  Storage store_;
-  std::size_t commands_since_sweep_ = 0;
+  Storage::Clock::time_point next_cron_{};
+  // Clients with commands read this round
+  std::vector<std::pair<int, ClientState *>> ready_;
+  // Clients that may have more input than they were allowed to read
+  std::vector<int> unread_;
 
   void AcceptNewConnections();
-  void HandleClientRequest(int client_fd);
+  void Cron();
+  int MillisUntilCron() const;
+  void ReadClient(int client_fd);
+  void ServeReadyClients();
+  void ServeReads(ClientState &client) const;
+  void ServeCommands(int client_fd, ClientState &client);
+  bool FlushCommands(int client_fd, ClientState &client);
   void RegisterToEpoll(int fd);
   void CloseClient(int client_fd);
   static bool WriteAll(int client_fd, std::string_view data);
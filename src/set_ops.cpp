@@ -0,0 +1,110 @@
+#include "set_ops.hpp"
+
+#include <algorithm>
+#include <functional>
+
+namespace set_ops {
+
+namespace {
+
+// Keeps the members of `from` that are in none of `exclude`
+struct Filter {
+  const SetValue *from;
+  std::span<const SetValue *const> exclude;
+
+  bool Keep(std::string_view member) const {
+    return std::ranges::none_of(
+      exclude, [&](const auto *set) { return set->contains(member); });
+  }
+};
+
+// One unit of work: a whole compact set, or a range of hashtable positions
+struct Task {
+  std::size_t filter;
+  std::size_t first = 0;
+  std::size_t last = 0; // exclusive; both 0 for the whole set
+};
+
+Result Run(const std::vector<Filter> &filters, WorkerPool &pool) {
+  std::size_t members = 0;
+  for (const auto &filter : filters) {
+    members += filter.from->size();
+  }
+  const bool parallel =
+    pool.Threads() > 1 && members >= PARALLEL_MIN_MEMBERS;
+
+  std::vector<Task> tasks;
+  for (std::size_t f = 0; f < filters.size(); ++f) {
+    const auto *from = filters[f].from;
+    if (!parallel || !from->IsHashtable()) {
+      tasks.push_back({f});
+      continue;
+    }
+    const auto size = from->size();
+    for (std::size_t i = 0; i < size; i += MEMBERS_PER_TASK) {
+      tasks.push_back({f, i, std::min(size, i + MEMBERS_PER_TASK)});
+    }
+  }
+
+  std::vector<Listpack> parts(tasks.size());
+  auto run_task = [&](std::size_t t) {
+    const auto &task = tasks[t];
+    const auto &filter = filters[task.filter];
+    auto &out = parts[t];
+    auto keep = [&](std::string_view member) {
+      if (filter.Keep(member)) {
+        out.Insert(out.End(), member);
+      }
+    };
+    if (task.last == 0) {
+      filter.from->ForEach(keep);
+      return;
+    }
+    const auto &table = filter.from->Hashtable();
+    for (auto i = task.first; i < task.last; ++i) {
+      keep(std::string_view{table.At(i)});
+    }
+  };
+  if (parallel) {
+    pool.Run(tasks.size(), run_task);
+  } else {
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+      run_task(t);
+    }
+  }
+
+  return Result{std::move(parts)};
+}
+
+} // namespace
+
+std::size_t Result::Size() const noexcept {
+  std::size_t size = 0;
+  for (const auto &part : parts_) {
+    size += part.Size();
+  }
+  return size;
+}
+
+Result Difference(std::span<const SetValue *const> sets, WorkerPool &pool) {
+  if (sets.empty() || sets.front()->empty()) {
+    return Result{};
+  }
+  return Run({Filter{sets.front(), sets.subspan(1)}}, pool);
+}
+
+Result Union(std::span<const SetValue *const> sets, WorkerPool &pool) {
+  std::vector<const SetValue *> ordered{sets.begin(), sets.end()};
+  std::erase_if(ordered, [](const auto *set) { return set->empty(); });
+  std::ranges::sort(ordered, std::ranges::greater{},
+                    [](const auto *set) { return set->size(); });
+
+  std::vector<Filter> filters;
+  filters.reserve(ordered.size());
+  for (std::size_t i = 0; i < ordered.size(); ++i) {
+    filters.push_back({ordered[i], std::span{ordered}.first(i)});
+  }
+  return Run(filters, pool);
+}
+
+} // namespace set_ops
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "listpack.hpp"
+#include "set_value.hpp"
+#include "worker_pool.hpp"
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// SDIFF and SUNION over set values. Both come down to one filter: the
+// members of a set that are in none of a list of others. A difference is
+// that filter on the first input; a union applies it to every input
+// against the ones before it, largest first so the biggest set is never
+// probed at all.
+//
+// Once the inputs hold PARALLEL_MIN_MEMBERS or more, hashtable inputs are
+// cut into ranges of positions in their dense member array that run on a
+// WorkerPool. Only const lookups run
+// concurrently and the caller waits for the result, so every task sees the
+// same sets. Results are collected per task in plain listpacks allocated
+// from the default resource, which any thread may use.
+namespace set_ops {
+
+inline constexpr std::size_t PARALLEL_MIN_MEMBERS = std::size_t{1} << 16;
+// Members per task; small enough to balance, big enough to amortize
+inline constexpr std::size_t MEMBERS_PER_TASK = 4096;
+
+// The members found, one listpack per task
+class Result {
+public:
+  explicit Result(std::vector<Listpack> parts = {}) noexcept
+      : parts_{std::move(parts)} {}
+
+  std::size_t Size() const noexcept;
+  bool Empty() const noexcept { return Size() == 0; }
+
+  // Calls visit(std::string_view) for every member
+  template <typename F> void ForEach(F &&visit) const {
+    for (const auto &part : parts_) {
+      for (auto offset = part.Begin(); offset != part.End();
+           offset = part.Next(offset)) {
+        visit(part.Get(offset));
+      }
+    }
+  }
+
+private:
+  std::vector<Listpack> parts_;
+};
+
+// Members of sets[0] that are in none of the other sets
+Result Difference(std::span<const SetValue *const> sets, WorkerPool &pool);
+// Members of any of the sets, each once
+Result Union(std::span<const SetValue *const> sets, WorkerPool &pool);
+
+} // namespace set_ops
@@ -0,0 +1,76 @@
+#include "set_ops.hpp"
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> Sorted(const set_ops::Result &result) {
+  std::vector<std::string> members;
+  result.ForEach([&](std::string_view m) { members.emplace_back(m); });
+  std::ranges::sort(members);
+  return members;
+}
+
+void Fill(SetValue &set, int from, int to, const std::string &prefix = "m") {
+  for (auto i = from; i < to; ++i) {
+    set.insert(prefix + std::to_string(i));
+  }
+}
+
+} // namespace
+
+TEST_CASE("Set difference and union", "[set_ops]") {
+  WorkerPool pool{1};
+  SetValue a, b, c;
+  Fill(a, 0, 10);
+  Fill(b, 5, 15);
+  c.insert("1");
+  c.insert("2");
+
+  SECTION("Difference keeps the first set's members found nowhere else") {
+    const std::vector<const SetValue *> sets{&a, &b};
+    REQUIRE(Sorted(set_ops::Difference(sets, pool)) ==
+            std::vector<std::string>{"m0", "m1", "m2", "m3", "m4"});
+    const std::vector<const SetValue *> alone{&a};
+    REQUIRE(set_ops::Difference(alone, pool).Size() == 10);
+  }
+
+  SECTION("Union lists every member once, across encodings") {
+    const std::vector<const SetValue *> sets{&c, &a, &b, &a};
+    const auto members = Sorted(set_ops::Union(sets, pool));
+    REQUIRE(members.size() == 17);
+    REQUIRE(std::ranges::binary_search(members, "2"));
+    REQUIRE(std::ranges::binary_search(members, "m14"));
+  }
+
+  SECTION("Empty inputs") {
+    const SetValue empty;
+    const std::vector<const SetValue *> first_empty{&empty, &a};
+    REQUIRE(set_ops::Difference(first_empty, pool).Empty());
+    const std::vector<const SetValue *> none;
+    REQUIRE(set_ops::Union(none, pool).Empty());
+  }
+}
+
+TEST_CASE("Large set operations run in parallel", "[set_ops]") {
+  constexpr int N = static_cast<int>(set_ops::PARALLEL_MIN_MEMBERS);
+  SetValue a, b;
+  Fill(a, 0, N);
+  Fill(b, N / 2, N + N / 2);
+  const std::vector<const SetValue *> sets{&a, &b};
+
+  WorkerPool inline_pool{1};
+  WorkerPool pool{4};
+
+  const auto difference = set_ops::Difference(sets, pool);
+  REQUIRE(difference.Size() == static_cast<std::size_t>(N / 2));
+  REQUIRE(Sorted(difference) ==
+          Sorted(set_ops::Difference(sets, inline_pool)));
+
+  const auto all = set_ops::Union(sets, pool);
+  REQUIRE(all.Size() == static_cast<std::size_t>(N + N / 2));
+  REQUIRE(Sorted(all) == Sorted(set_ops::Union(sets, inline_pool)));
+}
@@ -0,0 +1,122 @@
+#include "set_value.hpp"
+
+#include <charconv>
+
+std::string_view SetValue::Format(std::int64_t value,
+                                  StringValue::IntBuffer &buf) noexcept {
+  auto [end, _] = std::to_chars(buf.data(), buf.data() + buf.size(), value);
+  return {buf.data(), static_cast<std::size_t>(end - buf.data())};
+}
+
+std::string_view SetValue::At(std::size_t position,
+                              StringValue::IntBuffer &buf) const noexcept {
+  switch (encoding_) {
+  case Encoding::IntSet:
+    return Format(ints_.Get(position), buf);
+  case Encoding::Listpack: {
+    auto offset = entries_.Begin();
+    for (; position > 0; --position) {
+      offset = entries_.Next(offset);
+    }
+    return entries_.Get(offset);
+  }
+  case Encoding::Hashtable:
+    break;
+  }
+  return members_.At(position);
+}
+
+bool SetValue::contains(std::string_view member) const {
+  switch (encoding_) {
+  case Encoding::IntSet: {
+    const auto value = StringValue::ParseCanonical(member);
+    return value && ints_.Contains(*value);
+  }
+  case Encoding::Listpack:
+    return entries_.Find(member) != entries_.End();
+  case Encoding::Hashtable:
+    break;
+  }
+  return members_.contains(member);
+}
+
+bool SetValue::ContainsInt(std::int64_t member) const {
+  if (IsIntSet()) {
+    return ints_.Contains(member);
+  }
+  StringValue::IntBuffer buf;
+  return contains(Format(member, buf));
+}
+
+bool SetValue::insert(std::string_view member) {
+  if (IsIntSet()) {
+    const auto value = StringValue::ParseCanonical(member);
+    if (value && ints_.Contains(*value)) {
+      return false;
+    }
+    if (value && ints_.Size() < MAX_INTSET_ENTRIES) {
+      return ints_.Insert(*value);
+    }
+    if (FitsListpack(ints_.Size(), member)) {
+      ConvertToListpack();
+    } else {
+      ConvertToHashtable();
+    }
+  }
+
+  if (encoding_ == Encoding::Listpack) {
+    if (entries_.Find(member) != entries_.End()) {
+      return false;
+    }
+    if (FitsListpack(entries_.Size(), member)) {
+      entries_.Insert(entries_.End(), member);
+      return true;
+    }
+    ConvertToHashtable();
+  }
+  return members_.insert(member);
+}
+
+bool SetValue::erase(std::string_view member) {
+  switch (encoding_) {
+  case Encoding::IntSet: {
+    const auto value = StringValue::ParseCanonical(member);
+    return value && ints_.Erase(*value);
+  }
+  case Encoding::Listpack: {
+    const auto offset = entries_.Find(member);
+    if (offset == entries_.End()) {
+      return false;
+    }
+    entries_.Erase(offset);
+    return true;
+  }
+  case Encoding::Hashtable:
+    break;
+  }
+  return members_.erase(member);
+}
+
+void SetValue::clear() noexcept {
+  ints_.Clear();
+  entries_.Clear();
+  members_.clear();
+  encoding_ = Encoding::IntSet;
+}
+
+void SetValue::ConvertToListpack() {
+  StringValue::IntBuffer buf;
+  for (std::size_t i = 0; i < ints_.Size(); ++i) {
+    entries_.Insert(entries_.End(), Format(ints_.Get(i), buf));
+  }
+  ints_.Clear();
+  encoding_ = Encoding::Listpack;
+}
+
+void SetValue::ConvertToHashtable() {
+  members_.Reserve(size() + 1);
+  ForEach([&](std::string_view member) { members_.insert(member); });
+  ints_.Clear();
+  entries_.Clear();
+  encoding_ = Encoding::Hashtable;
+}
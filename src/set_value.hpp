@@ -0,0 +1,147 @@
+#pragma once
+
+#include "dense_set.hpp"
+#include "intset.hpp"
+#include "listpack.hpp"
+#include "string_value.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+#include <type_traits>
+
+// A set value. While every member is the canonical spelling of a 64-bit
+// integer and there are at most MAX_INTSET_ENTRIES of them, the members
+// are an IntSet (the "intset" encoding): a few bytes each in one buffer
+// instead of a hash node and a string apiece. A small set of short strings
+// is a Listpack searched front to back (the "listpack" encoding), which
+// beats hashing at that size and costs two bytes per member on top of the
+// bytes themselves. Outgrowing either converts the set to a DenseSet (the
+// "hashtable" encoding) for good.
+//
+// Members are handed out as string views; an intset formats each integer
+// into a buffer that only lives for the duration of the callback.
+class SetValue {
+public:
+  enum class Encoding : std::uint8_t { IntSet, Listpack, Hashtable };
+  using Members = DenseSet;
+
+  static constexpr std::size_t MAX_INTSET_ENTRIES = 512;
+  static constexpr std::size_t MAX_LISTPACK_ENTRIES = 128;
+  static constexpr std::size_t MAX_LISTPACK_VALUE = 64;
+
+  explicit SetValue(std::pmr::memory_resource *resource =
+                      std::pmr::get_default_resource()) noexcept
+      : ints_{resource}, entries_{resource}, members_{resource} {}
+
+  std::size_t size() const noexcept {
+    switch (encoding_) {
+    case Encoding::IntSet:
+      return ints_.Size();
+    case Encoding::Listpack:
+      return entries_.Size();
+    case Encoding::Hashtable:
+      break;
+    }
+    return members_.size();
+  }
+  bool empty() const noexcept { return size() == 0; }
+
+  bool contains(std::string_view member) const;
+  // Faster than contains() on an intset, and no parsing either way
+  bool ContainsInt(std::int64_t member) const;
+  // Both return whether the set changed
+  bool insert(std::string_view member);
+  bool erase(std::string_view member);
+  void clear() noexcept;
+
+  // Calls visit(std::string_view) for every member. A visit that returns
+  // bool can stop the walk early by returning false.
+  template <typename F> void ForEach(F &&visit) const {
+    auto next = [&](std::string_view member) {
+      if constexpr (std::is_same_v<std::invoke_result_t<F &, std::string_view>,
+                                   bool>) {
+        return visit(member);
+      } else {
+        visit(member);
+        return true;
+      }
+    };
+
+    if (IsIntSet()) {
+      StringValue::IntBuffer buf;
+      for (std::size_t i = 0; i < ints_.Size(); ++i) {
+        if (!next(Format(ints_.Get(i), buf))) {
+          return;
+        }
+      }
+      return;
+    }
+    if (encoding_ == Encoding::Listpack) {
+      for (auto offset = entries_.Begin(); offset != entries_.End();
+           offset = entries_.Next(offset)) {
+        if (!next(entries_.Get(offset))) {
+          return;
+        }
+      }
+      return;
+    }
+    for (std::size_t i = 0; i < members_.size(); ++i) {
+      if (!next(std::string_view{members_.At(i)})) {
+        return;
+      }
+    }
+  }
+
+  // The member at `position` (below size()); every encoding has some order.
+  // O(1) except in a listpack, which is small. An integer is formatted
+  // into `buf`.
+  std::string_view At(std::size_t position,
+                      StringValue::IntBuffer &buf) const noexcept;
+
+  // Like Dict::Scan. An intset or listpack is small, so it is visited whole
+  // and the returned cursor is always 0.
+  template <typename F> std::uint64_t Scan(std::uint64_t cursor, F &&visit) {
+    if (!IsHashtable()) {
+      ForEach(visit);
+      return 0;
+    }
+    return members_.Scan(cursor, [&](const std::pmr::string &member) {
+      visit(std::string_view{member});
+    });
+  }
+
+  Encoding GetEncoding() const noexcept { return encoding_; }
+  bool IsIntSet() const noexcept { return encoding_ == Encoding::IntSet; }
+  bool IsHashtable() const noexcept {
+    return encoding_ == Encoding::Hashtable;
+  }
+  // The representation itself, for memory accounting, defrag and commands
+  // that can work on packed integers directly
+  const IntSet &Ints() const noexcept { return ints_; }
+  IntSet &Ints() noexcept { return ints_; }
+  const Listpack &Entries() const noexcept { return entries_; }
+  Listpack &Entries() noexcept { return entries_; }
+  const Members &Hashtable() const noexcept { return members_; }
+  Members &Hashtable() noexcept { return members_; }
+
+  std::pmr::memory_resource *resource() const noexcept {
+    return members_.resource();
+  }
+
+  static std::string_view Format(std::int64_t value,
+                                 StringValue::IntBuffer &buf) noexcept;
+
+private:
+  IntSet ints_;      // the members while IsIntSet(), else empty
+  Listpack entries_; // the members in the listpack encoding
+  Members members_;  // the members otherwise
+  Encoding encoding_ = Encoding::IntSet;
+
+  static bool FitsListpack(std::size_t size, std::string_view member) noexcept {
+    return size < MAX_LISTPACK_ENTRIES && member.size() <= MAX_LISTPACK_VALUE;
+  }
+  void ConvertToListpack();
+  void ConvertToHashtable();
+};
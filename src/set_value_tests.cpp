@@ -0,0 +1,126 @@
+#include "set_value.hpp"
+
+#include "counting_resource.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> Members(const SetValue &set) {
+  std::vector<std::string> members;
+  set.ForEach([&](std::string_view m) { members.emplace_back(m); });
+  return members;
+}
+
+} // namespace
+
+TEST_CASE("SetValue encodings", "[set_value]") {
+  CountingResource memory;
+  SetValue set{&memory};
+
+  SECTION("Integers stay packed") {
+    REQUIRE(set.insert("3"));
+    REQUIRE(set.insert("-1"));
+    REQUIRE(set.insert("100000"));
+    REQUIRE_FALSE(set.insert("3"));
+    REQUIRE(set.IsIntSet());
+    REQUIRE(set.size() == 3);
+    REQUIRE(set.contains("-1"));
+    REQUIRE(set.ContainsInt(100000));
+    REQUIRE_FALSE(set.contains("abc"));
+    REQUIRE(Members(set) == std::vector<std::string>{"-1", "3", "100000"});
+
+    REQUIRE(set.erase("3"));
+    REQUIRE_FALSE(set.erase("3"));
+    REQUIRE_FALSE(set.erase("x"));
+    REQUIRE(set.size() == 2);
+  }
+
+  SECTION("A short string converts an intset to a listpack") {
+    set.insert("1");
+    set.insert("2");
+    REQUIRE(set.insert("007"));
+    REQUIRE(set.GetEncoding() == SetValue::Encoding::Listpack);
+    REQUIRE_FALSE(set.insert("1"));
+    REQUIRE(set.size() == 3);
+    REQUIRE(set.contains("1"));
+    REQUIRE(set.contains("007"));
+    REQUIRE_FALSE(set.contains("7"));
+    REQUIRE(set.ContainsInt(2));
+    REQUIRE(Members(set) == std::vector<std::string>{"1", "2", "007"});
+
+    REQUIRE(set.erase("2"));
+    REQUIRE_FALSE(set.erase("2"));
+    REQUIRE(set.size() == 2);
+  }
+
+  SECTION("A long member converts a listpack to a hashtable") {
+    set.insert("a");
+    REQUIRE(set.GetEncoding() == SetValue::Encoding::Listpack);
+    const std::string long_member(SetValue::MAX_LISTPACK_VALUE + 1, 'x');
+    REQUIRE(set.insert(long_member));
+    REQUIRE(set.IsHashtable());
+    REQUIRE(set.contains("a"));
+    REQUIRE(set.contains(long_member));
+  }
+
+  SECTION("Too many strings convert a listpack to a hashtable") {
+    for (std::size_t i = 0; i < SetValue::MAX_LISTPACK_ENTRIES; ++i) {
+      set.insert("m" + std::to_string(i));
+    }
+    REQUIRE(set.GetEncoding() == SetValue::Encoding::Listpack);
+    REQUIRE(set.insert("one more"));
+    REQUIRE(set.IsHashtable());
+    REQUIRE(set.size() == SetValue::MAX_LISTPACK_ENTRIES + 1);
+    REQUIRE(set.contains("m0"));
+  }
+
+  SECTION("Too many integers convert to a hashtable") {
+    for (std::size_t i = 0; i < SetValue::MAX_INTSET_ENTRIES; ++i) {
+      set.insert(std::to_string(i * 3));
+    }
+    REQUIRE(set.IsIntSet());
+    REQUIRE_FALSE(set.insert("0"));
+    REQUIRE(set.IsIntSet());
+    REQUIRE(set.insert("1"));
+    REQUIRE(set.IsHashtable());
+    REQUIRE(set.size() == SetValue::MAX_INTSET_ENTRIES + 1);
+    REQUIRE(set.contains("3"));
+  }
+
+  SECTION("Scan visits a compact set in one call") {
+    set.insert("1");
+    set.insert("2");
+    std::size_t visited = 0;
+    REQUIRE(set.Scan(0, [&](std::string_view) { ++visited; }) == 0);
+    REQUIRE(visited == 2);
+    set.insert("three");
+    REQUIRE(set.Scan(0, [&](std::string_view) { ++visited; }) == 0);
+    REQUIRE(visited == 5);
+  }
+
+  SECTION("At reaches every member in every encoding") {
+    auto positions = [&] {
+      std::vector<std::string> members;
+      StringValue::IntBuffer buf;
+      for (std::size_t i = 0; i < set.size(); ++i) {
+        members.emplace_back(set.At(i, buf));
+      }
+      return members;
+    };
+    set.insert("20");
+    set.insert("10");
+    REQUIRE(positions() == Members(set));
+    set.insert("x");
+    REQUIRE(positions() == Members(set));
+    set.insert(std::string(SetValue::MAX_LISTPACK_VALUE + 1, 'y'));
+    REQUIRE(set.IsHashtable());
+    REQUIRE(positions() == Members(set));
+  }
+
+  set.clear();
+  REQUIRE(set.IsIntSet());
+  REQUIRE(memory.Allocated() == 0);
+}
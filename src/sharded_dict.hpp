@@ -0,0 +1,280 @@
+#pragma once
+
+#include "dict.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory_resource>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// A Dict split into 2^SHARD_BITS independent sub-tables, chosen by the top
+// bits of the key's hash (each sub-table buckets by the low bits). It has
+// the same interface as Dict, and a key is still hashed once per lookup.
+//
+// Every shard grows, shrinks and rehashes on its own, so a resize allocates
+// and moves a sixteenth of the keyspace at a time. Shards are also the unit
+// of parallel read-only walks (see Shard()), and of anything else that
+// wants to handle the keyspace a piece at a time.
+//
+// Scan cursors carry the shard in their low SHARD_BITS and the shard's own
+// Dict cursor above them, so shards are walked one after the other and the
+// usual guarantees hold within each.
+template <typename Mapped, unsigned SHARD_BITS = 4> class ShardedDict {
+  using ShardType = Dict<Mapped>;
+
+public:
+  static constexpr std::size_t SHARDS = std::size_t{1} << SHARD_BITS;
+
+  using key_type = typename ShardType::key_type;
+  using value_type = typename ShardType::value_type;
+  using size_type = std::size_t;
+
+  static constexpr std::size_t NODE_SIZE = ShardType::NODE_SIZE;
+  static constexpr std::size_t NODE_ALIGN = ShardType::NODE_ALIGN;
+
+private:
+  template <bool Const> class Iterator {
+    using OwnerPtr =
+      std::conditional_t<Const, const ShardedDict *, ShardedDict *>;
+    using Inner = std::conditional_t<Const, typename ShardType::const_iterator,
+                                     typename ShardType::iterator>;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = ShardedDict::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer =
+      std::conditional_t<Const, const value_type *, value_type *>;
+    using reference =
+      std::conditional_t<Const, const value_type &, value_type &>;
+
+    Iterator() = default;
+    // iterator -> const_iterator
+    operator Iterator<true>() const
+      requires(!Const)
+    {
+      return Iterator<true>{owner_, shard_, inner_};
+    }
+
+    reference operator*() const { return *inner_; }
+    pointer operator->() const { return &*inner_; }
+
+    Iterator &operator++() {
+      ++inner_;
+      Settle();
+      return *this;
+    }
+    Iterator operator++(int) {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    // Positions are nodes, so the shard need not be compared
+    friend bool operator==(const Iterator &a, const Iterator &b) noexcept {
+      return a.inner_ == b.inner_;
+    }
+
+  private:
+    friend class ShardedDict;
+    template <bool> friend class Iterator;
+
+    OwnerPtr owner_ = nullptr;
+    std::size_t shard_ = SHARDS;
+    Inner inner_;
+
+    Iterator(OwnerPtr owner, std::size_t shard, Inner inner)
+        : owner_{owner}, shard_{shard}, inner_{inner} {}
+
+    // Moves past the end of finished shards to the next element, if any
+    void Settle() {
+      while (inner_ == Inner{} && ++shard_ < SHARDS) {
+        inner_ = owner_->shards_[shard_].begin();
+      }
+    }
+  };
+
+public:
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  explicit ShardedDict(std::pmr::memory_resource *resource =
+                         std::pmr::get_default_resource()) noexcept
+      : shards_{MakeShards(resource, std::make_index_sequence<SHARDS>{})} {}
+
+  ShardedDict(ShardedDict &&) noexcept = default;
+  ShardedDict(const ShardedDict &) = delete;
+  ShardedDict &operator=(const ShardedDict &) = delete;
+
+  std::pmr::memory_resource *resource() const noexcept {
+    return shards_[0].resource();
+  }
+
+  std::size_t size() const noexcept {
+    std::size_t total = 0;
+    for (const auto &shard : shards_) {
+      total += shard.size();
+    }
+    return total;
+  }
+  bool empty() const noexcept {
+    for (const auto &shard : shards_) {
+      if (!shard.empty()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  iterator begin() noexcept {
+    iterator it{this, 0, shards_[0].begin()};
+    it.Settle();
+    return it;
+  }
+  iterator end() noexcept { return {}; }
+  const_iterator begin() const noexcept {
+    const_iterator it{this, 0, shards_[0].begin()};
+    it.Settle();
+    return it;
+  }
+  const_iterator end() const noexcept { return {}; }
+
+  iterator find(std::string_view key) {
+    const auto hash = ShardType::Hash(key);
+    const auto index = ShardOf(hash);
+    return iterator{this, index, shards_[index].find(key, hash)};
+  }
+  const_iterator find(std::string_view key) const {
+    const auto hash = ShardType::Hash(key);
+    const auto index = ShardOf(hash);
+    return const_iterator{this, index, shards_[index].find(key, hash)};
+  }
+  bool contains(std::string_view key) const { return find(key) != end(); }
+
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> emplace(K &&key, Args &&...args) {
+    const auto hash = ShardType::Hash(std::string_view{key});
+    const auto index = ShardOf(hash);
+    auto [it, inserted] = shards_[index].EmplaceHashed(
+      hash, std::forward<K>(key), std::forward<Args>(args)...);
+    return {iterator{this, index, it}, inserted};
+  }
+
+  // Returns the iterator following `pos`.
+  iterator erase(const_iterator pos) {
+    iterator next{this, pos.shard_, shards_[pos.shard_].erase(pos.inner_)};
+    next.Settle();
+    return next;
+  }
+
+  std::size_t erase(std::string_view key) {
+    return shards_[ShardOf(ShardType::Hash(key))].erase(key);
+  }
+
+  void clear() noexcept {
+    for (auto &shard : shards_) {
+      shard.clear();
+    }
+  }
+
+  void swap(ShardedDict &other) noexcept {
+    for (std::size_t i = 0; i < SHARDS; ++i) {
+      shards_[i].swap(other.shards_[i]);
+    }
+  }
+
+  // Moves up to `buckets` buckets of every shard's resize along. Returns
+  // true while any shard has more to do.
+  bool RehashStep(std::size_t buckets) {
+    bool more = false;
+    for (auto &shard : shards_) {
+      more |= shard.RehashStep(buckets);
+    }
+    return more;
+  }
+
+  void ShrinkIfNeeded() {
+    for (auto &shard : shards_) {
+      shard.ShrinkIfNeeded();
+    }
+  }
+
+  bool Rehashing() const noexcept {
+    for (const auto &shard : shards_) {
+      if (shard.Rehashing()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Buckets of every shard, numbered shard after shard (see Dict)
+  std::size_t BucketCount() const noexcept {
+    std::size_t total = 0;
+    for (const auto &shard : shards_) {
+      total += shard.BucketCount();
+    }
+    return total;
+  }
+  template <typename F> void ForEachInBucket(std::size_t bucket, F &&visit) {
+    for (auto &shard : shards_) {
+      if (bucket < shard.BucketCount()) {
+        shard.ForEachInBucket(bucket, std::forward<F>(visit));
+        return;
+      }
+      bucket -= shard.BucketCount();
+    }
+  }
+
+  template <typename F> std::uint64_t Scan(std::uint64_t cursor, F &&visit) {
+    auto index = static_cast<std::size_t>(cursor & (SHARDS - 1));
+    auto next = shards_[index].Scan(cursor >> SHARD_BITS, visit);
+    // A finished shard hands over to the next one that has anything in it
+    while (next == 0) {
+      if (++index == SHARDS) {
+        return 0;
+      }
+      if (!shards_[index].empty()) {
+        break;
+      }
+    }
+    return next << SHARD_BITS | index;
+  }
+
+  value_type &Reallocate(value_type &value) {
+    return shards_[ShardOf(ShardType::Hash(KeyOf(value)))].Reallocate(value);
+  }
+
+  // One sub-table, for walks that handle shards independently (e.g. on
+  // several threads, each reading its own shard through const lookups)
+  const ShardType &Shard(std::size_t index) const noexcept {
+    return shards_[index];
+  }
+
+private:
+  std::array<ShardType, SHARDS> shards_;
+
+  static std::size_t ShardOf(std::size_t hash) noexcept {
+    return hash >> (std::numeric_limits<std::size_t>::digits - SHARD_BITS);
+  }
+
+  static std::string_view KeyOf(const value_type &value) noexcept {
+    if constexpr (std::is_void_v<Mapped>) {
+      return value;
+    } else {
+      return value.first;
+    }
+  }
+
+  template <std::size_t... I>
+  static std::array<ShardType, SHARDS>
+  MakeShards(std::pmr::memory_resource *resource,
+             std::index_sequence<I...>) noexcept {
+    return {{((void)I, ShardType{resource})...}};
+  }
+};
@@ -0,0 +1,142 @@
+#include "sharded_dict.hpp"
+
+#include "counting_resource.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+
+namespace {
+
+std::string Key(int i) { return "key:" + std::to_string(i); }
+
+} // namespace
+
+TEST_CASE("ShardedDict matches std::map", "[sharded_dict]") {
+  CountingResource memory;
+  ShardedDict<int> dict{&memory};
+  std::map<std::string, int> model;
+  std::mt19937_64 rng{5};
+  std::uniform_int_distribution<int> pick{0, 5'000};
+
+  for (auto i = 0; i < 40'000; ++i) {
+    const auto key = Key(pick(rng));
+    if (i % 3 == 0) {
+      REQUIRE(dict.erase(key) == model.erase(key));
+    } else {
+      const auto [it, inserted] = dict.emplace(key, i);
+      REQUIRE(inserted == model.emplace(key, i).second);
+      REQUIRE(std::string_view{it->first} == key);
+    }
+  }
+  REQUIRE(dict.size() == model.size());
+
+  // Iteration crosses every shard exactly once
+  std::map<std::string, int> seen;
+  for (const auto &[key, value] : dict) {
+    REQUIRE(seen.emplace(key, value).second);
+  }
+  REQUIRE(seen == model);
+
+  // Keys spread over every shard
+  std::size_t used = 0;
+  for (std::size_t shard = 0; shard < decltype(dict)::SHARDS; ++shard) {
+    used += dict.Shard(shard).empty() ? 0 : 1;
+  }
+  REQUIRE(used == decltype(dict)::SHARDS);
+
+  // Erasing while iterating hands over from shard to shard
+  for (auto it = dict.begin(); it != dict.end();) {
+    if (it->second % 2 == 0) {
+      model.erase(std::string{it->first});
+      it = dict.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  dict.ShrinkIfNeeded();
+  REQUIRE(dict.size() == model.size());
+  for (const auto &[key, value] : model) {
+    const auto it = std::as_const(dict).find(key);
+    REQUIRE(it != dict.end());
+    REQUIRE(it->second == value);
+  }
+
+  dict.clear();
+  REQUIRE(dict.empty());
+  REQUIRE(dict.begin() == dict.end());
+  REQUIRE(memory.Allocated() == 0);
+}
+
+TEST_CASE("ShardedDict scan", "[sharded_dict]") {
+  ShardedDict<int> dict;
+  for (auto i = 0; i < 3'000; ++i) {
+    dict.emplace(Key(i), i);
+  }
+
+  SECTION("Visits every key, shard after shard") {
+    std::multiset<std::string> seen;
+    std::uint64_t cursor = 0;
+    do {
+      cursor = dict.Scan(cursor, [&](const auto &node) {
+        seen.emplace(node.first);
+      });
+    } while (cursor != 0);
+    REQUIRE(std::set<std::string>{seen.begin(), seen.end()}.size() == 3'000);
+  }
+
+  SECTION("Keys present throughout survive resizes between steps") {
+    std::set<std::string> seen;
+    std::uint64_t cursor = 0;
+    auto next = 3'000;
+    do {
+      cursor = dict.Scan(cursor, [&](const auto &node) {
+        seen.emplace(node.first);
+      });
+      // Grow some shards and shrink others as the walk goes
+      dict.emplace(Key(next++), 0);
+      dict.erase(Key(next % 1'500 + 1'500));
+    } while (cursor != 0);
+    for (auto i = 0; i < 1'500; ++i) {
+      REQUIRE(seen.contains(Key(i)));
+    }
+  }
+
+  SECTION("An empty dict finishes at once") {
+    ShardedDict<int> empty;
+    REQUIRE(empty.Scan(0, [](const auto &) { FAIL(); }) == 0);
+  }
+}
+
+TEST_CASE("ShardedDict sampling and reallocation", "[sharded_dict]") {
+  ShardedDict<int> dict;
+  for (auto i = 0; i < 1'000; ++i) {
+    dict.emplace(Key(i) + " long enough to be allocated on the heap", i);
+  }
+
+  std::size_t visited = 0;
+  for (std::size_t bucket = 0; bucket < dict.BucketCount(); ++bucket) {
+    dict.ForEachInBucket(bucket, [&](auto &) { ++visited; });
+  }
+  REQUIRE(visited == dict.size());
+
+  for (auto i = 0; i < 1'000; ++i) {
+    auto &node =
+      *dict.find(Key(i) + " long enough to be allocated on the heap");
+    auto &moved = dict.Reallocate(node);
+    REQUIRE(&moved != &node);
+  }
+  for (auto i = 0; i < 1'000; ++i) {
+    const auto it =
+      dict.find(Key(i) + " long enough to be allocated on the heap");
+    REQUIRE(it != dict.end());
+    REQUIRE(it->second == i);
+  }
+
+  ShardedDict<int> other;
+  other.swap(dict);
+  REQUIRE(dict.empty());
+  REQUIRE(other.size() == 1'000);
+}
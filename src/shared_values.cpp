@@ -0,0 +1,27 @@
+#include "shared_values.hpp"
+
+#include "string_value.hpp"
+
+#include <functional>
+
+const std::pmr::string *SharedValues::Intern(std::string_view value) {
+  if (value.size() < MIN_LENGTH || value.size() > MAX_LENGTH ||
+      StringValue::ParseCanonical(value)) {
+    return nullptr;
+  }
+  if (auto it = pool_.find(value); it != pool_.end()) {
+    return &*it;
+  }
+  if (pool_.size() >= max_entries_) {
+    return nullptr;
+  }
+
+  const auto hash = std::hash<std::string_view>{}(value);
+  auto &candidate = candidates_[hash % CANDIDATES];
+  if (candidate != hash) {
+    candidate = hash;
+    return nullptr;
+  }
+  candidate = 0;
+  return &*pool_.insert(value).first;
+}
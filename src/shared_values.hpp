@@ -0,0 +1,46 @@
+#pragma once
+
+#include "dict.hpp"
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+// Immutable string values that any number of keys can point at instead of
+// each owning a copy, like Redis' shared objects. Entries live as long as
+// the pool, so dropping a reference is just forgetting a pointer, on any
+// thread, and modifying a value means detaching from the pool first.
+//
+// Only values worth sharing get in: integers and values short enough for
+// the small string buffer already take no heap of their own, and a value
+// is admitted the second time it is offered, so one-off values do not use
+// up the `max_entries` slots.
+class SharedValues {
+public:
+  // std::pmr::string keeps up to 15 bytes in place
+  static constexpr std::size_t MIN_LENGTH = 16;
+  static constexpr std::size_t MAX_LENGTH = 64;
+  static constexpr std::size_t DEFAULT_MAX_ENTRIES = 10'000;
+
+  explicit SharedValues(
+    std::pmr::memory_resource *resource = std::pmr::get_default_resource(),
+    std::size_t max_entries = DEFAULT_MAX_ENTRIES)
+      : pool_{resource}
+      , max_entries_{max_entries} {}
+
+  // The pooled copy of `value`, or nullptr if it is not pooled (yet)
+  const std::pmr::string *Intern(std::string_view value);
+
+  std::size_t Size() const noexcept { return pool_.size(); }
+
+private:
+  // Hashes of values offered once, direct-mapped; a collision just forgets
+  // the older candidate
+  static constexpr std::size_t CANDIDATES = 1024;
+
+  Dict<void> pool_;
+  std::array<std::size_t, CANDIDATES> candidates_{};
+  std::size_t max_entries_;
+};
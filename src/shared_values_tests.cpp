@@ -0,0 +1,43 @@
+#include "shared_values.hpp"
+
+#include "counting_resource.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+TEST_CASE("SharedValues admission", "[shared_values]") {
+  CountingResource memory;
+  SharedValues pool{&memory, 3};
+  const std::string value(30, 'v');
+
+  SECTION("A value is pooled the second time it is offered") {
+    REQUIRE(pool.Intern(value) == nullptr);
+    const auto *pooled = pool.Intern(value);
+    REQUIRE(pooled != nullptr);
+    REQUIRE(std::string_view{*pooled} == value);
+    REQUIRE(pool.Intern(value) == pooled);
+    REQUIRE(pool.Size() == 1);
+  }
+
+  SECTION("Short values and integers are never pooled") {
+    for (auto i = 0; i < 2; ++i) {
+      REQUIRE(pool.Intern("true") == nullptr);
+      REQUIRE(pool.Intern("12345678901234567") == nullptr);
+      REQUIRE(pool.Intern(std::string(SharedValues::MAX_LENGTH + 1, 'x')) ==
+              nullptr);
+    }
+    REQUIRE(pool.Size() == 0);
+    REQUIRE(memory.Allocated() == 0);
+  }
+
+  SECTION("The pool stops growing when full") {
+    for (char c = 'a'; c < 'f'; ++c) {
+      const std::string other(20, c);
+      pool.Intern(other);
+      pool.Intern(other);
+    }
+    REQUIRE(pool.Size() == 3);
+    REQUIRE(pool.Intern(std::string(20, 'a')) != nullptr);
+    REQUIRE(pool.Intern(std::string(20, 'e')) == nullptr);
+  }
+}
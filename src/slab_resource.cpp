@@ -0,0 +1,199 @@
+#include "slab_resource.hpp"
+
+#include <bit>
+#include <new>
+
+#include <sys/mman.h>
+
+namespace {
+
+// mmap only promises page alignment, so over-map and trim to SLAB_SIZE
+void *MapAligned(std::size_t size) {
+  auto *raw =
+    static_cast<std::byte *>(mmap(nullptr, size * 2, PROT_READ | PROT_WRITE,
+                                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  if (raw == MAP_FAILED) {
+    throw std::bad_alloc{};
+  }
+
+  const auto addr = reinterpret_cast<std::uintptr_t>(raw);
+  const auto head = ((addr + size - 1) & ~(size - 1)) - addr;
+  if (head > 0) {
+    munmap(raw, head);
+  }
+  munmap(raw + head + size, size - head);
+  return raw + head;
+}
+
+} // namespace
+
+SlabResource::~SlabResource() {
+  DrainRemoteFrees();
+  // Only cached empty slabs can be left once every container is gone
+  for (auto &cls : classes_) {
+    while (cls.partial) {
+      auto *slab = cls.partial;
+      UnlinkPartial(cls, slab);
+      munmap(slab, SLAB_SIZE);
+    }
+  }
+}
+
+std::size_t SlabResource::ClassIndex(std::size_t bytes) noexcept {
+  if (bytes <= 128) {
+    return bytes == 0 ? 0 : (bytes - 1) / 8;
+  }
+  // Four classes per power of two: 160, 192, 224, 256, 320, ...
+  const auto width = static_cast<std::size_t>(std::bit_width(bytes - 1));
+  const auto shift = width - 3;
+  return 16 + (width - 8) * 4 + ((bytes - 1) >> shift) - 4;
+}
+
+std::size_t SlabResource::RoundedSize(std::size_t bytes,
+                                      std::size_t alignment) {
+  if (!IsSmall(bytes, alignment)) {
+    return bytes;
+  }
+  const auto aligned = (bytes + alignment - 1) & ~(alignment - 1);
+  return ClassSize(ClassIndex(aligned));
+}
+
+void SlabResource::LinkPartial(SizeClass &cls, Slab *slab) noexcept {
+  slab->prev = nullptr;
+  slab->next = cls.partial;
+  if (cls.partial) {
+    cls.partial->prev = slab;
+  }
+  cls.partial = slab;
+  ++cls.partial_count;
+}
+
+void SlabResource::UnlinkPartial(SizeClass &cls, Slab *slab) noexcept {
+  if (slab->prev) {
+    slab->prev->next = slab->next;
+  } else {
+    cls.partial = slab->next;
+  }
+  if (slab->next) {
+    slab->next->prev = slab->prev;
+  }
+  slab->prev = slab->next = nullptr;
+  --cls.partial_count;
+}
+
+SlabResource::Slab *SlabResource::NewSlab(std::uint8_t size_class) {
+  auto *slab = new (MapAligned(SLAB_SIZE)) Slab{};
+  slab->bump = reinterpret_cast<std::byte *>(slab) + HEADER_SIZE;
+  slab->capacity = static_cast<std::uint32_t>((SLAB_SIZE - HEADER_SIZE) /
+                                             ClassSize(size_class));
+  slab->size_class = size_class;
+  ++classes_[size_class].slabs;
+  ++slab_count_;
+  return slab;
+}
+
+void SlabResource::ReleaseSlab(Slab *slab) noexcept {
+  --classes_[slab->size_class].slabs;
+  munmap(slab, SLAB_SIZE);
+  --slab_count_;
+}
+
+bool SlabResource::ShouldMove(const void *p, std::size_t bytes,
+                              std::size_t alignment) const noexcept {
+  if (!IsSmall(bytes, alignment)) {
+    return false;
+  }
+  const auto *slab = SlabOf(p);
+  const auto &cls = classes_[slab->size_class];
+  if (slab == cls.partial || slab->used == slab->capacity) {
+    return false;
+  }
+  // used / capacity < cls.used / (cls.slabs * capacity)
+  return slab->used * cls.slabs < cls.used;
+}
+
+void SlabResource::DrainRemoteFrees() noexcept {
+  auto *node = remote_frees_.exchange(nullptr, std::memory_order_acquire);
+  while (node) {
+    auto *next = node->next;
+    FreeSmall(node);
+    node = next;
+  }
+}
+
+void *SlabResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+  if (!IsSmall(bytes, alignment)) {
+    void *p = upstream_->allocate(bytes, alignment);
+    large_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    return p;
+  }
+  if (remote_frees_.load(std::memory_order_relaxed)) [[unlikely]] {
+    DrainRemoteFrees();
+  }
+
+  const auto aligned = (bytes + alignment - 1) & ~(alignment - 1);
+  const auto index = ClassIndex(aligned);
+  auto &cls = classes_[index];
+  auto *slab = cls.partial;
+  if (!slab) {
+    slab = NewSlab(static_cast<std::uint8_t>(index));
+    LinkPartial(cls, slab);
+  }
+
+  void *p;
+  if (slab->free) {
+    p = slab->free;
+    slab->free = slab->free->next;
+  } else {
+    p = slab->bump;
+    slab->bump += ClassSize(index);
+  }
+
+  ++cls.used;
+  if (++slab->used == slab->capacity) {
+    UnlinkPartial(cls, slab);
+  }
+  small_bytes_ += ClassSize(index);
+  return p;
+}
+
+void SlabResource::do_deallocate(void *p, std::size_t bytes,
+                                 std::size_t alignment) {
+  if (!IsSmall(bytes, alignment)) {
+    upstream_->deallocate(p, bytes, alignment);
+    large_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+    return;
+  }
+
+  if (std::this_thread::get_id() != owner_) [[unlikely]] {
+    auto *node = static_cast<RemoteFree *>(p);
+    node->next = remote_frees_.load(std::memory_order_relaxed);
+    while (!remote_frees_.compare_exchange_weak(node->next, node,
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed)) {
+    }
+    return;
+  }
+  FreeSmall(p);
+}
+
+void SlabResource::FreeSmall(void *p) noexcept {
+  auto *slab = SlabOf(p);
+  auto &cls = classes_[slab->size_class];
+  small_bytes_ -= ClassSize(slab->size_class);
+  --cls.used;
+
+  if (slab->used-- == slab->capacity) {
+    LinkPartial(cls, slab);
+  }
+  if (slab->used == 0 && cls.partial_count > 1) {
+    // Keep the last slab of a class around so churn does not map and unmap
+    UnlinkPartial(cls, slab);
+    ReleaseSlab(slab);
+    return;
+  }
+
+  auto *obj = static_cast<FreeObject *>(p);
+  obj->next = slab->free;
+  slab->free = obj;
+}
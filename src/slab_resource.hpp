@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <thread>
+
+// Size-class slab allocator for the many small objects Storage creates (keys,
+// short strings, hash nodes, deque blocks).
+//
+// Requests up to MAX_SMALL bytes are rounded up to one of a few dozen size
+// classes (8-byte steps up to 128, then four classes per power of two) and
+// carved out of SLAB_SIZE-aligned slabs that hold objects of a single class,
+// with no per-object header. Freed objects go on their slab's free list; a
+// slab that becomes empty is unmapped, except for the last one of its class,
+// which is kept to absorb SET/DEL churn. Larger requests go upstream.
+//
+// Allocation is single-threaded: only the thread that created the resource
+// may allocate. Other threads (the lazy freer) may deallocate; their small
+// objects are pushed onto a lock-free list that the owner drains on its next
+// allocation or on DrainRemoteFrees().
+class SlabResource : public std::pmr::memory_resource {
+public:
+  static constexpr std::size_t SLAB_SIZE = std::size_t{64} << 10;
+  static constexpr std::size_t MAX_SMALL = 1024;
+
+  explicit SlabResource(std::pmr::memory_resource *upstream =
+                          std::pmr::new_delete_resource()) noexcept
+      : upstream_{upstream}, owner_{std::this_thread::get_id()} {}
+  ~SlabResource() override;
+
+  SlabResource(const SlabResource &) = delete;
+  SlabResource &operator=(const SlabResource &) = delete;
+
+  // Bytes obtained from the OS/upstream: whole slabs plus large allocations.
+  std::size_t Reserved() const noexcept {
+    return slab_count_ * SLAB_SIZE +
+           large_bytes_.load(std::memory_order_relaxed);
+  }
+  // Bytes handed out, rounded up to the size class.
+  std::size_t InUse() const noexcept {
+    return small_bytes_ + large_bytes_.load(std::memory_order_relaxed);
+  }
+  std::size_t SlabCount() const noexcept { return slab_count_; }
+
+  // Defrag hint: true if the object at `p` (any address inside an allocation
+  // of `bytes`) sits in a slab that is emptier than its class's average and
+  // is not where new objects of that class go. Reallocating such an object
+  // moves it into a denser slab and helps the sparse one drain.
+  bool ShouldMove(const void *p, std::size_t bytes,
+                  std::size_t alignment = 1) const noexcept;
+
+  // Owner thread only: returns objects freed by other threads to their slabs.
+  void DrainRemoteFrees() noexcept;
+
+  // Size class an allocation of `bytes` ends up in (or `bytes` itself when it
+  // bypasses the slabs); exposed for tests and memory estimates.
+  static std::size_t RoundedSize(std::size_t bytes,
+                                 std::size_t alignment = alignof(void *));
+
+private:
+  static constexpr std::size_t HEADER_SIZE = 64;
+  static constexpr std::size_t MAX_ALIGN = 16;
+  static constexpr std::size_t CLASS_COUNT = 28;
+
+  struct FreeObject {
+    FreeObject *next;
+  };
+
+  // Overlaid on an object freed by another thread until the owner drains it
+  struct RemoteFree {
+    RemoteFree *next;
+  };
+
+  struct Slab {
+    Slab *prev = nullptr; // links in the class's list of non-full slabs
+    Slab *next = nullptr;
+    FreeObject *free = nullptr; // recycled objects
+    std::byte *bump = nullptr;  // first never-used object
+    std::uint32_t used = 0;
+    std::uint32_t capacity = 0;
+    std::uint8_t size_class = 0;
+  };
+  static_assert(sizeof(Slab) <= HEADER_SIZE);
+
+  struct SizeClass {
+    Slab *partial = nullptr; // slabs with at least one free object
+    std::size_t partial_count = 0;
+    std::size_t slabs = 0;
+    std::size_t used = 0; // objects handed out across all slabs
+  };
+
+  std::pmr::memory_resource *upstream_;
+  std::thread::id owner_;
+  std::array<SizeClass, CLASS_COUNT> classes_{};
+  std::size_t slab_count_ = 0;
+  std::size_t small_bytes_ = 0;
+  std::atomic<std::size_t> large_bytes_ = 0;
+  std::atomic<RemoteFree *> remote_frees_ = nullptr;
+
+  static constexpr std::size_t ClassSize(std::size_t index) noexcept {
+    if (index < 16) {
+      return (index + 1) * 8;
+    }
+    const auto group = (index - 16) / 4;
+    const auto step = std::size_t{32} << group;
+    return (std::size_t{128} << group) + ((index - 16) % 4 + 1) * step;
+  }
+  static std::size_t ClassIndex(std::size_t bytes) noexcept;
+  static bool IsSmall(std::size_t bytes, std::size_t alignment) noexcept {
+    return alignment <= MAX_ALIGN && bytes <= MAX_SMALL;
+  }
+  static Slab *SlabOf(const void *p) noexcept {
+    return reinterpret_cast<Slab *>(reinterpret_cast<std::uintptr_t>(p) &
+                                    ~(SLAB_SIZE - 1));
+  }
+
+  Slab *NewSlab(std::uint8_t size_class);
+  void ReleaseSlab(Slab *slab) noexcept;
+  void LinkPartial(SizeClass &cls, Slab *slab) noexcept;
+  void UnlinkPartial(SizeClass &cls, Slab *slab) noexcept;
+  void FreeSmall(void *p) noexcept;
+
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void *p, std::size_t bytes,
+                     std::size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+    noexcept override {
+    return this == &other;
+  }
+};
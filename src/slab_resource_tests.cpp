@@ -0,0 +1,204 @@
+#include "slab_resource.hpp"
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+TEST_CASE("SlabResource size classes", "[slab]") {
+  SECTION("Small sizes round up to 8-byte steps") {
+    REQUIRE(SlabResource::RoundedSize(1) == 8);
+    REQUIRE(SlabResource::RoundedSize(8) == 8);
+    REQUIRE(SlabResource::RoundedSize(9) == 16);
+    REQUIRE(SlabResource::RoundedSize(128) == 128);
+  }
+
+  SECTION("Larger sizes use four classes per power of two") {
+    REQUIRE(SlabResource::RoundedSize(129) == 160);
+    REQUIRE(SlabResource::RoundedSize(256) == 256);
+    REQUIRE(SlabResource::RoundedSize(257) == 320);
+    REQUIRE(SlabResource::RoundedSize(1000) == 1024);
+    REQUIRE(SlabResource::RoundedSize(1024) == 1024);
+  }
+
+  SECTION("Classes never waste more than a quarter") {
+    for (std::size_t size = 1; size <= SlabResource::MAX_SMALL; ++size) {
+      const auto rounded = SlabResource::RoundedSize(size);
+      REQUIRE(rounded >= size);
+      REQUIRE(rounded - size < std::max<std::size_t>(8, size / 4));
+    }
+  }
+
+  SECTION("Big or over-aligned requests bypass the slabs") {
+    REQUIRE(SlabResource::RoundedSize(5000) == 5000);
+    REQUIRE(SlabResource::RoundedSize(24, 64) == 24);
+    REQUIRE(SlabResource::RoundedSize(24, 16) == 32);
+  }
+}
+
+TEST_CASE("SlabResource allocation", "[slab]") {
+  SlabResource slab;
+
+  SECTION("Objects are distinct, aligned and writable") {
+    std::vector<void *> ptrs;
+    for (auto i = 0; i < 10'000; ++i) {
+      auto *p = slab.allocate(24, 8);
+      std::memset(p, i & 0xFF, 24);
+      REQUIRE(reinterpret_cast<std::uintptr_t>(p) % 8 == 0);
+      ptrs.push_back(p);
+    }
+    REQUIRE(std::set<void *>(ptrs.begin(), ptrs.end()).size() == ptrs.size());
+    REQUIRE(slab.InUse() == 10'000 * 24);
+
+    for (auto *p : ptrs) {
+      slab.deallocate(p, 24, 8);
+    }
+    REQUIRE(slab.InUse() == 0);
+  }
+
+  SECTION("16-byte alignment is honoured") {
+    for (auto i = 0; i < 100; ++i) {
+      auto *p = slab.allocate(24, 16);
+      REQUIRE(reinterpret_cast<std::uintptr_t>(p) % 16 == 0);
+    }
+  }
+
+  SECTION("Freed objects are reused") {
+    auto *a = slab.allocate(40, 8);
+    slab.deallocate(a, 40, 8);
+    auto *b = slab.allocate(40, 8);
+    REQUIRE(a == b);
+    slab.deallocate(b, 40, 8);
+  }
+
+  SECTION("Empty slabs go back to the OS, keeping one per class") {
+    std::vector<void *> ptrs;
+    for (auto i = 0; i < 20'000; ++i) {
+      ptrs.push_back(slab.allocate(64, 8));
+    }
+    const auto peak = slab.SlabCount();
+    REQUIRE(peak > 10);
+
+    for (auto *p : ptrs) {
+      slab.deallocate(p, 64, 8);
+    }
+    REQUIRE(slab.SlabCount() == 1);
+    REQUIRE(slab.Reserved() == SlabResource::SLAB_SIZE);
+  }
+
+  SECTION("Large allocations are tracked") {
+    auto *p = slab.allocate(100'000, 8);
+    REQUIRE(slab.Reserved() == 100'000);
+    slab.deallocate(p, 100'000, 8);
+    REQUIRE(slab.Reserved() == 0);
+  }
+
+  SECTION("Random churn keeps the books balanced") {
+    std::mt19937 rng{7};
+    std::vector<std::pair<void *, std::size_t>> live;
+    for (auto i = 0; i < 50'000; ++i) {
+      if (live.empty() || rng() % 3 != 0) {
+        const auto size = 1 + rng() % 1500;
+        auto *p = slab.allocate(size, 8);
+        std::memset(p, 0xAB, size);
+        live.emplace_back(p, size);
+      } else {
+        const auto idx = rng() % live.size();
+        slab.deallocate(live[idx].first, live[idx].second, 8);
+        live[idx] = live.back();
+        live.pop_back();
+      }
+    }
+
+    std::size_t expected = 0;
+    for (const auto &[p, size] : live) {
+      expected += SlabResource::RoundedSize(size);
+    }
+    REQUIRE(slab.InUse() == expected);
+    REQUIRE(slab.Reserved() >= slab.InUse());
+
+    for (const auto &[p, size] : live) {
+      slab.deallocate(p, size, 8);
+    }
+    REQUIRE(slab.InUse() == 0);
+  }
+}
+
+TEST_CASE("SlabResource defrag hints", "[slab]") {
+  SlabResource slab;
+  constexpr std::size_t SIZE = 64;
+
+  std::vector<void *> ptrs;
+  for (auto i = 0; i < 20'000; ++i) {
+    ptrs.push_back(slab.allocate(SIZE, 8));
+  }
+  // Free nine objects in ten so every slab is left sparse
+  std::vector<void *> live;
+  for (std::size_t i = 0; i < ptrs.size(); ++i) {
+    if (i % 10 == 0) {
+      live.push_back(ptrs[i]);
+    } else {
+      slab.deallocate(ptrs[i], SIZE, 8);
+    }
+  }
+  const auto slabs_before = slab.SlabCount();
+
+  SECTION("Large objects are never moved") {
+    auto *big = slab.allocate(4096, 8);
+    REQUIRE_FALSE(slab.ShouldMove(big, 4096));
+    slab.deallocate(big, 4096, 8);
+  }
+
+  SECTION("Reallocating hinted objects drains sparse slabs") {
+    std::size_t moved = 0;
+    for (auto &p : live) {
+      if (slab.ShouldMove(p, SIZE, 8)) {
+        auto *fresh = slab.allocate(SIZE, 8);
+        slab.deallocate(p, SIZE, 8);
+        p = fresh;
+        ++moved;
+      }
+    }
+    REQUIRE(moved > 0);
+    REQUIRE(slab.SlabCount() < slabs_before);
+    REQUIRE(slab.InUse() == live.size() * SIZE);
+  }
+
+  for (auto *p : live) {
+    slab.deallocate(p, SIZE, 8);
+  }
+}
+
+TEST_CASE("SlabResource frees from other threads", "[slab]") {
+  SlabResource slab;
+  std::vector<void *> ptrs;
+  for (auto i = 0; i < 10'000; ++i) {
+    ptrs.push_back(slab.allocate(48, 8));
+  }
+  auto *big = slab.allocate(10'000, 8);
+
+  std::thread other{[&] {
+    for (auto *p : ptrs) {
+      slab.deallocate(p, 48, 8);
+    }
+    slab.deallocate(big, 10'000, 8);
+  }};
+  other.join();
+
+  // Large blocks are returned at once, small ones once the owner drains
+  REQUIRE(slab.InUse() == ptrs.size() * 48);
+  slab.DrainRemoteFrees();
+  REQUIRE(slab.InUse() == 0);
+  REQUIRE(slab.SlabCount() == 1);
+
+  // Allocating also picks up remote frees
+  auto *p = slab.allocate(48, 8);
+  std::thread{[&] { slab.deallocate(p, 48, 8); }}.join();
+  auto *q = slab.allocate(48, 8);
+  REQUIRE(slab.InUse() == 48);
+  slab.deallocate(q, 48, 8);
+}
@@ -1,43 +1,241 @@
 #include "storage.hpp"
 
 #include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <limits>
 
-Storage::Entry *Storage::FindEntry(std::string_view key) {
-  auto it = data_.find(key);
-  if (it == data_.end()) {
+Storage::Storage() : dbs_(DEFAULT_DATABASES) { Select(0); }
+
+Storage::~Storage() {
+  if (snapshot_) {
+    EndSnapshot(/*complete=*/false);
+  }
+}
+
+Storage::Database &Storage::Db(std::size_t index) {
+  auto &db = dbs_[index];
+  if (!db) {
+    db = std::make_unique<Database>(&keys_memory_);
+  }
+  return *db;
+}
+
+void Storage::SetDatabases(std::size_t count) {
+  // Queued work may name a database that is about to go
+  eviction_pool_size_ = 0;
+  defrag_later_.clear();
+  defrag_running_ = false;
+  for (auto i = count; i < dbs_.size() && snapshot_; ++i) {
+    if (dbs_[i]) {
+      RetireForSnapshot(i);
+    }
+  }
+  dbs_.resize(count);
+  Select(selected_ < count ? selected_ : 0);
+}
+
+void Storage::Select(std::size_t db) {
+  selected_ = db;
+  db_ = &Db(db);
+}
+
+void Storage::SwapDb(std::size_t a, std::size_t b) {
+  std::swap(dbs_[a], dbs_[b]);
+  db_ = &Db(selected_);
+}
+
+bool Storage::Move(std::string_view key, std::size_t db) {
+  auto *node = FindForWrite(key);
+  auto &target = Db(db);
+  if (!node || &target == db_) {
+    return false;
+  }
+  if (auto it = target.data.find(key); it != target.data.end()) {
+    if (!it->second.Expired(NowMs())) {
+      return false;
+    }
+    EraseEntry(target, it);
+    ++expired_keys_;
+  }
+
+  // The value changes tables by moving the variant, so collections keep
+  // their nodes; only the entry's own node is new
+  auto &entry = node->second;
+  Entry moved{.value = std::move(entry.value),
+              .expires_at = entry.expires_at,
+              .expiry = {}, // scheduled below, in the target's wheel
+              .lru = entry.lru,
+              // The lookup above preserved the original
+              .version = snapshot_epoch_};
+  auto [it, _] = target.data.emplace(key, std::move(moved));
+  if (it->second.expires_at != NO_EXPIRY) {
+    target.expiry.Schedule(it->second.expiry, it->first,
+                           it->second.expires_at);
+  }
+  if (key_index_enabled_) {
+    target.key_index.Insert(it->first);
+  }
+  EraseEntry(*db_, db_->data.find(key), /*lazy=*/false);
+  db_->data.ShrinkIfNeeded();
+  return true;
+}
+
+Storage::Node *Storage::FindEntry(std::string_view key) {
+  auto it = db_->data.find(key);
+  if (it == db_->data.end()) {
     return nullptr;
   }
 
-  if (it->second.Expired(Clock::now())) {
-    data_.erase(it);
+  const auto now = NowMs();
+  if (it->second.Expired(now)) {
+    EraseEntry(*db_, it);
+    ++expired_keys_;
     return nullptr;
   }
 
-  return &it->second;
+  Touch(it->second, now);
+  return &*it;
+}
+
+template <typename T> Storage::Node *Storage::Insert(std::string_view key) {
+  Entry entry{.value = Value{std::in_place_type<T>, MemoryFor<T>()},
+              .expires_at = NO_EXPIRY,
+              .expiry = {},
+              .lru = InitialAccess(NowMs()),
+              // Too new for any running snapshot
+              .version = snapshot_epoch_};
+  auto [it, _] = db_->data.emplace(key, std::move(entry));
+  if (key_index_enabled_) {
+    db_->key_index.Insert(it->first);
+  }
+  return &*it;
+}
+
+Storage::Table::iterator Storage::EraseEntry(Database &db, Table::iterator it,
+                                             bool lazy) {
+  Preserve(db, *it, Reason::Removal);
+  db.expiry.Unschedule(it->second.expiry);
+  if (lazy) {
+    ReleaseValue(it->second.value);
+  }
+  if (key_index_enabled_) {
+    db.key_index.Erase(it->first);
+  }
+  return db.data.erase(it);
+}
+
+void Storage::ReleaseValue(Value &value) {
+  const auto effort = std::visit(
+    [](const auto &val) -> std::size_t {
+      using T = std::decay_t<decltype(val)>;
+      if constexpr (std::is_same_v<T, String>) {
+        return 1; // a single buffer, as cheap to free here as anywhere
+      } else if constexpr (std::is_same_v<T, List>) {
+        return val.NodeCount(); // one free per listpack, not per element
+      } else {
+        return val.IsHashtable() ? val.size() : 1;
+      }
+    },
+    value);
+  if (effort > LAZYFREE_THRESHOLD) {
+    freer_.Free(std::move(value));
+  }
 }
 
 bool Storage::Exists(std::string_view key) { return FindEntry(key) != nullptr; }
 
 bool Storage::Erase(std::string_view key) {
-  auto it = data_.find(key);
-  if (it == data_.end()) {
+  auto it = db_->data.find(key);
+  if (it == db_->data.end()) {
     return false;
   }
-  data_.erase(it);
+  EraseEntry(*db_, it);
+  db_->data.ShrinkIfNeeded();
   return true;
 }
 
 std::vector<std::string_view> Storage::Keys() {
+  return Keys(GlobPattern{"*"});
+}
+
+std::vector<std::string_view> Storage::Keys(const GlobPattern &pattern) {
   std::vector<std::string_view> result;
-  result.reserve(data_.size());
-  auto now = Clock::now();
+  auto now = NowMs();
 
-  auto it = data_.begin();
-  while (it != data_.end()) {
+  if (pattern.IsLiteral()) {
+    auto it = db_->data.find(pattern.LiteralPrefix());
+    if (it == db_->data.end()) {
+      return result;
+    }
     if (it->second.Expired(now)) {
-      it = data_.erase(it);
+      EraseEntry(*db_, it);
+      ++expired_keys_;
+      return result;
+    }
+    result.emplace_back(it->first);
+    return result;
+  }
+
+  if (key_index_enabled_ && !pattern.LiteralPrefix().empty()) {
+    // Only keys under the literal prefix can match
+    std::vector<const KeyIndex::Key *> candidates;
+    db_->key_index.CollectPrefix(pattern.LiteralPrefix(), candidates);
+    for (const auto *key : candidates) {
+      if (!pattern.Matches(*key)) {
+        continue;
+      }
+      auto it = db_->data.find(*key);
+      if (it->second.Expired(now)) {
+        EraseEntry(*db_, it);
+        ++expired_keys_;
+      } else {
+        result.emplace_back(it->first);
+      }
+    }
+    return result;
+  }
+
+  const bool all = pattern.MatchesAll();
+  if (all) {
+    result.reserve(db_->data.size());
+  }
+
+  if (db_->data.size() >= PARALLEL_WALK_MIN && workers_.Threads() > 1) {
+    // One task per shard. Tasks only read, so the keys they find expired
+    // are deleted here afterwards.
+    std::array<std::vector<std::string_view>, Table::SHARDS> matches;
+    std::array<std::vector<std::string_view>, Table::SHARDS> expired;
+    const auto &table = db_->data;
+    workers_.Run(Table::SHARDS, [&](std::size_t shard) {
+      for (const auto &node : table.Shard(shard)) {
+        if (node.second.Expired(now)) {
+          expired[shard].emplace_back(node.first);
+        } else if (all || pattern.Matches(node.first)) {
+          matches[shard].emplace_back(node.first);
+        }
+      }
+    });
+    for (std::size_t shard = 0; shard < Table::SHARDS; ++shard) {
+      result.insert(result.end(), matches[shard].begin(),
+                    matches[shard].end());
+      for (const auto key : expired[shard]) {
+        EraseEntry(*db_, db_->data.find(key));
+        ++expired_keys_;
+      }
+    }
+    return result;
+  }
+
+  auto it = db_->data.begin();
+  while (it != db_->data.end()) {
+    if (it->second.Expired(now)) {
+      it = EraseEntry(*db_, it);
+      ++expired_keys_;
     } else {
-      result.emplace_back(it->first);
+      if (all || pattern.Matches(it->first)) {
+        result.emplace_back(it->first);
+      }
       ++it;
     }
   }
@@ -45,15 +243,137 @@ std::vector<std::string_view> Storage::Keys() {
   return result;
 }
 
-void Storage::Clear() { data_.clear(); }
+std::size_t Storage::ErasePrefix(std::string_view prefix) {
+  const auto now = NowMs();
+  std::size_t erased = 0;
+  auto erase = [&](Table::iterator it) {
+    // Expired keys go too, but only live ones count as deleted
+    if (it->second.Expired(now)) {
+      ++expired_keys_;
+    } else {
+      ++erased;
+    }
+    return EraseEntry(*db_, it);
+  };
+
+  if (key_index_enabled_) {
+    std::vector<const KeyIndex::Key *> keys;
+    db_->key_index.CollectPrefix(prefix, keys);
+    for (const auto *key : keys) {
+      erase(db_->data.find(*key));
+    }
+  } else {
+    for (auto it = db_->data.begin(); it != db_->data.end();) {
+      it = std::string_view{it->first}.starts_with(prefix) ? erase(it)
+                                                           : std::next(it);
+    }
+  }
+  db_->data.ShrinkIfNeeded();
+  return erased;
+}
+
+void Storage::SetKeyIndexEnabled(bool enabled) {
+  if (enabled == key_index_enabled_) {
+    return;
+  }
+  key_index_enabled_ = enabled;
+  for (auto &db : dbs_) {
+    if (!db) {
+      continue;
+    }
+    db->key_index.Clear();
+    if (enabled) {
+      for (const auto &node : db->data) {
+        db->key_index.Insert(node.first);
+      }
+    }
+  }
+}
+
+void Storage::Clear() {
+  if (snapshot_ && RetireForSnapshot(selected_)) {
+    db_ = &Db(selected_);
+    return;
+  }
+  db_->expiry.Clear();
+  db_->key_index.Clear();
+  db_->data.clear();
+}
+
+void Storage::ClearAsync() {
+  if (snapshot_ && RetireForSnapshot(selected_)) {
+    db_ = &Db(selected_);
+    return;
+  }
+  db_->expiry.Clear();
+  db_->key_index.Clear();
+  ClearLater(db_->data);
+}
+
+void Storage::ClearLater(Table &table) {
+  Table old{&keys_memory_};
+  old.swap(table);
+  freer_.Free(std::move(old));
+}
+
+void Storage::ClearAll() {
+  const auto selected = selected_;
+  for (std::size_t db = 0; db < dbs_.size(); ++db) {
+    if (dbs_[db]) {
+      Select(db);
+      Clear();
+    }
+  }
+  Select(selected);
+}
+
+void Storage::ClearAllAsync() {
+  const auto selected = selected_;
+  for (std::size_t db = 0; db < dbs_.size(); ++db) {
+    if (dbs_[db]) {
+      Select(db);
+      ClearAsync();
+    }
+  }
+  Select(selected);
+}
 
 template <typename T> Storage::Result<T *> Storage::Find(std::string_view key) {
-  auto *entry = FindEntry(key);
-  if (!entry) {
+  auto *node = FindForWrite(key);
+  if (!node) {
     return std::unexpected{Error::NotFound};
   }
 
-  auto *val = std::get_if<T>(&entry->value);
+  auto *val = std::get_if<T>(&node->second.value);
+  if (!val) {
+    return std::unexpected{Error::WrongType};
+  }
+
+  return val;
+}
+
+template <typename T>
+Storage::Result<const T *> Storage::Get(std::string_view key) {
+  const auto *node = FindEntry(key);
+  if (!node) {
+    return std::unexpected{Error::NotFound};
+  }
+
+  const auto *val = std::get_if<T>(&node->second.value);
+  if (!val) {
+    return std::unexpected{Error::WrongType};
+  }
+
+  return val;
+}
+
+Storage::Result<Storage::Set *> Storage::FindSetForScan(std::string_view key) {
+  auto *node = FindEntry(key);
+  if (!node) {
+    return std::unexpected{Error::NotFound};
+  }
+
+  auto *val = std::get_if<Set>(&node->second.value);
   if (!val) {
     return std::unexpected{Error::WrongType};
   }
@@ -63,14 +383,13 @@ template <typename T> Storage::Result<T *> Storage::Find(std::string_view key) {
 
 template <typename T>
 Storage::Result<T *> Storage::FindOrCreate(std::string_view key) {
-  auto *entry = FindEntry(key);
+  auto *node = FindForWrite(key);
 
-  if (!entry) {
-    auto [it, _] = data_.emplace(std::string{key}, Entry{T{}, std::nullopt});
-    return &std::get<T>(it->second.value);
+  if (!node) {
+    return &std::get<T>(Insert<T>(key)->second.value);
   }
 
-  auto *val = std::get_if<T>(&entry->value);
+  auto *val = std::get_if<T>(&node->second.value);
   if (!val) {
     return std::unexpected{Error::WrongType};
   }
@@ -78,55 +397,1097 @@ Storage::Result<T *> Storage::FindOrCreate(std::string_view key) {
   return val;
 }
 
-bool Storage::SetExpiry(std::string_view key, std::chrono::seconds ttl) {
-  auto *entry = FindEntry(key);
-  if (!entry) {
+template <typename T> T *Storage::Overwrite(std::string_view key) {
+  auto *node = FindForWrite(key, Reason::Removal);
+  if (!node) {
+    return &std::get<T>(Insert<T>(key)->second.value);
+  }
+
+  ReleaseValue(node->second.value);
+  node->second.value.template emplace<T>(MemoryFor<T>());
+  ApplyDeadline(*node, NO_EXPIRY);
+  return &std::get<T>(node->second.value);
+}
+
+std::int64_t Storage::DeadlineFromUnixMs(std::int64_t unix_ms) noexcept {
+  const auto unix_now = std::chrono::floor<std::chrono::milliseconds>(
+                          std::chrono::system_clock::now().time_since_epoch())
+                          .count();
+  // A time long past must not land on NO_EXPIRY or KEEP_TTL; any
+  // deadline at or before now is just as due
+  return std::max<std::int64_t>(0, NowMs() + (unix_ms - unix_now));
+}
+
+void Storage::ApplyDeadline(Node &node, std::int64_t deadline_ms) {
+  auto &entry = node.second;
+  entry.expires_at = deadline_ms;
+  if (deadline_ms == NO_EXPIRY) {
+    db_->expiry.Unschedule(entry.expiry);
+  } else {
+    // The wheel keeps a view of the stored key, which outlives the request
+    db_->expiry.Schedule(entry.expiry, node.first, deadline_ms);
+  }
+}
+
+Storage::Result<Storage::String *>
+Storage::SetString(std::string_view key, std::string_view value,
+                   std::int64_t deadline_ms) {
+  auto *node = FindForWrite(key);
+  if (!node) {
+    node = Insert<String>(key);
+  }
+
+  auto *str = std::get_if<String>(&node->second.value);
+  if (!str) {
+    return std::unexpected{Error::WrongType};
+  }
+
+  const auto *pooled =
+    shared_values_enabled_ ? shared_values_.Intern(value) : nullptr;
+  if (pooled) {
+    str->Share(*pooled);
+  } else {
+    str->Assign(value);
+  }
+  if (deadline_ms != KEEP_TTL) {
+    ApplyDeadline(*node, deadline_ms);
+  }
+  return str;
+}
+
+Storage::Result<std::int64_t> Storage::IncrBy(std::string_view key,
+                                              std::int64_t delta) {
+  auto *node = FindForWrite(key);
+  std::optional<std::int64_t> current = 0;
+  if (!node) {
+    node = Insert<String>(key);
+  } else if (const auto *str = std::get_if<String>(&node->second.value)) {
+    current = str->ToInt();
+  } else {
+    return std::unexpected{Error::WrongType};
+  }
+  if (!current) {
+    return std::unexpected{Error::NotInteger};
+  }
+
+  constexpr auto MIN = std::numeric_limits<std::int64_t>::min();
+  constexpr auto MAX = std::numeric_limits<std::int64_t>::max();
+  if ((delta > 0 && *current > MAX - delta) ||
+      (delta < 0 && *current < MIN - delta)) {
+    return std::unexpected{Error::Overflow};
+  }
+  const auto result = *current + delta;
+  std::get<String>(node->second.value).SetInt(result);
+  return result;
+}
+
+Storage::Result<const Storage::String *>
+Storage::IncrByFloat(std::string_view key, double delta) {
+  auto *node = FindForWrite(key);
+  double current = 0;
+  if (!node) {
+    node = Insert<String>(key);
+  } else if (const auto *str = std::get_if<String>(&node->second.value)) {
+    if (str->IsInt()) {
+      current = static_cast<double>(*str->ToInt());
+    } else {
+      String::IntBuffer buf;
+      const auto view = str->View(buf);
+      auto [ptr, ec] =
+        std::from_chars(view.data(), view.data() + view.size(), current);
+      if (ec != std::errc{} || ptr != view.data() + view.size() ||
+          !std::isfinite(current)) {
+        return std::unexpected{Error::NotInteger};
+      }
+    }
+  } else {
+    return std::unexpected{Error::WrongType};
+  }
+
+  auto result = current + delta;
+  if (!std::isfinite(result)) {
+    return std::unexpected{Error::Overflow};
+  }
+  if (result == 0) {
+    result = 0; // no "-0"
+  }
+  // Fixed notation, as Redis prints it; the longest, 5e-324, is 327 chars
+  std::array<char, 400> buf{};
+  auto [end, _] = std::to_chars(buf.data(), buf.data() + buf.size(), result,
+                                std::chars_format::fixed);
+  auto &str = std::get<String>(node->second.value);
+  str.Assign({buf.data(), static_cast<std::size_t>(end - buf.data())});
+  return &str;
+}
+
+bool Storage::SetExpiry(std::string_view key, std::chrono::milliseconds ttl) {
+  return SetDeadline(key, NowMs() + ttl.count());
+}
+
+bool Storage::SetDeadline(std::string_view key, std::int64_t deadline_ms) {
+  auto *node = FindForWrite(key, Reason::Deadline);
+  if (!node) {
+    return false;
+  }
+  ApplyDeadline(*node, deadline_ms);
+  return true;
+}
+
+bool Storage::Persist(std::string_view key) {
+  auto *node = FindForWrite(key, Reason::Deadline);
+  if (!node || node->second.expires_at == NO_EXPIRY) {
     return false;
   }
-  entry->expires_at = Clock::now() + ttl;
+  ApplyDeadline(*node, NO_EXPIRY);
   return true;
 }
 
 int Storage::GetTtl(std::string_view key) {
-  auto *entry = FindEntry(key);
-  if (!entry) {
+  const auto pttl = GetPttl(key);
+  if (pttl < 0) {
+    return static_cast<int>(pttl);
+  }
+  return static_cast<int>((pttl + 500) / 1000);
+}
+
+std::int64_t Storage::GetPttl(std::string_view key) {
+  auto *node = FindEntry(key);
+  if (!node) {
     return -2;
   }
-  if (!entry->expires_at) {
+  const auto &entry = node->second;
+  if (entry.expires_at == NO_EXPIRY) {
     return -1;
   }
 
-  auto remaining = std::chrono::duration_cast<std::chrono::seconds>(
-    *entry->expires_at - Clock::now());
+  return std::max<std::int64_t>(0, entry.expires_at - NowMs());
+}
+
+Storage::Reader::Reader(const Storage &store, std::size_t db)
+    : db_{store.dbs_[db].get()}, now_ms_{NowMs()} {}
+
+const Storage::Node *Storage::Reader::FindEntry(std::string_view key) {
+  if (!db_) {
+    return nullptr; // a database never used
+  }
+  const auto &data = db_->data;
+  const auto it = data.find(key);
+  if (it == data.end() || it->second.Expired(now_ms_)) {
+    return nullptr;
+  }
+  accessed_.push_back(&*it);
+  return &*it;
+}
+
+template <typename T>
+Storage::Result<const T *> Storage::Reader::Get(std::string_view key) {
+  const auto *node = FindEntry(key);
+  if (!node) {
+    return std::unexpected{Error::NotFound};
+  }
+  const auto *val = std::get_if<T>(&node->second.value);
+  if (!val) {
+    return std::unexpected{Error::WrongType};
+  }
+  return val;
+}
+
+int Storage::Reader::GetTtl(std::string_view key) {
+  const auto pttl = GetPttl(key);
+  if (pttl < 0) {
+    return static_cast<int>(pttl);
+  }
+  return static_cast<int>((pttl + 500) / 1000);
+}
+
+std::int64_t Storage::Reader::GetPttl(std::string_view key) {
+  const auto *node = FindEntry(key);
+  if (!node) {
+    return -2;
+  }
+  const auto &entry = node->second;
+  if (entry.expires_at == NO_EXPIRY) {
+    return -1;
+  }
+  return std::max<std::int64_t>(0, entry.expires_at - now_ms_);
+}
+
+void Storage::RecordAccesses(Reader &reader) {
+  // Nothing has written since the reads, so every node is still in place
+  const auto now = NowMs();
+  for (const auto *node : reader.accessed_) {
+    Touch(const_cast<Node *>(node)->second, now);
+  }
+  reader.accessed_.clear();
+}
+
+namespace {
+
+// Elements a snapshot delivers for `value`; a string is one
+std::size_t ElementCount(const Storage::Value &value) {
+  return std::visit(
+    [](const auto &val) -> std::size_t {
+      if constexpr (std::is_same_v<std::decay_t<decltype(val)>,
+                                   Storage::String>) {
+        return 1;
+      } else {
+        return val.size();
+      }
+    },
+    value);
+}
+
+Storage::Snapshot::Type SnapshotType(const Storage::Value &value) {
+  if (std::holds_alternative<Storage::List>(value)) {
+    return Storage::Snapshot::Type::List;
+  }
+  if (std::holds_alternative<Storage::Set>(value)) {
+    return Storage::Snapshot::Type::Set;
+  }
+  return Storage::Snapshot::Type::String;
+}
+
+// Calls visit(std::string_view) for up to `count` elements of `value` from
+// position `from`, in delivery order: the list in order, the set by At
+template <typename F>
+void VisitElements(const Storage::Value &value, std::size_t from,
+                   std::size_t count, F &&visit) {
+  std::visit(
+    [&](const auto &val) {
+      using T = std::decay_t<decltype(val)>;
+      if constexpr (std::is_same_v<T, Storage::String>) {
+        if (from == 0 && count > 0) {
+          Storage::String::IntBuffer buf;
+          visit(val.View(buf));
+        }
+      } else if constexpr (std::is_same_v<T, Storage::List>) {
+        for (auto it = val.Seek(from); it != val.end() && count > 0;
+             ++it, --count) {
+          visit(*it);
+        }
+      } else {
+        const auto last = from + std::min(count, val.size() - from);
+        if (from == 0 && last == val.size()) {
+          val.ForEach(visit); // At walks a listpack from its start
+          return;
+        }
+        Storage::String::IntBuffer buf;
+        for (auto i = from; i < last; ++i) {
+          visit(val.At(i, buf));
+        }
+      }
+    },
+    value);
+}
+
+} // namespace
+
+std::shared_ptr<Storage::Snapshot> Storage::StartSnapshot() {
+  if (snapshot_) {
+    return nullptr;
+  }
+  // Every entry now carries an older epoch, so it is due to be copied. The
+  // epoch wraps after 2^32 snapshots; an entry untouched for that long
+  // would be missed.
+  ++snapshot_epoch_;
+  snapshot_ = std::shared_ptr<Snapshot>{new Snapshot{NowMs()}};
+  for (auto &db : dbs_) {
+    snapshot_->dbs_.push_back(db.get());
+  }
+  return snapshot_;
+}
+
+std::size_t Storage::SnapshotStep(std::size_t max_keys) {
+  if (!snapshot_) {
+    return 0;
+  }
+  if (snapshot_.use_count() == 1) {
+    EndSnapshot(/*complete=*/false); // nobody is reading it any more
+    return 0;
+  }
+
+  auto &snapshot = *snapshot_;
+  std::size_t visited = 0;
+  while (visited < max_keys) {
+    // Resumes on a later tick, once the consumer has caught up
+    if (snapshot.QueuedBytes() >= Snapshot::MAX_QUEUED_BYTES) {
+      break;
+    }
+    // Big keys already reached go out before the walk moves on
+    if (!snapshot.pending_.empty()) {
+      DeliverPart();
+      ++visited;
+      continue;
+    }
+    if (snapshot.walk_db_ == snapshot.dbs_.size()) {
+      EndSnapshot(/*complete=*/true);
+      break;
+    }
+    auto *db = snapshot.dbs_[snapshot.walk_db_];
+    const auto retired =
+      std::ranges::find_if(snapshot.retired_, [&](const auto &old) {
+        return old.get() == db;
+      });
+    if (db) {
+      // Nothing else can reach a retired database, so its values are
+      // taken rather than read in place
+      const auto reason = retired == snapshot.retired_.end() ? Reason::Walk
+                                                              : Reason::Removal;
+      snapshot.cursor_ = db->data.Scan(snapshot.cursor_, [&](Node &node) {
+        Preserve(*db, node, reason);
+        ++visited;
+      });
+    }
+    if (!db || snapshot.cursor_ == 0) {
+      if (db && retired != snapshot.retired_.end()) {
+        ClearLater(db->data);
+        snapshot.retired_.erase(retired);
+        snapshot.dbs_[snapshot.walk_db_] = nullptr;
+      }
+      ++snapshot.walk_db_;
+      snapshot.cursor_ = 0;
+    }
+  }
+  return visited;
+}
+
+void Storage::EndSnapshot(bool complete) {
+  auto &snapshot = *snapshot_;
+  for (auto &pending : snapshot.pending_) {
+    if (pending.live) {
+      pending.live->second.delivering = false;
+    } else {
+      ReleaseValue(*pending.taken);
+    }
+  }
+  snapshot.pending_.clear();
+  for (auto &db : snapshot.retired_) {
+    ClearLater(db->data);
+  }
+  snapshot.retired_.clear();
+  snapshot.Finish(complete);
+  snapshot_.reset();
+}
+
+bool Storage::RetireForSnapshot(std::size_t index) {
+  auto &db = dbs_[index];
+  auto &snapshot = *snapshot_;
+  for (auto &pending : snapshot.pending_) {
+    if (pending.live_db == db.get()) {
+      pending.live->second.delivering = false;
+      pending.Take(pending.live->second.value, /*removal=*/true,
+                   &snapshot_memory_);
+    }
+  }
+  // Once the walk is past it, every key that was there at the start has
+  // been delivered or is being delivered from a taken value
+  const auto it = std::ranges::find(snapshot.dbs_, db.get());
+  if (it == snapshot.dbs_.end() ||
+      static_cast<std::size_t>(it - snapshot.dbs_.begin()) <
+        snapshot.walk_db_) {
+    return false;
+  }
+
+  // The walk finishes it and then frees it, instead of a copy of every key
+  // being made here
+  db->expiry.Clear();
+  db->key_index.Clear();
+  snapshot.retired_.push_back(std::move(db));
+  return true;
+}
 
-  return std::max(0, static_cast<int>(remaining.count()));
+std::size_t Storage::SnapshotMemory() const noexcept {
+  return snapshot_ ? snapshot_->QueuedBytes() + snapshot_memory_.Allocated()
+                   : 0;
 }
 
-void Storage::Sweep(std::size_t max_checks) {
-  const auto bucket_count = data_.bucket_count();
-  if (bucket_count == 0) {
+void Storage::Capture(Database &db, Node &node, Reason reason) {
+  auto &entry = node.second;
+  auto &snapshot = *snapshot_;
+  if (entry.delivering) {
+    // Part way through; what is left must not change under the snapshot
+    if (reason == Reason::Write || reason == Reason::Removal) {
+      auto &pending =
+        *std::ranges::find(snapshot.pending_, &node, &Snapshot::Pending::live);
+      entry.delivering = false;
+      pending.Take(entry.value, reason == Reason::Removal, &snapshot_memory_);
+    }
+    return;
+  }
+
+  entry.version = snapshot_epoch_;
+  const auto it = std::ranges::find(snapshot.dbs_, &db);
+  // Keys already expired at the start are not part of the view, and neither
+  // is a database created since (nor anything in it)
+  if (entry.Expired(snapshot.started_at_) || it == snapshot.dbs_.end()) {
     return;
   }
 
-  auto now = Clock::now();
-  auto checked = 0;
+  const auto index = static_cast<std::size_t>(it - snapshot.dbs_.begin());
+  const auto size = ElementCount(entry.value);
+  if (size <= Snapshot::PART_ELEMENTS) {
+    Snapshot::Item item{
+      .db = index,
+      .key = std::string{node.first},
+      .type = SnapshotType(entry.value),
+      .elements = {},
+      .expires_at = entry.expires_at,
+    };
+    item.elements.reserve(size);
+    VisitElements(entry.value, 0, size, [&](std::string_view element) {
+      item.elements.emplace_back(element);
+    });
+    snapshot.Push(std::move(item));
+    return;
+  }
 
-  for (auto attempt = 0; checked < max_checks && attempt < max_checks * 2;
-       ++attempt) {
-    const auto bucket = rng_() % bucket_count;
-    for (auto it = data_.begin(bucket); it != data_.end(bucket); ++it) {
-      if (checked >= max_checks) {
+  // Too big to copy inside a write: queued, and read in place until
+  // something changes it
+  auto &pending = snapshot.pending_.emplace_back(Snapshot::Pending{
+    .db = index,
+    .key = std::string{node.first},
+    .type = SnapshotType(entry.value),
+    .expires_at = entry.expires_at,
+  });
+  if (reason == Reason::Walk || reason == Reason::Deadline) {
+    pending.live = &node;
+    pending.live_db = &db;
+    entry.delivering = true;
+  } else {
+    pending.Take(entry.value, reason == Reason::Removal, &snapshot_memory_);
+  }
+}
+
+void Storage::DeliverPart() {
+  auto &snapshot = *snapshot_;
+  auto &pending = snapshot.pending_.front();
+  const auto &value =
+    pending.live ? pending.live->second.value : *pending.taken;
+  Snapshot::Item item{
+    .db = pending.db,
+    .key = pending.key,
+    .type = pending.type,
+    .elements = {},
+    .expires_at = pending.expires_at,
+  };
+  item.elements.reserve(Snapshot::PART_ELEMENTS);
+  VisitElements(value, pending.done, Snapshot::PART_ELEMENTS,
+                [&](std::string_view element) {
+                  item.elements.emplace_back(element);
+                });
+  pending.done += item.elements.size();
+  item.more = pending.done < ElementCount(value);
+  const auto last = !item.more;
+  snapshot.Push(std::move(item));
+  if (!last) {
+    return;
+  }
+
+  if (pending.live) {
+    pending.live->second.delivering = false;
+  } else {
+    ReleaseValue(*pending.taken);
+  }
+  snapshot.pending_.pop_front();
+}
+
+void Storage::Snapshot::Pending::Take(Value &value, bool removal,
+                                      std::pmr::memory_resource *copies) {
+  live = nullptr;
+  live_db = nullptr;
+  if (removal) {
+    taken.emplace(std::move(value));
+    return;
+  }
+  // Written in place, so the rest is copied; a list holds any type's
+  // elements in order
+  List rest{copies};
+  VisitElements(value, done, SIZE_MAX,
+                [&](std::string_view element) { rest.push_back(element); });
+  taken.emplace(std::in_place_type<List>, std::move(rest));
+  done = 0;
+}
+
+std::optional<Storage::Snapshot::Item> Storage::Snapshot::Next() {
+  std::unique_lock lock{mutex_};
+  ready_.wait(lock, [this] { return !items_.empty() || finished_; });
+  if (items_.empty()) {
+    return std::nullopt;
+  }
+  auto item = std::move(items_.front());
+  items_.pop_front();
+  queued_bytes_ -= QueuedSize(item);
+  return item;
+}
+
+bool Storage::Snapshot::Complete() const {
+  std::lock_guard lock{mutex_};
+  return complete_;
+}
+
+void Storage::Snapshot::Push(Item item) {
+  {
+    std::lock_guard lock{mutex_};
+    queued_bytes_ += QueuedSize(item);
+    items_.push_back(std::move(item));
+  }
+  ready_.notify_one();
+}
+
+std::size_t Storage::Snapshot::QueuedSize(const Item &item) noexcept {
+  auto bytes = sizeof(Item) + item.key.capacity() +
+               item.elements.capacity() * sizeof(std::string);
+  for (const auto &element : item.elements) {
+    bytes += element.capacity();
+  }
+  return bytes;
+}
+
+void Storage::Snapshot::Finish(bool complete) {
+  {
+    std::lock_guard lock{mutex_};
+    finished_ = true;
+    complete_ = complete;
+  }
+  ready_.notify_all();
+}
+
+std::size_t Storage::Sweep(std::size_t max_keys) {
+  const auto now = NowMs();
+  std::size_t removed = 0;
+  for (auto &db : dbs_) {
+    if (!db) {
+      continue;
+    }
+    db->expiry.Advance(now);
+    while (removed < max_keys) {
+      auto key = db->expiry.PopDue();
+      if (!key) {
         break;
       }
-      if (it->second.Expired(now)) {
-        data_.erase(it->first);
-        break; // bucket iterators invalidated after erase
+      // Anything due has already expired, and PopDue unhooked its timer
+      auto it = db->data.find(*key);
+      Preserve(*db, *it, Reason::Removal);
+      ReleaseValue(it->second.value);
+      if (key_index_enabled_) {
+        db->key_index.Erase(it->first);
       }
-      ++checked;
+      db->data.erase(it);
+      ++removed;
+    }
+  }
+  expired_keys_ += removed;
+  return removed;
+}
+
+void Storage::ResizeStep() {
+  for (auto &db : dbs_) {
+    if (db) {
+      db->data.ShrinkIfNeeded();
+      db->data.RehashStep(REHASH_STEP);
     }
   }
 }
 
+std::string_view Storage::Encoding(std::string_view key) {
+  auto it = db_->data.find(key);
+  if (it == db_->data.end()) {
+    return {};
+  }
+  return std::visit(
+    [](const auto &value) -> std::string_view {
+      using T = std::decay_t<decltype(value)>;
+      if constexpr (std::is_same_v<T, String>) {
+        switch (value.GetEncoding()) {
+        case String::Encoding::Int:
+          return "int";
+        case String::Encoding::Shared:
+          return "shared";
+        case String::Encoding::Raw:
+          break;
+        }
+        return "raw";
+      } else if constexpr (std::is_same_v<T, List>) {
+        return value.IsCompact() ? "listpack" : "quicklist";
+      } else {
+        switch (value.GetEncoding()) {
+        case Set::Encoding::IntSet:
+          return "intset";
+        case Set::Encoding::Listpack:
+          return "listpack";
+        case Set::Encoding::Hashtable:
+          break;
+        }
+        return "hashtable";
+      }
+    },
+    it->second.value);
+}
+
+std::int64_t Storage::IdleTime(std::string_view key) {
+  auto it = db_->data.find(key);
+  if (it == db_->data.end()) {
+    return -1;
+  }
+  // Lookup through db_->data directly so that asking does not touch the clock
+  return static_cast<std::int64_t>(IdleMs(it->second, NowMs()) / 1000);
+}
+
+int Storage::AccessFrequency(std::string_view key) {
+  auto it = db_->data.find(key);
+  if (it == db_->data.end()) {
+    return -1;
+  }
+  return LfuDecayed(it->second, NowMs());
+}
+
+Storage::MemoryStats Storage::GetMemoryStats() noexcept {
+  slab_.DrainRemoteFrees();
+  UpdatePeakMemory();
+  return {.keys = keys_memory_.Allocated(),
+          .strings = strings_memory_.Allocated(),
+          .lists = lists_memory_.Allocated(),
+          .sets = sets_memory_.Allocated(),
+          .clients = clients_memory_.Allocated(),
+          .snapshot = SnapshotMemory(),
+          .total = UsedMemory(),
+          .peak = peak_memory_,
+          .reserved = slab_.Reserved()};
+}
+
+namespace {
+
+// Short strings live inside their owner (SSO) and cost nothing extra
+bool OnHeap(const std::pmr::string &str) {
+  static const auto inline_capacity = std::pmr::string{}.capacity();
+  return str.capacity() > inline_capacity;
+}
+
+std::size_t HeapBytes(const std::pmr::string &str) {
+  return OnHeap(str) ? SlabResource::RoundedSize(str.capacity() + 1, 1) : 0;
+}
+
+// Heap bytes of the first `samples` elements, scaled up to the whole
+// container so big collections cost O(samples) to estimate.
+template <typename Container>
+std::size_t SampledHeapBytes(const Container &container, std::size_t samples) {
+  std::size_t seen = 0;
+  std::size_t bytes = 0;
+  for (const auto &elem : container) {
+    if (samples != 0 && seen == samples) {
+      break;
+    }
+    bytes += HeapBytes(elem);
+    ++seen;
+  }
+  return seen == 0 ? 0 : bytes / seen * container.size();
+}
+
+} // namespace
+
+std::optional<std::size_t> Storage::MemoryUsage(std::string_view key,
+                                                std::size_t samples) {
+  auto it = db_->data.find(key);
+  if (it == db_->data.end() || it->second.Expired(NowMs())) {
+    return std::nullopt;
+  }
+
+  // Hash node plus its bucket slot
+  std::size_t bytes =
+    SlabResource::RoundedSize(Table::NODE_SIZE, Table::NODE_ALIGN) +
+    sizeof(void *) + HeapBytes(it->first);
+
+  std::visit(
+    [&](const auto &value) {
+      using T = std::decay_t<decltype(value)>;
+      if constexpr (std::is_same_v<T, String>) {
+        bytes += HeapBytes(value.Buffer());
+      } else if constexpr (std::is_same_v<T, List>) {
+        // Few enough buffers to count exactly: one per listpack, plus the
+        // node around each and the positional index once the list is a
+        // chain
+        if (!value.IsCompact()) {
+          bytes += value.NodeCount() * SlabResource::RoundedSize(
+                                         List::NODE_SIZE, List::NODE_ALIGN) +
+                   value.IndexCapacity() * sizeof(void *);
+        }
+        value.ForEachListpack([&](const Listpack &entries) {
+          bytes += HeapBytes(entries.Buffer());
+        });
+      } else if (value.IsIntSet()) {
+        bytes += HeapBytes(value.Ints().Buffer());
+      } else if (!value.IsHashtable()) {
+        bytes += HeapBytes(value.Entries().Buffer());
+      } else {
+        const auto &members = value.Hashtable();
+        const auto node = SlabResource::RoundedSize(Set::Members::NODE_SIZE,
+                                                    Set::Members::NODE_ALIGN);
+        bytes += members.BucketCount() * sizeof(void *) +
+                 members.ArrayCapacity() * sizeof(void *) +
+                 members.size() * node +
+                 SampledHeapBytes(members.Members(), samples);
+      }
+    },
+    it->second.value);
+  return bytes;
+}
+
+bool Storage::DefragNeeded() const noexcept {
+  const auto reserved = slab_.Reserved();
+  const auto used = slab_.InUse();
+  if (reserved <= used) {
+    return false;
+  }
+  const auto wasted = reserved - used;
+  return wasted >= defrag_ignore_bytes_ &&
+         wasted * 100 >=
+           used * static_cast<std::size_t>(defrag_threshold_lower_);
+}
+
+std::size_t Storage::ActiveDefrag(std::chrono::microseconds budget) {
+  slab_.DrainRemoteFrees();
+  if (!defrag_running_) {
+    if (!defrag_enabled_ || !DefragNeeded()) {
+      return 0;
+    }
+    defrag_running_ = true;
+    defrag_db_ = 0;
+    defrag_cursor_ = 0;
+    defrag_scanned_ = false;
+  }
+
+  const auto start = Clock::now();
+  const auto hits_before = defrag_hits_;
+  const auto reserved_before = slab_.Reserved();
+  std::size_t work = 0;
+  std::size_t next_check = DEFRAG_CHUNK;
+
+  while (defrag_running_) {
+    // Checking the clock is not free, so only do it every few objects
+    if (work >= next_check) {
+      next_check = work + DEFRAG_CHUNK;
+      if (Clock::now() - start > budget) {
+        break;
+      }
+    }
+
+    if (!defrag_later_.empty()) {
+      auto &later = defrag_later_.front();
+      auto &db = Db(later.db);
+      auto it = db.data.find(std::string_view{later.key});
+      // The key may have been deleted (or replaced, or its database swapped)
+      // since it was queued
+      if (it == db.data.end() ||
+          DefragValue(it->second.value, later.cursor, work)) {
+        defrag_later_.pop_front();
+      }
+      continue;
+    }
+
+    if (defrag_scanned_) {
+      defrag_running_ = false;
+      break;
+    }
+
+    // A scan cursor rather than a bucket index, so that resizes between
+    // steps neither skip keys nor restart the pass
+    if (auto *db = dbs_[defrag_db_].get()) {
+      defrag_cursor_ = db->data.Scan(defrag_cursor_, [&](Node &node) {
+        auto *moved = DefragNode(*db, &node);
+        ++work;
+        std::size_t cursor = 0;
+        if (!DefragValue(moved->second.value, cursor, work)) {
+          defrag_later_.push_back(
+            {defrag_db_, std::string{moved->first}, cursor});
+        }
+      });
+    }
+    // Databases are walked one after the other
+    if (defrag_cursor_ == 0) {
+      defrag_scanned_ = ++defrag_db_ >= dbs_.size();
+    }
+  }
+
+  const auto reserved_after = slab_.Reserved();
+  if (reserved_after < reserved_before) {
+    defrag_reclaimed_ += reserved_before - reserved_after;
+  }
+  return defrag_hits_ - hits_before;
+}
+
+bool Storage::DefragString(std::pmr::string &str) {
+  if (!OnHeap(str) || !slab_.ShouldMove(str.data(), str.capacity() + 1)) {
+    return false;
+  }
+  // The copy is allocated from a denser slab; swapping frees the old buffer
+  std::pmr::string fresh{str, str.get_allocator()};
+  str.swap(fresh);
+  ++defrag_hits_;
+  return true;
+}
+
+Storage::Node *Storage::DefragNode(Database &db, Node *node) {
+  const bool move_node =
+    slab_.ShouldMove(node, Table::NODE_SIZE, Table::NODE_ALIGN);
+  const bool move_key =
+    OnHeap(node->first) &&
+    slab_.ShouldMove(node->first.data(), node->first.capacity() + 1);
+  if (!move_node && !move_key) {
+    return node;
+  }
+
+  // Keys are immutable in place, so a new node always gets its own copy
+  auto *old = node;
+  node = &db.data.Reallocate(*node);
+  if (node->second.delivering) {
+    // The snapshot reads the value through the node
+    std::ranges::find(snapshot_->pending_, old, &Snapshot::Pending::live)
+      ->live = node;
+  }
+  defrag_hits_ += OnHeap(node->first) ? 2 : 1;
+  if (key_index_enabled_) {
+    db.key_index.Insert(node->first); // repoint at the moved key
+  }
+  // The timer still points at the old hook and key
+  db.expiry.Relocate(node->second.expiry, node->first);
+  return node;
+}
+
+void Storage::DefragMember(Set::Members &set,
+                           Set::Members::Index::value_type &node) {
+  const auto &member = node.first;
+  const bool move_node = slab_.ShouldMove(&node, Set::Members::NODE_SIZE,
+                                          Set::Members::NODE_ALIGN);
+  const bool move_buffer =
+    OnHeap(member) && slab_.ShouldMove(member.data(), member.capacity() + 1);
+  if (!move_node && !move_buffer) {
+    return;
+  }
+
+  const bool on_heap = OnHeap(member);
+  set.Reallocate(node); // `member` went with the old node
+  defrag_hits_ += on_heap ? 2 : 1;
+}
+
+bool Storage::DefragValue(Value &value, std::size_t &cursor,
+                          std::size_t &work) {
+  return std::visit(
+    [&](auto &val) {
+      using T = std::decay_t<decltype(val)>;
+      if constexpr (std::is_same_v<T, String>) {
+        DefragString(val.Buffer());
+        ++work;
+        return true;
+      } else if constexpr (std::is_same_v<T, List>) {
+        // Listpacks are plain buffers; `cursor` counts them
+        std::size_t index = 0;
+        val.ForEachListpack([&](Listpack &entries) {
+          if (index >= cursor && index < cursor + DEFRAG_CHUNK) {
+            DefragString(entries.Buffer());
+            ++work;
+          }
+          ++index;
+        });
+        cursor = std::min(index, cursor + DEFRAG_CHUNK);
+        return cursor >= index;
+      } else if (!val.IsHashtable()) {
+        DefragString(val.IsIntSet() ? val.Ints().Buffer()
+                                    : val.Entries().Buffer());
+        ++work;
+        return true;
+      } else {
+        auto &members = val.Hashtable();
+        std::size_t visited = 0;
+        do {
+          cursor = members.ScanNodes(
+            cursor, [&](Set::Members::Index::value_type &node) {
+              DefragMember(members, node);
+              ++visited;
+            });
+          ++visited; // empty buckets cost something too
+        } while (cursor != 0 && visited < DEFRAG_CHUNK);
+        work += visited;
+        return cursor == 0;
+      }
+    },
+    value);
+}
+
+void Storage::Touch(Entry &entry, std::int64_t now_ms) {
+  if (UsesLfu()) {
+    const auto counter = LfuLogIncr(LfuDecayed(entry, now_ms));
+    entry.lru = (LfuMinutes(now_ms) << 8) | counter;
+  } else {
+    entry.lru = LruClock(now_ms);
+  }
+}
+
+std::uint32_t Storage::InitialAccess(std::int64_t now_ms) const noexcept {
+  // New keys start with a small count so they survive long enough to prove
+  // themselves instead of being the first thing evicted.
+  return UsesLfu() ? (LfuMinutes(now_ms) << 8) | LFU_INIT_VAL
+                   : LruClock(now_ms);
+}
+
+std::uint8_t Storage::LfuDecayed(const Entry &entry,
+                                 std::int64_t now_ms) const noexcept {
+  const std::uint32_t last = entry.lru >> 8;
+  const std::uint32_t counter = entry.lru & 0xFF;
+  const auto now = LfuMinutes(now_ms);
+  const auto elapsed = now >= last ? now - last : 0xFFFF - last + now;
+
+  const auto periods =
+    lfu_decay_time_ > 0 ? elapsed / static_cast<std::uint32_t>(lfu_decay_time_)
+                        : 0;
+  return static_cast<std::uint8_t>(periods > counter ? 0 : counter - periods);
+}
+
+std::uint8_t Storage::LfuLogIncr(std::uint8_t counter) {
+  if (counter == 255) {
+    return counter;
+  }
+  // The more hits a key already has, the less likely another one counts:
+  // 8 bits then cover roughly a million accesses with the default factor.
+  const auto base = std::max(0, counter - LFU_INIT_VAL);
+  const auto p = 1.0 / (base * lfu_log_factor_ + 1);
+  const auto r = static_cast<double>(rng_() - rng_.min()) /
+                 static_cast<double>(rng_.max() - rng_.min());
+  return r < p ? counter + 1 : counter;
+}
+
+std::uint64_t Storage::EvictionScore(const Entry &entry,
+                                     std::int64_t now_ms) const {
+  if (UsesLfu()) {
+    return 255 - LfuDecayed(entry, now_ms);
+  }
+  return IdleMs(entry, now_ms);
+}
+
+std::uint64_t Storage::IdleMs(const Entry &entry,
+                              std::int64_t now_ms) noexcept {
+  const auto clock = LruClock(now_ms);
+  const auto idle = clock >= entry.lru
+                      ? clock - entry.lru
+                      : clock + (LRU_CLOCK_MAX - entry.lru); // wrapped
+  return std::uint64_t{idle} * LRU_CLOCK_RESOLUTION_MS;
+}
+
+Storage::EvictionStatus Storage::PerformEvictions() {
+  if (policy_ == EvictionPolicy::NoEviction) {
+    return EvictionStatus::Failed;
+  }
+
+  const auto start = Clock::now();
+  const auto now = NowMs();
+  std::size_t evicted = 0;
+
+  while (MemoryForEviction() > maxmemory_) {
+    if (!EvictOne(now)) {
+      return evicted > 0 ? EvictionStatus::Running : EvictionStatus::Failed;
+    }
+    ++evicted;
+
+    // Checking the clock is not free, so only do it every few keys
+    if (evicted % 16 == 0 && Clock::now() - start > EVICTION_TIME_BUDGET) {
+      return EvictionStatus::Running;
+    }
+  }
+  return EvictionStatus::Ok;
+}
+
+bool Storage::EvictOne(std::int64_t now_ms) {
+  // A few rounds of sampling; the pool remembers good candidates across calls
+  for (auto round = 0; round < 4; ++round) {
+    PopulateEvictionPool(now_ms);
+
+    while (eviction_pool_size_ > 0) {
+      auto &best = eviction_pool_[--eviction_pool_size_];
+      auto &db = Db(best.db);
+      auto it = db.data.find(std::string_view{best.key});
+      // The candidate may have been deleted or persisted (or its database
+      // swapped) since it was sampled
+      if (it == db.data.end() ||
+          (EvictsVolatileOnly() && it->second.expires_at == NO_EXPIRY)) {
+        continue;
+      }
+      EraseEntry(db, it, /*lazy=*/false);
+      ++evicted_keys_;
+      return true;
+    }
+  }
+  return false;
+}
+
+void Storage::PopulateEvictionPool(std::int64_t now_ms) {
+  // Every database is sampled, so the pool compares keys across all of them
+  for (std::size_t index = 0; index < dbs_.size(); ++index) {
+    auto *db = dbs_[index].get();
+    if (!db) {
+      continue;
+    }
+
+    if (EvictsVolatileOnly()) {
+      if (db->expiry.Size() == 0) {
+        continue;
+      }
+      for (std::size_t i = 0; i < EVICTION_SAMPLES; ++i) {
+        auto key = db->expiry.At(rng_() % db->expiry.Size());
+        auto it = db->data.find(*key);
+        if (it != db->data.end()) {
+          OfferEvictionCandidate(index, *it, now_ms);
+        }
+      }
+      continue;
+    }
+
+    const auto bucket_count = db->data.BucketCount();
+    if (db->data.empty() || bucket_count == 0) {
+      continue;
+    }
+
+    std::size_t sampled = 0;
+    for (std::size_t attempt = 0;
+         sampled < EVICTION_SAMPLES && attempt < EVICTION_SAMPLES * 8;
+         ++attempt) {
+      db->data.ForEachInBucket(rng_() % bucket_count, [&](const Node &node) {
+        if (sampled < EVICTION_SAMPLES) {
+          OfferEvictionCandidate(index, node, now_ms);
+          ++sampled;
+        }
+      });
+    }
+  }
+}
+
+void Storage::OfferEvictionCandidate(std::size_t db, const Node &node,
+                                     std::int64_t now_ms) {
+  const auto score = EvictionScore(node.second, now_ms);
+  const std::string_view key{node.first};
+
+  auto begin = eviction_pool_.begin();
+  auto end = begin + static_cast<std::ptrdiff_t>(eviction_pool_size_);
+  if (std::any_of(begin, end,
+                  [&](const auto &c) { return c.db == db && c.key == key; })) {
+    return;
+  }
+
+  auto pos =
+    std::find_if(begin, end, [&](const auto &c) { return c.score > score; });
+  if (eviction_pool_size_ < EVICTION_POOL_SIZE) {
+    std::move_backward(pos, end, end + 1);
+    ++eviction_pool_size_;
+  } else if (pos == begin) {
+    return; // worse than everything already pooled
+  } else {
+    // Drop the weakest candidate to make room
+    --pos;
+    std::move(begin + 1, pos + 1, begin);
+  }
+  pos->score = score;
+  pos->db = db;
+  pos->key.assign(key);
+}
+
 // Explicit instantiations
 template Storage::Result<Storage::String *>
   Storage::Find<Storage::String>(std::string_view);
@@ -135,9 +1496,28 @@ template Storage::Result<Storage::List *>
 template Storage::Result<Storage::Set *>
   Storage::Find<Storage::Set>(std::string_view);
 
+template Storage::Result<const Storage::String *>
+  Storage::Get<Storage::String>(std::string_view);
+template Storage::Result<const Storage::List *>
+  Storage::Get<Storage::List>(std::string_view);
+template Storage::Result<const Storage::Set *>
+  Storage::Get<Storage::Set>(std::string_view);
+
 template Storage::Result<Storage::String *>
   Storage::FindOrCreate<Storage::String>(std::string_view);
 template Storage::Result<Storage::List *>
   Storage::FindOrCreate<Storage::List>(std::string_view);
 template Storage::Result<Storage::Set *>
   Storage::FindOrCreate<Storage::Set>(std::string_view);
+
+template Storage::String *
+  Storage::Overwrite<Storage::String>(std::string_view);
+template Storage::List *Storage::Overwrite<Storage::List>(std::string_view);
+template Storage::Set *Storage::Overwrite<Storage::Set>(std::string_view);
+
+template Storage::Result<const Storage::String *>
+  Storage::Reader::Get<Storage::String>(std::string_view);
+template Storage::Result<const Storage::List *>
+  Storage::Reader::Get<Storage::List>(std::string_view);
+template Storage::Result<const Storage::Set *>
+  Storage::Reader::Get<Storage::Set>(std::string_view);
@@ -1,64 +1,676 @@
 #pragma once
 
+#include "counting_resource.hpp"
+#include "dict.hpp"
+#include "expiry_wheel.hpp"
+#include "glob.hpp"
+#include "key_index.hpp"
+#include "lazy_freer.hpp"
+#include "quicklist.hpp"
+#include "set_value.hpp"
+#include "sharded_dict.hpp"
+#include "shared_values.hpp"
+#include "slab_resource.hpp"
+#include "string_value.hpp"
+#include "worker_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <deque>
 #include <expected>
-#include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <memory_resource>
 #include <random>
 #include <string>
 #include <string_view>
-#include <unordered_map>
-#include <unordered_set>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
 class Storage {
 public:
+  // Every container allocates from a counting resource for its data type, so
+  // used memory is known exactly (per type) and maxmemory can be enforced.
+  // All of them share one slab allocator underneath.
   using Clock = std::chrono::steady_clock;
-  using String = std::string;
-  using List = std::deque<std::string>;
-  using Set = std::unordered_set<std::string>;
+  using String = StringValue;
+  using List = QuickList;
+  using Set = SetValue;
   using Value = std::variant<String, List, Set>;
 
-  enum class Error : std::uint8_t { NotFound, WrongType };
+  enum class Error : std::uint8_t {
+    NotFound,
+    WrongType,
+    NotInteger, // the value does not parse as the number asked for
+    Overflow,   // the result would not fit, or is not finite
+  };
   template <typename T> using Result = std::expected<T, Error>;
 
+  enum class EvictionPolicy : std::uint8_t {
+    NoEviction,
+    AllKeysLru,
+    VolatileLru,
+    AllKeysLfu,
+    VolatileLfu,
+  };
+  // Bytes currently allocated, broken down by what owns them.
+  struct MemoryStats {
+    std::size_t keys = 0; // table nodes, buckets and key strings
+    std::size_t strings = 0;
+    std::size_t lists = 0;
+    std::size_t sets = 0;
+    std::size_t clients = 0; // client arenas, including output buffers
+    std::size_t snapshot = 0; // copies waiting for a snapshot's consumer
+    std::size_t total = 0;
+    std::size_t peak = 0;
+    std::size_t reserved = 0; // obtained from the OS, including slab slack
+
+    // How much more memory the allocator holds than is actually in use
+    double FragmentationRatio() const noexcept {
+      return total == 0 ? 1.0
+                        : static_cast<double>(reserved) /
+                            static_cast<double>(total);
+    }
+  };
+
+  enum class EvictionStatus : std::uint8_t {
+    Ok,      // within maxmemory
+    Running, // still above the limit after this round's time budget
+    Failed,  // above the limit and nothing can be evicted
+  };
+
+  Storage();
+  ~Storage();
+  Storage(const Storage &) = delete;
+  Storage &operator=(const Storage &) = delete;
+
+  // Logical databases, as in Redis. Each has its own keyspace, timers and
+  // key index; key operations act on the selected one. Memory limits,
+  // eviction and defragmentation span all of them.
+  static constexpr std::size_t DEFAULT_DATABASES = 16;
+  std::size_t Databases() const noexcept { return dbs_.size(); }
+  // Sets the number of databases (at least 1); dropped ones lose their keys.
+  void SetDatabases(std::size_t count);
+  std::size_t SelectedDb() const noexcept { return selected_; }
+  void Select(std::size_t db); // `db` < Databases()
+  // Exchanges the contents of two databases in O(1).
+  void SwapDb(std::size_t a, std::size_t b);
+  // Moves `key`, with its TTL, from the selected database into `db`. False
+  // if it is missing here or `db` already holds it. The value is not copied.
+  bool Move(std::string_view key, std::size_t db);
+
+  // Deleting or expiring a value with more than LAZYFREE_THRESHOLD elements
+  // (listpacks, for a list) unlinks it here and destroys it on the lazy
+  // free thread.
+  static constexpr std::size_t LAZYFREE_THRESHOLD = 64;
+
   bool Exists(std::string_view key);
   bool Erase(std::string_view key);
   std::vector<std::string_view> Keys();
+  // Keys matching `pattern`; a pattern without wildcards is a single lookup.
+  std::vector<std::string_view> Keys(const GlobPattern &pattern);
+  // Deletes every key starting with `prefix`; returns how many there were.
+  // Proportional to the matches with the key index on, else a full walk.
+  std::size_t ErasePrefix(std::string_view prefix);
   void Clear();
+  // Empties the keyspace at once and frees the old one in the background.
+  void ClearAsync();
+  // The same for every database.
+  void ClearAll();
+  void ClearAllAsync();
+  std::size_t LazyFreePending() const noexcept { return freer_.Pending(); }
+  std::size_t LazyFreed() const noexcept { return freer_.Freed(); }
+  // Blocks until the lazy free thread has caught up.
+  void WaitForLazyFree() { freer_.Wait(); }
 
   // NOTE: will be instantiated explicitly since we only need to care about:
   // string, list, set
+  // For callers that go on to modify the value; a running snapshot gets a
+  // copy of it first. Lookups that only read use Get.
   template <typename T> Result<T *> Find(std::string_view key);
+  template <typename T> Result<const T *> Get(std::string_view key);
   template <typename T> Result<T *> FindOrCreate(std::string_view key);
+  // For SSCAN, whose cursor may step the set's rehash: that moves no member
+  // in or out, so a running snapshot is not given a copy
+  Result<Set *> FindSetForScan(std::string_view key);
+  // Replaces whatever `key` holds, of any type, with an empty T and drops
+  // its TTL. The old value is released like a deleted one.
+  template <typename T> T *Overwrite(std::string_view key);
+
+  // Deadlines are absolute milliseconds on Clock (see NowMs).
+  static constexpr std::int64_t NO_EXPIRY = -1;
+  static constexpr std::int64_t KEEP_TTL = -2;
+
+  static std::int64_t NowMs() noexcept {
+    return std::chrono::floor<std::chrono::milliseconds>(
+             Clock::now().time_since_epoch())
+      .count();
+  }
+  // Converts a Unix timestamp (ms) into a deadline on Clock; never negative,
+  // so a time long past is still a deadline (one already due).
+  static std::int64_t DeadlineFromUnixMs(std::int64_t unix_ms) noexcept;
+
+  // Overwrites or creates a string in a single lookup. `deadline_ms` is a
+  // deadline, NO_EXPIRY to drop any TTL, or KEEP_TTL to leave it untouched.
+  Result<String *> SetString(std::string_view key, std::string_view value,
+                             std::int64_t deadline_ms = NO_EXPIRY);
 
-  bool SetExpiry(std::string_view key, std::chrono::seconds ttl);
+  // Adds `delta` to the integer at `key` (0 if missing) in a single lookup,
+  // keeping any TTL. An int-encoded value is updated in place.
+  Result<std::int64_t> IncrBy(std::string_view key, std::int64_t delta);
+  // The same in floating point; the sum is stored in its shortest decimal
+  // form, which is returned.
+  Result<const String *> IncrByFloat(std::string_view key, double delta);
+
+  bool SetExpiry(std::string_view key, std::chrono::milliseconds ttl);
+  bool SetDeadline(std::string_view key, std::int64_t deadline_ms);
+  bool Persist(std::string_view key); // false if missing or no TTL
   int GetTtl(std::string_view key); // -2 = not found, -1 = no expiry
-  void Sweep(std::size_t max_checks = 20);
+  std::int64_t GetPttl(std::string_view key);
+
+  // Deletes up to `max_keys` keys whose deadline has passed. Only due keys
+  // are visited, so the cost does not depend on the size of the keyspace.
+  std::size_t Sweep(std::size_t max_keys = 20);
+  std::size_t VolatileCount() const noexcept { return db_->expiry.Size(); }
+  std::size_t VolatileCount(std::size_t db) const noexcept {
+    return dbs_[db] ? dbs_[db]->expiry.Size() : 0;
+  }
+
+  // Bytes currently allocated for keys, values, clients and snapshot copies.
+  std::size_t UsedMemory() const noexcept {
+    return MemoryForEviction() + SnapshotMemory();
+  }
+  std::size_t DatasetMemory() const noexcept {
+    return keys_memory_.Allocated() + strings_memory_.Allocated() +
+           lists_memory_.Allocated() + sets_memory_.Allocated();
+  }
+  MemoryStats GetMemoryStats() noexcept;
+  // Samples the total so the peak survives short-lived spikes; called from
+  // the server cron and whenever stats are read.
+  void UpdatePeakMemory() noexcept {
+    peak_memory_ = std::max(peak_memory_, UsedMemory());
+  }
+  // Upstream for client arenas, so their memory is counted with the rest.
+  std::pmr::memory_resource *ClientMemory() noexcept {
+    return &clients_memory_;
+  }
+  // Estimated bytes used by a key and its value. Collections extrapolate
+  // from the first `samples` elements (0 = all of them). nullopt if missing.
+  std::optional<std::size_t> MemoryUsage(std::string_view key,
+                                         std::size_t samples);
+
+  std::size_t MaxMemory() const noexcept { return maxmemory_; }
+  void SetMaxMemory(std::size_t bytes) noexcept { maxmemory_ = bytes; }
+  EvictionPolicy GetEvictionPolicy() const noexcept { return policy_; }
+  void SetEvictionPolicy(EvictionPolicy policy) noexcept { policy_ = policy; }
+  int LfuLogFactor() const noexcept { return lfu_log_factor_; }
+  void SetLfuLogFactor(int factor) noexcept { lfu_log_factor_ = factor; }
+  int LfuDecayTime() const noexcept { return lfu_decay_time_; }
+  void SetLfuDecayTime(int minutes) noexcept { lfu_decay_time_ = minutes; }
+  bool UsesLfu() const noexcept {
+    return policy_ == EvictionPolicy::AllKeysLfu ||
+           policy_ == EvictionPolicy::VolatileLfu;
+  }
+  bool EvictsVolatileOnly() const noexcept {
+    return policy_ == EvictionPolicy::VolatileLru ||
+           policy_ == EvictionPolicy::VolatileLfu;
+  }
+  std::size_t EvictedKeys() const noexcept { return evicted_keys_; }
+  std::size_t ExpiredKeys() const noexcept { return expired_keys_; }
+  std::size_t KeyCount() const noexcept { return db_->data.size(); }
+  std::size_t KeyCount(std::size_t db) const noexcept {
+    return dbs_[db] ? dbs_[db]->data.size() : 0;
+  }
+
+  // One step of a SCAN over the keyspace: visits (key, value) for the keys
+  // under `cursor` and returns the next cursor, 0 when done (see
+  // Dict::Scan). Expired keys are skipped.
+  template <typename F> std::uint64_t Scan(std::uint64_t cursor, F &&visit) {
+    const auto now = NowMs();
+    return db_->data.Scan(cursor, [&](const Node &node) {
+      if (!node.second.Expired(now)) {
+        visit(std::string_view{node.first}, node.second.value);
+      }
+    });
+  }
+  // Interning of repeated string values (see SharedValues), off by default.
+  // Turning it off keeps existing references valid.
+  bool SharedValuesEnabled() const noexcept { return shared_values_enabled_; }
+  void SetSharedValuesEnabled(bool enabled) noexcept {
+    shared_values_enabled_ = enabled;
+  }
+  std::size_t SharedValueCount() const noexcept {
+    return shared_values_.Size();
+  }
+
+  // Threads that big set operations are split across (see set_ops.hpp)
+  WorkerPool &Workers() noexcept { return workers_; }
+  std::size_t WorkerThreads() const noexcept { return workers_.Threads(); }
+
+  // Read-only lookups for several threads at once, while nothing writes.
+  class Reader;
+  // Threads that serve read-only commands in parallel (see Server); 1, the
+  // default, runs every command on the event loop.
+  WorkerPool &Readers() noexcept { return readers_; }
+  std::size_t ReadThreads() const noexcept { return readers_.Threads(); }
+  // Applies the LRU/LFU updates for the keys `reader` found, then forgets
+  // them. Call before anything writes.
+  void RecordAccesses(Reader &reader);
+
+  // Point-in-time view of every database for a consumer on another thread
+  // (backups, exports), without stopping writes (see Snapshot).
+  class Snapshot;
+  // Null if one is already running.
+  std::shared_ptr<Snapshot> StartSnapshot();
+  bool SnapshotRunning() const noexcept { return snapshot_ != nullptr; }
+  // Moves the running snapshot's walk along by up to `max_keys` keys,
+  // finishing it at the end; called from the cron. Returns the keys visited.
+  std::size_t SnapshotStep(std::size_t max_keys);
+
+  // Uniform in [0, bound), for SPOP and SRANDMEMBER; `bound` is nonzero
+  std::size_t RandomIndex(std::size_t bound) {
+    return std::uniform_int_distribution<std::size_t>{0, bound - 1}(rng_);
+  }
+
+  // Ordered key index, off by default. Turning it on indexes every key in
+  // one go; while on, prefix queries cost O(prefix + matches).
+  bool KeyIndexEnabled() const noexcept { return key_index_enabled_; }
+  void SetKeyIndexEnabled(bool enabled);
+  // Visits (key, value) for every live key starting with `prefix`, in key
+  // order. Returns false, visiting nothing, when the index is off or more
+  // than `limit` keys start with `prefix`; finding that out costs
+  // O(prefix + limit).
+  template <typename F>
+  bool ScanPrefix(std::string_view prefix, F &&visit,
+                  std::size_t limit = SIZE_MAX) {
+    if (!key_index_enabled_) {
+      return false;
+    }
+    std::vector<const KeyIndex::Key *> keys;
+    db_->key_index.CollectPrefix(prefix, keys,
+                                 limit == SIZE_MAX ? limit : limit + 1);
+    if (keys.size() > limit) {
+      return false;
+    }
+    const auto now = NowMs();
+    for (const auto *key : keys) {
+      const auto &entry = db_->data.find(*key)->second;
+      if (!entry.Expired(now)) {
+        visit(std::string_view{*key}, entry.value);
+      }
+    }
+    return true;
+  }
+
+  // Cron housekeeping for the keyspace tables: shrinks them after mass deletes
+  // and moves a pending resize along even when no commands arrive.
+  void ResizeStep();
+
+  // Called before commands that may grow memory. Cheap when under the limit;
+  // otherwise evicts keys until back under it or the time budget runs out.
+  EvictionStatus FreeMemoryIfNeeded() {
+    if (maxmemory_ == 0 || MemoryForEviction() <= maxmemory_) [[likely]] {
+      return EvictionStatus::Ok;
+    }
+    return PerformEvictions();
+  }
+
+  // Active defragmentation, off by default. Once the slab allocator wastes
+  // more than both thresholds, each call moves objects out of sparse slabs
+  // for up to `budget`, resuming the keyspace scan where the last call
+  // stopped. Returns the number of objects moved.
+  std::size_t ActiveDefrag(std::chrono::microseconds budget);
+  bool ActiveDefragEnabled() const noexcept { return defrag_enabled_; }
+  void SetActiveDefragEnabled(bool enabled) noexcept {
+    defrag_enabled_ = enabled;
+  }
+  std::size_t DefragIgnoreBytes() const noexcept {
+    return defrag_ignore_bytes_;
+  }
+  void SetDefragIgnoreBytes(std::size_t bytes) noexcept {
+    defrag_ignore_bytes_ = bytes;
+  }
+  // Percent of wasted over used bytes before a defrag pass starts
+  int DefragThresholdLower() const noexcept { return defrag_threshold_lower_; }
+  void SetDefragThresholdLower(int percent) noexcept {
+    defrag_threshold_lower_ = percent;
+  }
+  bool DefragRunning() const noexcept { return defrag_running_; }
+  std::size_t DefragHits() const noexcept { return defrag_hits_; }
+  // Bytes of slabs given back to the OS while defragmenting
+  std::size_t DefragReclaimed() const noexcept { return defrag_reclaimed_; }
+
+  // Introspection for OBJECT; none of these counts as an access.
+  // How the value is stored ("int", "raw", ...); empty if missing.
+  std::string_view Encoding(std::string_view key);
+  // Seconds since the last access (LRU policies); -1 if missing.
+  std::int64_t IdleTime(std::string_view key);
+  // Logarithmic access counter 0-255, decayed to now (LFU policies); -1 if
+  // missing.
+  int AccessFrequency(std::string_view key);
 
 private:
+  static constexpr int LRU_BITS = 24;
+  static constexpr std::uint32_t LRU_CLOCK_MAX = (1U << LRU_BITS) - 1;
+  static constexpr std::int64_t LRU_CLOCK_RESOLUTION_MS = 1000;
+  static constexpr std::uint8_t LFU_INIT_VAL = 5;
+  static constexpr std::size_t EVICTION_POOL_SIZE = 16;
+  static constexpr std::size_t EVICTION_SAMPLES = 5;
+  static constexpr auto EVICTION_TIME_BUDGET = std::chrono::microseconds{500};
+  // Elements of one collection handled per defrag step; bigger collections
+  // are queued and finished over several steps.
+  static constexpr std::size_t DEFRAG_CHUNK = 64;
+  // Buckets of a keyspace resize moved per cron tick
+  static constexpr std::size_t REHASH_STEP = 100;
+  // Keyspaces at least this big are walked by KEYS one shard per task
+  static constexpr std::size_t PARALLEL_WALK_MIN = 65'536;
+
   struct Entry {
     Value value;
-    std::optional<Clock::time_point> expires_at;
+    std::int64_t expires_at = NO_EXPIRY;
+    ExpiryWheel::Hook expiry;
+    // LRU: access clock. LFU: minutes of the last decrement (16 bits) and a
+    // logarithmic access counter (8 bits), as in Redis.
+    std::uint32_t lru : LRU_BITS = 0;
+    // Set while a snapshot delivers the value in parts straight from here
+    std::uint32_t delivering : 1 = 0;
+    // Epoch of the last snapshot that copied this entry or started before
+    // it was created; fits in the padding after `lru`
+    std::uint32_t version = 0;
 
-    bool Expired(Clock::time_point now) const {
-      return expires_at && now >= *expires_at;
+    bool Expired(std::int64_t now_ms) const {
+      return expires_at != NO_EXPIRY && now_ms >= expires_at;
     }
   };
 
-  struct TransparentHash {
-    using is_transparent = void;
-    std::size_t operator()(std::string_view sv) const noexcept {
-      return std::hash<std::string_view>{}(sv);
-    }
+  // Sharded by key hash, so each sub-table resizes on its own and big walks
+  // can split by shard
+  using Table = ShardedDict<Entry>;
+  using Node = Table::value_type;
+
+  struct Database {
+    explicit Database(std::pmr::memory_resource *memory)
+        : data{memory}, key_index{memory} {}
+
+    Table data;
+    KeyIndex key_index; // points at keys owned by data
+    ExpiryWheel expiry{NowMs()};
+  };
+
+  // A collection too big to defragment in one go, and how far we got
+  struct DeferredDefrag {
+    std::size_t db = 0;
+    std::string key;
+    std::size_t cursor = 0; // element index for lists, scan cursor for sets
   };
 
-  std::unordered_map<std::string, Entry, TransparentHash, std::equal_to<>>
-    data_;
+  // Candidates kept sorted by ascending score; the best victim is last.
+  struct EvictionCandidate {
+    std::uint64_t score = 0;
+    std::size_t db = 0;
+    std::string key;
+  };
+
+  SlabResource slab_; // must outlive every container below
+  CountingResource keys_memory_{&slab_};
+  CountingResource strings_memory_{&slab_};
+  CountingResource lists_memory_{&slab_};
+  CountingResource sets_memory_{&slab_};
+  CountingResource clients_memory_{&slab_};
+  CountingResource snapshot_memory_{&slab_}; // values copied for a snapshot
+  SharedValues shared_values_{&strings_memory_}; // outlives every value
+  bool shared_values_enabled_ = false;
+  LazyFreer freer_; // joined before the resources it frees into go away
+  WorkerPool workers_;
+  WorkerPool readers_{1};
+  std::size_t peak_memory_ = 0;
+  // Created on first use; swapping two only swaps the pointers
+  std::vector<std::unique_ptr<Database>> dbs_;
+  std::size_t selected_ = 0;
+  Database *db_ = nullptr; // dbs_[selected_], never null
+  bool key_index_enabled_ = false;
   std::minstd_rand rng_{std::random_device{}()};
 
-  Entry *FindEntry(std::string_view key);
+  std::size_t maxmemory_ = 0; // 0 = unlimited
+  EvictionPolicy policy_ = EvictionPolicy::NoEviction;
+  int lfu_log_factor_ = 10;
+  int lfu_decay_time_ = 1; // minutes per counter decrement
+  std::size_t evicted_keys_ = 0;
+  std::size_t expired_keys_ = 0;
+  std::array<EvictionCandidate, EVICTION_POOL_SIZE> eviction_pool_{};
+  std::size_t eviction_pool_size_ = 0;
+
+  bool defrag_enabled_ = false;
+  std::size_t defrag_ignore_bytes_ = std::size_t{100} << 20;
+  int defrag_threshold_lower_ = 10;
+  bool defrag_running_ = false;
+  std::size_t defrag_db_ = 0;
+  std::uint64_t defrag_cursor_ = 0; // scan cursor into that database
+  bool defrag_scanned_ = false;     // cursor wrapped; only queued work left
+  std::deque<DeferredDefrag> defrag_later_;
+  std::size_t defrag_hits_ = 0;
+  std::size_t defrag_reclaimed_ = 0;
+
+  std::shared_ptr<Snapshot> snapshot_; // the running one, if any
+  std::uint32_t snapshot_epoch_ = 0;   // of the latest one started
+
+  static std::uint32_t LruClock(std::int64_t now_ms) noexcept {
+    return static_cast<std::uint32_t>(now_ms / LRU_CLOCK_RESOLUTION_MS) &
+           LRU_CLOCK_MAX;
+  }
+  static std::uint64_t IdleMs(const Entry &entry, std::int64_t now_ms) noexcept;
+  static std::uint32_t LfuMinutes(std::int64_t now_ms) noexcept {
+    return static_cast<std::uint32_t>(now_ms / 60'000) & 0xFFFF;
+  }
+  std::uint8_t LfuDecayed(const Entry &entry, std::int64_t now_ms) const noexcept;
+  std::uint8_t LfuLogIncr(std::uint8_t counter);
+
+  // Refreshes the LRU clock or bumps the LFU counter, per policy
+  void Touch(Entry &entry, std::int64_t now_ms);
+  std::uint32_t InitialAccess(std::int64_t now_ms) const noexcept;
+  // Higher means a better eviction victim
+  std::uint64_t EvictionScore(const Entry &entry, std::int64_t now_ms) const;
+
+  template <typename T> CountingResource *MemoryFor() noexcept {
+    if constexpr (std::is_same_v<T, String>) {
+      return &strings_memory_;
+    } else if constexpr (std::is_same_v<T, List>) {
+      return &lists_memory_;
+    } else {
+      return &sets_memory_;
+    }
+  }
+
+  Database &Db(std::size_t index);
+  // Snapshot copies are left out: evicting a key the snapshot still wants
+  // would only move its bytes into the queue
+  std::size_t MemoryForEviction() const noexcept {
+    return DatasetMemory() + clients_memory_.Allocated();
+  }
+  // Copies queued for or held back by the running snapshot, if any
+  std::size_t SnapshotMemory() const noexcept;
+  // What is about to happen to an entry the snapshot may still need
+  enum class Reason : std::uint8_t {
+    Walk,     // nothing; the walk got to it
+    Deadline, // only its TTL changes
+    Write,    // its value changes in place
+    Removal,  // it is deleted or its value replaced
+  };
+  // Hands `node` to the running snapshot before it changes or goes, unless
+  // the snapshot already has it or does not want it. Every path that
+  // modifies or removes an existing entry goes through here.
+  void Preserve(Database &db, Node &node, Reason reason = Reason::Write) {
+    if (snapshot_ && (node.second.version != snapshot_epoch_ ||
+                      node.second.delivering)) [[unlikely]] {
+      Capture(db, node, reason);
+    }
+  }
+  void Capture(Database &db, Node &node, Reason reason);
+  // Queues the next part of the first key being delivered in parts
+  void DeliverPart();
+  // Gives database `index` to the running snapshot if its walk has not
+  // finished it yet, leaving the slot empty; false if it is not needed.
+  // Either way no part still to come is read from it afterwards.
+  bool RetireForSnapshot(std::size_t index);
+  // Wakes the consumer and drops what the snapshot still held back
+  void EndSnapshot(bool complete);
+  // Empties `table` at once; the lazy freer destroys what it held
+  void ClearLater(Table &table);
+  Node *FindEntry(std::string_view key);
+  // FindEntry for a caller about to modify, replace or move the entry
+  Node *FindForWrite(std::string_view key, Reason reason = Reason::Write) {
+    auto *node = FindEntry(key);
+    if (node) {
+      Preserve(*db_, *node, reason);
+    }
+    return node;
+  }
+  template <typename T> Node *Insert(std::string_view key);
+  // Eviction frees inline (`lazy` false): memory still owned by the lazy
+  // freer would otherwise look live and cause more keys to be evicted.
+  Table::iterator EraseEntry(Database &db, Table::iterator it,
+                             bool lazy = true);
+  // Hands big values to the lazy freer; small ones die with their node
+  void ReleaseValue(Value &value);
+  void ApplyDeadline(Node &node, std::int64_t deadline_ms);
+
+  bool DefragNeeded() const noexcept;
+  bool DefragString(std::pmr::string &str);
+  Node *DefragNode(Database &db, Node *node);
+  void DefragMember(Set::Members &set, Set::Members::Index::value_type &node);
+  // Handles up to DEFRAG_CHUNK elements from `cursor`; true once finished
+  bool DefragValue(Value &value, std::size_t &cursor, std::size_t &work);
+
+  EvictionStatus PerformEvictions();
+  void PopulateEvictionPool(std::int64_t now_ms);
+  void OfferEvictionCandidate(std::size_t db, const Node &node,
+                              std::int64_t now_ms);
+  bool EvictOne(std::int64_t now_ms);
+};
+
+// Lookups in one database that only read: they never advance a resize,
+// delete an expired key (it just reads as missing) or update access
+// times. Any number of readers may run on different threads as long as
+// nothing writes meanwhile. Keys found are remembered, so that the owner
+// can pass the reader to Storage::RecordAccesses afterwards.
+class Storage::Reader {
+public:
+  Reader(const Storage &store, std::size_t db);
+
+  template <typename T> Result<const T *> Get(std::string_view key);
+  int GetTtl(std::string_view key);
+  std::int64_t GetPttl(std::string_view key);
+
+private:
+  friend class Storage;
+
+  const Database *db_;
+  std::int64_t now_ms_;
+  std::vector<const Node *> accessed_;
+
+  const Node *FindEntry(std::string_view key);
+};
+
+// A copy of every database as it was at StartSnapshot, handed key by key to
+// a consumer on another thread while the event loop keeps serving writes.
+// Nothing is copied up front. The cron walks the keyspace in steps, and a
+// write to a key the walk has not reached yet copies that key out first.
+// An entry records the epoch of the last snapshot that copied it, so each
+// key is delivered exactly once, by whichever comes first, and keys
+// created after the start are never delivered. Without a running snapshot
+// the write path pays one null check.
+//
+// A collection of more than PART_ELEMENTS is not copied at once: it is
+// delivered in parts from the keyspace, and a write that gets to it first
+// takes the value (a delete) or copies just the rest (a change in place).
+// A database flushed or dropped before the walk is done with it is handed
+// over whole and freed once walked.
+//
+// The consumer owns the copies. Dropping every reference stops the walk.
+class Storage::Snapshot {
+public:
+  enum class Type : std::uint8_t { String, List, Set };
+
+  // One key as it was when the snapshot started
+  struct Item {
+    std::size_t db = 0;
+    std::string key;
+    Type type = Type::String;
+    // The string, the list in order, or the set's members
+    std::vector<std::string> elements;
+    std::int64_t expires_at = NO_EXPIRY; // a deadline on Clock
+    // More elements of the same key follow in a later item, possibly after
+    // other keys
+    bool more = false;
+  };
+
+  // Collections bigger than this arrive in parts of this many elements.
+  static constexpr std::size_t PART_ELEMENTS = 128;
+
+  // Blocks until the next key arrives; nullopt once there are no more.
+  std::optional<Item> Next();
+  // False if the snapshot was cut short because its Storage went away.
+  bool Complete() const;
+  std::int64_t StartedAt() const noexcept { return started_at_; }
+  // Roughly the memory held by items not yet taken. The walk waits while
+  // it is at MAX_QUEUED_BYTES or more, so a slow consumer slows the
+  // snapshot down instead of growing the queue. Writes still queue the
+  // small keys they are about to change; big ones wait their turn.
+  static constexpr std::size_t MAX_QUEUED_BYTES = 16 << 20;
+  std::size_t QueuedBytes() const noexcept {
+    return queued_bytes_.load(std::memory_order_relaxed);
+  }
+
+private:
+  friend class Storage;
+
+  explicit Snapshot(std::int64_t started_at) : started_at_{started_at} {}
+
+  mutable std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<Item> items_;
+  bool finished_ = false;
+  bool complete_ = false;
+  // Also read without the lock, by the owner's memory stats
+  std::atomic<std::size_t> queued_bytes_ = 0;
+
+  // The owner's side, only touched on its thread
+  std::int64_t started_at_;
+  // By index as of the start, so SWAPDB and MOVE keep the original numbers;
+  // null for a database that went away once the snapshot was done with it
+  std::vector<Database *> dbs_;
+  std::size_t walk_db_ = 0;
+  std::uint64_t cursor_ = 0;
+  // Databases flushed or dropped before the walk finished them
+  std::vector<std::unique_ptr<Database>> retired_;
+
+  // A key too big to copy in one go, delivered a part at a time
+  struct Pending {
+    std::size_t db = 0;
+    std::string key;
+    Type type = Type::String;
+    std::int64_t expires_at = NO_EXPIRY;
+    // Read from its entry (flagged `delivering`) until a write comes...
+    Node *live = nullptr;
+    Database *live_db = nullptr;
+    // ...then from here
+    std::optional<Value> taken = std::nullopt;
+    std::size_t done = 0; // elements delivered so far
+
+    // Moves off the entry before it changes: takes `value` whole if it is
+    // going away, else copies what is left of it into `copies`
+    void Take(Value &value, bool removal, std::pmr::memory_resource *copies);
+  };
+  std::deque<Pending> pending_; // oldest first
+
+  void Push(Item item);
+  void Finish(bool complete);
+  static std::size_t QueuedSize(const Item &item) noexcept;
 };
@@ -1,6 +1,10 @@
 #include "storage.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <catch2/catch_test_macros.hpp>
+#include <map>
+#include <memory>
 #include <thread>
 
 TEST_CASE("Storage key operations", "[storage]") {
@@ -13,7 +17,7 @@ TEST_CASE("Storage key operations", "[storage]") {
   SECTION("FindOrCreate creates string entry") {
     auto result = store.FindOrCreate<Storage::String>("key");
     REQUIRE(result.has_value());
-    **result = "hello";
+    (*result)->Assign("hello");
 
     auto found = store.Find<Storage::String>("key");
     REQUIRE(found.has_value());
@@ -50,6 +54,22 @@ TEST_CASE("Storage key operations", "[storage]") {
     store.Clear();
     REQUIRE(store.Keys().empty());
   }
+
+  SECTION("Keys over a big keyspace splits by shard") {
+    store.Workers().SetThreads(4);
+    for (auto i = 0; i < 100'000; ++i) {
+      store.SetString("key:" + std::to_string(i), "v");
+    }
+    for (auto i = 0; i < 100; ++i) {
+      store.SetDeadline("key:" + std::to_string(i), Storage::NowMs() - 1);
+    }
+
+    REQUIRE(store.Keys().size() == 99'900);
+    REQUIRE(store.ExpiredKeys() == 100);
+    REQUIRE(store.KeyCount() == 99'900);
+    const auto keys = store.Keys(GlobPattern{"key:9999*"});
+    REQUIRE(keys.size() == 11);
+  }
 }
 
 TEST_CASE("Storage type safety", "[storage]") {
@@ -85,6 +105,19 @@ TEST_CASE("Storage type safety", "[storage]") {
     REQUIRE_FALSE(result.has_value());
     REQUIRE(result.error() == Storage::Error::NotFound);
   }
+
+  SECTION("Overwrite replaces any type and drops the TTL") {
+    store.SetString("key", "value", Storage::NowMs() + 100'000);
+    auto *set = store.Overwrite<Storage::Set>("key");
+    REQUIRE(set->empty());
+    set->insert("member");
+    REQUIRE((*store.Find<Storage::Set>("key"))->contains("member"));
+    REQUIRE(store.GetPttl("key") == -1);
+    REQUIRE(store.VolatileCount() == 0);
+
+    REQUIRE(store.Overwrite<Storage::List>("new")->empty());
+    REQUIRE(store.Find<Storage::List>("new").has_value());
+  }
 }
 
 TEST_CASE("Storage string operations", "[storage]") {
@@ -92,7 +125,7 @@ TEST_CASE("Storage string operations", "[storage]") {
 
   SECTION("Set and get string") {
     auto *s = *store.FindOrCreate<Storage::String>("key");
-    *s = "hello";
+    s->Assign("hello");
 
     auto *found = *store.Find<Storage::String>("key");
     REQUIRE(*found == "hello");
@@ -100,10 +133,59 @@ TEST_CASE("Storage string operations", "[storage]") {
 
   SECTION("Overwrite string value") {
     auto *s = *store.FindOrCreate<Storage::String>("key");
-    *s = "first";
-    *s = "second";
+    s->Assign("first");
+    s->Assign("second");
     REQUIRE(*s == "second");
   }
+
+  SECTION("Integers are int-encoded") {
+    store.SetString("n", "12345");
+    REQUIRE(store.Encoding("n") == "int");
+    store.SetString("padded", "012");
+    REQUIRE(store.Encoding("padded") == "raw");
+    REQUIRE(**store.Find<Storage::String>("padded") == "012");
+    REQUIRE(store.Encoding("missing").empty());
+  }
+
+  SECTION("IncrBy creates, updates in place and keeps the TTL") {
+    REQUIRE(store.IncrBy("counter", 5) == 5);
+    REQUIRE(store.Encoding("counter") == "int");
+    store.SetDeadline("counter", Storage::NowMs() + 10'000);
+    const auto strings = store.GetMemoryStats().strings;
+    REQUIRE(store.IncrBy("counter", -7) == -2);
+    REQUIRE(store.GetMemoryStats().strings == strings);
+    REQUIRE(store.GetPttl("counter") > 0);
+    REQUIRE(**store.Find<Storage::String>("counter") == "-2");
+
+    store.SetString("raw", "10");
+    REQUIRE(store.IncrBy("raw", 1) == 11);
+  }
+
+  SECTION("IncrBy errors leave the value alone") {
+    store.SetString("text", "abc");
+    REQUIRE(store.IncrBy("text", 1).error() == Storage::Error::NotInteger);
+    store.SetString("spaces", " 1");
+    REQUIRE(store.IncrBy("spaces", 1).error() == Storage::Error::NotInteger);
+    store.SetString("max", "9223372036854775807");
+    REQUIRE(store.IncrBy("max", 1).error() == Storage::Error::Overflow);
+    REQUIRE(**store.Find<Storage::String>("max") == "9223372036854775807");
+    store.FindOrCreate<Storage::List>("list");
+    REQUIRE(store.IncrBy("list", 1).error() == Storage::Error::WrongType);
+  }
+
+  SECTION("IncrByFloat") {
+    REQUIRE(**store.IncrByFloat("f", 10.5) == "10.5");
+    REQUIRE(**store.IncrByFloat("f", 0.1) == "10.6");
+    REQUIRE(**store.IncrByFloat("f", -0.6) == "10");
+    REQUIRE(store.Encoding("f") == "int");
+    REQUIRE(**store.IncrByFloat("f", 1e20) == "100000000000000000000");
+
+    store.SetString("nan", "nan");
+    REQUIRE(store.IncrByFloat("nan", 1).error() == Storage::Error::NotInteger);
+    store.SetString("big", "1e308");
+    REQUIRE(store.IncrByFloat("big", 1e308).error() ==
+            Storage::Error::Overflow);
+  }
 }
 
 TEST_CASE("Storage list operations", "[storage]") {
@@ -126,12 +208,12 @@ TEST_CASE("Storage list operations", "[storage]") {
     list->push_back("b");
     list->push_back("c");
 
-    auto front = list->front();
+    std::string front{list->front()};
     list->pop_front();
     REQUIRE(front == "a");
     REQUIRE(list->size() == 2);
 
-    auto back = list->back();
+    std::string back{list->back()};
     list->pop_back();
     REQUIRE(back == "c");
     REQUIRE(list->size() == 1);
@@ -144,10 +226,11 @@ TEST_CASE("Storage list operations", "[storage]") {
     list->push_back("c");
     list->push_back("d");
 
-    REQUIRE((*list)[0] == "a");
-    REQUIRE((*list)[1] == "b");
-    REQUIRE((*list)[2] == "c");
-    REQUIRE((*list)[3] == "d");
+    REQUIRE(*list->Seek(0) == "a");
+    REQUIRE(*list->Seek(1) == "b");
+    REQUIRE(*list->Seek(2) == "c");
+    REQUIRE(*list->Seek(3) == "d");
+    REQUIRE(list->Seek(4) == list->end());
   }
 }
 
@@ -156,22 +239,21 @@ TEST_CASE("Storage set operations", "[storage]") {
 
   SECTION("Add and check membership") {
     auto *set = *store.FindOrCreate<Storage::Set>("myset");
-    auto [_, inserted] = set->insert("member1");
-    REQUIRE(inserted);
+    REQUIRE(set->insert("member1"));
     REQUIRE(set->contains("member1"));
   }
 
   SECTION("Duplicate insert returns false") {
     auto *set = *store.FindOrCreate<Storage::Set>("myset");
     set->insert("member1");
-    auto [_, inserted] = set->insert("member1");
+    auto inserted = set->insert("member1");
     REQUIRE_FALSE(inserted);
   }
 
   SECTION("Remove from set") {
     auto *set = *store.FindOrCreate<Storage::Set>("myset");
     set->insert("member1");
-    REQUIRE(set->erase("member1") == 1);
+    REQUIRE(set->erase("member1"));
     REQUIRE_FALSE(set->contains("member1"));
   }
 
@@ -195,11 +277,11 @@ TEST_CASE("Storage set operations", "[storage]") {
     s2->insert("d");
 
     std::vector<std::string> intersection;
-    for (const auto &member : *s1) {
+    s1->ForEach([&](std::string_view member) {
       if (s2->contains(member)) {
-        intersection.push_back(member);
+        intersection.emplace_back(member);
       }
-    }
+    });
 
     REQUIRE(intersection.size() == 2);
     // b and c should be in the intersection
@@ -251,4 +333,1018 @@ TEST_CASE("Storage expiration", "[storage]") {
     REQUIRE_FALSE(store.Exists("a"));
     REQUIRE(store.Exists("b"));
   }
+
+  SECTION("Millisecond TTLs") {
+    store.FindOrCreate<Storage::String>("key");
+    REQUIRE(store.SetExpiry("key", std::chrono::milliseconds{20}));
+    REQUIRE(store.GetPttl("key") <= 20);
+    REQUIRE(store.Exists("key"));
+    std::this_thread::sleep_for(std::chrono::milliseconds{30});
+    REQUIRE_FALSE(store.Exists("key"));
+  }
+
+  SECTION("Persist removes the TTL") {
+    store.FindOrCreate<Storage::String>("key");
+    REQUIRE_FALSE(store.Persist("key"));
+    store.SetExpiry("key", std::chrono::seconds{10});
+    REQUIRE(store.Persist("key"));
+    REQUIRE(store.GetTtl("key") == -1);
+    REQUIRE(store.VolatileCount() == 0);
+  }
+
+  SECTION("SetString replaces or keeps the TTL") {
+    store.SetString("key", "a", Storage::NowMs() + 10'000);
+    store.SetString("key", "b", Storage::KEEP_TTL);
+    REQUIRE(store.GetTtl("key") == 10);
+    store.SetString("key", "c");
+    REQUIRE(store.GetTtl("key") == -1);
+    REQUIRE(**store.Find<Storage::String>("key") == "c");
+  }
+
+  SECTION("Sweep only removes keys that are due") {
+    for (auto i = 0; i < 100; ++i) {
+      auto key = "k" + std::to_string(i);
+      store.FindOrCreate<Storage::String>(key);
+      store.SetExpiry(key, std::chrono::seconds{i % 2 == 0 ? 0 : 100});
+    }
+    REQUIRE(store.VolatileCount() == 100);
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+
+    REQUIRE(store.Sweep(1000) == 50);
+    REQUIRE(store.VolatileCount() == 50);
+    REQUIRE(store.Keys().size() == 50);
+  }
+
+  SECTION("Sweep honours its budget") {
+    for (auto i = 0; i < 10; ++i) {
+      auto key = "k" + std::to_string(i);
+      store.FindOrCreate<Storage::String>(key);
+      store.SetExpiry(key, std::chrono::seconds{0});
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+
+    REQUIRE(store.Sweep(4) == 4);
+    REQUIRE(store.Sweep(4) == 4);
+    REQUIRE(store.Sweep(4) == 2);
+  }
+
+  SECTION("Deleting a volatile key cancels its timer") {
+    store.FindOrCreate<Storage::String>("key");
+    store.SetExpiry("key", std::chrono::seconds{0});
+    REQUIRE(store.Erase("key"));
+    REQUIRE(store.VolatileCount() == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    REQUIRE(store.Sweep() == 0);
+  }
+}
+
+TEST_CASE("Storage memory limit", "[storage]") {
+  Storage store;
+
+  SECTION("Used memory follows keys and values") {
+    const auto empty = store.UsedMemory();
+    auto *s = *store.FindOrCreate<Storage::String>("key");
+    s->Assign(std::string(1000, 'x'));
+    REQUIRE(store.UsedMemory() >= empty + 1000);
+    store.Erase("key");
+    REQUIRE(store.UsedMemory() < empty + 1000);
+  }
+
+  SECTION("Unlimited by default") {
+    REQUIRE(store.MaxMemory() == 0);
+    REQUIRE(store.FreeMemoryIfNeeded() == Storage::EvictionStatus::Ok);
+  }
+
+  SECTION("noeviction refuses to free memory") {
+    store.SetString("key", std::string(1000, 'x'));
+    store.SetMaxMemory(100);
+    REQUIRE(store.FreeMemoryIfNeeded() == Storage::EvictionStatus::Failed);
+    REQUIRE(store.Exists("key"));
+  }
+
+  SECTION("allkeys-lru evicts until under the limit") {
+    for (auto i = 0; i < 200; ++i) {
+      store.SetString("key:" + std::to_string(i), std::string(100, 'x'));
+    }
+    const auto limit = store.UsedMemory() / 2;
+    store.SetMaxMemory(limit);
+    store.SetEvictionPolicy(Storage::EvictionPolicy::AllKeysLru);
+
+    REQUIRE(store.FreeMemoryIfNeeded() != Storage::EvictionStatus::Failed);
+    while (store.FreeMemoryIfNeeded() == Storage::EvictionStatus::Running) {
+    }
+    REQUIRE(store.UsedMemory() <= limit);
+    REQUIRE(store.EvictedKeys() > 0);
+    REQUIRE(store.Keys().size() == 200 - store.EvictedKeys());
+  }
+
+  SECTION("volatile-lru only evicts keys with a TTL") {
+    for (auto i = 0; i < 100; ++i) {
+      store.SetString("persistent:" + std::to_string(i), std::string(100, 'x'));
+      store.SetString("volatile:" + std::to_string(i), std::string(100, 'x'),
+                      Storage::NowMs() + 100'000);
+    }
+    store.SetMaxMemory(store.UsedMemory() * 3 / 4);
+    store.SetEvictionPolicy(Storage::EvictionPolicy::VolatileLru);
+
+    while (store.FreeMemoryIfNeeded() == Storage::EvictionStatus::Running) {
+    }
+    REQUIRE(store.EvictedKeys() > 0);
+    for (auto i = 0; i < 100; ++i) {
+      REQUIRE(store.Exists("persistent:" + std::to_string(i)));
+    }
+  }
+
+  SECTION("volatile-lru fails once no volatile keys remain") {
+    store.SetString("key", std::string(1000, 'x'));
+    store.SetMaxMemory(100);
+    store.SetEvictionPolicy(Storage::EvictionPolicy::VolatileLru);
+    REQUIRE(store.FreeMemoryIfNeeded() == Storage::EvictionStatus::Failed);
+  }
+}
+
+TEST_CASE("Storage memory accounting", "[storage]") {
+  Storage store;
+
+  SECTION("Each type is counted separately") {
+    const auto before = store.GetMemoryStats();
+    (*store.FindOrCreate<Storage::String>("str"))
+      ->Assign(std::string(1000, 'x'));
+    (*store.FindOrCreate<Storage::List>("list"))
+      ->push_back(std::string(2000, 'x'));
+    (*store.FindOrCreate<Storage::Set>("set"))->insert(std::string(3000, 'x'));
+
+    const auto after = store.GetMemoryStats();
+    REQUIRE(after.keys > before.keys);
+    REQUIRE(after.strings >= before.strings + 1000);
+    REQUIRE(after.lists >= before.lists + 2000);
+    REQUIRE(after.sets >= before.sets + 3000);
+    REQUIRE(after.total == after.keys + after.strings + after.lists +
+                             after.sets + after.clients);
+    REQUIRE(store.DatasetMemory() == after.total - after.clients);
+  }
+
+  SECTION("Client memory counts towards the total") {
+    auto *clients = store.ClientMemory();
+    void *p = clients->allocate(4096);
+    REQUIRE(store.GetMemoryStats().clients == 4096);
+    REQUIRE(store.UsedMemory() == store.DatasetMemory() + 4096);
+    clients->deallocate(p, 4096);
+    REQUIRE(store.GetMemoryStats().clients == 0);
+  }
+
+  SECTION("Peak remembers the highest total") {
+    store.SetString("key", std::string(10'000, 'x'));
+    const auto high = store.GetMemoryStats().total;
+    store.Erase("key");
+    const auto stats = store.GetMemoryStats();
+    REQUIRE(stats.total < high);
+    REQUIRE(stats.peak >= high);
+  }
+
+  SECTION("MEMORY USAGE estimates") {
+    REQUIRE_FALSE(store.MemoryUsage("missing", 5).has_value());
+
+    store.SetString("small", "v");
+    store.SetString("big", std::string(10'000, 'x'));
+    REQUIRE(*store.MemoryUsage("big", 5) >= 10'000);
+    REQUIRE(*store.MemoryUsage("big", 5) > *store.MemoryUsage("small", 5));
+
+    auto *set = *store.FindOrCreate<Storage::Set>("set");
+    for (auto i = 0; i < 1000; ++i) {
+      set->insert(std::string(100, 'a') + std::to_string(i));
+    }
+    const auto sampled = *store.MemoryUsage("set", 5);
+    const auto exact = *store.MemoryUsage("set", 0);
+    REQUIRE(exact >= 100'000);
+    // Elements are all the same size, so sampling should be close
+    REQUIRE(sampled >= exact * 9 / 10);
+    REQUIRE(sampled <= exact * 11 / 10);
+  }
+}
+
+TEST_CASE("Storage active defrag", "[storage]") {
+  Storage store;
+  store.SetActiveDefragEnabled(true);
+  store.SetDefragIgnoreBytes(0);
+
+  constexpr auto N = 20'000;
+  for (auto i = 0; i < N; ++i) {
+    const auto key = "key:" + std::to_string(i);
+    store.SetString(key, std::string(40, 'a' + i % 26),
+                    i % 3 == 0 ? Storage::NowMs() + 100'000
+                               : Storage::NO_EXPIRY);
+  }
+  auto *set = *store.FindOrCreate<Storage::Set>("set");
+  auto *list = *store.FindOrCreate<Storage::List>("list");
+  for (auto i = 0; i < 5000; ++i) {
+    set->insert("member:" + std::string(30, 'x') + std::to_string(i));
+    list->push_back("element:" + std::string(30, 'y') + std::to_string(i));
+  }
+  // Leave one key in ten, scattered across every slab
+  for (auto i = 0; i < N; ++i) {
+    if (i % 10 != 0) {
+      store.Erase("key:" + std::to_string(i));
+    }
+  }
+  for (auto i = 0; i < 5000; ++i) {
+    if (i % 10 != 0) {
+      const auto member = "member:" + std::string(30, 'x') + std::to_string(i);
+      set->erase(member);
+    }
+  }
+
+  SECTION("Nothing happens while disabled or below the thresholds") {
+    store.SetActiveDefragEnabled(false);
+    REQUIRE(store.ActiveDefrag(std::chrono::seconds{1}) == 0);
+    store.SetActiveDefragEnabled(true);
+    store.SetDefragIgnoreBytes(std::size_t{1} << 40);
+    REQUIRE(store.ActiveDefrag(std::chrono::seconds{1}) == 0);
+    REQUIRE_FALSE(store.DefragRunning());
+  }
+
+  SECTION("Defrag reclaims slabs and keeps the data intact") {
+    const auto reserved_before = store.GetMemoryStats().reserved;
+    std::size_t moved = store.ActiveDefrag(std::chrono::microseconds{100});
+    while (store.DefragRunning()) {
+      moved += store.ActiveDefrag(std::chrono::microseconds{100});
+    }
+    REQUIRE(moved > 0);
+    REQUIRE(store.DefragHits() == moved);
+    REQUIRE(store.DefragReclaimed() > 0);
+    REQUIRE(store.GetMemoryStats().reserved < reserved_before);
+
+    for (auto i = 0; i < N; i += 10) {
+      const auto key = "key:" + std::to_string(i);
+      auto str = store.Find<Storage::String>(key);
+      REQUIRE(str.has_value());
+      REQUIRE(**str == std::string(40, 'a' + i % 26));
+      REQUIRE((store.GetPttl(key) > 0) == (i % 3 == 0));
+    }
+    set = *store.Find<Storage::Set>("set");
+    REQUIRE(set->size() == 500);
+    const auto member = "member:" + std::string(30, 'x') + "10";
+    REQUIRE(set->contains(std::string_view{member}));
+    REQUIRE((*store.Find<Storage::List>("list"))->size() == 5000);
+
+    // Relocated entries are still unhooked from the wheel on delete
+    for (auto i = 0; i < N; i += 30) {
+      REQUIRE(store.Erase("key:" + std::to_string(i)));
+    }
+    REQUIRE(store.VolatileCount() == 0);
+  }
+}
+
+TEST_CASE("Storage lazy freeing", "[storage]") {
+  Storage store;
+  const auto empty = store.UsedMemory();
+
+  auto fill_set = [&](std::string_view key, int members) {
+    auto *set = *store.FindOrCreate<Storage::Set>(key);
+    for (auto i = 0; i < members; ++i) {
+      set->insert("member:" + std::string(30, 'x') + std::to_string(i));
+    }
+  };
+
+  SECTION("Big values are freed in the background") {
+    fill_set("big", 10'000);
+    REQUIRE(store.Erase("big"));
+    REQUIRE_FALSE(store.Exists("big"));
+    store.WaitForLazyFree();
+    REQUIRE(store.LazyFreed() == 1);
+    REQUIRE(store.UsedMemory() <= empty + 1024);
+  }
+
+  SECTION("Small values are freed inline") {
+    fill_set("small", 10);
+    store.SetString("str", std::string(1000, 'x'));
+    REQUIRE(store.Erase("small"));
+    REQUIRE(store.Erase("str"));
+    REQUIRE(store.LazyFreePending() == 0);
+    REQUIRE(store.LazyFreed() == 0);
+  }
+
+  SECTION("Expired big values are freed in the background") {
+    fill_set("big", 1000);
+    store.SetDeadline("big", Storage::NowMs() - 1);
+    REQUIRE(store.Sweep() == 1);
+    store.WaitForLazyFree();
+    REQUIRE(store.LazyFreed() == 1);
+  }
+
+  SECTION("ClearAsync empties the keyspace at once") {
+    for (auto i = 0; i < 1000; ++i) {
+      store.SetString("key:" + std::to_string(i), "value",
+                      Storage::NowMs() + 100'000);
+    }
+    fill_set("big", 1000);
+    store.ClearAsync();
+    REQUIRE(store.Keys().empty());
+    REQUIRE(store.VolatileCount() == 0);
+
+    // The new keyspace is usable straight away
+    store.SetString("key:1", "new");
+    REQUIRE(store.Exists("key:1"));
+    store.WaitForLazyFree();
+    REQUIRE(store.LazyFreed() == 1);
+  }
+}
+
+TEST_CASE("Storage key index", "[storage]") {
+  Storage store;
+  for (auto tenant = 0; tenant < 20; ++tenant) {
+    for (auto i = 0; i < 50; ++i) {
+      store.SetString("tenant:" + std::to_string(tenant) + ":" +
+                        std::to_string(i),
+                      "v");
+    }
+  }
+
+  auto count_prefix = [&](std::string_view prefix) {
+    std::size_t count = 0;
+    const bool indexed =
+      store.ScanPrefix(prefix, [&](std::string_view key, const auto &) {
+        REQUIRE(key.starts_with(prefix));
+        ++count;
+      });
+    REQUIRE(indexed);
+    return count;
+  };
+
+  SECTION("Off by default") {
+    REQUIRE_FALSE(store.KeyIndexEnabled());
+    REQUIRE_FALSE(store.ScanPrefix("tenant:", [](auto, const auto &) {}));
+    REQUIRE(store.ErasePrefix("tenant:1:") == 50);
+    REQUIRE(store.KeyCount() == 950);
+  }
+
+  SECTION("Enabling indexes existing keys and tracks new ones") {
+    store.SetKeyIndexEnabled(true);
+    REQUIRE(count_prefix("tenant:1:") == 50);
+    REQUIRE(count_prefix("tenant:1") == 550);
+
+    store.SetString("tenant:1:new", "v");
+    REQUIRE(count_prefix("tenant:1:") == 51);
+    store.Erase("tenant:1:0");
+    REQUIRE(count_prefix("tenant:1:") == 50);
+
+    const auto keys = store.Keys(GlobPattern{"tenant:1?:4*"});
+    REQUIRE(keys.size() == 10 * 11);
+  }
+
+  SECTION("A limit declines prefixes with more keys, visiting none") {
+    store.SetKeyIndexEnabled(true);
+    std::size_t visited = 0;
+    auto visit = [&](std::string_view, const auto &) { ++visited; };
+    REQUIRE(store.ScanPrefix("tenant:1:", visit, 50));
+    REQUIRE(visited == 50);
+    REQUIRE_FALSE(store.ScanPrefix("tenant:1:", visit, 49));
+    REQUIRE_FALSE(store.ScanPrefix("tenant:1", visit, 100));
+    REQUIRE(visited == 50);
+  }
+
+  SECTION("Deleting by prefix only touches matching keys") {
+    store.SetKeyIndexEnabled(true);
+    store.SetDeadline("tenant:2:0", Storage::NowMs() - 1);
+    REQUIRE(store.ErasePrefix("tenant:2:") == 49);
+    REQUIRE(count_prefix("tenant:2:") == 0);
+    REQUIRE(store.KeyCount() == 950);
+    REQUIRE(store.Exists("tenant:20:0") == false);
+    REQUIRE(store.Exists("tenant:12:0"));
+  }
+
+  SECTION("Expiry and flushes keep the index in step") {
+    store.SetKeyIndexEnabled(true);
+    store.SetDeadline("tenant:3:7", Storage::NowMs() - 1);
+    REQUIRE(count_prefix("tenant:3:") == 49);
+    store.Sweep(100);
+    REQUIRE(count_prefix("tenant:3:") == 49);
+
+    store.ClearAsync();
+    REQUIRE(count_prefix("") == 0);
+    store.SetString("tenant:1:x", "v");
+    REQUIRE(count_prefix("tenant:") == 1);
+    store.WaitForLazyFree();
+  }
+
+  SECTION("Disabling drops the index") {
+    store.SetKeyIndexEnabled(true);
+    store.SetKeyIndexEnabled(false);
+    REQUIRE_FALSE(store.ScanPrefix("tenant:", [](auto, const auto &) {}));
+    store.SetKeyIndexEnabled(true);
+    REQUIRE(count_prefix("tenant:") == 1000);
+  }
+}
+
+TEST_CASE("Storage shared values", "[storage]") {
+  Storage store;
+  const std::string status = R"({"state":"active","tier":"free"})";
+  auto fill = [&](std::string_view prefix) {
+    for (auto i = 0; i < 1000; ++i) {
+      store.SetString(std::string{prefix} + std::to_string(i), status);
+    }
+  };
+
+  SECTION("Repeated values are stored once") {
+    auto before = store.GetMemoryStats().strings;
+    fill("owned:");
+    const auto owned = store.GetMemoryStats().strings - before;
+    REQUIRE(owned >= 1000 * status.size());
+
+    store.SetSharedValuesEnabled(true);
+    before = store.GetMemoryStats().strings;
+    fill("shared:");
+    REQUIRE(store.GetMemoryStats().strings - before < owned / 10);
+    REQUIRE(store.SharedValueCount() == 1);
+    REQUIRE(store.Encoding("shared:999") == "shared");
+    REQUIRE(**store.Find<Storage::String>("shared:999") == status);
+  }
+
+  SECTION("Writes detach from the pool") {
+    store.SetSharedValuesEnabled(true);
+    fill("key:");
+    store.SetString("key:1", "changed but long enough to own");
+    REQUIRE(**store.Find<Storage::String>("key:1") ==
+            "changed but long enough to own");
+    REQUIRE(**store.Find<Storage::String>("key:2") == status);
+    REQUIRE(store.Encoding("key:1") == "raw");
+    REQUIRE(store.IncrByFloat("key:3", 1).error() ==
+            Storage::Error::NotInteger);
+  }
+
+  SECTION("References outlive disabling and flushing") {
+    store.SetSharedValuesEnabled(true);
+    fill("key:");
+    store.SetSharedValuesEnabled(false);
+    REQUIRE(**store.Find<Storage::String>("key:5") == status);
+    store.SetString("new", status);
+    REQUIRE(store.Encoding("new") == "raw");
+    store.ClearAsync();
+    store.WaitForLazyFree();
+    REQUIRE(store.KeyCount() == 0);
+  }
+}
+
+TEST_CASE("Storage LFU access counters", "[storage]") {
+  Storage store;
+  store.SetEvictionPolicy(Storage::EvictionPolicy::AllKeysLfu);
+
+  SECTION("New keys start at the initial count") {
+    store.SetString("key", "v");
+    REQUIRE(store.AccessFrequency("key") == 5);
+    REQUIRE(store.AccessFrequency("missing") == -1);
+  }
+
+  SECTION("Accesses increment the counter") {
+    store.SetLfuLogFactor(0); // every hit counts
+    store.SetString("key", "v");
+    for (auto i = 0; i < 10; ++i) {
+      REQUIRE(store.Exists("key"));
+    }
+    REQUIRE(store.AccessFrequency("key") == 15);
+  }
+
+  SECTION("The counter grows logarithmically") {
+    store.SetString("key", "v");
+    for (auto i = 0; i < 10'000; ++i) {
+      store.Exists("key");
+    }
+    const auto freq = store.AccessFrequency("key");
+    REQUIRE(freq > 5);
+    REQUIRE(freq < 255);
+  }
+
+  SECTION("allkeys-lfu keeps frequently used keys") {
+    store.SetLfuLogFactor(0);
+    for (auto i = 0; i < 200; ++i) {
+      store.SetString("key:" + std::to_string(i), std::string(100, 'x'));
+    }
+    for (auto i = 0; i < 5; ++i) {
+      for (auto hit = 0; hit < 50; ++hit) {
+        store.Exists("key:" + std::to_string(i));
+      }
+    }
+
+    store.SetMaxMemory(store.UsedMemory() / 2);
+    while (store.FreeMemoryIfNeeded() == Storage::EvictionStatus::Running) {
+    }
+    REQUIRE(store.EvictedKeys() > 0);
+    for (auto i = 0; i < 5; ++i) {
+      REQUIRE(store.Exists("key:" + std::to_string(i)));
+    }
+  }
+}
+
+TEST_CASE("Storage logical databases", "[storage]") {
+  Storage store;
+  REQUIRE(store.Databases() == Storage::DEFAULT_DATABASES);
+  REQUIRE(store.SelectedDb() == 0);
+  store.SetString("key", "zero");
+
+  SECTION("Each database is its own keyspace") {
+    store.Select(3);
+    REQUIRE_FALSE(store.Exists("key"));
+    store.SetString("key", "three");
+    store.SetExpiry("key", std::chrono::hours{1});
+    REQUIRE(store.KeyCount() == 1);
+    REQUIRE(store.VolatileCount() == 1);
+
+    store.Select(0);
+    REQUIRE(**store.Find<Storage::String>("key") == "zero");
+    REQUIRE(store.VolatileCount() == 0);
+    REQUIRE(store.KeyCount(3) == 1);
+    REQUIRE(store.VolatileCount(3) == 1);
+    REQUIRE(store.KeyCount(5) == 0);
+  }
+
+  SECTION("Swapping exchanges contents, not selection") {
+    store.Select(1);
+    store.SetString("other", "one");
+    store.SwapDb(0, 1);
+    REQUIRE(store.SelectedDb() == 1);
+    REQUIRE(**store.Find<Storage::String>("key") == "zero");
+    store.Select(0);
+    REQUIRE(**store.Find<Storage::String>("other") == "one");
+
+    // A database never used swaps like an empty one
+    store.SwapDb(0, 7);
+    REQUIRE(store.KeyCount() == 0);
+    REQUIRE(store.KeyCount(7) == 1);
+  }
+
+  SECTION("Moving carries the value and its TTL") {
+    auto list = store.FindOrCreate<Storage::List>("list");
+    for (auto i = 0; i < 1'000; ++i) {
+      (*list)->push_back(std::to_string(i));
+    }
+    store.SetExpiry("list", std::chrono::hours{1});
+    store.SetKeyIndexEnabled(true);
+
+    REQUIRE(store.Move("list", 2));
+    REQUIRE_FALSE(store.Exists("list"));
+    REQUIRE(store.VolatileCount() == 0);
+    REQUIRE_FALSE(store.Move("missing", 2));
+
+    store.Select(2);
+    auto moved = store.Find<Storage::List>("list");
+    REQUIRE(moved);
+    REQUIRE((*moved)->size() == 1'000);
+    REQUIRE(store.GetTtl("list") > 0);
+    REQUIRE(store.VolatileCount() == 1);
+    REQUIRE(store.ScanPrefix("li", [](auto, const auto &) {}));
+
+    // An existing key in the target blocks the move
+    store.SetString("key", "two");
+    store.Select(0);
+    REQUIRE_FALSE(store.Move("key", 2));
+    REQUIRE(store.Exists("key"));
+  }
+
+  SECTION("Expiry and eviction reach every database") {
+    store.Select(4);
+    store.SetString("volatile", "v");
+    store.SetDeadline("volatile", Storage::NowMs() - 1);
+    store.Select(0);
+    REQUIRE(store.Sweep(100) == 1);
+    REQUIRE(store.KeyCount(4) == 0);
+
+    store.Select(5);
+    for (auto i = 0; i < 200; ++i) {
+      store.SetString("key:" + std::to_string(i), std::string(100, 'x'));
+    }
+    store.Select(0);
+    store.SetEvictionPolicy(Storage::EvictionPolicy::AllKeysLru);
+    store.SetMaxMemory(store.UsedMemory() / 2);
+    while (store.FreeMemoryIfNeeded() == Storage::EvictionStatus::Running) {
+    }
+    REQUIRE(store.KeyCount(5) < 200);
+  }
+
+  SECTION("Flushing all databases") {
+    store.Select(6);
+    store.SetString("key", "six");
+    store.ClearAll();
+    REQUIRE(store.SelectedDb() == 6);
+    REQUIRE(store.KeyCount(0) == 0);
+    REQUIRE(store.KeyCount(6) == 0);
+  }
+
+  SECTION("Shrinking the count drops databases") {
+    store.Select(9);
+    store.SetDatabases(4);
+    REQUIRE(store.Databases() == 4);
+    REQUIRE(store.SelectedDb() == 0);
+    REQUIRE(store.Exists("key"));
+  }
+}
+
+TEST_CASE("Storage readers", "[storage]") {
+  Storage store;
+  store.SetEvictionPolicy(Storage::EvictionPolicy::AllKeysLfu);
+  store.SetLfuLogFactor(0);
+  store.SetString("key", "value");
+  store.SetExpiry("key", std::chrono::hours{1});
+  store.FindOrCreate<Storage::List>("list");
+  store.SetString("stale", "v");
+  store.SetDeadline("stale", Storage::NowMs() - 1);
+
+  SECTION("Lookups see what Find does") {
+    Storage::Reader reader{store, 0};
+    REQUIRE(**reader.Get<Storage::String>("key") == "value");
+    REQUIRE(reader.Get<Storage::String>("list").error() ==
+            Storage::Error::WrongType);
+    REQUIRE(reader.Get<Storage::String>("missing").error() ==
+            Storage::Error::NotFound);
+    REQUIRE(reader.GetTtl("key") == store.GetTtl("key"));
+    REQUIRE(reader.GetPttl("list") == -1);
+    REQUIRE(reader.GetPttl("missing") == -2);
+  }
+
+  SECTION("Expired keys read as missing but stay for the owner to delete") {
+    Storage::Reader reader{store, 0};
+    REQUIRE(reader.Get<Storage::String>("stale").error() ==
+            Storage::Error::NotFound);
+    REQUIRE(reader.GetPttl("stale") == -2);
+    REQUIRE(store.KeyCount() == 3);
+  }
+
+  SECTION("Unused databases are empty") {
+    Storage::Reader reader{store, 9};
+    REQUIRE(reader.Get<Storage::String>("key").error() ==
+            Storage::Error::NotFound);
+  }
+
+  SECTION("Accesses count once recorded") {
+    const auto before = store.AccessFrequency("key");
+    std::vector<Storage::Reader> readers;
+    for (auto i = 0; i < 4; ++i) {
+      readers.emplace_back(store, 0);
+    }
+    // Catch2 assertions are not thread-safe, so the threads only count
+    std::atomic<int> found = 0;
+    std::vector<std::thread> threads;
+    for (auto &reader : readers) {
+      threads.emplace_back([&reader, &found] {
+        for (auto i = 0; i < 10; ++i) {
+          if (reader.Get<Storage::String>("key")) {
+            ++found;
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    REQUIRE(found == 40);
+    REQUIRE(store.AccessFrequency("key") == before);
+
+    for (auto &reader : readers) {
+      store.RecordAccesses(reader);
+    }
+    REQUIRE(store.AccessFrequency("key") == before + 40);
+    // Each reader forgets what it recorded
+    store.RecordAccesses(readers[0]);
+    REQUIRE(store.AccessFrequency("key") == before + 40);
+  }
+}
+
+namespace {
+
+// Drives the snapshot to the end, then returns what it delivered by key,
+// with the parts of big keys joined up
+std::map<std::string, Storage::Snapshot::Item>
+Drain(Storage &store, Storage::Snapshot &snapshot) {
+  while (store.SnapshotRunning()) {
+    store.SnapshotStep(7);
+  }
+  std::map<std::string, Storage::Snapshot::Item> items;
+  while (auto item = snapshot.Next()) {
+    const auto key = std::to_string(item->db) + ":" + item->key;
+    auto it = items.find(key);
+    if (it == items.end()) {
+      items.emplace(key, std::move(*item));
+      continue;
+    }
+    REQUIRE(it->second.more);
+    auto &elements = it->second.elements;
+    elements.insert(elements.end(), item->elements.begin(),
+                    item->elements.end());
+    it->second.more = item->more;
+  }
+  for (const auto &[key, item] : items) {
+    REQUIRE_FALSE(item.more);
+  }
+  return items;
+}
+
+} // namespace
+
+TEST_CASE("Storage snapshots", "[storage]") {
+  Storage store;
+  for (auto i = 0; i < 100; ++i) {
+    store.SetString("key:" + std::to_string(i), std::to_string(i));
+  }
+  auto list = store.FindOrCreate<Storage::List>("list");
+  (*list)->push_back("a");
+  (*list)->push_back("b");
+  auto set = store.FindOrCreate<Storage::Set>("set");
+  (*set)->insert("m");
+  store.SetExpiry("set", std::chrono::hours{1});
+  store.SetString("gone", "v");
+  store.SetDeadline("gone", Storage::NowMs() - 1);
+  store.Select(3);
+  store.SetString("key:0", "three");
+  store.Select(0);
+
+  auto snapshot = store.StartSnapshot();
+  REQUIRE(snapshot);
+  REQUIRE(store.SnapshotRunning());
+  REQUIRE_FALSE(store.StartSnapshot());
+
+  SECTION("Delivers every live key once, typed") {
+    const auto items = Drain(store, *snapshot);
+    REQUIRE(snapshot->Complete());
+    REQUIRE(items.size() == 103);
+    REQUIRE(items.at("0:key:42").elements == std::vector<std::string>{"42"});
+    REQUIRE(items.at("3:key:0").elements ==
+            std::vector<std::string>{"three"});
+    const auto &list_item = items.at("0:list");
+    REQUIRE(list_item.type == Storage::Snapshot::Type::List);
+    REQUIRE(list_item.elements == std::vector<std::string>{"a", "b"});
+    const auto &set_item = items.at("0:set");
+    REQUIRE(set_item.type == Storage::Snapshot::Type::Set);
+    REQUIRE(set_item.expires_at > snapshot->StartedAt());
+    REQUIRE(items.at("0:key:1").expires_at == Storage::NO_EXPIRY);
+    REQUIRE_FALSE(items.contains("0:gone"));
+  }
+
+  SECTION("Writes after the start are not seen") {
+    store.SetString("key:1", "changed");
+    (*store.Find<Storage::List>("list"))->push_back("c");
+    store.Persist("set");
+    REQUIRE(store.Erase("key:2"));
+    store.SetString("new", "v");
+    store.SwapDb(0, 3);
+    store.Select(3);
+    REQUIRE(store.Move("key:3", 5));
+    store.ClearAsync();
+    store.Select(0);
+    store.Clear();
+
+    const auto items = Drain(store, *snapshot);
+    REQUIRE(items.size() == 103);
+    REQUIRE(items.at("0:key:1").elements == std::vector<std::string>{"1"});
+    REQUIRE(items.at("0:key:2").elements == std::vector<std::string>{"2"});
+    REQUIRE(items.at("0:key:3").elements == std::vector<std::string>{"3"});
+    REQUIRE(items.at("0:list").elements ==
+            std::vector<std::string>{"a", "b"});
+    REQUIRE(items.at("0:set").expires_at != Storage::NO_EXPIRY);
+    REQUIRE(items.at("3:key:0").elements ==
+            std::vector<std::string>{"three"});
+    REQUIRE_FALSE(items.contains("0:new"));
+    store.WaitForLazyFree();
+  }
+
+  SECTION("Only writes copy a key ahead of the walk") {
+    REQUIRE(**store.Get<Storage::String>("key:7") == "7");
+    REQUIRE(store.Exists("key:8"));
+    REQUIRE(store.GetPttl("key:9") == -1);
+    (*store.FindSetForScan("set"))->Scan(0, [](std::string_view) {});
+    (*store.Find<Storage::List>("list"))->push_back("c");
+
+    // The walk has not started, so the first copy is the write's
+    const auto first = snapshot->Next();
+    REQUIRE(first->key == "list");
+    REQUIRE(first->elements == std::vector<std::string>{"a", "b"});
+    const auto items = Drain(store, *snapshot);
+    REQUIRE(items.size() == 102);
+    REQUIRE(items.at("0:key:7").elements == std::vector<std::string>{"7"});
+  }
+
+  SECTION("Flushed and dropped databases are handed to the walk") {
+    store.SnapshotStep(3);
+    const auto queued = snapshot->QueuedBytes();
+    store.ClearAsync();
+    store.SetDatabases(2);
+    REQUIRE(store.KeyCount() == 0);
+    REQUIRE(snapshot->QueuedBytes() == queued);
+    const auto items = Drain(store, *snapshot);
+    REQUIRE(items.at("3:key:0").elements ==
+            std::vector<std::string>{"three"});
+    REQUIRE(items.size() == 103);
+  }
+
+  SECTION("A later snapshot sees the changes") {
+    Drain(store, *snapshot);
+    store.SetString("key:1", "changed");
+    auto second = store.StartSnapshot();
+    REQUIRE(second);
+    const auto items = Drain(store, *second);
+    REQUIRE(items.size() == 103);
+    REQUIRE(items.at("0:key:1").elements ==
+            std::vector<std::string>{"changed"});
+  }
+
+  SECTION("Dropping the snapshot stops the walk") {
+    snapshot.reset();
+    store.SnapshotStep(1);
+    REQUIRE_FALSE(store.SnapshotRunning());
+  }
+}
+
+TEST_CASE("Storage snapshot read on another thread", "[storage]") {
+  Storage store;
+  for (auto i = 0; i < 20'000; ++i) {
+    store.SetString("key:" + std::to_string(i), std::to_string(i));
+  }
+  auto snapshot = store.StartSnapshot();
+
+  std::map<std::string, std::string> seen;
+  std::thread consumer{[&] {
+    while (auto item = snapshot->Next()) {
+      seen.emplace(item->key, item->elements.front());
+    }
+  }};
+
+  // Overwrite, delete and add keys while the walk goes on
+  for (auto i = 0; store.SnapshotRunning(); ++i) {
+    const auto key = "key:" + std::to_string(i % 25'000);
+    if (i % 3 == 0) {
+      store.Erase(key);
+    } else {
+      store.SetString(key, "new");
+    }
+    store.SnapshotStep(16);
+  }
+  consumer.join();
+
+  REQUIRE(snapshot->Complete());
+  REQUIRE(seen.size() == 20'000);
+  for (const auto &[key, value] : seen) {
+    REQUIRE(key == "key:" + value);
+  }
+}
+
+TEST_CASE("Storage snapshot waits for a slow consumer", "[storage]") {
+  Storage store;
+  const std::string big(std::size_t{1} << 20, 'x');
+  for (auto i = 0; i < 32; ++i) {
+    store.SetString("big:" + std::to_string(i), big);
+  }
+  auto snapshot = store.StartSnapshot();
+
+  store.SnapshotStep(1000);
+  const auto queued = snapshot->QueuedBytes();
+  REQUIRE(queued >= Storage::Snapshot::MAX_QUEUED_BYTES);
+  REQUIRE(queued < 32 * big.size());
+  REQUIRE(store.SnapshotStep(1000) == 0);
+  REQUIRE(store.SnapshotRunning());
+
+  SECTION("Queued copies are counted, but not for eviction") {
+    const auto stats = store.GetMemoryStats();
+    REQUIRE(stats.snapshot == queued);
+    REQUIRE(stats.total == store.DatasetMemory() + stats.clients + queued);
+
+    store.SetEvictionPolicy(Storage::EvictionPolicy::AllKeysLru);
+    store.SetMaxMemory(stats.total - queued / 2);
+    REQUIRE(store.FreeMemoryIfNeeded() == Storage::EvictionStatus::Ok);
+    REQUIRE(store.KeyCount() == 32);
+  }
+
+  SECTION("Taking items lets the walk go on") {
+    std::size_t delivered = 0;
+    while (store.SnapshotRunning()) {
+      while (snapshot->QueuedBytes() >= Storage::Snapshot::MAX_QUEUED_BYTES) {
+        REQUIRE(snapshot->Next());
+        ++delivered;
+      }
+      store.SnapshotStep(1000);
+    }
+    while (snapshot->Next()) {
+      ++delivered;
+    }
+    REQUIRE(delivered == 32);
+    REQUIRE(snapshot->Complete());
+    REQUIRE(snapshot->QueuedBytes() == 0);
+  }
+}
+
+TEST_CASE("Storage snapshot of big keys", "[storage]") {
+  Storage store;
+  const auto size = Storage::Snapshot::PART_ELEMENTS * 3 + 5;
+  std::vector<std::string> elements;
+  auto *list = *store.FindOrCreate<Storage::List>("list");
+  auto *set = *store.FindOrCreate<Storage::Set>("set");
+  for (std::size_t i = 0; i < size; ++i) {
+    elements.push_back("e" + std::to_string(i));
+    list->push_back(elements.back());
+    set->insert(elements.back());
+  }
+  store.SetString("key", "v");
+  auto snapshot = store.StartSnapshot();
+
+  auto members = [](std::vector<std::string> all) {
+    std::ranges::sort(all);
+    return all;
+  };
+  auto parts = [&](std::string_view key) {
+    std::size_t count = 0;
+    while (store.SnapshotRunning()) {
+      store.SnapshotStep(7);
+    }
+    while (auto item = snapshot->Next()) {
+      REQUIRE(item->elements.size() <= Storage::Snapshot::PART_ELEMENTS);
+      count += item->key == key ? 1 : 0;
+    }
+    return count;
+  };
+
+  SECTION("Arrive in parts") {
+    const auto items = Drain(store, *snapshot);
+    REQUIRE(items.size() == 3);
+    REQUIRE(items.at("0:list").elements == elements);
+    REQUIRE(items.at("0:list").type == Storage::Snapshot::Type::List);
+    REQUIRE(members(items.at("0:set").elements) == members(elements));
+    REQUIRE(items.at("0:set").type == Storage::Snapshot::Type::Set);
+  }
+
+  SECTION("Are not copied by a delete, a replace or a TTL change") {
+    REQUIRE(store.Erase("set"));
+    store.Overwrite<Storage::String>("list");
+    store.SetExpiry("list", std::chrono::hours{1});
+    REQUIRE(snapshot->QueuedBytes() == 0);
+    REQUIRE(store.GetMemoryStats().snapshot == 0);
+    REQUIRE(parts("set") == 4);
+  }
+
+  SECTION("A TTL change waits for the walk") {
+    store.SetExpiry("list", std::chrono::hours{1});
+    REQUIRE(snapshot->QueuedBytes() == 0);
+    store.SetExpiry("list", std::chrono::hours{2});
+    const auto items = Drain(store, *snapshot);
+    REQUIRE(items.at("0:list").elements == elements);
+    REQUIRE(items.at("0:list").expires_at == Storage::NO_EXPIRY);
+  }
+
+  SECTION("A write part way through copies only the rest") {
+    store.Persist("list"); // queued without being read yet
+    store.SnapshotStep(1);
+    REQUIRE(snapshot->Next()->more);
+    (*store.Find<Storage::List>("list"))->push_back("new");
+    REQUIRE(store.GetMemoryStats().snapshot > 0);
+    REQUIRE(store.GetMemoryStats().snapshot < store.DatasetMemory());
+
+    std::vector<std::string> rest;
+    while (store.SnapshotRunning()) {
+      store.SnapshotStep(7);
+    }
+    while (auto item = snapshot->Next()) {
+      if (item->key == "list") {
+        rest.insert(rest.end(), item->elements.begin(), item->elements.end());
+      }
+    }
+    REQUIRE(rest.size() == size - Storage::Snapshot::PART_ELEMENTS);
+    REQUIRE(rest.back() == elements.back());
+    REQUIRE(store.GetMemoryStats().snapshot == 0);
+  }
+
+  SECTION("A database flushed part way through is still delivered") {
+    store.Persist("set");
+    store.SnapshotStep(2);
+    store.ClearAsync();
+    REQUIRE(store.KeyCount() == 0);
+    const auto items = Drain(store, *snapshot);
+    REQUIRE(items.size() == 3);
+    REQUIRE(items.at("0:list").elements == elements);
+    REQUIRE(members(items.at("0:set").elements) == members(elements));
+    store.WaitForLazyFree();
+  }
+
+  SECTION("Dropping the snapshot lets the next one read them again") {
+    store.Persist("list");
+    snapshot.reset();
+    store.SnapshotStep(1);
+    REQUIRE_FALSE(store.SnapshotRunning());
+    snapshot = store.StartSnapshot();
+    (*store.Find<Storage::List>("list"))->push_back("new");
+    const auto items = Drain(store, *snapshot);
+    REQUIRE(items.at("0:list").elements == elements);
+  }
+}
+
+TEST_CASE("Storage snapshot outliving its storage", "[storage]") {
+  auto store = std::make_unique<Storage>();
+  store->SetString("key", "v");
+  auto *list = *store->FindOrCreate<Storage::List>("list");
+  for (std::size_t i = 0; i < Storage::Snapshot::PART_ELEMENTS * 2; ++i) {
+    list->push_back("e");
+  }
+  auto snapshot = store->StartSnapshot();
+  store->Persist("list");
+  store->ClearAsync();
+  store.reset();
+  // Whatever was copied before is still delivered
+  while (snapshot->Next()) {
+  }
+  REQUIRE_FALSE(snapshot->Complete());
 }
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// A string value. A value that spells a 64-bit integer exactly as it would
+// be printed (no '+', leading zeros or "-0") is kept as the integer itself,
+// like Redis' int encoding: it needs no buffer, and INCR updates it in
+// place without parsing or formatting anything. A value can also point at
+// an immutable copy in SharedValues; writing to it detaches it first.
+class StringValue {
+public:
+  enum class Encoding : std::uint8_t { Raw, Int, Shared };
+
+  // Room for the longest integer, "-9223372036854775808"
+  using IntBuffer = std::array<char, 20>;
+
+  explicit StringValue(std::pmr::memory_resource *resource =
+                         std::pmr::get_default_resource()) noexcept
+      : str_{resource} {}
+
+  // Stores `value`, int-encoded when it is an integer's canonical spelling
+  void Assign(std::string_view value) {
+    if (auto parsed = ParseCanonical(value)) {
+      SetInt(*parsed);
+      return;
+    }
+    str_.assign(value);
+    encoding_ = Encoding::Raw;
+  }
+
+  void SetInt(std::int64_t value) noexcept {
+    DropBuffer();
+    encoding_ = Encoding::Int;
+    int_ = value;
+  }
+
+  // Refers to `pooled`, which must outlive this value, instead of a copy
+  void Share(const std::pmr::string &pooled) noexcept {
+    DropBuffer();
+    encoding_ = Encoding::Shared;
+    shared_ = &pooled;
+  }
+
+  Encoding GetEncoding() const noexcept { return encoding_; }
+  bool IsInt() const noexcept { return encoding_ == Encoding::Int; }
+  // The value as an integer, whatever the encoding; nullopt if it is not one
+  std::optional<std::int64_t> ToInt() const noexcept {
+    if (IsInt()) {
+      return int_;
+    }
+    IntBuffer buf;
+    return ParseCanonical(View(buf));
+  }
+
+  // The bytes of the value; an integer is formatted into `buf`
+  std::string_view View(IntBuffer &buf) const noexcept {
+    switch (encoding_) {
+    case Encoding::Int: {
+      auto [end, _] =
+        std::to_chars(buf.data(), buf.data() + buf.size(), int_);
+      return {buf.data(), static_cast<std::size_t>(end - buf.data())};
+    }
+    case Encoding::Shared:
+      return *shared_;
+    case Encoding::Raw:
+      break;
+    }
+    return str_;
+  }
+  std::size_t Size() const noexcept {
+    IntBuffer buf;
+    return View(buf).size();
+  }
+
+  // The buffer this value owns (empty unless raw), for memory accounting
+  // and defrag
+  std::pmr::string &Buffer() noexcept { return str_; }
+  const std::pmr::string &Buffer() const noexcept { return str_; }
+
+  friend bool operator==(const StringValue &lhs, std::string_view rhs) {
+    IntBuffer buf;
+    return lhs.View(buf) == rhs;
+  }
+
+  static std::optional<std::int64_t>
+  ParseCanonical(std::string_view sv) noexcept {
+    if (sv.empty() || sv.size() > IntBuffer{}.size()) {
+      return std::nullopt;
+    }
+    std::int64_t val{};
+    auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), val);
+    if (ec != std::errc{} || ptr != sv.data() + sv.size()) {
+      return std::nullopt;
+    }
+    // Printing it back must give the same bytes, or GET would change them
+    IntBuffer buf;
+    auto [end, _] = std::to_chars(buf.data(), buf.data() + buf.size(), val);
+    const std::string_view printed{
+      buf.data(), static_cast<std::size_t>(end - buf.data())};
+    if (printed != sv) {
+      return std::nullopt;
+    }
+    return val;
+  }
+
+private:
+  std::pmr::string str_;
+  union {
+    std::int64_t int_ = 0;
+    const std::pmr::string *shared_;
+  };
+  Encoding encoding_ = Encoding::Raw;
+
+  // Gives a raw value's buffer back before switching to another encoding
+  void DropBuffer() noexcept {
+    if (encoding_ == Encoding::Raw) {
+      std::pmr::string{str_.get_allocator()}.swap(str_);
+    }
+  }
+};
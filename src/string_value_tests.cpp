@@ -0,0 +1,55 @@
+#include "string_value.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <string>
+
+TEST_CASE("StringValue encoding", "[string_value]") {
+  StringValue str;
+
+  SECTION("Only canonical integers are int-encoded") {
+    for (auto sv : {"0", "-1", "42", "9223372036854775807",
+                    "-9223372036854775808"}) {
+      str.Assign(sv);
+      REQUIRE(str.IsInt());
+      REQUIRE(str == sv);
+    }
+    for (auto sv : {"", "-0", "007", "+1", " 1", "1 ", "1.0", "0x10",
+                    "9223372036854775808", "-9223372036854775809"}) {
+      str.Assign(sv);
+      REQUIRE_FALSE(str.IsInt());
+      REQUIRE(str == sv);
+      REQUIRE_FALSE(str.ToInt());
+    }
+  }
+
+  SECTION("Switching encodings") {
+    str.Assign(std::string(100, 'x'));
+    REQUIRE(str.Buffer().capacity() >= 100);
+    str.SetInt(INT64_MIN);
+    REQUIRE(str.IsInt());
+    REQUIRE(str.Buffer().capacity() < 100);
+    REQUIRE(str.Size() == 20);
+    REQUIRE(str.ToInt() == INT64_MIN);
+
+    str.Assign("text");
+    REQUIRE_FALSE(str.IsInt());
+    REQUIRE(str == "text");
+    REQUIRE(str.Size() == 4);
+  }
+
+  SECTION("Shared values detach on write") {
+    const std::pmr::string pooled(40, 'p');
+    str.Assign(std::string(100, 'x'));
+    str.Share(pooled);
+    REQUIRE(str.GetEncoding() == StringValue::Encoding::Shared);
+    REQUIRE(str == pooled);
+    REQUIRE(str.Buffer().capacity() < 100);
+    REQUIRE_FALSE(str.ToInt());
+
+    str.Assign("own copy");
+    REQUIRE(str.GetEncoding() == StringValue::Encoding::Raw);
+    REQUIRE(str == "own copy");
+    REQUIRE(std::string_view{pooled} == std::string(40, 'p'));
+  }
+}
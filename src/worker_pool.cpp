@@ -0,0 +1,82 @@
+#include "worker_pool.hpp"
+
+#include <algorithm>
+
+std::size_t WorkerPool::DefaultThreads() noexcept {
+  return std::clamp<std::size_t>(std::thread::hardware_concurrency(), 1, 8);
+}
+
+void WorkerPool::SetThreads(std::size_t threads) {
+  Stop();
+  threads_ = threads == 0 ? 1 : threads;
+}
+
+void WorkerPool::Run(std::size_t count,
+                     const std::function<void(std::size_t)> &task) {
+  if (threads_ == 1 || count <= 1) {
+    for (std::size_t i = 0; i < count; ++i) {
+      task(i);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard lock{mutex_};
+    while (workers_.size() + 1 < threads_) {
+      workers_.emplace_back(&WorkerPool::Loop, this);
+    }
+    task_ = &task;
+    count_ = count;
+    next_.store(0, std::memory_order_relaxed);
+    busy_ = workers_.size();
+    ++generation_;
+  }
+  wake_.notify_all();
+
+  Work();
+
+  std::unique_lock lock{mutex_};
+  done_.wait(lock, [this] { return busy_ == 0; });
+  task_ = nullptr;
+}
+
+void WorkerPool::Work() noexcept {
+  // Indexes are claimed one at a time, so uneven tasks still balance out
+  for (auto i = next_.fetch_add(1, std::memory_order_relaxed); i < count_;
+       i = next_.fetch_add(1, std::memory_order_relaxed)) {
+    (*task_)(i);
+  }
+}
+
+void WorkerPool::Loop() {
+  std::uint64_t seen = 0;
+  std::unique_lock lock{mutex_};
+  while (true) {
+    wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+    if (stop_) {
+      return;
+    }
+    seen = generation_;
+
+    lock.unlock();
+    Work();
+    lock.lock();
+
+    if (--busy_ == 0) {
+      done_.notify_one();
+    }
+  }
+}
+
+void WorkerPool::Stop() noexcept {
+  {
+    std::lock_guard lock{mutex_};
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+  stop_ = false;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads for splitting one big computation, fork-join style. Run() hands
+// task indexes to the workers and to the calling thread alike and returns
+// once every task is done. The event loop blocks for the duration, so
+// whatever the tasks read cannot change under them; tasks must only read
+// shared state, keep their output to themselves and not throw.
+//
+// Workers are started on first use and parked between runs.
+class WorkerPool {
+public:
+  // `threads` counts the caller, so 1 runs everything inline
+  explicit WorkerPool(std::size_t threads = DefaultThreads()) noexcept
+      : threads_{threads == 0 ? 1 : threads} {}
+  ~WorkerPool() { Stop(); }
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  std::size_t Threads() const noexcept { return threads_; }
+  void SetThreads(std::size_t threads);
+
+  // Calls task(i) for every i in [0, count), spread across the threads
+  void Run(std::size_t count, const std::function<void(std::size_t)> &task);
+
+  // Up to 8, leaving nothing idle on smaller machines
+  static std::size_t DefaultThreads() noexcept;
+
+private:
+  std::size_t threads_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  std::vector<std::thread> workers_;
+  bool stop_ = false;
+
+  // The current run
+  const std::function<void(std::size_t)> *task_ = nullptr;
+  std::size_t count_ = 0;
+  std::atomic<std::size_t> next_ = 0;
+  std::size_t busy_ = 0; // workers still inside the run
+  std::uint64_t generation_ = 0;
+
+  void Work() noexcept;
+  void Loop();
+  void Stop() noexcept;
+};
@@ -0,0 +1,51 @@
+#include "worker_pool.hpp"
+
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+TEST_CASE("WorkerPool runs every task once", "[worker_pool]") {
+  SECTION("Tasks are spread across the threads") {
+    WorkerPool pool{4};
+    std::vector<std::atomic<int>> runs(1000);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    pool.Run(runs.size(), [&](std::size_t i) {
+      ++runs[i];
+      std::lock_guard lock{mutex};
+      threads.insert(std::this_thread::get_id());
+    });
+    for (const auto &count : runs) {
+      REQUIRE(count == 1);
+    }
+    REQUIRE_FALSE(threads.empty());
+    REQUIRE(threads.size() <= 4);
+  }
+
+  SECTION("The pool is reused across runs and resizes") {
+    WorkerPool pool{3};
+    std::atomic<std::size_t> total = 0;
+    for (auto round = 0; round < 50; ++round) {
+      pool.Run(17, [&](std::size_t i) { total += i; });
+    }
+    REQUIRE(total == 50 * (16 * 17 / 2));
+
+    pool.SetThreads(2);
+    REQUIRE(pool.Threads() == 2);
+    pool.Run(10, [&](std::size_t) { ++total; });
+    REQUIRE(total == 50 * (16 * 17 / 2) + 10);
+  }
+
+  SECTION("One thread runs inline") {
+    WorkerPool pool{1};
+    std::vector<std::thread::id> ran_on;
+    pool.Run(3, [&](std::size_t) {
+      ran_on.push_back(std::this_thread::get_id());
+    });
+    REQUIRE(ran_on ==
+            std::vector<std::thread::id>(3, std::this_thread::get_id()));
+  }
+}